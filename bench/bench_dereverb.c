@@ -0,0 +1,87 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "dereverb.h"
+
+#define BENCH_FRAMES 1024
+#define BENCH_ITERATIONS 50
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Time WPE on blocks of BENCH_FRAMES frames of noise, which keeps every
+ * bin adapting, and report the cost per channel. */
+static int bench_channels(int channels, int order) {
+    dereverb_config_t config = {
+        .num_channels = channels,
+        .sample_rate = 16000,
+        .frame_size = 512,
+        .order = order,
+        .delay = 2,
+        .forgetting = 0.99f
+    };
+    
+    dereverb_context_t *ctx = NULL;
+    if (dereverb_init(&ctx, &config) != MICARRAY_SUCCESS) {
+        fprintf(stderr, "dereverb_init failed for %d channels, order %d\n", channels, order);
+        return 1;
+    }
+    
+    int16_t *buffers[MAX_MICROPHONES];
+    uint32_t seed = 1;
+    for (int c = 0; c < channels; c++) {
+        buffers[c] = malloc(BENCH_FRAMES * sizeof(int16_t));
+    }
+    
+    const uint32_t mask = (channels >= 32) ? 0xFFFFFFFFu : ((1u << channels) - 1);
+    uint64_t elapsed = 0;
+    for (int i = 0; i < BENCH_ITERATIONS + 1; i++) {
+        for (int c = 0; c < channels; c++) {
+            for (int j = 0; j < BENCH_FRAMES; j++) {
+                seed = seed * 1664525u + 1013904223u;
+                buffers[c][j] = (int16_t)((int32_t)(seed >> 16) - 32768) / 4;
+            }
+        }
+        
+        uint64_t start = monotonic_ns();
+        dereverb_process(ctx, buffers, BENCH_FRAMES, mask);
+        if (i > 0) {
+            elapsed += monotonic_ns() - start;
+        }
+    }
+    
+    double per_block_us = elapsed / 1000.0 / BENCH_ITERATIONS;
+    double per_channel_ns = (double)elapsed / BENCH_ITERATIONS / BENCH_FRAMES / channels;
+    double block_budget_us = BENCH_FRAMES * 1e6 / config.sample_rate;
+    
+    printf("%8d %6d %6d %12.2f %14.3f %9.3f%%\n", channels, order, channels * order,
+           per_block_us, per_channel_ns, 100.0 * per_block_us / block_budget_us);
+    
+    for (int c = 0; c < channels; c++) {
+        free(buffers[c]);
+    }
+    dereverb_cleanup(ctx);
+    return 0;
+}
+
+int main(void) {
+    static const int channel_counts[] = {1, 2, 4, 6, 8};
+    static const int orders[] = {2, 4, 8};
+    
+    printf("WPE dereverberation, 512-sample frames, %d-frame blocks at 16 kHz\n", BENCH_FRAMES);
+    printf("%8s %6s %6s %12s %14s %10s\n", "channels", "order", "taps", "us/block", "ns/frame/ch", "realtime");
+    
+    for (size_t i = 0; i < sizeof(channel_counts) / sizeof(channel_counts[0]); i++) {
+        for (size_t j = 0; j < sizeof(orders) / sizeof(orders[0]); j++) {
+            if (bench_channels(channel_counts[i], orders[j]) != 0) {
+                return 1;
+            }
+        }
+    }
+    
+    return 0;
+}
@@ -0,0 +1,163 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "mic_health.h"
+#include "beamformer.h"
+#include "localization.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// The common deployment: 8 microphones on a 15 mm circle at 16 kHz
+#define BENCH_MICS 8
+#define BENCH_SPACING 0.015f
+#define BENCH_RATE 16000
+#define BENCH_FRAMES 512
+#define BENCH_BEAMS 4
+#define BENCH_ITERATIONS 2000
+
+static int16_t interleaved[BENCH_FRAMES * BENCH_MICS];
+static int16_t planar[BENCH_MICS][BENCH_FRAMES];
+static microphone_position_t positions[BENCH_MICS];
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static double bench_deinterleave(bool generic) {
+    mic_health_config_t config = {
+        .num_channels = BENCH_MICS,
+        .sample_rate = BENCH_RATE,
+        .generic = generic
+    };
+    mic_health_context_t *ctx = NULL;
+    if (mic_health_init(&ctx, &config) != MICARRAY_SUCCESS) {
+        return -1.0;
+    }
+    
+    int16_t *out[BENCH_MICS];
+    for (int m = 0; m < BENCH_MICS; m++) {
+        out[m] = planar[m];
+    }
+    
+    uint64_t start = monotonic_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        mic_health_deinterleave(ctx, interleaved, BENCH_FRAMES, out, 0);
+        mic_health_evaluate(ctx);
+    }
+    uint64_t elapsed = monotonic_ns() - start;
+    
+    mic_health_cleanup(ctx);
+    return (double)elapsed / BENCH_ITERATIONS / 1000.0;
+}
+
+static double bench_beamformer(bool generic) {
+    beamformer_config_t config = {
+        .num_microphones = BENCH_MICS,
+        .mic_positions = positions,
+        .sample_rate = BENCH_RATE,
+        .speed_of_sound = 343.0f,
+        .num_beams = BENCH_BEAMS,
+        .generic = generic
+    };
+    beamformer_context_t *ctx = NULL;
+    if (beamformer_init(&ctx, &config) != MICARRAY_SUCCESS) {
+        return -1.0;
+    }
+    
+    int16_t *channels[BENCH_MICS];
+    for (int m = 0; m < BENCH_MICS; m++) {
+        channels[m] = planar[m];
+    }
+    int16_t *out = malloc(BENCH_FRAMES * BENCH_BEAMS * sizeof(int16_t));
+    
+    uint64_t start = monotonic_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        beamformer_process(ctx, channels, BENCH_FRAMES, 0xFF, out, BENCH_BEAMS);
+    }
+    uint64_t elapsed = monotonic_ns() - start;
+    
+    free(out);
+    beamformer_cleanup(ctx);
+    return (double)elapsed / BENCH_ITERATIONS / 1000.0;
+}
+
+static double bench_localization(bool generic) {
+    localization_config_t config = {
+        .num_microphones = BENCH_MICS,
+        .mic_positions = positions,
+        .mic_spacing = BENCH_SPACING,
+        .sample_rate = BENCH_RATE,
+        .speed_of_sound = 343.0f,
+        .min_confidence_threshold = 0.3f,
+        .gcc_frame_size = 512,
+        .generic = generic
+    };
+    localization_context_t *ctx = NULL;
+    if (localization_init(&ctx, &config) != MICARRAY_SUCCESS) {
+        return -1.0;
+    }
+    
+    int16_t *channels[BENCH_MICS];
+    for (int m = 0; m < BENCH_MICS; m++) {
+        channels[m] = planar[m];
+    }
+    sound_location_t location;
+    
+    uint64_t start = monotonic_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        localization_process(ctx, channels, BENCH_FRAMES, &location);
+    }
+    uint64_t elapsed = monotonic_ns() - start;
+    
+    localization_cleanup(ctx);
+    return (double)elapsed / BENCH_ITERATIONS / 1000.0;
+}
+
+int main(void) {
+    uint32_t seed = 1;
+    for (int j = 0; j < BENCH_FRAMES * BENCH_MICS; j++) {
+        seed = seed * 1664525u + 1013904223u;
+        interleaved[j] = (int16_t)((int32_t)(seed >> 16) - 32768) / 4;
+    }
+    for (int m = 0; m < BENCH_MICS; m++) {
+        float angle = 2.0f * (float)M_PI * m / BENCH_MICS;
+        positions[m].x = BENCH_SPACING * cosf(angle);
+        positions[m].y = BENCH_SPACING * sinf(angle);
+        positions[m].z = 0.0f;
+        for (int j = 0; j < BENCH_FRAMES; j++) {
+            planar[m][j] = interleaved[j * BENCH_MICS + m];
+        }
+    }
+    
+    printf("Fixed geometry (%d mics, %.0f mm circle, %d Hz), %d-frame blocks\n",
+           BENCH_MICS, BENCH_SPACING * 1000.0f, BENCH_RATE, BENCH_FRAMES);
+    printf("%-24s %12s %12s %9s\n", "stage", "generic us", "fixed us", "speedup");
+    
+    struct {
+        const char *name;
+        double (*run)(bool generic);
+    } stages[] = {
+        {"deinterleave + health", bench_deinterleave},
+        {"beamformer, 4 beams", bench_beamformer},
+        {"GCC-PHAT localization", bench_localization}
+    };
+    
+    for (size_t s = 0; s < sizeof(stages) / sizeof(stages[0]); s++) {
+        double generic = stages[s].run(true);
+        double fixed = stages[s].run(false);
+        if (generic < 0.0 || fixed < 0.0) {
+            fprintf(stderr, "Failed to initialize %s\n", stages[s].name);
+            return 1;
+        }
+        printf("%-24s %12.2f %12.2f %8.2fx\n", stages[s].name, generic, fixed, generic / fixed);
+    }
+    
+    return 0;
+}
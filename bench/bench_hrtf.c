@@ -0,0 +1,128 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "hrtf.h"
+
+#define BENCH_FILE "bench_hrir.bin"
+#define BENCH_TAPS 256
+#define BENCH_DIRECTIONS 72
+#define BENCH_FRAMES 1024
+#define BENCH_ITERATIONS 1000
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* A horizontal ring of decaying noise responses, the size of a typical
+ * measured set resampled to 16 kHz. */
+static int write_hrir_file(void) {
+    FILE *file = fopen(BENCH_FILE, "wb");
+    if (!file) {
+        return 1;
+    }
+    
+    uint32_t header[4] = {16000, BENCH_TAPS, BENCH_DIRECTIONS, 0};
+    fwrite(HRTF_FILE_MAGIC, 1, 8, file);
+    fwrite(header, sizeof(header), 1, file);
+    
+    for (int d = 0; d < BENCH_DIRECTIONS; d++) {
+        float angles[2] = {360.0f * d / BENCH_DIRECTIONS, 0.0f};
+        fwrite(angles, sizeof(angles), 1, file);
+    }
+    
+    uint32_t seed = 1;
+    float hrir[BENCH_TAPS];
+    for (int i = 0; i < 2 * BENCH_DIRECTIONS; i++) {
+        for (int t = 0; t < BENCH_TAPS; t++) {
+            seed = seed * 1664525u + 1013904223u;
+            hrir[t] = ((int32_t)(seed >> 16) - 32768) / 32768.0f * expf(-t / 32.0f);
+        }
+        fwrite(hrir, sizeof(hrir), 1, file);
+    }
+    
+    fclose(file);
+    return 0;
+}
+
+/* Every source orbits the listener, so each block also pays for a
+ * direction change and its crossfade every few blocks. */
+static int bench_sources(int sources, int block_size) {
+    hrtf_config_t config = {
+        .sample_rate = 16000,
+        .block_size = block_size,
+        .max_sources = sources
+    };
+    strcpy(config.hrir_file, BENCH_FILE);
+    
+    hrtf_context_t *ctx = NULL;
+    if (hrtf_init(&ctx, &config) != MICARRAY_SUCCESS) {
+        fprintf(stderr, "hrtf_init failed for %d sources\n", sources);
+        return 1;
+    }
+    
+    int16_t *buffers[HRTF_MAX_SOURCES];
+    const int16_t *inputs[HRTF_MAX_SOURCES];
+    sound_location_t locations[HRTF_MAX_SOURCES];
+    int16_t *stereo = malloc(2 * BENCH_FRAMES * sizeof(int16_t));
+    uint32_t seed = 1;
+    for (int s = 0; s < sources; s++) {
+        buffers[s] = malloc(BENCH_FRAMES * sizeof(int16_t));
+        for (int j = 0; j < BENCH_FRAMES; j++) {
+            seed = seed * 1664525u + 1013904223u;
+            buffers[s][j] = (int16_t)(((int32_t)(seed >> 16) - 32768) / 8);
+        }
+        inputs[s] = buffers[s];
+    }
+    
+    uint64_t start = monotonic_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        for (int s = 0; s < sources; s++) {
+            float angle = 0.05f * i + s;
+            locations[s] = (sound_location_t){cosf(angle), sinf(angle), 0.0f, 1.0f};
+        }
+        hrtf_render(ctx, inputs, locations, sources, 0.5f, stereo, BENCH_FRAMES);
+    }
+    uint64_t elapsed = monotonic_ns() - start;
+    
+    double per_block_us = elapsed / 1000.0 / BENCH_ITERATIONS;
+    double block_budget_us = BENCH_FRAMES * 1e6 / config.sample_rate;
+    
+    printf("%8d %10d %12.2f %9.3f%%\n", sources, block_size, per_block_us,
+           100.0 * per_block_us / block_budget_us);
+    
+    for (int s = 0; s < sources; s++) {
+        free(buffers[s]);
+    }
+    free(stereo);
+    hrtf_cleanup(ctx);
+    return 0;
+}
+
+int main(void) {
+    static const int source_counts[] = {1, 2, 4, 8};
+    static const int block_sizes[] = {128, 256, 1024};
+    
+    if (write_hrir_file() != 0) {
+        fprintf(stderr, "Failed to write %s\n", BENCH_FILE);
+        return 1;
+    }
+    
+    printf("HRTF renderer, %d-tap HRIRs, %d-frame blocks at 16 kHz\n", BENCH_TAPS, BENCH_FRAMES);
+    printf("%8s %10s %12s %10s\n", "sources", "partition", "us/block", "realtime");
+    
+    int result = 0;
+    for (size_t b = 0; b < sizeof(block_sizes) / sizeof(block_sizes[0]) && result == 0; b++) {
+        for (size_t i = 0; i < sizeof(source_counts) / sizeof(source_counts[0]) && result == 0; i++) {
+            result = bench_sources(source_counts[i], block_sizes[b]);
+        }
+    }
+    
+    unlink(BENCH_FILE);
+    return result;
+}
@@ -0,0 +1,73 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "kernels.h"
+#include "simd.h"
+
+// One echo canceller partition at 512-sample blocks, and the GRU recurrent
+// layer of the noise reduction bench model
+#define BENCH_VECTORS 129
+#define BENCH_ROWS 288
+#define BENCH_STRIDE 96
+#define BENCH_ITERATIONS 20000
+
+static const char *const levels[] = {"scalar", "sse4", "avx2", "avx512", "neon", "dotprod"};
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int main(void) {
+    const int count = BENCH_VECTORS * SIMD_LANES;
+    float *buffers[6];
+    for (int b = 0; b < 6; b++) {
+        buffers[b] = (float*)simd_alloc(BENCH_VECTORS);
+        for (int k = 0; k < count; k++) {
+            buffers[b][k] = (float)((k * 37 + b * 11) % 97) / 97.0f - 0.5f;
+        }
+    }
+    int8_t *weight = malloc(BENCH_ROWS * BENCH_STRIDE);
+    int8_t x[BENCH_STRIDE];
+    int32_t out[BENCH_ROWS];
+    for (int i = 0; i < BENCH_ROWS * BENCH_STRIDE; i++) {
+        weight[i] = (int8_t)(i * 29);
+    }
+    for (int j = 0; j < BENCH_STRIDE; j++) {
+        x[j] = (int8_t)(j * 13);
+    }
+    
+    printf("SIMD kernels, complex_mac over %d bins, gemv_int8 %dx%d\n", count, BENCH_ROWS, BENCH_STRIDE);
+    printf("%-10s %18s %18s\n", "level", "complex_mac ns", "gemv_int8 ns");
+    
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+        if (kernels_select(levels[l]) != MICARRAY_SUCCESS) {
+            continue;
+        }
+        const kernel_table_t *table = kernels_get();
+        
+        uint64_t start = monotonic_ns();
+        for (int i = 0; i < BENCH_ITERATIONS; i++) {
+            table->complex_mac(buffers[0], buffers[1], buffers[2], buffers[3], buffers[4], buffers[5], count);
+        }
+        double mac_ns = (double)(monotonic_ns() - start) / BENCH_ITERATIONS;
+        
+        start = monotonic_ns();
+        for (int i = 0; i < BENCH_ITERATIONS; i++) {
+            table->gemv_int8(weight, BENCH_ROWS, BENCH_STRIDE, x, out);
+            x[i % BENCH_STRIDE] ^= (int8_t)out[i % BENCH_ROWS];
+        }
+        double gemv_ns = (double)(monotonic_ns() - start) / BENCH_ITERATIONS;
+        
+        printf("%-10s %18.1f %18.1f\n", levels[l], mac_ns, gemv_ns);
+    }
+    
+    for (int b = 0; b < 6; b++) {
+        free(buffers[b]);
+    }
+    free(weight);
+    return 0;
+}
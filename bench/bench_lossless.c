@@ -0,0 +1,107 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "lossless.h"
+
+#define BENCH_RATE 48000
+#define BENCH_SECONDS 20
+#define BENCH_CHUNK 4096
+#define BENCH_FILE "/tmp/bench_lossless.mla"
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* A voice-band mixture at a moderate level plus a little noise on every
+ * channel, each slightly delayed, like an array hearing one talker. */
+static int16_t* make_capture(int channels, size_t frames) {
+    int16_t *samples = malloc(frames * channels * sizeof(int16_t));
+    uint32_t seed = 3;
+    for (size_t n = 0; n < frames; n++) {
+        for (int c = 0; c < channels; c++) {
+            seed = seed * 1664525u + 1013904223u;
+            float t = (float)(n + 2 * c) / BENCH_RATE;
+            float voice = 3000.0f * sinf(2.0f * (float)M_PI * 220.0f * t) +
+                          1500.0f * sinf(2.0f * (float)M_PI * 1330.0f * t);
+            samples[n * channels + c] = (int16_t)(voice + (float)((int32_t)(seed >> 16) - 32768) / 512.0f);
+        }
+    }
+    return samples;
+}
+
+/* Encode and decode BENCH_SECONDS of audio and report how many times
+ * faster than real time each runs. */
+static int bench_channels(int channels, int threads) {
+    const size_t frames = (size_t)BENCH_RATE * BENCH_SECONDS;
+    int16_t *samples = make_capture(channels, frames);
+    
+    lossless_config_t config = {
+        .channels = channels,
+        .sample_rate = BENCH_RATE,
+        .block_frames = LOSSLESS_DEFAULT_BLOCK,
+        .threads = threads
+    };
+    
+    lossless_writer_t *writer = NULL;
+    int fd = open(BENCH_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || lossless_writer_init(&writer, &config) != MICARRAY_SUCCESS) {
+        fprintf(stderr, "Cannot set up a %d-channel encoder\n", channels);
+        return 1;
+    }
+    
+    uint64_t start = monotonic_ns();
+    lossless_writer_begin(writer, fd);
+    for (size_t done = 0; done < frames; done += BENCH_CHUNK) {
+        size_t count = frames - done < BENCH_CHUNK ? frames - done : BENCH_CHUNK;
+        lossless_writer_write(writer, samples + done * channels, count);
+    }
+    lossless_writer_finish(writer);
+    uint64_t encode_ns = monotonic_ns() - start;
+    close(fd);
+    lossless_writer_cleanup(writer);
+    
+    struct stat st;
+    stat(BENCH_FILE, &st);
+    
+    lossless_reader_t *reader = NULL;
+    if (lossless_reader_open(&reader, BENCH_FILE) != MICARRAY_SUCCESS) {
+        return 1;
+    }
+    
+    start = monotonic_ns();
+    size_t read;
+    do {
+        lossless_reader_read(reader, samples, BENCH_CHUNK, &read);
+    } while (read > 0);
+    uint64_t decode_ns = monotonic_ns() - start;
+    lossless_reader_close(reader);
+    unlink(BENCH_FILE);
+    free(samples);
+    
+    printf("%8d %8d %9.1f%% %12.1f %12.1f\n", channels, threads,
+           100.0 * st.st_size / (frames * channels * sizeof(int16_t)),
+           BENCH_SECONDS * 1e9 / encode_ns, BENCH_SECONDS * 1e9 / decode_ns);
+    return 0;
+}
+
+int main(void) {
+    static const int channel_counts[] = {2, 4, 8, 16};
+    
+    printf("Lossless capture, %d s at %d Hz\n", BENCH_SECONDS, BENCH_RATE);
+    printf("%8s %8s %10s %12s %12s\n", "channels", "threads", "size", "encode x rt", "decode x rt");
+    
+    for (size_t i = 0; i < sizeof(channel_counts) / sizeof(channel_counts[0]); i++) {
+        if (bench_channels(channel_counts[i], 1) != 0 || bench_channels(channel_counts[i], 0) != 0) {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
@@ -0,0 +1,137 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "noise_reduction.h"
+#include "nn_suppressor.h"
+
+#define BENCH_FRAMES 1024
+#define BENCH_ITERATIONS 200
+#define BENCH_MODEL "bench_nn_model.bin"
+#define BENCH_DENSE 64
+#define BENCH_GRU 96
+#define ALIGNED(n) (((n) + NN_ALIGN - 1) / NN_ALIGN * NN_ALIGN)
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t next_random(uint32_t *seed) {
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed >> 16;
+}
+
+static void write_layer(FILE *file, uint32_t rows, uint32_t cols, uint32_t *seed) {
+    uint32_t shape[2] = {rows, cols};
+    float scales[2] = {0.5f / 127.0f, 0.1f / 32767.0f};
+    fwrite(shape, sizeof(shape), 1, file);
+    fwrite(scales, sizeof(scales), 1, file);
+    
+    for (uint32_t i = 0; i < ALIGNED(rows); i++) {
+        int16_t bias = (int16_t)(next_random(seed) - 32768);
+        fwrite(&bias, sizeof(bias), 1, file);
+    }
+    for (uint32_t i = 0; i < rows; i++) {
+        for (uint32_t j = 0; j < ALIGNED(cols); j++) {
+            int8_t weight = j < cols ? (int8_t)(next_random(seed) % 255 - 127) : 0;
+            fwrite(&weight, sizeof(weight), 1, file);
+        }
+    }
+}
+
+/* Random weights cost the same as trained ones; the layer sizes are in
+ * the range of RNNoise. */
+static int write_model(void) {
+    FILE *file = fopen(BENCH_MODEL, "wb");
+    if (!file) {
+        return 1;
+    }
+    
+    uint32_t seed = 1;
+    uint32_t header[4] = {NN_BANDS, BENCH_DENSE, BENCH_GRU, 0};
+    fwrite(NN_FILE_MAGIC, 8, 1, file);
+    fwrite(header, sizeof(header), 1, file);
+    write_layer(file, BENCH_DENSE, NN_BANDS, &seed);
+    write_layer(file, 3 * BENCH_GRU, BENCH_DENSE, &seed);
+    write_layer(file, 3 * BENCH_GRU, BENCH_GRU, &seed);
+    write_layer(file, NN_BANDS, BENCH_GRU, &seed);
+    fclose(file);
+    return 0;
+}
+
+/* Time one noise reduction context per channel on blocks of BENCH_FRAMES
+ * frames, as the pipeline runs them, and report the cost per channel. */
+static int bench_channels(const char *algorithm, int channels) {
+    noise_reduction_config_t config = {
+        .noise_threshold = 0.05f,
+        .frame_size = 1024,
+        .overlap = 512,
+        .alpha = 2.0f,
+        .beta = 0.1f,
+        .sample_rate = 16000
+    };
+    strcpy(config.algorithm, algorithm);
+    strcpy(config.model_file, BENCH_MODEL);
+    
+    noise_reduction_context_t *ctx[MAX_MICROPHONES] = {NULL};
+    int16_t *buffers[MAX_MICROPHONES];
+    uint32_t seed = 1;
+    for (int c = 0; c < channels; c++) {
+        if (noise_reduction_init(&ctx[c], &config) != MICARRAY_SUCCESS) {
+            fprintf(stderr, "noise_reduction_init failed for %s\n", algorithm);
+            return 1;
+        }
+        buffers[c] = malloc(BENCH_FRAMES * sizeof(int16_t));
+        for (int j = 0; j < BENCH_FRAMES; j++) {
+            buffers[c][j] = (int16_t)((int32_t)next_random(&seed) - 32768) / 4;
+        }
+    }
+    
+    uint64_t start = monotonic_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        for (int c = 0; c < channels; c++) {
+            noise_reduction_process(ctx[c], buffers[c], buffers[c], BENCH_FRAMES);
+        }
+    }
+    uint64_t elapsed = monotonic_ns() - start;
+    
+    double per_block_us = elapsed / 1000.0 / BENCH_ITERATIONS;
+    double per_channel_ns = (double)elapsed / BENCH_ITERATIONS / BENCH_FRAMES / channels;
+    double block_budget_us = BENCH_FRAMES * 1e6 / config.sample_rate;
+    
+    printf("%-22s %8d %12.2f %14.3f %9.3f%%\n", algorithm, channels, per_block_us, per_channel_ns,
+           100.0 * per_block_us / block_budget_us);
+    
+    for (int c = 0; c < channels; c++) {
+        free(buffers[c]);
+        noise_reduction_cleanup(ctx[c]);
+    }
+    return 0;
+}
+
+int main(void) {
+    static const int channel_counts[] = {1, 4, 8};
+    static const char *const algorithms[] = {"spectral_subtraction", "nn"};
+    
+    if (write_model() != 0) {
+        fprintf(stderr, "Failed to write %s\n", BENCH_MODEL);
+        return 1;
+    }
+    
+    printf("Noise reduction, 1024-sample frames, %d-frame blocks at 16 kHz (nn: %d dense, %d GRU units)\n",
+           BENCH_FRAMES, BENCH_DENSE, BENCH_GRU);
+    printf("%-22s %8s %12s %14s %10s\n", "algorithm", "channels", "us/block", "ns/frame/ch", "realtime");
+    
+    int result = 0;
+    for (size_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]) && result == 0; a++) {
+        for (size_t i = 0; i < sizeof(channel_counts) / sizeof(channel_counts[0]) && result == 0; i++) {
+            result = bench_channels(algorithms[a], channel_counts[i]);
+        }
+    }
+    
+    remove(BENCH_MODEL);
+    return result;
+}
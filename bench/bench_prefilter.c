@@ -0,0 +1,78 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "prefilter.h"
+
+#define BENCH_FRAMES 1024
+#define BENCH_ITERATIONS 2000
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Time the full DC + high-pass + low-pass cascade on blocks of
+ * BENCH_FRAMES frames and report the cost per channel. */
+static int bench_channels(int channels) {
+    prefilter_config_t config = {
+        .num_channels = channels,
+        .sample_rate = 16000,
+        .dc_removal = true,
+        .highpass_hz = 80.0f,
+        .lowpass_hz = 6000.0f
+    };
+    
+    prefilter_context_t *ctx = NULL;
+    if (prefilter_init(&ctx, &config) != MICARRAY_SUCCESS) {
+        fprintf(stderr, "prefilter_init failed for %d channels\n", channels);
+        return 1;
+    }
+    
+    int16_t *buffers[MAX_MICROPHONES];
+    uint32_t seed = 1;
+    for (int c = 0; c < channels; c++) {
+        buffers[c] = malloc(BENCH_FRAMES * sizeof(int16_t));
+        for (int j = 0; j < BENCH_FRAMES; j++) {
+            seed = seed * 1664525u + 1013904223u;
+            buffers[c][j] = (int16_t)((int32_t)(seed >> 16) - 32768) / 4;
+        }
+    }
+    
+    prefilter_process(ctx, buffers, BENCH_FRAMES);
+    
+    uint64_t start = monotonic_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        prefilter_process(ctx, buffers, BENCH_FRAMES);
+    }
+    uint64_t elapsed = monotonic_ns() - start;
+    
+    double per_block_us = elapsed / 1000.0 / BENCH_ITERATIONS;
+    double per_channel_ns = (double)elapsed / BENCH_ITERATIONS / BENCH_FRAMES / channels;
+    double block_budget_us = BENCH_FRAMES * 1e6 / config.sample_rate;
+    
+    printf("%8d %10d %12.2f %14.3f %9.3f%%\n", channels, prefilter_get_num_sections(ctx),
+           per_block_us, per_channel_ns, 100.0 * per_block_us / block_budget_us);
+    
+    for (int c = 0; c < channels; c++) {
+        free(buffers[c]);
+    }
+    prefilter_cleanup(ctx);
+    return 0;
+}
+
+int main(void) {
+    static const int channel_counts[] = {1, 2, 4, 6, 8, 16};
+    
+    printf("Pre-filter, %d-frame blocks at 16 kHz\n", BENCH_FRAMES);
+    printf("%8s %10s %12s %14s %10s\n", "channels", "sections", "us/block", "ns/frame/ch", "realtime");
+    
+    for (size_t i = 0; i < sizeof(channel_counts) / sizeof(channel_counts[0]); i++) {
+        if (bench_channels(channel_counts[i]) != 0) {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
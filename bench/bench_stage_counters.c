@@ -0,0 +1,88 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "libmicarray.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// The default pipeline on the 8-microphone array at 16 kHz
+#define BENCH_MICS 8
+#define BENCH_RATE 16000
+#define BENCH_FRAMES 512
+#define BENCH_BLOCKS 400
+
+int main(void) {
+    micarray_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.num_microphones = BENCH_MICS;
+    config.mic_spacing = 15.0f;
+    config.dma_buffer_size = BENCH_FRAMES;
+    config.sample_rate = BENCH_RATE;
+    config.prefilter_enable = true;
+    config.prefilter_dc_removal = true;
+    config.prefilter_highpass = 80.0f;
+    config.dereverb_enable = true;
+    config.dereverb_order = 4;
+    config.dereverb_delay = 2;
+    config.dereverb_frame_size = 512;
+    config.dereverb_forgetting = 0.99f;
+    config.noise_reduction_enable = true;
+    config.noise_threshold = 0.05f;
+    strcpy(config.algorithm, "spectral_subtraction");
+    config.volume = 0.8f;
+    strcpy(config.log_level, "ERROR");
+    config.perf_counters = true;
+    
+    micarray_context_t *ctx = NULL;
+    if (micarray_init_headless(&ctx, &config) != MICARRAY_SUCCESS) {
+        fprintf(stderr, "Failed to initialize the pipeline\n");
+        return 1;
+    }
+    
+    int16_t *input = malloc(BENCH_FRAMES * BENCH_MICS * sizeof(int16_t));
+    int16_t *output = malloc(BENCH_FRAMES * 2 * sizeof(int16_t));
+    uint32_t seed = 1;
+    for (int block = 0; block < BENCH_BLOCKS; block++) {
+        for (int j = 0; j < BENCH_FRAMES; j++) {
+            float tone = 6000.0f * sinf(2.0f * (float)M_PI * 440.0f * (block * BENCH_FRAMES + j) / BENCH_RATE);
+            for (int m = 0; m < BENCH_MICS; m++) {
+                seed = seed * 1664525u + 1013904223u;
+                input[j * BENCH_MICS + m] = (int16_t)(tone + (float)((int32_t)(seed >> 20) - 2048));
+            }
+        }
+        micarray_process_block(ctx, input, MICARRAY_LAYOUT_INTERLEAVED, BENCH_FRAMES, output, NULL);
+    }
+    
+    micarray_stats_t stats;
+    micarray_stage_stats_t stages[MICARRAY_MAX_STAGES + MICARRAY_PSEUDO_STAGES];
+    int num_stages = 0;
+    micarray_get_stats(ctx, &stats);
+    micarray_get_stage_stats(ctx, stages, MICARRAY_MAX_STAGES + MICARRAY_PSEUDO_STAGES, &num_stages);
+    
+    printf("Pipeline stages (%d mics, %d Hz), %d-frame blocks, hardware counters %s\n",
+           BENCH_MICS, BENCH_RATE, BENCH_FRAMES, stats.perf_counters ? "on" : "not available");
+    printf("%-16s %10s %14s %6s %16s %17s\n", "stage", "us/call", "cycles/call", "IPC", 
+           "cache miss/call", "branch miss/call");
+    
+    for (int i = 0; i < num_stages && i < MICARRAY_MAX_STAGES + MICARRAY_PSEUDO_STAGES; i++) {
+        const micarray_stage_stats_t *s = &stages[i];
+        double calls = s->calls ? (double)s->calls : 1.0;
+        printf("%-16s %10.2f", s->name, s->total_ns / calls / 1000.0);
+        if (stats.perf_counters) {
+            printf(" %14.0f %6.2f %16.1f %17.1f\n", s->cycles / calls, 
+                   s->cycles ? (double)s->instructions / s->cycles : 0.0,
+                   s->cache_misses / calls, s->branch_misses / calls);
+        } else {
+            printf(" %14s %6s %16s %17s\n", "-", "-", "-", "-");
+        }
+    }
+    
+    free(input);
+    free(output);
+    micarray_cleanup(ctx);
+    return 0;
+}
@@ -0,0 +1,276 @@
+#define _GNU_SOURCE
+#include "agc.h"
+#include "simd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define AGC_DETECTOR_MS 10.0f
+#define AGC_LIMITER_RELEASE_MS 60.0f
+
+typedef struct {
+    uint64_t index;
+    float value;
+} peak_t;
+
+/* The AGC works a chunk at a time: the chunk's energy feeds the level
+ * detector and the gain ramps linearly across it, both a vector at a
+ * time. The detector averages power evenly so a tone's ripple does not
+ * bias it; attack and release shape how the gain follows it. The limiter
+ * then runs per sample. Over the look-ahead window it tracks the peak
+ * with a monotonic deque (amortised O(1)), holds the gain that peak
+ * needs, and smooths it with a box filter as long as the window. Every
+ * value in the box is at most the gain the peak needs, so by the time the
+ * peak leaves the delay line it is at or under the ceiling. */
+struct agc_context {
+    agc_config_t config;
+    
+    float target_power;
+    float gate_power;
+    float max_gain;
+    float min_gain;
+    float detector_coef;
+    float attack_coef;
+    float release_coef;
+    float envelope;
+    float gain;
+    
+    float ceiling;
+    float limiter_release;
+    int lookahead;
+    int window;
+    uint64_t frame;
+    
+    peak_t *deque;
+    int deque_head;
+    int deque_count;
+    
+    float *box;
+    double box_sum;
+    float release_gain;
+    float *delay;
+    int pos;
+    float min_limiter_gain;
+};
+
+static float db_to_amplitude(float db) {
+    return powf(10.0f, db / 20.0f);
+}
+
+/* One-pole coefficient for a time constant of ms, updated every step
+ * frames. */
+static float smoothing_coef(float ms, int step, int sample_rate) {
+    if (ms <= 0.0f) {
+        return 1.0f;
+    }
+    return 1.0f - expf(-(float)step / (ms * sample_rate / 1000.0f));
+}
+
+int agc_init(agc_context_t **ctx, const agc_config_t *config) {
+    if (!ctx || !config || config->sample_rate <= 0 || config->max_gain_db < 0.0f ||
+        config->target_level_db > 0.0f || config->ceiling_db > 0.0f || config->attack_ms < 0.0f ||
+        config->release_ms < 0.0f || config->lookahead_ms < 0.0f ||
+        config->lookahead_ms > AGC_MAX_LOOKAHEAD_MS) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(agc_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    agc_context_t *agc = *ctx;
+    agc->config = *config;
+    agc->target_power = powf(10.0f, config->target_level_db / 10.0f);
+    agc->gate_power = powf(10.0f, config->gate_db / 10.0f);
+    agc->max_gain = db_to_amplitude(config->max_gain_db);
+    agc->min_gain = 1.0f / agc->max_gain;
+    agc->detector_coef = smoothing_coef(AGC_DETECTOR_MS, AGC_CHUNK, config->sample_rate);
+    agc->attack_coef = smoothing_coef(config->attack_ms, AGC_CHUNK, config->sample_rate);
+    agc->release_coef = smoothing_coef(config->release_ms, AGC_CHUNK, config->sample_rate);
+    
+    agc->ceiling = db_to_amplitude(config->ceiling_db);
+    agc->limiter_release = smoothing_coef(AGC_LIMITER_RELEASE_MS, 1, config->sample_rate);
+    agc->lookahead = (int)lrintf(config->lookahead_ms * config->sample_rate / 1000.0f);
+    agc->window = agc->lookahead + 1;
+    
+    agc->deque = calloc(agc->window, sizeof(peak_t));
+    agc->box = calloc(agc->window, sizeof(float));
+    agc->delay = calloc(agc->lookahead + 1, sizeof(float));
+    if (!agc->deque || !agc->box || !agc->delay) {
+        agc_cleanup(agc);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    agc_reset(agc);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int agc_cleanup(agc_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    free(ctx->deque);
+    free(ctx->box);
+    free(ctx->delay);
+    free(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int agc_reset(agc_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    /* Start at the target so the first words are neither pumped nor cut. */
+    ctx->envelope = ctx->target_power;
+    ctx->gain = 1.0f;
+    ctx->frame = 0;
+    ctx->deque_head = 0;
+    ctx->deque_count = 0;
+    ctx->release_gain = 1.0f;
+    ctx->pos = 0;
+    ctx->min_limiter_gain = 1.0f;
+    
+    for (int i = 0; i < ctx->window; i++) {
+        ctx->box[i] = 1.0f;
+    }
+    ctx->box_sum = ctx->window;
+    memset(ctx->delay, 0, (ctx->lookahead + 1) * sizeof(float));
+    
+    return MICARRAY_SUCCESS;
+}
+
+static float next_gain(agc_context_t *ctx, float power) {
+    /* A pause leaves the detector and the gain where speech left them. */
+    if (power < ctx->gate_power) {
+        return ctx->gain;
+    }
+    ctx->envelope += ctx->detector_coef * (power - ctx->envelope);
+    
+    float wanted = sqrtf(ctx->target_power / ctx->envelope);
+    wanted = fminf(ctx->max_gain, fmaxf(ctx->min_gain, wanted));
+    float coef = wanted < ctx->gain ? ctx->attack_coef : ctx->release_coef;
+    return ctx->gain + coef * (wanted - ctx->gain);
+}
+
+/* Applies the AGC to one chunk of at most AGC_CHUNK samples. */
+static void level_chunk(agc_context_t *ctx, const int16_t *in, float *out, int count) {
+    const int vectors = AGC_CHUNK / SIMD_LANES;
+    float4_t x[AGC_CHUNK / SIMD_LANES];
+    float *lanes = (float*)x;
+    
+    for (int i = 0; i < AGC_CHUNK; i++) {
+        lanes[i] = i < count ? in[i] * (1.0f / 32768.0f) : 0.0f;
+    }
+    
+    float4_t energy = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int v = 0; v < vectors; v++) {
+        energy += x[v] * x[v];
+    }
+    float power = (energy[0] + energy[1] + energy[2] + energy[3]) / count;
+    
+    float start = ctx->gain;
+    float end = next_gain(ctx, power);
+    float step = (end - start) / count;
+    float4_t ramp = {1.0f, 2.0f, 3.0f, 4.0f};
+    for (int v = 0; v < vectors; v++) {
+        x[v] *= start + step * ramp;
+        ramp += (float)SIMD_LANES;
+    }
+    ctx->gain = end;
+    
+    memcpy(out, lanes, count * sizeof(float));
+}
+
+static int16_t to_sample(float value) {
+    value += (value < 0.0f) ? -0.5f : 0.5f;
+    value = fmaxf(-32768.0f, fminf(32767.0f, value));
+    return (int16_t)value;
+}
+
+/* Pushes one AGC output through the limiter and returns the sample that
+ * leaves the look-ahead delay. */
+static float limit_sample(agc_context_t *ctx, float x) {
+    const int window = ctx->window;
+    float magnitude = fabsf(x);
+    
+    /* The deque holds decreasing peaks of the last window samples. */
+    if (ctx->deque_count > 0 && ctx->deque[ctx->deque_head].index + window <= ctx->frame) {
+        ctx->deque_head = (ctx->deque_head + 1) % window;
+        ctx->deque_count--;
+    }
+    while (ctx->deque_count > 0) {
+        int tail = (ctx->deque_head + ctx->deque_count - 1) % window;
+        if (ctx->deque[tail].value > magnitude) {
+            break;
+        }
+        ctx->deque_count--;
+    }
+    int tail = (ctx->deque_head + ctx->deque_count) % window;
+    ctx->deque[tail].index = ctx->frame;
+    ctx->deque[tail].value = magnitude;
+    ctx->deque_count++;
+    
+    float peak = ctx->deque[ctx->deque_head].value;
+    float held = peak > ctx->ceiling ? ctx->ceiling / peak : 1.0f;
+    if (held < ctx->release_gain) {
+        ctx->release_gain = held;
+    } else {
+        ctx->release_gain += ctx->limiter_release * (held - ctx->release_gain);
+    }
+    
+    ctx->box_sum += ctx->release_gain - ctx->box[ctx->pos];
+    ctx->box[ctx->pos] = ctx->release_gain;
+    ctx->pos = (ctx->pos + 1) % window;
+    float gain = fminf(1.0f, (float)(ctx->box_sum / window));
+    
+    float delayed = x;
+    if (ctx->lookahead > 0) {
+        int slot = (int)(ctx->frame % ctx->lookahead);
+        delayed = ctx->delay[slot];
+        ctx->delay[slot] = x;
+    }
+    ctx->frame++;
+    
+    if (gain < ctx->min_limiter_gain) {
+        ctx->min_limiter_gain = gain;
+    }
+    return delayed * gain;
+}
+
+int agc_process(agc_context_t *ctx, int16_t *samples, size_t frames) {
+    if (!ctx || !samples) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    ctx->min_limiter_gain = 1.0f;
+    
+    float leveled[AGC_CHUNK];
+    for (size_t done = 0; done < frames; done += AGC_CHUNK) {
+        int count = frames - done < AGC_CHUNK ? (int)(frames - done) : AGC_CHUNK;
+        level_chunk(ctx, samples + done, leveled, count);
+        for (int i = 0; i < count; i++) {
+            samples[done + i] = to_sample(limit_sample(ctx, leveled[i]) * 32768.0f);
+        }
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int agc_get_latency(const agc_context_t *ctx) {
+    return ctx ? ctx->lookahead : 0;
+}
+
+float agc_get_gain_db(const agc_context_t *ctx) {
+    return ctx ? 20.0f * log10f(ctx->gain) : 0.0f;
+}
+
+float agc_get_limiter_db(const agc_context_t *ctx) {
+    return ctx ? 20.0f * log10f(ctx->min_limiter_gain) : 0.0f;
+}
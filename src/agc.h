@@ -0,0 +1,53 @@
+#ifndef AGC_H
+#define AGC_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AGC_CHUNK 16
+#define AGC_MAX_LOOKAHEAD_MS 20.0f
+
+typedef struct agc_context agc_context_t;
+
+/* The AGC steers the RMS level towards target_level_db, boosting by at
+ * most max_gain_db and cutting by at most as much. The gain falls with
+ * time constant attack_ms and rises with release_ms; while the level is
+ * under gate_db it holds so pauses are not pumped up. The limiter then
+ * keeps every sample under ceiling_db, seeing lookahead_ms ahead so it
+ * can fade the gain down before a peak instead of clipping it. Levels are
+ * dBFS. */
+typedef struct {
+    int sample_rate;
+    float target_level_db;
+    float max_gain_db;
+    float gate_db;
+    float attack_ms;
+    float release_ms;
+    float ceiling_db;
+    float lookahead_ms;
+} agc_config_t;
+
+int agc_init(agc_context_t **ctx, const agc_config_t *config);
+int agc_cleanup(agc_context_t *ctx);
+
+/* Levels samples[0..frames) in place. The output is delayed by
+ * agc_get_latency() frames. Does not allocate. */
+int agc_process(agc_context_t *ctx, int16_t *samples, size_t frames);
+int agc_reset(agc_context_t *ctx);
+
+int agc_get_latency(const agc_context_t *ctx);
+
+/* The AGC gain at the end of the last block, and the deepest limiter
+ * gain reduction within it (0 or below). */
+float agc_get_gain_db(const agc_context_t *ctx);
+float agc_get_limiter_db(const agc_context_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
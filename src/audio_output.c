@@ -25,28 +25,37 @@ struct audio_output_context {
     
     int16_t *output_buffer;
     size_t buffer_frames;
+    
+    void (*playback_callback)(const int16_t *stereo, size_t frames, void *user_data);
+    void *playback_user_data;
 };
 
-static void apply_stereo_panning(int16_t *mono_data, int16_t *left_out, int16_t *right_out, 
-                                size_t samples, const sound_location_t *location) {
+static void compute_pan_gains(const sound_location_t *location, float *left_gain, float *right_gain) {
     float angle = atan2f(location->y, location->x);
     float distance = sqrtf(location->x * location->x + location->y * location->y);
     
-    float pan = angle / M_PI;
+    /* Counter-clockwise azimuth, so a source at +y pans left. */
+    float pan = -angle / M_PI;
     pan = fmaxf(-1.0f, fminf(1.0f, pan));
     
     float distance_attenuation = 1.0f / (1.0f + distance * 0.1f);
     distance_attenuation = fmaxf(0.1f, fminf(1.0f, distance_attenuation));
     
-    float left_gain = (1.0f - pan) * 0.5f + 0.5f;
-    float right_gain = (1.0f + pan) * 0.5f + 0.5f;
+    *left_gain = ((1.0f - pan) * 0.5f + 0.5f) * distance_attenuation * location->confidence;
+    *right_gain = ((1.0f + pan) * 0.5f + 0.5f) * distance_attenuation * location->confidence;
+}
+
+void audio_output_render_localized(const int16_t *mono_data, int16_t *stereo_out, size_t samples, 
+                                   const sound_location_t *location, float volume) {
+    float left_gain, right_gain;
+    compute_pan_gains(location, &left_gain, &right_gain);
     
-    left_gain *= distance_attenuation * location->confidence;
-    right_gain *= distance_attenuation * location->confidence;
+    left_gain *= volume;
+    right_gain *= volume;
     
     for (size_t i = 0; i < samples; i++) {
-        left_out[i] = (int16_t)(mono_data[i] * left_gain);
-        right_out[i] = (int16_t)(mono_data[i] * right_gain);
+        stereo_out[i * 2] = (int16_t)(mono_data[i] * left_gain);
+        stereo_out[i * 2 + 1] = (int16_t)(mono_data[i] * right_gain);
     }
 }
 
@@ -256,6 +265,28 @@ int audio_output_cleanup(audio_output_context_t *ctx) {
     return MICARRAY_SUCCESS;
 }
 
+/* Called with the mutex held once output_buffer holds the interleaved frames. */
+static int write_output_buffer(audio_output_context_t *ctx, size_t frames) {
+    snd_pcm_sframes_t frames_written = snd_pcm_writei(ctx->pcm_handle, ctx->output_buffer, frames);
+    
+    if (frames_written < 0) {
+        if (frames_written == -EPIPE) {
+            fprintf(stderr, "Audio underrun occurred\n");
+            snd_pcm_prepare(ctx->pcm_handle);
+            return MICARRAY_SUCCESS;
+        } else {
+            fprintf(stderr, "Audio write error: %s\n", snd_strerror(frames_written));
+            return MICARRAY_ERROR_AUDIO_OUTPUT;
+        }
+    }
+    
+    if (ctx->playback_callback && frames_written > 0) {
+        ctx->playback_callback(ctx->output_buffer, (size_t)frames_written, ctx->playback_user_data);
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
 int audio_output_write_stereo(audio_output_context_t *ctx, int16_t *left_channel, int16_t *right_channel, size_t samples) {
     if (!ctx || !left_channel || !right_channel) {
         return MICARRAY_ERROR_INVALID_PARAM;
@@ -265,29 +296,80 @@ int audio_output_write_stereo(audio_output_context_t *ctx, int16_t *left_channel
         return MICARRAY_ERROR_AUDIO_OUTPUT;
     }
     
+    int result = MICARRAY_SUCCESS;
+    
     pthread_mutex_lock(&ctx->mutex);
     
-    for (size_t i = 0; i < samples; i++) {
-        ctx->output_buffer[i * 2] = (int16_t)(left_channel[i] * ctx->config.volume);
-        ctx->output_buffer[i * 2 + 1] = (int16_t)(right_channel[i] * ctx->config.volume);
+    for (size_t offset = 0; offset < samples && result == MICARRAY_SUCCESS; offset += ctx->buffer_frames) {
+        size_t frames = samples - offset;
+        if (frames > ctx->buffer_frames) {
+            frames = ctx->buffer_frames;
+        }
+        
+        for (size_t i = 0; i < frames; i++) {
+            ctx->output_buffer[i * 2] = (int16_t)(left_channel[offset + i] * ctx->config.volume);
+            ctx->output_buffer[i * 2 + 1] = (int16_t)(right_channel[offset + i] * ctx->config.volume);
+        }
+        
+        result = write_output_buffer(ctx, frames);
     }
     
-    snd_pcm_sframes_t frames_written = snd_pcm_writei(ctx->pcm_handle, ctx->output_buffer, samples);
-    
     pthread_mutex_unlock(&ctx->mutex);
     
-    if (frames_written < 0) {
-        if (frames_written == -EPIPE) {
-            fprintf(stderr, "Audio underrun occurred\n");
-            snd_pcm_prepare(ctx->pcm_handle);
-            return MICARRAY_SUCCESS;
-        } else {
-            fprintf(stderr, "Audio write error: %s\n", snd_strerror(frames_written));
-            return MICARRAY_ERROR_AUDIO_OUTPUT;
+    return result;
+}
+
+int audio_output_write_interleaved(audio_output_context_t *ctx, const int16_t *data, size_t frames) {
+    if (!ctx || !data) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (!ctx->running) {
+        return MICARRAY_ERROR_AUDIO_OUTPUT;
+    }
+    
+    int result = MICARRAY_SUCCESS;
+    
+    pthread_mutex_lock(&ctx->mutex);
+    
+    for (size_t offset = 0; offset < frames && result == MICARRAY_SUCCESS; offset += ctx->buffer_frames) {
+        size_t count = frames - offset;
+        if (count > ctx->buffer_frames) {
+            count = ctx->buffer_frames;
         }
+        
+        const size_t channels = ctx->config.channels;
+        memcpy(ctx->output_buffer, data + channels * offset, count * channels * sizeof(int16_t));
+        result = write_output_buffer(ctx, count);
     }
     
-    return MICARRAY_SUCCESS;
+    pthread_mutex_unlock(&ctx->mutex);
+    
+    return result;
+}
+
+int16_t* audio_output_acquire(audio_output_context_t *ctx, size_t *frames) {
+    if (!ctx || !frames || !ctx->running) {
+        return NULL;
+    }
+    
+    pthread_mutex_lock(&ctx->mutex);
+    if (*frames > ctx->buffer_frames) {
+        *frames = ctx->buffer_frames;
+    }
+    
+    return ctx->output_buffer;
+}
+
+int audio_output_commit(audio_output_context_t *ctx, size_t frames) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    int result = frames > 0 ? write_output_buffer(ctx, frames) : MICARRAY_SUCCESS;
+    pthread_mutex_unlock(&ctx->mutex);
+    
+    return result;
 }
 
 int audio_output_write_localized(audio_output_context_t *ctx, int16_t *audio_data, size_t samples, const sound_location_t *location) {
@@ -295,21 +377,25 @@ int audio_output_write_localized(audio_output_context_t *ctx, int16_t *audio_dat
         return MICARRAY_ERROR_INVALID_PARAM;
     }
     
-    int16_t *left_channel = malloc(samples * sizeof(int16_t));
-    int16_t *right_channel = malloc(samples * sizeof(int16_t));
-    
-    if (!left_channel || !right_channel) {
-        free(left_channel);
-        free(right_channel);
-        return MICARRAY_ERROR_MEMORY;
+    if (!ctx->running) {
+        return MICARRAY_ERROR_AUDIO_OUTPUT;
     }
     
-    apply_stereo_panning(audio_data, left_channel, right_channel, samples, location);
+    int result = MICARRAY_SUCCESS;
     
-    int result = audio_output_write_stereo(ctx, left_channel, right_channel, samples);
+    pthread_mutex_lock(&ctx->mutex);
     
-    free(left_channel);
-    free(right_channel);
+    for (size_t offset = 0; offset < samples && result == MICARRAY_SUCCESS; offset += ctx->buffer_frames) {
+        size_t frames = samples - offset;
+        if (frames > ctx->buffer_frames) {
+            frames = ctx->buffer_frames;
+        }
+        
+        audio_output_render_localized(audio_data + offset, ctx->output_buffer, frames, location, ctx->config.volume);
+        result = write_output_buffer(ctx, frames);
+    }
+    
+    pthread_mutex_unlock(&ctx->mutex);
     
     return result;
 }
@@ -326,6 +412,21 @@ int audio_output_set_volume(audio_output_context_t *ctx, float volume) {
     return MICARRAY_SUCCESS;
 }
 
+int audio_output_set_playback_callback(audio_output_context_t *ctx,
+                                       void (*callback)(const int16_t *stereo, size_t frames, void *user_data),
+                                       void *user_data) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&ctx->mutex);
+    ctx->playback_callback = callback;
+    ctx->playback_user_data = user_data;
+    pthread_mutex_unlock(&ctx->mutex);
+    
+    return MICARRAY_SUCCESS;
+}
+
 int audio_output_get_latency(audio_output_context_t *ctx) {
     if (!ctx) {
         return -1;
@@ -25,9 +25,30 @@ int audio_output_stop(audio_output_context_t *ctx);
 int audio_output_cleanup(audio_output_context_t *ctx);
 
 int audio_output_write_stereo(audio_output_context_t *ctx, int16_t *left_channel, int16_t *right_channel, size_t samples);
+/* Writes frames of config.channels interleaved samples that are already
+ * rendered and scaled; the volume is not applied again. */
+int audio_output_write_interleaved(audio_output_context_t *ctx, const int16_t *data, size_t frames);
+
+/* Zero-copy write: acquire returns the device buffer and clamps *frames to
+ * its size, the caller fills that many interleaved frames and commit
+ * writes them. The output is locked from acquire until commit. */
+int16_t* audio_output_acquire(audio_output_context_t *ctx, size_t *frames);
+int audio_output_commit(audio_output_context_t *ctx, size_t frames);
 int audio_output_write_localized(audio_output_context_t *ctx, int16_t *audio_data, size_t samples, const sound_location_t *location);
 
+/* Gain-pans mono_data into interleaved stereo_out (2 * samples values)
+ * without touching a device; used by write_localized. The library itself
+ * renders through the ITD/ILD panner in panner.h. */
+void audio_output_render_localized(const int16_t *mono_data, int16_t *stereo_out, size_t samples, 
+                                   const sound_location_t *location, float volume);
+
 int audio_output_set_volume(audio_output_context_t *ctx, float volume);
+
+/* Called with the interleaved frames the device accepted, right after each
+ * write; the echo canceller uses it as its playback reference. */
+int audio_output_set_playback_callback(audio_output_context_t *ctx,
+                                       void (*callback)(const int16_t *stereo, size_t frames, void *user_data),
+                                       void *user_data);
 int audio_output_get_latency(audio_output_context_t *ctx);
 
 bool audio_output_is_running(audio_output_context_t *ctx);
@@ -0,0 +1,388 @@
+#define _GNU_SOURCE
+#include "beam_output.h"
+#include "audio_output.h"
+#include "wav.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#define BEAM_WAKE_NS 50000000L
+
+struct beam_output_context {
+    beam_output_config_t config;
+    
+    audio_output_context_t *audio_ctx;
+    
+    int fd;
+    
+    beam_ring_header_t *ring;
+    int16_t *ring_data;
+    size_t ring_size;
+    
+    /* File sink: the processing thread fills the queue, frame n in slot
+     * n % queue_frames, and a writer thread drains it, so the audio path
+     * never waits on the disk. Frames that find the queue full are
+     * dropped and counted. */
+    int16_t *queue;
+    uint64_t queue_frames;
+    uint64_t write_frames;
+    uint64_t read_frames;
+    uint64_t dropped_frames;
+    uint64_t data_bytes;
+    int write_errors;
+    
+    bool shutdown;
+    bool writer_started;
+    pthread_t writer;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+static int write_all(int fd, const void *data, size_t bytes) {
+    const uint8_t *p = data;
+    while (bytes > 0) {
+        ssize_t written = write(fd, p, bytes);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += written;
+        bytes -= written;
+    }
+    return 0;
+}
+
+static int open_alsa(beam_output_context_t *ctx) {
+    audio_output_config_t audio_config = {
+        .sample_rate = ctx->config.sample_rate,
+        .channels = ctx->config.channels,
+        .bits_per_sample = 16,
+        .buffer_size = ctx->config.block_frames,
+        .volume = 1.0f
+    };
+    const char *device = ctx->config.target[0] ? ctx->config.target : "default";
+    size_t length = strlen(device);
+    if (length >= sizeof(audio_config.device_name)) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    memcpy(audio_config.device_name, device, length + 1);
+    
+    int result = audio_output_init(&ctx->audio_ctx, &audio_config);
+    if (result != MICARRAY_SUCCESS) {
+        return result;
+    }
+    
+    return audio_output_start(ctx->audio_ctx);
+}
+
+/* Writes everything queued so far with one gathered write, which wraps
+ * at most once, then hands the slots back. A failed write drops the
+ * frames so the queue keeps moving. */
+static void drain_queue(beam_output_context_t *ctx) {
+    const size_t frame_bytes = (size_t)ctx->config.channels * sizeof(int16_t);
+    uint64_t head = __atomic_load_n(&ctx->write_frames, __ATOMIC_ACQUIRE);
+    uint64_t count = head - ctx->read_frames;
+    if (count == 0) {
+        return;
+    }
+    
+    uint64_t start = ctx->read_frames % ctx->queue_frames;
+    uint64_t first = count < ctx->queue_frames - start ? count : ctx->queue_frames - start;
+    struct iovec iov[2] = {
+        { ctx->queue + start * ctx->config.channels, first * frame_bytes },
+        { ctx->queue, (count - first) * frame_bytes }
+    };
+    int iovcnt = count > first ? 2 : 1;
+    
+    size_t remaining = count * frame_bytes;
+    while (remaining > 0) {
+        ssize_t written = writev(ctx->fd, iov, iovcnt);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        
+        remaining -= written;
+        for (int i = 0; i < iovcnt && written > 0; i++) {
+            size_t used = (size_t)written < iov[i].iov_len ? (size_t)written : iov[i].iov_len;
+            iov[i].iov_base = (uint8_t*)iov[i].iov_base + used;
+            iov[i].iov_len -= used;
+            written -= used;
+        }
+    }
+    
+    if (remaining > 0) {
+        ctx->write_errors++;
+        __atomic_add_fetch(&ctx->dropped_frames, remaining / frame_bytes, __ATOMIC_RELAXED);
+    }
+    ctx->data_bytes += count * frame_bytes - remaining;
+    __atomic_store_n(&ctx->read_frames, head, __ATOMIC_RELEASE);
+}
+
+static void* writer_thread_func(void *arg) {
+    beam_output_context_t *ctx = (beam_output_context_t*)arg;
+    
+    pthread_mutex_lock(&ctx->mutex);
+    while (!ctx->shutdown) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += BEAM_WAKE_NS;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_nsec -= 1000000000L;
+            deadline.tv_sec++;
+        }
+        pthread_cond_timedwait(&ctx->cond, &ctx->mutex, &deadline);
+        
+        pthread_mutex_unlock(&ctx->mutex);
+        drain_queue(ctx);
+        pthread_mutex_lock(&ctx->mutex);
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+    
+    drain_queue(ctx);
+    return NULL;
+}
+
+/* The queue holds ring_frames, and at least a second so a slow disk is
+ * ridden out rather than dropped. */
+static int open_file(beam_output_context_t *ctx) {
+    ctx->queue_frames = (uint64_t)ctx->config.sample_rate + ctx->config.block_frames;
+    if ((uint64_t)ctx->config.ring_frames > ctx->queue_frames) {
+        ctx->queue_frames = (uint64_t)ctx->config.ring_frames;
+    }
+    ctx->queue = malloc(ctx->queue_frames * ctx->config.channels * sizeof(int16_t));
+    if (!ctx->queue) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    ctx->fd = open(ctx->config.target, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (ctx->fd < 0) {
+        return MICARRAY_ERROR_AUDIO_OUTPUT;
+    }
+    
+    uint8_t header[WAV_HEADER_SIZE];
+    wav_build_header(header, sizeof(header), ctx->config.channels, ctx->config.sample_rate, 0);
+    if (write_all(ctx->fd, header, sizeof(header)) != 0) {
+        return MICARRAY_ERROR_AUDIO_OUTPUT;
+    }
+    
+    if (pthread_mutex_init(&ctx->mutex, NULL) != 0) {
+        return MICARRAY_ERROR_INIT;
+    }
+    if (pthread_cond_init(&ctx->cond, NULL) != 0) {
+        pthread_mutex_destroy(&ctx->mutex);
+        return MICARRAY_ERROR_INIT;
+    }
+    if (pthread_create(&ctx->writer, NULL, writer_thread_func, ctx) != 0) {
+        pthread_cond_destroy(&ctx->cond);
+        pthread_mutex_destroy(&ctx->mutex);
+        return MICARRAY_ERROR_INIT;
+    }
+    ctx->writer_started = true;
+    
+    return MICARRAY_SUCCESS;
+}
+
+static int open_ring(beam_output_context_t *ctx) {
+    if (ctx->config.ring_frames < ctx->config.block_frames) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    ctx->fd = shm_open(ctx->config.target, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (ctx->fd < 0) {
+        return MICARRAY_ERROR_AUDIO_OUTPUT;
+    }
+    
+    ctx->ring_size = sizeof(beam_ring_header_t) +
+                     (size_t)ctx->config.ring_frames * ctx->config.channels * sizeof(int16_t);
+    if (ftruncate(ctx->fd, (off_t)ctx->ring_size) != 0) {
+        return MICARRAY_ERROR_AUDIO_OUTPUT;
+    }
+    
+    void *map = mmap(NULL, ctx->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, ctx->fd, 0);
+    if (map == MAP_FAILED) {
+        return MICARRAY_ERROR_AUDIO_OUTPUT;
+    }
+    
+    ctx->ring = map;
+    ctx->ring_data = (int16_t*)(ctx->ring + 1);
+    
+    /* A reader attached to an older ring sees the counter restart before
+     * the new geometry, never samples in the old layout past its count. */
+    __atomic_store_n(&ctx->ring->write_frames, 0, __ATOMIC_RELEASE);
+    ctx->ring->channels = (uint32_t)ctx->config.channels;
+    ctx->ring->sample_rate = (uint32_t)ctx->config.sample_rate;
+    ctx->ring->capacity = (uint32_t)ctx->config.ring_frames;
+    ctx->ring->reserved = 0;
+    memcpy(ctx->ring->magic, BEAM_RING_MAGIC, sizeof(ctx->ring->magic));
+    
+    return MICARRAY_SUCCESS;
+}
+
+int beam_output_init(beam_output_context_t **ctx, const beam_output_config_t *config) {
+    if (!ctx || !config || config->channels < 1 || config->sample_rate <= 0 ||
+        config->block_frames < 1 || config->block_frames > MAX_BUFFER_SIZE) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (config->sink != BEAM_SINK_ALSA && config->target[0] == '\0') {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(beam_output_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    (*ctx)->config = *config;
+    (*ctx)->fd = -1;
+    
+    int result;
+    switch (config->sink) {
+        case BEAM_SINK_ALSA:
+            result = open_alsa(*ctx);
+            break;
+        case BEAM_SINK_FILE:
+            result = open_file(*ctx);
+            break;
+        case BEAM_SINK_SHM:
+            result = open_ring(*ctx);
+            break;
+        default:
+            result = MICARRAY_ERROR_INVALID_PARAM;
+            break;
+    }
+    
+    if (result != MICARRAY_SUCCESS) {
+        beam_output_cleanup(*ctx);
+        *ctx = NULL;
+    }
+    
+    return result;
+}
+
+int beam_output_cleanup(beam_output_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    int result = MICARRAY_SUCCESS;
+    
+    if (ctx->writer_started) {
+        pthread_mutex_lock(&ctx->mutex);
+        ctx->shutdown = true;
+        pthread_cond_signal(&ctx->cond);
+        pthread_mutex_unlock(&ctx->mutex);
+        pthread_join(ctx->writer, NULL);
+        
+        pthread_cond_destroy(&ctx->cond);
+        pthread_mutex_destroy(&ctx->mutex);
+        if (ctx->write_errors > 0) {
+            result = MICARRAY_ERROR_AUDIO_OUTPUT;
+        }
+    }
+    
+    if (ctx->audio_ctx) {
+        audio_output_stop(ctx->audio_ctx);
+        audio_output_cleanup(ctx->audio_ctx);
+    }
+    
+    if (ctx->ring) {
+        munmap(ctx->ring, ctx->ring_size);
+    }
+    
+    if (ctx->fd >= 0) {
+        if (ctx->config.sink == BEAM_SINK_FILE) {
+            uint8_t header[WAV_HEADER_SIZE];
+            wav_build_header(header, sizeof(header), ctx->config.channels, ctx->config.sample_rate, ctx->data_bytes);
+            if (pwrite(ctx->fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+                result = MICARRAY_ERROR_AUDIO_OUTPUT;
+            }
+        }
+        close(ctx->fd);
+    }
+    
+    free(ctx->queue);
+    free(ctx);
+    
+    return result;
+}
+
+int16_t* beam_output_acquire(beam_output_context_t *ctx, size_t *frames) {
+    if (!ctx || !frames) {
+        return NULL;
+    }
+    
+    if (*frames > (size_t)ctx->config.block_frames) {
+        *frames = ctx->config.block_frames;
+    }
+    
+    switch (ctx->config.sink) {
+        case BEAM_SINK_ALSA:
+            return audio_output_acquire(ctx->audio_ctx, frames);
+        case BEAM_SINK_FILE: {
+            uint64_t used = ctx->write_frames - __atomic_load_n(&ctx->read_frames, __ATOMIC_ACQUIRE);
+            size_t position = ctx->write_frames % ctx->queue_frames;
+            size_t space = ctx->queue_frames - used;
+            if (space > ctx->queue_frames - position) {
+                space = ctx->queue_frames - position;
+            }
+            if (space == 0) {
+                __atomic_add_fetch(&ctx->dropped_frames, *frames, __ATOMIC_RELAXED);
+                return NULL;
+            }
+            if (*frames > space) {
+                *frames = space;
+            }
+            return ctx->queue + position * ctx->config.channels;
+        }
+        case BEAM_SINK_SHM: {
+            size_t position = ctx->ring->write_frames % ctx->config.ring_frames;
+            if (*frames > ctx->config.ring_frames - position) {
+                *frames = ctx->config.ring_frames - position;
+            }
+            return ctx->ring_data + position * ctx->config.channels;
+        }
+    }
+    
+    return NULL;
+}
+
+int beam_output_commit(beam_output_context_t *ctx, size_t frames) {
+    if (!ctx || frames > (size_t)ctx->config.block_frames) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    switch (ctx->config.sink) {
+        case BEAM_SINK_ALSA:
+            return audio_output_commit(ctx->audio_ctx, frames);
+        case BEAM_SINK_FILE:
+            __atomic_store_n(&ctx->write_frames, ctx->write_frames + frames, __ATOMIC_RELEASE);
+            return MICARRAY_SUCCESS;
+        case BEAM_SINK_SHM:
+            __atomic_store_n(&ctx->ring->write_frames, ctx->ring->write_frames + frames, __ATOMIC_RELEASE);
+            return MICARRAY_SUCCESS;
+    }
+    
+    return MICARRAY_ERROR_INVALID_PARAM;
+}
+
+int beam_output_get_dropped(beam_output_context_t *ctx, uint64_t *frames) {
+    if (!ctx || !frames) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *frames = __atomic_load_n(&ctx->dropped_frames, __ATOMIC_RELAXED);
+    return MICARRAY_SUCCESS;
+}
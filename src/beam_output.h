@@ -0,0 +1,66 @@
+#ifndef BEAM_OUTPUT_H
+#define BEAM_OUTPUT_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BEAM_RING_MAGIC "MICBEAM1"
+
+typedef enum {
+    BEAM_SINK_ALSA = 0,
+    BEAM_SINK_FILE,
+    BEAM_SINK_SHM
+} beam_sink_t;
+
+typedef struct beam_output_context beam_output_context_t;
+
+/* target is the ALSA device, the WAV file path or the shared-memory object
+ * name ("/name"). ring_frames sizes the shared-memory ring, and the queue
+ * the file sink's writer thread drains (at least a second). */
+typedef struct {
+    beam_sink_t sink;
+    char target[256];
+    int channels;
+    int sample_rate;
+    int block_frames;
+    int ring_frames;
+} beam_output_config_t;
+
+/* Layout of the shared-memory object: this header, then capacity frames of
+ * channels interleaved int16 samples. write_frames counts every frame ever
+ * committed and is stored with release order after the samples, so a
+ * reader that loads it with acquire order may read frame n from slot
+ * n % capacity until the writer laps it. */
+typedef struct {
+    char magic[8];
+    uint32_t channels;
+    uint32_t sample_rate;
+    uint32_t capacity;
+    uint32_t reserved;
+    uint64_t write_frames;
+} beam_ring_header_t;
+
+int beam_output_init(beam_output_context_t **ctx, const beam_output_config_t *config);
+int beam_output_cleanup(beam_output_context_t *ctx);
+
+/* Returns where the next frames go, interleaved by channel, and reduces
+ * *frames to what fits there contiguously (never more than block_frames).
+ * Fill that many frames and pass the count to commit; a caller with more
+ * to write loops. Returns NULL when the sink cannot take data, in which
+ * case commit must not be called. */
+int16_t* beam_output_acquire(beam_output_context_t *ctx, size_t *frames);
+int beam_output_commit(beam_output_context_t *ctx, size_t frames);
+
+/* Frames the file sink dropped because its writer fell a whole queue
+ * behind or the disk refused them; always 0 for the other sinks. */
+int beam_output_get_dropped(beam_output_context_t *ctx, uint64_t *frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
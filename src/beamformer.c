@@ -0,0 +1,281 @@
+#define _GNU_SOURCE
+#include "beamformer.h"
+#include "simd.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef struct {
+    float delay[MAX_MICROPHONES];
+    float target[MAX_MICROPHONES];
+} beam_t;
+
+typedef void (*steady_sum_fn)(beamformer_context_t *ctx, const beam_t *beam, size_t frames);
+
+struct beamformer_context {
+    beamformer_config_t config;
+    microphone_position_t positions[MAX_MICROPHONES];
+    float radius;
+    
+    /* Per microphone, the last `history` samples followed by the current
+     * block, as in the panner. Every beam reads from the same lines. */
+    float *lines[MAX_MICROPHONES];
+    int history;
+    
+    float *sum;
+    beam_t beams[MAX_BEAMS];
+    steady_sum_fn steady_sum;
+};
+
+/* Delays that line a plane wave from direction (ux, uy, uz) up across the
+ * array: the microphone nearest the source waits longest. All delays are
+ * within [0, 2 * radius / c]. */
+static void compute_delays(const beamformer_context_t *ctx, float ux, float uy, float uz, float *delays) {
+    const float scale = ctx->config.sample_rate / ctx->config.speed_of_sound;
+    for (int m = 0; m < ctx->config.num_microphones; m++) {
+        const microphone_position_t *p = &ctx->positions[m];
+        delays[m] = (ctx->radius + p->x * ux + p->y * uy + p->z * uz) * scale;
+    }
+}
+
+static inline float4_t load4(const float *p) {
+    float4_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline int16_t to_sample(float value) {
+    value += (value < 0.0f) ? -0.5f : 0.5f;
+    value = fmaxf(-32768.0f, fminf(32767.0f, value));
+    return (int16_t)value;
+}
+
+/* Adds one microphone to the beam sum. A steady delay is a fixed two-tap
+ * interpolation and runs a vector at a time; a moving one is resolved per
+ * sample, as in the panner. */
+static void accumulate(const float *x, float *sum, float delay0, float delay1, size_t frames) {
+    size_t j = 0;
+    
+    if (delay0 == delay1) {
+        const int whole = (int)delay1;
+        const float frac = delay1 - whole;
+        for (; j + SIMD_LANES <= frames; j += SIMD_LANES) {
+            float4_t a = load4(x + j - whole);
+            float4_t b = load4(x + j - whole - 1);
+            float4_t acc;
+            memcpy(&acc, sum + j, sizeof(acc));
+            acc += a + frac * (b - a);
+            memcpy(sum + j, &acc, sizeof(acc));
+        }
+    }
+    
+    const float step = (delay1 - delay0) / frames;
+    for (; j < frames; j++) {
+        float delay = delay0 + step * (j + 1);
+        int whole = (int)delay;
+        float frac = delay - whole;
+        float a = x[(long)j - whole];
+        float b = x[(long)j - whole - 1];
+        sum[j] += a + frac * (b - a);
+    }
+}
+
+/* The whole beam in one pass when every microphone is active and none is
+ * moving, so the sum stays in a register instead of being reloaded once
+ * per microphone. Adds in the same order as accumulate(), so the result is
+ * the same. Called with a constant count the microphone loop unrolls. */
+static inline __attribute__((always_inline))
+void sum_steady(beamformer_context_t *ctx, const beam_t *beam, size_t frames, const int mics) {
+    const float *x[MAX_MICROPHONES];
+    float frac[MAX_MICROPHONES];
+    for (int m = 0; m < mics; m++) {
+        const int whole = (int)beam->target[m];
+        x[m] = ctx->lines[m] + ctx->history - whole;
+        frac[m] = beam->target[m] - whole;
+    }
+    
+    float *sum = ctx->sum;
+    size_t j = 0;
+    for (; j + SIMD_LANES <= frames; j += SIMD_LANES) {
+        float4_t acc = {0.0f, 0.0f, 0.0f, 0.0f};
+#pragma GCC unroll 8
+        for (int m = 0; m < mics; m++) {
+            float4_t a = load4(x[m] + j);
+            float4_t b = load4(x[m] + j - 1);
+            acc += a + frac[m] * (b - a);
+        }
+        memcpy(sum + j, &acc, sizeof(acc));
+    }
+    for (; j < frames; j++) {
+        float acc = 0.0f;
+        for (int m = 0; m < mics; m++) {
+            float a = x[m][j];
+            float b = x[m][(long)j - 1];
+            acc += a + frac[m] * (b - a);
+        }
+        sum[j] = acc;
+    }
+}
+
+static void sum_steady_4(beamformer_context_t *ctx, const beam_t *beam, size_t frames) {
+    sum_steady(ctx, beam, frames, 4);
+}
+
+static void sum_steady_8(beamformer_context_t *ctx, const beam_t *beam, size_t frames) {
+    sum_steady(ctx, beam, frames, 8);
+}
+
+static bool is_steady(const beam_t *beam, int mics) {
+    for (int m = 0; m < mics; m++) {
+        if (beam->delay[m] != beam->target[m]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int beamformer_init(beamformer_context_t **ctx, const beamformer_config_t *config) {
+    if (!ctx || !config || !config->mic_positions || config->num_microphones < 1 ||
+        config->num_microphones > MAX_MICROPHONES || config->sample_rate <= 0 ||
+        config->speed_of_sound <= 0.0f || config->num_beams < 1 || config->num_beams > MAX_BEAMS) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(beamformer_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    (*ctx)->config = *config;
+    memcpy((*ctx)->positions, config->mic_positions, config->num_microphones * sizeof(microphone_position_t));
+    (*ctx)->config.mic_positions = (*ctx)->positions;
+    
+    for (int m = 0; m < config->num_microphones; m++) {
+        const microphone_position_t *p = &config->mic_positions[m];
+        float r = sqrtf(p->x * p->x + p->y * p->y + p->z * p->z);
+        if (r > (*ctx)->radius) {
+            (*ctx)->radius = r;
+        }
+    }
+    
+    /* The widest spread plus the sample the interpolation reads past the
+     * integer delay. */
+    int history = (int)ceilf(2.0f * (*ctx)->radius / config->speed_of_sound * config->sample_rate) + 2;
+    (*ctx)->history = (history + SIMD_LANES - 1) / SIMD_LANES * SIMD_LANES;
+    
+    (*ctx)->sum = (float*)simd_alloc(MAX_BUFFER_SIZE / SIMD_LANES);
+    if (!(*ctx)->sum) {
+        beamformer_cleanup(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    for (int m = 0; m < config->num_microphones; m++) {
+        (*ctx)->lines[m] = (float*)simd_alloc(((*ctx)->history + MAX_BUFFER_SIZE) / SIMD_LANES);
+        if (!(*ctx)->lines[m]) {
+            beamformer_cleanup(*ctx);
+            *ctx = NULL;
+            return MICARRAY_ERROR_MEMORY;
+        }
+    }
+    
+    /* Until steered, beams face evenly spaced azimuths on the horizon. */
+    for (int b = 0; b < config->num_beams; b++) {
+        float azimuth = 2.0f * (float)M_PI * b / config->num_beams;
+        beam_t *beam = &(*ctx)->beams[b];
+        compute_delays(*ctx, cosf(azimuth), sinf(azimuth), 0.0f, beam->target);
+        memcpy(beam->delay, beam->target, sizeof(beam->delay));
+    }
+    
+    if (!config->generic && config->num_microphones == 4) {
+        (*ctx)->steady_sum = sum_steady_4;
+    } else if (!config->generic && config->num_microphones == 8) {
+        (*ctx)->steady_sum = sum_steady_8;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int beamformer_cleanup(beamformer_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    for (int m = 0; m < MAX_MICROPHONES; m++) {
+        free(ctx->lines[m]);
+    }
+    free(ctx->sum);
+    free(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int beamformer_steer(beamformer_context_t *ctx, int beam, const sound_location_t *target) {
+    if (!ctx || !target || beam < 0 || beam >= ctx->config.num_beams) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    float norm = sqrtf(target->x * target->x + target->y * target->y + target->z * target->z);
+    if (norm > 0.0f) {
+        compute_delays(ctx, target->x / norm, target->y / norm, target->z / norm, ctx->beams[beam].target);
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int beamformer_process(beamformer_context_t *ctx, int16_t *const *channels, size_t frames,
+                       uint32_t active_mask, int16_t *out, size_t stride) {
+    if (!ctx || !channels || !out || frames == 0 || frames > MAX_BUFFER_SIZE ||
+        stride < (size_t)ctx->config.num_beams) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    const int mics = ctx->config.num_microphones;
+    int active = 0;
+    for (int m = 0; m < mics; m++) {
+        if (!(active_mask & (1u << m))) {
+            continue;
+        }
+        float *x = ctx->lines[m] + ctx->history;
+        for (size_t j = 0; j < frames; j++) {
+            x[j] = channels[m][j];
+        }
+        active++;
+    }
+    
+    const float gain = active > 0 ? 1.0f / active : 0.0f;
+    for (int b = 0; b < ctx->config.num_beams; b++) {
+        beam_t *beam = &ctx->beams[b];
+        
+        if (ctx->steady_sum && active == mics && is_steady(beam, mics)) {
+            ctx->steady_sum(ctx, beam, frames);
+        } else {
+            memset(ctx->sum, 0, frames * sizeof(float));
+            for (int m = 0; m < mics; m++) {
+                if (active_mask & (1u << m)) {
+                    accumulate(ctx->lines[m] + ctx->history, ctx->sum, beam->delay[m], beam->target[m], frames);
+                }
+            }
+        }
+        memcpy(beam->delay, beam->target, sizeof(beam->delay));
+        
+        for (size_t j = 0; j < frames; j++) {
+            out[j * stride + b] = to_sample(ctx->sum[j] * gain);
+        }
+    }
+    
+    /* Inactive channels keep their old history; it is not read until the
+     * channel returns, and a stale tail only lasts the few history frames. */
+    for (int m = 0; m < mics; m++) {
+        if (active_mask & (1u << m)) {
+            float *x = ctx->lines[m] + ctx->history;
+            memmove(ctx->lines[m], x + frames - ctx->history, ctx->history * sizeof(float));
+        }
+    }
+    
+    return MICARRAY_SUCCESS;
+}
@@ -0,0 +1,46 @@
+#ifndef BEAMFORMER_H
+#define BEAMFORMER_H
+
+#include "libmicarray.h"
+#include "localization.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct beamformer_context beamformer_context_t;
+
+typedef struct {
+    int num_microphones;
+    const microphone_position_t *mic_positions;
+    int sample_rate;
+    float speed_of_sound;
+    int num_beams;
+    
+    /* Arrays of 4 or 8 microphones sum a steady beam through a loop built
+     * for that count; generic keeps them on the per-microphone path. */
+    bool generic;
+} beamformer_config_t;
+
+int beamformer_init(beamformer_context_t **ctx, const beamformer_config_t *config);
+int beamformer_cleanup(beamformer_context_t *ctx);
+
+/* Points beam at the direction of target; the distance is ignored and a
+ * zero vector leaves the beam where it is. The new delays ramp in across
+ * the next beamformer_process() call. */
+int beamformer_steer(beamformer_context_t *ctx, int beam, const sound_location_t *target);
+
+/* Delay-and-sum of the channels in active_mask, frames up to
+ * MAX_BUFFER_SIZE. Beam b of frame j goes to out[j * stride + b], so the
+ * output can be written straight into an interleaved device or ring
+ * buffer. Each channel is converted once and shared by every beam. Does
+ * not allocate. */
+int beamformer_process(beamformer_context_t *ctx, int16_t *const *channels, size_t frames,
+                       uint32_t active_mask, int16_t *out, size_t stride);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,4 +1,5 @@
 #include "config.h"
+#include "kernels.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,6 +10,10 @@ static int parse_general_section(const char *key, const char *value, micarray_co
         strncpy(config->log_level, value, sizeof(config->log_level) - 1);
         config->log_level[sizeof(config->log_level) - 1] = '\0';
         return 0;
+    } else if (strcmp(key, "kernels") == 0) {
+        strncpy(config->kernels, value, sizeof(config->kernels) - 1);
+        config->kernels[sizeof(config->kernels) - 1] = '\0';
+        return 0;
     }
     return -1;
 }
@@ -33,6 +38,69 @@ static int parse_microphone_section(const char *key, const char *value, micarray
     } else if (strcmp(key, "sample_rate") == 0) {
         config->sample_rate = atoi(value);
         return 0;
+    } else if (strcmp(key, "health_monitor") == 0) {
+        config->health_monitor = (strcmp(value, "true") == 0);
+        return 0;
+    } else if (strcmp(key, "low_latency") == 0) {
+        config->low_latency = (strcmp(value, "true") == 0);
+        return 0;
+    } else if (strcmp(key, "hop_size") == 0) {
+        config->hop_size = atoi(value);
+        return 0;
+    }
+    return -1;
+}
+
+static int parse_prefilter_section(const char *key, const char *value, micarray_config_t *config) {
+    if (strcmp(key, "enable") == 0) {
+        config->prefilter_enable = (strcmp(value, "true") == 0);
+        return 0;
+    } else if (strcmp(key, "dc_removal") == 0) {
+        config->prefilter_dc_removal = (strcmp(value, "true") == 0);
+        return 0;
+    } else if (strcmp(key, "highpass") == 0) {
+        config->prefilter_highpass = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "lowpass") == 0) {
+        config->prefilter_lowpass = strtof(value, NULL);
+        return 0;
+    }
+    return -1;
+}
+
+static int parse_echo_cancellation_section(const char *key, const char *value, micarray_config_t *config) {
+    if (strcmp(key, "enable") == 0) {
+        config->aec_enable = (strcmp(value, "true") == 0);
+        return 0;
+    } else if (strcmp(key, "tail_ms") == 0) {
+        config->aec_tail_ms = atoi(value);
+        return 0;
+    } else if (strcmp(key, "step") == 0) {
+        config->aec_step = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "delay_ms") == 0) {
+        config->aec_delay_ms = atoi(value);
+        return 0;
+    }
+    return -1;
+}
+
+static int parse_dereverberation_section(const char *key, const char *value, micarray_config_t *config) {
+    if (strcmp(key, "enable") == 0) {
+        config->dereverb_enable = (strcmp(value, "true") == 0);
+        return 0;
+    } else if (strcmp(key, "order") == 0) {
+        config->dereverb_order = atoi(value);
+        return 0;
+    } else if (strcmp(key, "delay") == 0) {
+        config->dereverb_delay = atoi(value);
+        return 0;
+    } else if (strcmp(key, "frame_size") == 0) {
+        config->dereverb_frame_size = atoi(value);
+        return 0;
+    } else if (strcmp(key, "forgetting") == 0) {
+        config->dereverb_forgetting = strtof(value, NULL);
+        return 0;
     }
     return -1;
 }
@@ -48,6 +116,66 @@ static int parse_noise_reduction_section(const char *key, const char *value, mic
         strncpy(config->algorithm, value, sizeof(config->algorithm) - 1);
         config->algorithm[sizeof(config->algorithm) - 1] = '\0';
         return 0;
+    } else if (strcmp(key, "model") == 0) {
+        strncpy(config->nn_model, value, sizeof(config->nn_model) - 1);
+        config->nn_model[sizeof(config->nn_model) - 1] = '\0';
+        return 0;
+    }
+    return -1;
+}
+
+static int parse_agc_section(const char *key, const char *value, micarray_config_t *config) {
+    if (strcmp(key, "enable") == 0) {
+        config->agc_enable = (strcmp(value, "true") == 0);
+        return 0;
+    } else if (strcmp(key, "target_level_db") == 0) {
+        config->agc_target_db = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "max_gain_db") == 0) {
+        config->agc_max_gain_db = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "gate_db") == 0) {
+        config->agc_gate_db = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "attack_ms") == 0) {
+        config->agc_attack_ms = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "release_ms") == 0) {
+        config->agc_release_ms = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "limiter_ceiling_db") == 0) {
+        config->agc_ceiling_db = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "lookahead_ms") == 0) {
+        config->agc_lookahead_ms = strtof(value, NULL);
+        return 0;
+    }
+    return -1;
+}
+
+static int parse_localization_section(const char *key, const char *value, micarray_config_t *config) {
+    if (strcmp(key, "rate") == 0) {
+        config->localization_rate = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "window") == 0) {
+        config->localization_window = atoi(value);
+        return 0;
+    } else if (strcmp(key, "method") == 0) {
+        strncpy(config->localization_method, value, sizeof(config->localization_method) - 1);
+        config->localization_method[sizeof(config->localization_method) - 1] = '\0';
+        return 0;
+    } else if (strcmp(key, "smoothing") == 0) {
+        config->localization_smoothing = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "band_low") == 0) {
+        config->localization_band_low = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "band_high") == 0) {
+        config->localization_band_high = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "max_bins") == 0) {
+        config->localization_max_bins = atoi(value);
+        return 0;
     }
     return -1;
 }
@@ -60,6 +188,73 @@ static int parse_audio_output_section(const char *key, const char *value, micarr
     } else if (strcmp(key, "volume") == 0) {
         config->volume = strtof(value, NULL);
         return 0;
+    } else if (strcmp(key, "renderer") == 0) {
+        strncpy(config->output_renderer, value, sizeof(config->output_renderer) - 1);
+        config->output_renderer[sizeof(config->output_renderer) - 1] = '\0';
+        return 0;
+    } else if (strcmp(key, "hrtf_file") == 0) {
+        strncpy(config->hrtf_file, value, sizeof(config->hrtf_file) - 1);
+        config->hrtf_file[sizeof(config->hrtf_file) - 1] = '\0';
+        return 0;
+    }
+    return -1;
+}
+
+static int parse_beam_output_section(const char *key, const char *value, micarray_config_t *config) {
+    if (strcmp(key, "enable") == 0) {
+        config->beam_enable = (strcmp(value, "true") == 0);
+        return 0;
+    } else if (strcmp(key, "beams") == 0) {
+        config->beam_count = atoi(value);
+        return 0;
+    } else if (strcmp(key, "sink") == 0) {
+        strncpy(config->beam_sink, value, sizeof(config->beam_sink) - 1);
+        config->beam_sink[sizeof(config->beam_sink) - 1] = '\0';
+        return 0;
+    } else if (strcmp(key, "target") == 0) {
+        strncpy(config->beam_target, value, sizeof(config->beam_target) - 1);
+        config->beam_target[sizeof(config->beam_target) - 1] = '\0';
+        return 0;
+    } else if (strcmp(key, "ring_ms") == 0) {
+        config->beam_ring_ms = atoi(value);
+        return 0;
+    }
+    return -1;
+}
+
+static int parse_recorder_section(const char *key, const char *value, micarray_config_t *config) {
+    if (strcmp(key, "enable") == 0) {
+        config->recorder_enable = (strcmp(value, "true") == 0);
+        return 0;
+    } else if (strcmp(key, "directory") == 0) {
+        strncpy(config->recorder_directory, value, sizeof(config->recorder_directory) - 1);
+        config->recorder_directory[sizeof(config->recorder_directory) - 1] = '\0';
+        return 0;
+    } else if (strcmp(key, "format") == 0) {
+        strncpy(config->recorder_format, value, sizeof(config->recorder_format) - 1);
+        config->recorder_format[sizeof(config->recorder_format) - 1] = '\0';
+        return 0;
+    } else if (strcmp(key, "pre_trigger_ms") == 0) {
+        config->recorder_pre_ms = atoi(value);
+        return 0;
+    } else if (strcmp(key, "post_trigger_ms") == 0) {
+        config->recorder_post_ms = atoi(value);
+        return 0;
+    } else if (strcmp(key, "trigger_level_db") == 0) {
+        config->recorder_trigger_db = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "trigger_confidence") == 0) {
+        config->recorder_trigger_confidence = strtof(value, NULL);
+        return 0;
+    }
+    return -1;
+}
+
+static int parse_pipeline_section(const char *key, const char *value, micarray_config_t *config) {
+    if (strcmp(key, "stages") == 0) {
+        strncpy(config->pipeline_stages, value, sizeof(config->pipeline_stages) - 1);
+        config->pipeline_stages[sizeof(config->pipeline_stages) - 1] = '\0';
+        return 0;
     }
     return -1;
 }
@@ -72,6 +267,12 @@ static int parse_logging_section(const char *key, const char *value, micarray_co
         strncpy(config->log_file, value, sizeof(config->log_file) - 1);
         config->log_file[sizeof(config->log_file) - 1] = '\0';
         return 0;
+    } else if (strcmp(key, "metrics_rate") == 0) {
+        config->metrics_rate = strtof(value, NULL);
+        return 0;
+    } else if (strcmp(key, "perf_counters") == 0) {
+        config->perf_counters = (strcmp(value, "true") == 0);
+        return 0;
     }
     return -1;
 }
@@ -140,10 +341,26 @@ int config_parse_file(const char *filename, micarray_config_t *config) {
             result = parse_general_section(key, value, config);
         } else if (strcmp(current_section, "MicrophoneArray") == 0) {
             result = parse_microphone_section(key, value, config);
+        } else if (strcmp(current_section, "PreFilter") == 0) {
+            result = parse_prefilter_section(key, value, config);
+        } else if (strcmp(current_section, "EchoCancellation") == 0) {
+            result = parse_echo_cancellation_section(key, value, config);
+        } else if (strcmp(current_section, "Dereverberation") == 0) {
+            result = parse_dereverberation_section(key, value, config);
         } else if (strcmp(current_section, "NoiseReduction") == 0) {
             result = parse_noise_reduction_section(key, value, config);
+        } else if (strcmp(current_section, "AGC") == 0) {
+            result = parse_agc_section(key, value, config);
+        } else if (strcmp(current_section, "Localization") == 0) {
+            result = parse_localization_section(key, value, config);
         } else if (strcmp(current_section, "AudioOutput") == 0) {
             result = parse_audio_output_section(key, value, config);
+        } else if (strcmp(current_section, "BeamOutput") == 0) {
+            result = parse_beam_output_section(key, value, config);
+        } else if (strcmp(current_section, "Recorder") == 0) {
+            result = parse_recorder_section(key, value, config);
+        } else if (strcmp(current_section, "Pipeline") == 0) {
+            result = parse_pipeline_section(key, value, config);
         } else if (strcmp(current_section, "Logging") == 0) {
             result = parse_logging_section(key, value, config);
         }
@@ -165,14 +382,64 @@ int config_set_defaults(micarray_config_t *config) {
     config->i2s_bus = 1;
     config->dma_buffer_size = 1024;
     config->sample_rate = DEFAULT_SAMPLE_RATE;
+    config->health_monitor = true;
+    config->low_latency = false;
+    config->hop_size = DEFAULT_HOP_SIZE;
+    config->localization_rate = 0.0f;
+    config->localization_window = 0;
+    strcpy(config->localization_method, "gcc_phat");
+    config->localization_smoothing = 0.0f;
+    config->localization_band_low = 300.0f;
+    config->localization_band_high = 0.0f;
+    config->localization_max_bins = 64;
+    config->prefilter_enable = true;
+    config->prefilter_dc_removal = true;
+    config->prefilter_highpass = 80.0f;
+    config->prefilter_lowpass = 0.0f;
+    config->aec_enable = false;
+    config->aec_tail_ms = 64;
+    config->aec_step = 0.5f;
+    config->aec_delay_ms = -1;
+    config->dereverb_enable = false;
+    config->dereverb_order = 4;
+    config->dereverb_delay = 2;
+    config->dereverb_frame_size = 512;
+    config->dereverb_forgetting = 0.99f;
     config->noise_reduction_enable = true;
     config->noise_threshold = 0.05f;
     strcpy(config->algorithm, "spectral_subtraction");
+    config->nn_model[0] = '\0';
+    config->agc_enable = false;
+    config->agc_target_db = -20.0f;
+    config->agc_max_gain_db = 18.0f;
+    config->agc_gate_db = -55.0f;
+    config->agc_attack_ms = 20.0f;
+    config->agc_release_ms = 500.0f;
+    config->agc_ceiling_db = -1.0f;
+    config->agc_lookahead_ms = 5.0f;
     strcpy(config->output_device, "headphones");
     config->volume = 0.8f;
+    strcpy(config->output_renderer, "pan");
+    config->hrtf_file[0] = '\0';
+    config->beam_enable = false;
+    config->beam_count = 2;
+    strcpy(config->beam_sink, "file");
+    strcpy(config->beam_target, "beams.wav");
+    config->beam_ring_ms = 2000;
+    config->recorder_enable = false;
+    strcpy(config->recorder_directory, "/var/lib/micarray");
+    strcpy(config->recorder_format, "wav");
+    config->recorder_pre_ms = 5000;
+    config->recorder_post_ms = 10000;
+    config->recorder_trigger_db = 0.0f;
+    config->recorder_trigger_confidence = 0.0f;
+    strcpy(config->pipeline_stages, MICARRAY_DEFAULT_STAGES);
     config->enable_serial_logging = true;
     strcpy(config->log_file, "/var/log/micarray.log");
     strcpy(config->log_level, "INFO");
+    strcpy(config->kernels, "auto");
+    config->metrics_rate = 1.0f;
+    config->perf_counters = false;
     
     return MICARRAY_SUCCESS;
 }
@@ -202,11 +469,212 @@ int config_validate(const micarray_config_t *config) {
         return MICARRAY_ERROR_CONFIG;
     }
     
+    if (config->low_latency && 
+        (config->hop_size < MIN_HOP_SIZE || config->hop_size > config->dma_buffer_size)) {
+        fprintf(stderr, "Invalid hop size: %d (must be %d-%d)\n", 
+                config->hop_size, MIN_HOP_SIZE, config->dma_buffer_size);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (config->localization_rate < 0.0f || config->localization_rate > config->sample_rate) {
+        fprintf(stderr, "Invalid localization rate: %f (must be 0-%d Hz)\n", 
+                config->localization_rate, config->sample_rate);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (config->localization_window != 0 && 
+        (config->localization_window < MIN_LOCALIZATION_WINDOW || 
+         config->localization_window > MAX_LOCALIZATION_WINDOW)) {
+        fprintf(stderr, "Invalid localization window: %d (must be %d-%d)\n", 
+                config->localization_window, MIN_LOCALIZATION_WINDOW, MAX_LOCALIZATION_WINDOW);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (config->localization_method[0] != '\0' && 
+        strcmp(config->localization_method, "gcc_phat") != 0 && 
+        strcmp(config->localization_method, "xcorr") != 0) {
+        fprintf(stderr, "Invalid localization method: %s (must be gcc_phat or xcorr)\n", 
+                config->localization_method);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (config->localization_smoothing < 0.0f || config->localization_smoothing > 1.0f) {
+        fprintf(stderr, "Invalid localization smoothing: %f (must be 0.0-1.0)\n", 
+                config->localization_smoothing);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (config->localization_band_low < 0.0f || 
+        config->localization_band_high > config->sample_rate / 2.0f || 
+        (config->localization_band_high > 0.0f && 
+         config->localization_band_high <= config->localization_band_low)) {
+        fprintf(stderr, "Invalid localization band: %.0f-%.0f Hz (must be within 0-%d Hz)\n", 
+                config->localization_band_low, config->localization_band_high, config->sample_rate / 2);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (config->localization_max_bins < 0) {
+        fprintf(stderr, "Invalid localization max bins: %d (must be >= 0)\n", 
+                config->localization_max_bins);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (config->prefilter_highpass < 0.0f || config->prefilter_highpass >= config->sample_rate / 2.0f ||
+        config->prefilter_lowpass < 0.0f || config->prefilter_lowpass >= config->sample_rate / 2.0f ||
+        (config->prefilter_lowpass > 0.0f && config->prefilter_lowpass <= config->prefilter_highpass)) {
+        fprintf(stderr, "Invalid pre-filter band: %.0f-%.0f Hz (must be within 0-%d Hz)\n", 
+                config->prefilter_highpass, config->prefilter_lowpass, config->sample_rate / 2);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (config->aec_enable) {
+        if (config->aec_tail_ms < 1 || config->aec_tail_ms > 1000) {
+            fprintf(stderr, "Invalid echo tail: %d ms (must be 1-1000)\n", config->aec_tail_ms);
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (config->aec_step <= 0.0f || config->aec_step > 1.0f) {
+            fprintf(stderr, "Invalid echo canceller step: %f (must be 0.0-1.0)\n", config->aec_step);
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (config->aec_delay_ms > 1000) {
+            fprintf(stderr, "Invalid echo delay: %d ms (must be at most 1000, or < 0 to measure)\n", 
+                    config->aec_delay_ms);
+            return MICARRAY_ERROR_CONFIG;
+        }
+    }
+    
+    if (config->noise_reduction_enable && strcmp(config->algorithm, "nn") == 0 && config->nn_model[0] == '\0') {
+        fprintf(stderr, "The nn noise reduction algorithm needs a model\n");
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (config->dereverb_enable) {
+        if (config->dereverb_frame_size < 64 || config->dereverb_frame_size > 2048 || 
+            (config->dereverb_frame_size & (config->dereverb_frame_size - 1)) != 0) {
+            fprintf(stderr, "Invalid dereverberation frame size: %d (must be a power of two, 64-2048)\n", 
+                    config->dereverb_frame_size);
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (config->dereverb_order < 1 || config->dereverb_order > 16 || 
+            config->dereverb_order * config->num_microphones > 64) {
+            fprintf(stderr, "Invalid dereverberation order: %d (must be 1-16 and at most 64 taps over %d microphones)\n", 
+                    config->dereverb_order, config->num_microphones);
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (config->dereverb_delay < 1 || config->dereverb_delay > 8) {
+            fprintf(stderr, "Invalid dereverberation delay: %d frames (must be 1-8)\n", config->dereverb_delay);
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (config->dereverb_forgetting < 0.9f || config->dereverb_forgetting >= 1.0f) {
+            fprintf(stderr, "Invalid dereverberation forgetting factor: %f (must be >= 0.9 and < 1.0)\n", 
+                    config->dereverb_forgetting);
+            return MICARRAY_ERROR_CONFIG;
+        }
+    }
+    
+    if (config->agc_enable) {
+        if (config->agc_target_db >= 0.0f || config->agc_ceiling_db > 0.0f || 
+            config->agc_target_db > config->agc_ceiling_db) {
+            fprintf(stderr, "Invalid AGC levels: target %.1f dB, ceiling %.1f dB (must be target <= ceiling <= 0)\n", 
+                    config->agc_target_db, config->agc_ceiling_db);
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (config->agc_max_gain_db < 0.0f || config->agc_max_gain_db > 60.0f) {
+            fprintf(stderr, "Invalid AGC max gain: %.1f dB (must be 0-60)\n", config->agc_max_gain_db);
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (config->agc_attack_ms < 0.0f || config->agc_release_ms < 0.0f || 
+            config->agc_lookahead_ms < 0.0f || config->agc_lookahead_ms > 20.0f) {
+            fprintf(stderr, "Invalid AGC timing: attack %.1f ms, release %.1f ms, look-ahead %.1f ms "
+                    "(must be >= 0, look-ahead at most 20)\n", 
+                    config->agc_attack_ms, config->agc_release_ms, config->agc_lookahead_ms);
+            return MICARRAY_ERROR_CONFIG;
+        }
+    }
+    
     if (config->volume < 0.0f || config->volume > 1.0f) {
         fprintf(stderr, "Invalid volume: %f (must be 0.0-1.0)\n", config->volume);
         return MICARRAY_ERROR_CONFIG;
     }
     
+    if (strcmp(config->output_renderer, "hrtf") == 0) {
+        if (config->hrtf_file[0] == '\0') {
+            fprintf(stderr, "The hrtf renderer needs an hrtf_file\n");
+            return MICARRAY_ERROR_CONFIG;
+        }
+    } else if (config->output_renderer[0] != '\0' && strcmp(config->output_renderer, "pan") != 0) {
+        fprintf(stderr, "Invalid output renderer: %s (must be pan or hrtf)\n", config->output_renderer);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (config->beam_enable) {
+        if (config->beam_count < 1 || config->beam_count > MAX_BEAMS) {
+            fprintf(stderr, "Invalid beam count: %d (must be 1-%d)\n", config->beam_count, MAX_BEAMS);
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (strcmp(config->beam_sink, "alsa") != 0 && strcmp(config->beam_sink, "file") != 0 && 
+            strcmp(config->beam_sink, "shm") != 0) {
+            fprintf(stderr, "Invalid beam sink: %s (must be alsa, file or shm)\n", config->beam_sink);
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (strcmp(config->beam_sink, "alsa") != 0 && config->beam_target[0] == '\0') {
+            fprintf(stderr, "The %s beam sink needs a target\n", config->beam_sink);
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (strcmp(config->beam_sink, "shm") == 0 && 
+            (config->beam_ring_ms < 10 || config->beam_ring_ms > 60000 || config->beam_target[0] != '/')) {
+            fprintf(stderr, "Invalid beam ring: %d ms at %s (must be 10-60000 ms at /name)\n", 
+                    config->beam_ring_ms, config->beam_target);
+            return MICARRAY_ERROR_CONFIG;
+        }
+    }
+    
+    if (config->recorder_enable) {
+        if (config->recorder_directory[0] == '\0') {
+            fprintf(stderr, "The recorder needs a directory\n");
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (strcmp(config->recorder_format, "wav") != 0 && strcmp(config->recorder_format, "lossless") != 0) {
+            fprintf(stderr, "Invalid recorder format: %s (must be wav or lossless)\n", config->recorder_format);
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (config->recorder_pre_ms < 0 || config->recorder_pre_ms > 60000 || config->recorder_post_ms < 0) {
+            fprintf(stderr, "Invalid recorder timing: %d ms before, %d ms after (must be 0-60000 and >= 0)\n", 
+                    config->recorder_pre_ms, config->recorder_post_ms);
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        if (config->recorder_trigger_confidence < 0.0f || config->recorder_trigger_confidence > 1.0f) {
+            fprintf(stderr, "Invalid recorder trigger confidence: %f (must be 0.0-1.0)\n", 
+                    config->recorder_trigger_confidence);
+            return MICARRAY_ERROR_CONFIG;
+        }
+    }
+    
+    if (config->metrics_rate < 0.0f || config->metrics_rate > config->sample_rate) {
+        fprintf(stderr, "Invalid metrics rate: %f (must be 0-%d Hz)\n", 
+                config->metrics_rate, config->sample_rate);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (config->kernels[0] && !kernels_is_known(config->kernels)) {
+        fprintf(stderr, "Invalid kernels: %s (must be auto, scalar, sse4, avx2, avx512, neon or dotprod)\n", 
+                config->kernels);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
     return MICARRAY_SUCCESS;
 }
 
@@ -215,16 +683,85 @@ void config_print(const micarray_config_t *config) {
     
     printf("Configuration:\n");
     printf("  Log Level: %s\n", config->log_level);
+    printf("  Kernels: %s\n", config->kernels[0] ? config->kernels : "auto");
     printf("  Microphones: %d\n", config->num_microphones);
     printf("  Mic Spacing: %.1fmm\n", config->mic_spacing);
     printf("  I2S Bus: %d\n", config->i2s_bus);
     printf("  DMA Buffer Size: %d\n", config->dma_buffer_size);
     printf("  Sample Rate: %d Hz\n", config->sample_rate);
+    printf("  Health Monitor: %s\n", config->health_monitor ? "enabled" : "disabled");
+    if (config->low_latency) {
+        printf("  Low Latency: enabled (hop %d)\n", config->hop_size);
+    }
+    if (config->localization_rate > 0.0f) {
+        printf("  Localization Rate: %.1f Hz\n", config->localization_rate);
+    }
+    if (config->localization_window > 0) {
+        printf("  Localization Window: %d\n", config->localization_window);
+    }
+    if (config->localization_method[0] != '\0') {
+        printf("  Localization Method: %s\n", config->localization_method);
+    }
+    if (config->localization_smoothing > 0.0f) {
+        printf("  Localization Smoothing: %.2f\n", config->localization_smoothing);
+    }
+    if (config->localization_band_low > 0.0f || config->localization_band_high > 0.0f) {
+        printf("  Localization Band: %.0f-%.0f Hz\n", config->localization_band_low, 
+               config->localization_band_high > 0.0f ? config->localization_band_high : config->sample_rate / 2.0f);
+    }
+    if (config->localization_max_bins > 0) {
+        printf("  Localization Max Bins: %d\n", config->localization_max_bins);
+    }
+    if (config->prefilter_enable) {
+        printf("  Pre-filter: %s%.0f-%.0f Hz\n", config->prefilter_dc_removal ? "DC removal, " : "", 
+               config->prefilter_highpass, 
+               config->prefilter_lowpass > 0.0f ? config->prefilter_lowpass : config->sample_rate / 2.0f);
+    } else {
+        printf("  Pre-filter: disabled\n");
+    }
+    if (config->aec_enable) {
+        if (config->aec_delay_ms >= 0) {
+            printf("  Echo Cancellation: %d ms tail, step %.2f, delay %d ms\n", 
+                   config->aec_tail_ms, config->aec_step, config->aec_delay_ms);
+        } else {
+            printf("  Echo Cancellation: %d ms tail, step %.2f, measured delay\n", 
+                   config->aec_tail_ms, config->aec_step);
+        }
+    }
+    if (config->dereverb_enable) {
+        printf("  Dereverberation: order %d, delay %d, %d-sample frames, forgetting %.3f\n", 
+               config->dereverb_order, config->dereverb_delay, config->dereverb_frame_size, 
+               config->dereverb_forgetting);
+    }
     printf("  Noise Reduction: %s\n", config->noise_reduction_enable ? "enabled" : "disabled");
     printf("  Noise Threshold: %.3f\n", config->noise_threshold);
     printf("  Algorithm: %s\n", config->algorithm);
+    if (strcmp(config->algorithm, "nn") == 0) {
+        printf("  Noise Model: %s\n", config->nn_model);
+    }
+    if (config->agc_enable) {
+        printf("  AGC: target %.1f dB, up to %.1f dB gain, limiter at %.1f dB with %.1f ms look-ahead\n", 
+               config->agc_target_db, config->agc_max_gain_db, config->agc_ceiling_db, config->agc_lookahead_ms);
+    }
     printf("  Output Device: %s\n", config->output_device);
     printf("  Volume: %.1f\n", config->volume);
+    if (strcmp(config->output_renderer, "hrtf") == 0) {
+        printf("  Renderer: hrtf (%s)\n", config->hrtf_file);
+    }
+    if (config->beam_enable) {
+        printf("  Beam Output: %d beams to %s %s\n", config->beam_count, config->beam_sink, config->beam_target);
+    }
+    if (config->recorder_enable) {
+        printf("  Recorder: %s (%s), %d ms before and %d ms after a trigger\n", config->recorder_directory, 
+               config->recorder_format, config->recorder_pre_ms, config->recorder_post_ms);
+    }
+    printf("  Pipeline: %s\n", config->pipeline_stages[0] ? config->pipeline_stages : MICARRAY_DEFAULT_STAGES);
     printf("  Serial Logging: %s\n", config->enable_serial_logging ? "enabled" : "disabled");
     printf("  Log File: %s\n", config->log_file);
+    if (config->metrics_rate > 0.0f) {
+        printf("  Metrics Rate: %.1f Hz\n", config->metrics_rate);
+    }
+    if (config->perf_counters) {
+        printf("  Perf Counters: enabled\n");
+    }
 }
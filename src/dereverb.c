@@ -0,0 +1,411 @@
+#define _GNU_SOURCE
+#include "dereverb.h"
+#include "simd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <fftw3.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define POWER_FLOOR 1e-8f
+
+/* Streaming STFT as in noise reduction (periodic sqrt-Hann on analysis
+ * and synthesis, output delayed by frame_size), with a hop of a quarter
+ * frame. Each frame's spectra go into a ring of the last delay + order
+ * frames. Per bin, the taps are the spectra of every channel from delay
+ * to delay + order - 1 frames back, stacked into y, and
+ *
+ *     d = x - G^H y                        (one row of G per channel)
+ *     lambda = max(mean |d|^2, floor)
+ *     u = P y,  k = u / (forgetting * lambda + y^H u)
+ *     P = (P - k u^H) / forgetting,  G += k d^H
+ *
+ * is the RLS update of the WPE filters. P (taps x taps) and G (taps x
+ * channels) live per group of SIMD_LANES bins, so every step above works
+ * on four bins at once. */
+struct dereverb_context {
+    dereverb_config_t config;
+    int hop;
+    int overlap;
+    int bins;
+    int vectors;
+    int taps;
+    int history;
+    int head;
+    int pos;
+    float power_floor;
+    float synthesis_scale;
+    
+    float *window;
+    float *input[MAX_MICROPHONES];
+    float *output[MAX_MICROPHONES];
+    float *fifo[MAX_MICROPHONES];
+    
+    float4_t *hr;
+    float4_t *hi;
+    float4_t *dr;
+    float4_t *di;
+    float4_t *pr;
+    float4_t *pi;
+    float4_t *gr;
+    float4_t *gi;
+    
+    float *time;
+    fftwf_complex *spectrum;
+    fftwf_plan forward;
+    fftwf_plan inverse;
+};
+
+int dereverb_init(dereverb_context_t **ctx, const dereverb_config_t *config) {
+    if (!ctx || !config || config->num_channels < 1 || config->num_channels > MAX_MICROPHONES ||
+        config->sample_rate <= 0 || config->frame_size < DEREVERB_MIN_FRAME ||
+        config->frame_size > DEREVERB_MAX_FRAME || (config->frame_size & (config->frame_size - 1)) != 0 ||
+        config->order < 1 || config->order > DEREVERB_MAX_ORDER || config->delay < 1 ||
+        config->delay > DEREVERB_MAX_DELAY || config->order * config->num_channels > DEREVERB_MAX_TAPS ||
+        config->forgetting <= 0.0f || config->forgetting >= 1.0f) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(dereverb_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    dereverb_context_t *d = *ctx;
+    const int channels = config->num_channels;
+    const int frame_size = config->frame_size;
+    d->config = *config;
+    d->hop = frame_size / 4;
+    d->overlap = frame_size - d->hop;
+    d->bins = frame_size / 2 + 1;
+    d->vectors = (d->bins + SIMD_LANES - 1) / SIMD_LANES;
+    d->taps = config->order * channels;
+    d->history = config->delay + config->order;
+    d->power_floor = POWER_FLOOR * frame_size;
+    d->synthesis_scale = 2.0f * d->hop / ((float)frame_size * frame_size);
+    
+    const size_t vectors = d->vectors;
+    const size_t taps = d->taps;
+    d->window = malloc(frame_size * sizeof(float));
+    d->hr = simd_alloc(d->history * channels * vectors);
+    d->hi = simd_alloc(d->history * channels * vectors);
+    d->dr = simd_alloc(channels * vectors);
+    d->di = simd_alloc(channels * vectors);
+    d->pr = simd_alloc(vectors * taps * taps);
+    d->pi = simd_alloc(vectors * taps * taps);
+    d->gr = simd_alloc(vectors * taps * channels);
+    d->gi = simd_alloc(vectors * taps * channels);
+    d->time = fftwf_alloc_real(frame_size);
+    d->spectrum = fftwf_alloc_complex(d->bins);
+    
+    bool allocated = d->window && d->hr && d->hi && d->dr && d->di && d->pr && d->pi && d->gr && d->gi &&
+                     d->time && d->spectrum;
+    for (int c = 0; c < channels && allocated; c++) {
+        d->input[c] = calloc(frame_size, sizeof(float));
+        d->output[c] = calloc(frame_size, sizeof(float));
+        d->fifo[c] = calloc(d->hop, sizeof(float));
+        allocated = d->input[c] && d->output[c] && d->fifo[c];
+    }
+    
+    if (!allocated) {
+        dereverb_cleanup(d);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    for (int i = 0; i < frame_size; i++) {
+        d->window[i] = sqrtf(0.5f * (1.0f - cosf(2.0f * (float)M_PI * i / frame_size)));
+    }
+    
+    d->forward = fftwf_plan_dft_r2c_1d(frame_size, d->time, d->spectrum, FFTW_MEASURE);
+    d->inverse = fftwf_plan_dft_c2r_1d(frame_size, d->spectrum, d->time, FFTW_MEASURE);
+    if (!d->forward || !d->inverse) {
+        dereverb_cleanup(d);
+        *ctx = NULL;
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    dereverb_reset(d);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int dereverb_cleanup(dereverb_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (ctx->forward) {
+        fftwf_destroy_plan(ctx->forward);
+    }
+    if (ctx->inverse) {
+        fftwf_destroy_plan(ctx->inverse);
+    }
+    
+    for (int c = 0; c < ctx->config.num_channels; c++) {
+        free(ctx->input[c]);
+        free(ctx->output[c]);
+        free(ctx->fifo[c]);
+    }
+    
+    free(ctx->window);
+    free(ctx->hr);
+    free(ctx->hi);
+    free(ctx->dr);
+    free(ctx->di);
+    free(ctx->pr);
+    free(ctx->pi);
+    free(ctx->gr);
+    free(ctx->gi);
+    
+    if (ctx->time) {
+        fftwf_free(ctx->time);
+    }
+    if (ctx->spectrum) {
+        fftwf_free(ctx->spectrum);
+    }
+    
+    free(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+/* P = I and G = 0 for one group of bins. */
+static void reset_filters(dereverb_context_t *ctx, int v) {
+    const int taps = ctx->taps;
+    float4_t *pr = ctx->pr + (size_t)v * taps * taps;
+    float4_t *pi = ctx->pi + (size_t)v * taps * taps;
+    
+    memset(pr, 0, (size_t)taps * taps * sizeof(float4_t));
+    memset(pi, 0, (size_t)taps * taps * sizeof(float4_t));
+    memset(ctx->gr + (size_t)v * taps * ctx->config.num_channels, 0,
+           (size_t)taps * ctx->config.num_channels * sizeof(float4_t));
+    memset(ctx->gi + (size_t)v * taps * ctx->config.num_channels, 0,
+           (size_t)taps * ctx->config.num_channels * sizeof(float4_t));
+    
+    const float4_t one = {1.0f, 1.0f, 1.0f, 1.0f};
+    for (int i = 0; i < taps; i++) {
+        pr[i * taps + i] = one;
+    }
+}
+
+int dereverb_reset(dereverb_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    const int channels = ctx->config.num_channels;
+    for (int c = 0; c < channels; c++) {
+        memset(ctx->input[c], 0, ctx->config.frame_size * sizeof(float));
+        memset(ctx->output[c], 0, ctx->config.frame_size * sizeof(float));
+        memset(ctx->fifo[c], 0, ctx->hop * sizeof(float));
+    }
+    
+    memset(ctx->hr, 0, (size_t)ctx->history * channels * ctx->vectors * sizeof(float4_t));
+    memset(ctx->hi, 0, (size_t)ctx->history * channels * ctx->vectors * sizeof(float4_t));
+    for (int v = 0; v < ctx->vectors; v++) {
+        reset_filters(ctx, v);
+    }
+    
+    ctx->head = 0;
+    ctx->pos = ctx->overlap;
+    
+    return MICARRAY_SUCCESS;
+}
+
+/* Predicts and removes the late reverberation of one group of bins in
+ * the newest frame, leaving the result in dr/di, then updates P and G. */
+static void predict_bins(dereverb_context_t *ctx, int v) {
+    const int channels = ctx->config.num_channels;
+    const int taps = ctx->taps;
+    const int vectors = ctx->vectors;
+    const int history = ctx->history;
+    const float forgetting = ctx->config.forgetting;
+    
+    float4_t yr[DEREVERB_MAX_TAPS], yi[DEREVERB_MAX_TAPS];
+    float4_t ur[DEREVERB_MAX_TAPS], ui[DEREVERB_MAX_TAPS];
+    float4_t kr[DEREVERB_MAX_TAPS], ki[DEREVERB_MAX_TAPS];
+    
+    for (int k = 0; k < ctx->config.order; k++) {
+        int slot = (ctx->head - ctx->config.delay - k + 2 * history) % history;
+        for (int c = 0; c < channels; c++) {
+            yr[k * channels + c] = ctx->hr[(slot * channels + c) * vectors + v];
+            yi[k * channels + c] = ctx->hi[(slot * channels + c) * vectors + v];
+        }
+    }
+    
+    float4_t *gr = ctx->gr + (size_t)v * taps * channels;
+    float4_t *gi = ctx->gi + (size_t)v * taps * channels;
+    float4_t power = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int m = 0; m < channels; m++) {
+        float4_t er = ctx->hr[(ctx->head * channels + m) * vectors + v];
+        float4_t ei = ctx->hi[(ctx->head * channels + m) * vectors + v];
+        for (int l = 0; l < taps; l++) {
+            float4_t wr = gr[l * channels + m];
+            float4_t wi = gi[l * channels + m];
+            er -= wr * yr[l] + wi * yi[l];
+            ei -= wr * yi[l] - wi * yr[l];
+        }
+        ctx->dr[m * vectors + v] = er;
+        ctx->di[m * vectors + v] = ei;
+        power += er * er + ei * ei;
+    }
+    
+    float4_t *pr = ctx->pr + (size_t)v * taps * taps;
+    float4_t *pi = ctx->pi + (size_t)v * taps * taps;
+    float4_t denom = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < taps; i++) {
+        float4_t sr = {0.0f, 0.0f, 0.0f, 0.0f};
+        float4_t si = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (int j = 0; j < taps; j++) {
+            sr += pr[i * taps + j] * yr[j] - pi[i * taps + j] * yi[j];
+            si += pr[i * taps + j] * yi[j] + pi[i * taps + j] * yr[j];
+        }
+        ur[i] = sr;
+        ui[i] = si;
+        denom += yr[i] * sr + yi[i] * si;
+    }
+    
+    float4_t inverse;
+    bool diverged = false;
+    for (int lane = 0; lane < SIMD_LANES; lane++) {
+        float lambda = fmaxf(power[lane] / channels, ctx->power_floor);
+        float total = forgetting * lambda + denom[lane];
+        diverged |= !(total > 0.0f) || !isfinite(total);
+        inverse[lane] = 1.0f / total;
+    }
+    
+    /* Rounding can make the recursion lose definiteness; start this group
+     * over. */
+    if (diverged) {
+        reset_filters(ctx, v);
+        for (int m = 0; m < channels; m++) {
+            ctx->dr[m * vectors + v] = ctx->hr[(ctx->head * channels + m) * vectors + v];
+            ctx->di[m * vectors + v] = ctx->hi[(ctx->head * channels + m) * vectors + v];
+        }
+        return;
+    }
+    
+    for (int i = 0; i < taps; i++) {
+        kr[i] = ur[i] * inverse;
+        ki[i] = ui[i] * inverse;
+    }
+    
+    /* P - k u^H is Hermitian like P, so only the upper triangle is
+     * computed and mirrored, which also stops rounding from drifting it. */
+    const float scale = 1.0f / forgetting;
+    for (int i = 0; i < taps; i++) {
+        for (int j = i; j < taps; j++) {
+            float4_t qr = kr[i] * ur[j] + ki[i] * ui[j];
+            float4_t qi = ki[i] * ur[j] - kr[i] * ui[j];
+            float4_t nr = (pr[i * taps + j] - qr) * scale;
+            float4_t ni = (pi[i * taps + j] - qi) * scale;
+            pr[i * taps + j] = nr;
+            pi[i * taps + j] = ni;
+            pr[j * taps + i] = nr;
+            pi[j * taps + i] = -ni;
+        }
+        pi[i * taps + i] = (float4_t){0.0f, 0.0f, 0.0f, 0.0f};
+    }
+    
+    for (int l = 0; l < taps; l++) {
+        for (int m = 0; m < channels; m++) {
+            float4_t er = ctx->dr[m * vectors + v];
+            float4_t ei = ctx->di[m * vectors + v];
+            gr[l * channels + m] += kr[l] * er + ki[l] * ei;
+            gi[l * channels + m] += ki[l] * er - kr[l] * ei;
+        }
+    }
+}
+
+static void process_frame(dereverb_context_t *ctx, uint32_t active_mask) {
+    const int channels = ctx->config.num_channels;
+    const int frame_size = ctx->config.frame_size;
+    const int vectors = ctx->vectors;
+    const int hop = ctx->hop;
+    
+    ctx->head = (ctx->head + 1) % ctx->history;
+    for (int c = 0; c < channels; c++) {
+        float4_t *xr = ctx->hr + (ctx->head * channels + c) * vectors;
+        float4_t *xi = ctx->hi + (ctx->head * channels + c) * vectors;
+        if (!(active_mask & (1u << c))) {
+            memset(xr, 0, vectors * sizeof(float4_t));
+            memset(xi, 0, vectors * sizeof(float4_t));
+            continue;
+        }
+        
+        for (int i = 0; i < frame_size; i++) {
+            ctx->time[i] = ctx->input[c][i] * ctx->window[i];
+        }
+        fftwf_execute(ctx->forward);
+        simd_split_complex((const float*)ctx->spectrum, xr, xi, ctx->bins);
+    }
+    
+    for (int v = 0; v < vectors; v++) {
+        predict_bins(ctx, v);
+    }
+    
+    for (int c = 0; c < channels; c++) {
+        float *output = ctx->output[c];
+        if (active_mask & (1u << c)) {
+            simd_merge_complex(ctx->dr + c * vectors, ctx->di + c * vectors, (float*)ctx->spectrum, ctx->bins);
+            fftwf_execute(ctx->inverse);
+            for (int i = 0; i < frame_size; i++) {
+                output[i] += ctx->time[i] * ctx->window[i] * ctx->synthesis_scale;
+            }
+        }
+        
+        memcpy(ctx->fifo[c], output, hop * sizeof(float));
+        memmove(output, output + hop, ctx->overlap * sizeof(float));
+        memset(output + ctx->overlap, 0, hop * sizeof(float));
+        memmove(ctx->input[c], ctx->input[c] + hop, ctx->overlap * sizeof(float));
+    }
+}
+
+int dereverb_process(dereverb_context_t *ctx, int16_t **channels, size_t frames, uint32_t active_mask) {
+    if (!ctx || !channels) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    const int frame_size = ctx->config.frame_size;
+    size_t done = 0;
+    while (done < frames) {
+        size_t count = (size_t)(frame_size - ctx->pos);
+        if (count > frames - done) {
+            count = frames - done;
+        }
+        
+        for (int c = 0; c < ctx->config.num_channels; c++) {
+            int16_t *samples = channels[c] + done;
+            float *input = ctx->input[c] + ctx->pos;
+            const float *fifo = ctx->fifo[c] + ctx->pos - ctx->overlap;
+            bool active = active_mask & (1u << c);
+            for (size_t i = 0; i < count; i++) {
+                input[i] = samples[i] / 32768.0f;
+                if (active) {
+                    float sample = fmaxf(-32768.0f, fminf(32767.0f, fifo[i] * 32768.0f));
+                    samples[i] = (int16_t)lrintf(sample);
+                }
+            }
+        }
+        
+        ctx->pos += (int)count;
+        done += count;
+        if (ctx->pos == frame_size) {
+            ctx->pos = ctx->overlap;
+            process_frame(ctx, active_mask);
+        }
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int dereverb_get_latency(const dereverb_context_t *ctx) {
+    return ctx ? ctx->config.frame_size : 0;
+}
@@ -0,0 +1,54 @@
+#ifndef DEREVERB_H
+#define DEREVERB_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEREVERB_MAX_ORDER 16
+#define DEREVERB_MAX_DELAY 8
+#define DEREVERB_MAX_TAPS 64
+#define DEREVERB_MIN_FRAME 64
+#define DEREVERB_MAX_FRAME 2048
+
+typedef struct dereverb_context dereverb_context_t;
+
+/* Online weighted prediction error (WPE) dereverberation. In every STFT
+ * bin the late reverberation of each channel is predicted from order
+ * past frames of all channels, starting delay frames back so the direct
+ * sound and early reflections are kept, and subtracted. frame_size is a
+ * power of two with a hop of a quarter frame; order * num_channels taps
+ * may not exceed DEREVERB_MAX_TAPS. forgetting, in (0, 1) and in practice
+ * just under 1, sets how fast the prediction filters track a changing
+ * room; at 1 the recursion would never forget and lose precision. */
+typedef struct {
+    int num_channels;
+    int sample_rate;
+    int frame_size;
+    int order;
+    int delay;
+    float forgetting;
+} dereverb_config_t;
+
+int dereverb_init(dereverb_context_t **ctx, const dereverb_config_t *config);
+int dereverb_cleanup(dereverb_context_t *ctx);
+
+/* Dereverberates channels[c][0..frames) in place for every channel in
+ * active_mask; the others only feed the predictor, as silence. Any block
+ * length works and the output is delayed by dereverb_get_latency()
+ * frames. Does not allocate. */
+int dereverb_process(dereverb_context_t *ctx, int16_t **channels, size_t frames, uint32_t active_mask);
+
+/* Forgets the room: clears the prediction filters and the STFT state. */
+int dereverb_reset(dereverb_context_t *ctx);
+
+int dereverb_get_latency(const dereverb_context_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,18 +1,42 @@
 #define _GNU_SOURCE
 #include "dma.h"
+#include "dma_mem.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <time.h>
 #include <sys/mman.h>
 #include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <poll.h>
 #include <pthread.h>
 #include <errno.h>
 
 #define DMA_BASE_ADDR 0x3F007000
 #define DMA_CHANNEL_SIZE 0x100
-#define PAGE_SIZE 4096
+
+#define DMA_REG_CS 0
+#define DMA_REG_CONBLK_AD 1
+
+#define DMA_CS_ACTIVE (1u << 0)
+#define DMA_CS_END (1u << 1)
+#define DMA_CS_INT (1u << 2)
+#define DMA_CS_ERROR (1u << 8)
+#define DMA_CS_RESET (1u << 31)
+
+#define DMA_TI_INTEN (1u << 0)
+#define DMA_TI_DEST_INC (1u << 4)
+#define DMA_TI_SRC_DREQ (1u << 10)
+#define DMA_TI_PERMAP(x) ((uint32_t)(x) << 16)
+#define DMA_TI_NO_WIDE_BURSTS (1u << 26)
+
+#define DMA_DREQ_PCM_RX 3
+#define DMA_PCM_FIFO_BUS_ADDR 0x7E203004u
+#define DMA_SOFT_BUS_BASE 0x10000000u
+#define DMA_SOFT_DEFAULT_PERIOD_US 1000
+#define DMA_POLL_FALLBACK_MS 1
 
 typedef struct {
     uint32_t ti;
@@ -28,58 +52,422 @@ struct dma_context {
     dma_config_t config;
     int mem_fd;
     volatile uint32_t *dma_reg;
+    uint32_t soft_reg[DMA_CHANNEL_SIZE / sizeof(uint32_t)];
     
+    dma_mem_t *buffer_mem;
+    dma_mem_t cb_mem;
     void **buffers;
     dma_cb_t *control_blocks;
-    void *control_blocks_phys;
+    int *next_buffer;
+    bool *in_chain;
+    int *refcount;
+    uint64_t *buffer_sequence;
+    int spare_buffer;
+    
+    uint32_t *completion_ring;
+    uint32_t completion_mask;
+    uint32_t completion_head;
+    uint32_t completion_tail;
     
     int current_buffer;
+    uint64_t next_sequence;
+    dma_stats_t stats;
     bool running;
+    int irq_fd;
+    bool irq_is_uio;
+    int wake_fd;
     pthread_t dma_thread;
     pthread_mutex_t mutex;
     
+    bool engine_running;
+    pthread_t engine_thread;
+    
     dma_callback_t callback;
     void *callback_user_data;
 };
 
-static uint32_t mem_virt_to_phys(void *virt_addr) {
-    return ((uint32_t)virt_addr) + 0x40000000;
+static bool dma_is_software(const dma_context_t *ctx) {
+    return ctx->config.engine == DMA_ENGINE_SOFTWARE;
 }
 
-static void* dma_thread_func(void *arg) {
+static uint32_t dma_read_cs(dma_context_t *ctx) {
+    if (dma_is_software(ctx)) {
+        return __atomic_load_n(&ctx->soft_reg[DMA_REG_CS], __ATOMIC_ACQUIRE);
+    }
+    return ctx->dma_reg[DMA_REG_CS];
+}
+
+/* The software engine mirrors the BCM2835 CS semantics: RESET clears the
+ * channel, END/INT/ERROR are write-1-to-clear and ACTIVE follows the write. */
+static void dma_write_cs(dma_context_t *ctx, uint32_t value) {
+    if (!dma_is_software(ctx)) {
+        ctx->dma_reg[DMA_REG_CS] = value;
+        return;
+    }
+    
+    if (value & DMA_CS_RESET) {
+        __atomic_store_n(&ctx->soft_reg[DMA_REG_CS], 0, __ATOMIC_RELEASE);
+        return;
+    }
+    
+    uint32_t cs = __atomic_load_n(&ctx->soft_reg[DMA_REG_CS], __ATOMIC_ACQUIRE);
+    uint32_t next;
+    do {
+        next = cs & ~(value & (DMA_CS_END | DMA_CS_INT | DMA_CS_ERROR));
+        next = (next & ~DMA_CS_ACTIVE) | (value & DMA_CS_ACTIVE);
+    } while (!__atomic_compare_exchange_n(&ctx->soft_reg[DMA_REG_CS], &cs, next, false,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+}
+
+static void dma_write_conblk(dma_context_t *ctx, uint32_t bus_addr) {
+    if (dma_is_software(ctx)) {
+        __atomic_store_n(&ctx->soft_reg[DMA_REG_CONBLK_AD], bus_addr, __ATOMIC_RELEASE);
+    } else {
+        ctx->dma_reg[DMA_REG_CONBLK_AD] = bus_addr;
+    }
+}
+
+static uint32_t dma_cb_bus_addr(dma_context_t *ctx, int index) {
+    return dma_mem_bus_addr(&ctx->cb_mem, &ctx->control_blocks[index]);
+}
+
+static void* dma_bus_to_virt(dma_context_t *ctx, uint32_t bus_addr, size_t len) {
+    if (dma_mem_contains(&ctx->cb_mem, bus_addr, len)) {
+        return dma_mem_virt_addr(&ctx->cb_mem, bus_addr);
+    }
+    
+    for (int i = 0; i <= ctx->config.num_buffers; i++) {
+        if (dma_mem_contains(&ctx->buffer_mem[i], bus_addr, len)) {
+            return dma_mem_virt_addr(&ctx->buffer_mem[i], bus_addr);
+        }
+    }
+    
+    return NULL;
+}
+
+static void dma_soft_raise_irq(dma_context_t *ctx) {
+    uint64_t one = 1;
+    if (write(ctx->irq_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        fprintf(stderr, "Failed to signal DMA completion: %s\n", strerror(errno));
+    }
+}
+
+/* Software stand-in for the DMA controller. It walks the same control-block
+ * chain by bus address, paced like the PCM peripheral, so the lease and
+ * completion paths are exercised without the hardware. */
+static void* dma_soft_engine_func(void *arg) {
     dma_context_t *ctx = (dma_context_t*)arg;
+    long period_ns = (long)(ctx->config.period_us > 0 ? ctx->config.period_us : DMA_SOFT_DEFAULT_PERIOD_US) * 1000L;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    
+    while (__atomic_load_n(&ctx->engine_running, __ATOMIC_ACQUIRE)) {
+        next.tv_nsec += period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        
+        uint32_t cs = dma_read_cs(ctx);
+        if (!(cs & DMA_CS_ACTIVE) || (cs & DMA_CS_ERROR)) {
+            continue;
+        }
+        
+        uint32_t cb_addr = __atomic_load_n(&ctx->soft_reg[DMA_REG_CONBLK_AD], __ATOMIC_ACQUIRE);
+        dma_cb_t *cb = dma_bus_to_virt(ctx, cb_addr, sizeof(dma_cb_t));
+        void *dest = cb ? dma_bus_to_virt(ctx, cb->dest_ad, cb->txfr_len) : NULL;
+        
+        if (!dest) {
+            __atomic_or_fetch(&ctx->soft_reg[DMA_REG_CS], DMA_CS_ERROR, __ATOMIC_ACQ_REL);
+            dma_soft_raise_irq(ctx);
+            continue;
+        }
+        
+        if (ctx->config.src_addr) {
+            memcpy(dest, ctx->config.src_addr, cb->txfr_len);
+        } else {
+            memset(dest, 0, cb->txfr_len);
+        }
+        
+        uint32_t next_cb = __atomic_load_n(&cb->nextconbk, __ATOMIC_ACQUIRE);
+        __atomic_store_n(&ctx->soft_reg[DMA_REG_CONBLK_AD], next_cb, __ATOMIC_RELEASE);
+        
+        uint32_t status = (cb->ti & DMA_TI_INTEN) ? DMA_CS_INT : 0;
+        if (next_cb == 0) {
+            __atomic_and_fetch(&ctx->soft_reg[DMA_REG_CS], ~DMA_CS_ACTIVE, __ATOMIC_ACQ_REL);
+            status |= DMA_CS_END;
+        }
+        __atomic_or_fetch(&ctx->soft_reg[DMA_REG_CS], status, __ATOMIC_ACQ_REL);
+        
+        if (status & DMA_CS_INT) {
+            dma_soft_raise_irq(ctx);
+        }
+    }
+    
+    return NULL;
+}
+
+static void dma_link(dma_context_t *ctx, int from, int to) {
+    ctx->next_buffer[from] = to;
+    
+    dma_mem_sync_start(&ctx->cb_mem, true);
+    __atomic_store_n(&ctx->control_blocks[from].nextconbk, 
+                     (to >= 0) ? dma_cb_bus_addr(ctx, to) : 0, __ATOMIC_RELEASE);
+    dma_mem_sync_end(&ctx->cb_mem, true);
+}
+
+/* Buffers with no references belong to the descriptor ring. The chain from
+ * the active block runs through every free buffer and ends on the spare,
+ * which loops on itself: it is never leased, so when every pool buffer is
+ * still queued or leased the engine parks there instead of overwriting
+ * consumer-held memory. Links to buffers that are still free are never
+ * rewritten, so the path the engine is already following stays valid; free
+ * buffers are only appended at the tail. */
+static void dma_relink(dma_context_t *ctx, int active) {
+    int n = ctx->config.num_buffers;
+    int spare = ctx->spare_buffer;
+    
+    memset(ctx->in_chain, 0, (n + 1) * sizeof(bool));
+    ctx->in_chain[active] = true;
+    
+    int tail = active;
+    for (;;) {
+        int next = ctx->next_buffer[tail];
+        if (next < 0 || next == spare || ctx->in_chain[next] ||
+            __atomic_load_n(&ctx->refcount[next], __ATOMIC_ACQUIRE) != 0) {
+            break;
+        }
+        ctx->in_chain[next] = true;
+        tail = next;
+    }
+    
+    int origin = (active == spare) ? n - 1 : active;
+    for (int step = 1; step <= n; step++) {
+        int i = (origin + step) % n;
+        if (!ctx->in_chain[i] && __atomic_load_n(&ctx->refcount[i], __ATOMIC_ACQUIRE) == 0) {
+            dma_link(ctx, tail, i);
+            ctx->in_chain[i] = true;
+            tail = i;
+        }
+    }
     
-    while (ctx->running) {
-        uint32_t cs = ctx->dma_reg[0];
+    if (ctx->next_buffer[tail] != spare) {
+        dma_link(ctx, tail, spare);
+    }
+    if (active != spare && ctx->next_buffer[spare] != spare) {
+        dma_link(ctx, spare, spare);
+    }
+}
+
+static int dma_cb_index(dma_context_t *ctx, uint32_t bus_addr) {
+    if (!dma_mem_contains(&ctx->cb_mem, bus_addr, sizeof(dma_cb_t))) {
+        return -1;
+    }
+    
+    uint32_t offset = bus_addr - ctx->cb_mem.bus_addr;
+    int index = (int)(offset / sizeof(dma_cb_t));
+    
+    return (index <= ctx->config.num_buffers) ? index : -1;
+}
+
+static int dma_buffer_index(dma_context_t *ctx, const void *buffer) {
+    for (int i = 0; i < ctx->config.num_buffers; i++) {
+        if (ctx->buffers[i] == buffer) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void dma_complete_buffer(dma_context_t *ctx, int done) {
+    __atomic_add_fetch(&ctx->stats.completed, 1, __ATOMIC_RELAXED);
+    
+    if (done == ctx->spare_buffer) {
+        __atomic_add_fetch(&ctx->stats.overruns, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    
+    ctx->buffer_sequence[done] = ctx->next_sequence++;
+    __atomic_store_n(&ctx->refcount[done], 1, __ATOMIC_RELEASE);
+    
+    int occupancy = 0;
+    for (int i = 0; i < ctx->config.num_buffers; i++) {
+        if (__atomic_load_n(&ctx->refcount[i], __ATOMIC_RELAXED) > 0) {
+            occupancy++;
+        }
+    }
+    if (occupancy > ctx->stats.peak_occupancy) {
+        __atomic_store_n(&ctx->stats.peak_occupancy, occupancy, __ATOMIC_RELAXED);
+    }
+    
+    pthread_mutex_lock(&ctx->mutex);
+    dma_callback_t callback = ctx->callback;
+    void *user_data = ctx->callback_user_data;
+    pthread_mutex_unlock(&ctx->mutex);
+    
+    if (callback) {
+        /* The callback runs under the lease taken above and may retain it. */
+        dma_mem_sync_start(&ctx->buffer_mem[done], false);
+        callback(ctx->buffers[done], ctx->config.buffer_size, user_data);
+        dma_release_buffer(ctx, ctx->buffers[done]);
+        return;
+    }
+    
+    uint32_t head = ctx->completion_head;
+    ctx->completion_ring[head & ctx->completion_mask] = (uint32_t)done;
+    __atomic_store_n(&ctx->completion_head, head + 1, __ATOMIC_RELEASE);
+}
+
+/* Every control block between the last one we accounted for and the one the
+ * engine has loaded now has completed, however many interrupts coalesced. */
+static int dma_collect_completions(dma_context_t *ctx) {
+    uint32_t conblk = dma_is_software(ctx) ? 
+        __atomic_load_n(&ctx->soft_reg[DMA_REG_CONBLK_AD], __ATOMIC_ACQUIRE) :
+        ctx->dma_reg[DMA_REG_CONBLK_AD];
+    int active = dma_cb_index(ctx, conblk);
+    int batch = 0;
+    
+    if (ctx->current_buffer == ctx->spare_buffer && active == ctx->spare_buffer) {
+        /* Parked on the self-looping spare: each interrupt is a dropped block. */
+        __atomic_add_fetch(&ctx->stats.completed, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&ctx->stats.overruns, 1, __ATOMIC_RELAXED);
+        batch = 1;
+    }
+    
+    for (; ctx->current_buffer >= 0 && ctx->current_buffer != active; batch++) {
+        if (batch > ctx->config.num_buffers) {
+            fprintf(stderr, "DMA chain out of sync, resynchronising\n");
+            break;
+        }
         
-        if (cs & (1 << 0)) {
-            pthread_mutex_lock(&ctx->mutex);
-            
-            if (ctx->callback) {
-                void *buffer = ctx->buffers[ctx->current_buffer];
-                ctx->callback(buffer, ctx->config.buffer_size, ctx->callback_user_data);
+        int done = ctx->current_buffer;
+        ctx->current_buffer = ctx->next_buffer[done];
+        dma_complete_buffer(ctx, done);
+    }
+    
+    ctx->current_buffer = active;
+    
+    if (active >= 0 && ctx->config.cyclic) {
+        dma_relink(ctx, active);
+    }
+    
+    return batch;
+}
+
+/* Consume the pending interrupt count. A UIO device reports it as a 32-bit
+ * counter and has to be re-armed; an eventfd hands back 64 bits and resets. */
+static void dma_ack_irq(dma_context_t *ctx) {
+    if (ctx->irq_is_uio) {
+        uint32_t count;
+        uint32_t enable = 1;
+        if (read(ctx->irq_fd, &count, sizeof(count)) == sizeof(count)) {
+            __atomic_add_fetch(&ctx->stats.wakeups, 1, __ATOMIC_RELAXED);
+        }
+        if (write(ctx->irq_fd, &enable, sizeof(enable)) != sizeof(enable)) {
+            fprintf(stderr, "Failed to re-enable DMA interrupt: %s\n", strerror(errno));
+        }
+    } else {
+        uint64_t count;
+        if (read(ctx->irq_fd, &count, sizeof(count)) == sizeof(count)) {
+            __atomic_add_fetch(&ctx->stats.wakeups, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void* dma_thread_func(void *arg) {
+    dma_context_t *ctx = (dma_context_t*)arg;
+    struct pollfd fds[2] = {
+        { .fd = ctx->wake_fd, .events = POLLIN },
+        { .fd = ctx->irq_fd, .events = POLLIN }
+    };
+    int nfds = (ctx->irq_fd >= 0) ? 2 : 1;
+    int timeout = (ctx->irq_fd >= 0) ? -1 : DMA_POLL_FALLBACK_MS;
+    
+    while (__atomic_load_n(&ctx->running, __ATOMIC_ACQUIRE)) {
+        int ready = poll(fds, nfds, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            fprintf(stderr, "DMA poll failed: %s\n", strerror(errno));
+            break;
+        }
+        
+        if (fds[0].revents & POLLIN) {
+            break;
+        }
+        
+        if (nfds > 1 && (fds[1].revents & POLLIN)) {
+            dma_ack_irq(ctx);
+        } else if (ready > 0) {
+            continue;
+        }
+        
+        uint32_t cs = dma_read_cs(ctx);
+        
+        if (cs & DMA_CS_INT) {
+            dma_write_cs(ctx, DMA_CS_INT | (cs & DMA_CS_ACTIVE));
             
-            ctx->current_buffer = (ctx->current_buffer + 1) % ctx->config.num_buffers;
-            
-            ctx->dma_reg[0] = (1 << 0);
-            
-            pthread_mutex_unlock(&ctx->mutex);
+            int batch = dma_collect_completions(ctx);
+            if (batch > ctx->stats.max_batch) {
+                __atomic_store_n(&ctx->stats.max_batch, batch, __ATOMIC_RELAXED);
+            }
         }
         
-        if (cs & (1 << 2)) {
+        if (cs & DMA_CS_ERROR) {
             fprintf(stderr, "DMA error detected\n");
-            ctx->dma_reg[0] = (1 << 2);
+            __atomic_add_fetch(&ctx->stats.errors, 1, __ATOMIC_RELAXED);
+            dma_write_cs(ctx, DMA_CS_ERROR | (cs & DMA_CS_ACTIVE));
         }
-        
-        usleep(100);
     }
     
     return NULL;
 }
 
+/* Completions are signalled through a file descriptor the DMA thread blocks
+ * on: the channel's UIO device on hardware, an eventfd written by the
+ * software engine otherwise. Without a UIO device the thread falls back to
+ * checking CS every DMA_POLL_FALLBACK_MS. */
+static int dma_open_irq(dma_context_t *ctx) {
+    ctx->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (ctx->wake_fd < 0) {
+        fprintf(stderr, "Failed to create DMA wake eventfd: %s\n", strerror(errno));
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    if (dma_is_software(ctx)) {
+        ctx->irq_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (ctx->irq_fd < 0) {
+            fprintf(stderr, "Failed to create DMA completion eventfd: %s\n", strerror(errno));
+            return MICARRAY_ERROR_INIT;
+        }
+        return MICARRAY_SUCCESS;
+    }
+    
+    if (ctx->config.irq_device[0]) {
+        ctx->irq_fd = open(ctx->config.irq_device, O_RDWR | O_CLOEXEC | O_NONBLOCK);
+        if (ctx->irq_fd < 0) {
+            fprintf(stderr, "Failed to open DMA interrupt device %s: %s\n", 
+                    ctx->config.irq_device, strerror(errno));
+            return MICARRAY_ERROR_DMA;
+        }
+        ctx->irq_is_uio = true;
+        
+        uint32_t enable = 1;
+        if (write(ctx->irq_fd, &enable, sizeof(enable)) != sizeof(enable)) {
+            fprintf(stderr, "Failed to enable DMA interrupt: %s\n", strerror(errno));
+            return MICARRAY_ERROR_DMA;
+        }
+    } else {
+        fprintf(stderr, "No DMA interrupt device configured, polling every %d ms\n", DMA_POLL_FALLBACK_MS);
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
 int dma_init(dma_context_t **ctx, const dma_config_t *config) {
-    if (!ctx || !config) {
+    if (!ctx || !config || config->num_buffers <= 0 || config->buffer_size == 0) {
         return MICARRAY_ERROR_INVALID_PARAM;
     }
     
@@ -91,6 +479,11 @@ int dma_init(dma_context_t **ctx, const dma_config_t *config) {
     (*ctx)->config = *config;
     (*ctx)->running = false;
     (*ctx)->current_buffer = 0;
+    (*ctx)->mem_fd = -1;
+    (*ctx)->irq_fd = -1;
+    (*ctx)->wake_fd = -1;
+    (*ctx)->cb_mem.fd = -1;
+    (*ctx)->cb_mem.memfd = -1;
     
     if (pthread_mutex_init(&(*ctx)->mutex, NULL) != 0) {
         free(*ctx);
@@ -98,89 +491,122 @@ int dma_init(dma_context_t **ctx, const dma_config_t *config) {
         return MICARRAY_ERROR_INIT;
     }
     
-    (*ctx)->mem_fd = open("/dev/mem", O_RDWR | O_SYNC);
-    if ((*ctx)->mem_fd < 0) {
-        fprintf(stderr, "Failed to open /dev/mem: %s\n", strerror(errno));
-        pthread_mutex_destroy(&(*ctx)->mutex);
-        free(*ctx);
-        *ctx = NULL;
-        return MICARRAY_ERROR_DMA;
-    }
+    bool software = dma_is_software(*ctx);
     
-    uint32_t dma_addr = DMA_BASE_ADDR + (config->channel * DMA_CHANNEL_SIZE);
-    (*ctx)->dma_reg = mmap(NULL, DMA_CHANNEL_SIZE, PROT_READ | PROT_WRITE, 
+    if (software) {
+        (*ctx)->dma_reg = (*ctx)->soft_reg;
+    } else {
+        (*ctx)->mem_fd = open("/dev/mem", O_RDWR | O_SYNC);
+        if ((*ctx)->mem_fd < 0) {
+            fprintf(stderr, "Failed to open /dev/mem: %s\n", strerror(errno));
+            dma_cleanup(*ctx);
+            *ctx = NULL;
+            return MICARRAY_ERROR_DMA;
+        }
+        
+        uint32_t dma_addr = DMA_BASE_ADDR + (config->channel * DMA_CHANNEL_SIZE);
+        void *regs = mmap(NULL, DMA_CHANNEL_SIZE, PROT_READ | PROT_WRITE, 
                           MAP_SHARED, (*ctx)->mem_fd, dma_addr);
+        
+        if (regs == MAP_FAILED) {
+            fprintf(stderr, "Failed to map DMA registers: %s\n", strerror(errno));
+            dma_cleanup(*ctx);
+            *ctx = NULL;
+            return MICARRAY_ERROR_DMA;
+        }
+        (*ctx)->dma_reg = regs;
+    }
     
-    if ((*ctx)->dma_reg == MAP_FAILED) {
-        fprintf(stderr, "Failed to map DMA registers: %s\n", strerror(errno));
-        close((*ctx)->mem_fd);
-        pthread_mutex_destroy(&(*ctx)->mutex);
-        free(*ctx);
+    int result = dma_open_irq(*ctx);
+    if (result != MICARRAY_SUCCESS) {
+        dma_cleanup(*ctx);
         *ctx = NULL;
-        return MICARRAY_ERROR_DMA;
+        return result;
     }
     
-    (*ctx)->buffers = calloc(config->num_buffers, sizeof(void*));
-    if (!(*ctx)->buffers) {
-        munmap((void*)(*ctx)->dma_reg, DMA_CHANNEL_SIZE);
-        close((*ctx)->mem_fd);
-        pthread_mutex_destroy(&(*ctx)->mutex);
-        free(*ctx);
+    int pool_size = config->num_buffers + 1;
+    uint32_t ring_size = 1;
+    while (ring_size < (uint32_t)config->num_buffers) {
+        ring_size <<= 1;
+    }
+    
+    (*ctx)->spare_buffer = config->num_buffers;
+    (*ctx)->buffer_mem = calloc(pool_size, sizeof(dma_mem_t));
+    (*ctx)->buffers = calloc(pool_size, sizeof(void*));
+    (*ctx)->next_buffer = calloc(pool_size, sizeof(int));
+    (*ctx)->in_chain = calloc(pool_size, sizeof(bool));
+    (*ctx)->refcount = calloc(pool_size, sizeof(int));
+    (*ctx)->buffer_sequence = calloc(pool_size, sizeof(uint64_t));
+    (*ctx)->completion_ring = calloc(ring_size, sizeof(uint32_t));
+    (*ctx)->completion_mask = ring_size - 1;
+    
+    if (!(*ctx)->buffer_mem || !(*ctx)->buffers || !(*ctx)->next_buffer || !(*ctx)->in_chain || !(*ctx)->refcount || 
+        !(*ctx)->buffer_sequence || !(*ctx)->completion_ring) {
+        dma_cleanup(*ctx);
         *ctx = NULL;
         return MICARRAY_ERROR_MEMORY;
     }
     
-    for (int i = 0; i < config->num_buffers; i++) {
-        (*ctx)->buffers[i] = aligned_alloc(PAGE_SIZE, config->buffer_size);
-        if (!(*ctx)->buffers[i]) {
-            for (int j = 0; j < i; j++) {
-                free((*ctx)->buffers[j]);
-            }
-            free((*ctx)->buffers);
-            munmap((void*)(*ctx)->dma_reg, DMA_CHANNEL_SIZE);
-            close((*ctx)->mem_fd);
-            pthread_mutex_destroy(&(*ctx)->mutex);
-            free(*ctx);
-            *ctx = NULL;
-            return MICARRAY_ERROR_MEMORY;
-        }
-        memset((*ctx)->buffers[i], 0, config->buffer_size);
+    for (int i = 0; i < pool_size; i++) {
+        (*ctx)->buffer_mem[i].fd = -1;
+        (*ctx)->buffer_mem[i].memfd = -1;
     }
     
-    size_t cb_size = config->num_buffers * sizeof(dma_cb_t);
-    (*ctx)->control_blocks = aligned_alloc(PAGE_SIZE, cb_size);
-    if (!(*ctx)->control_blocks) {
-        for (int i = 0; i < config->num_buffers; i++) {
-            free((*ctx)->buffers[i]);
+    /* Each buffer is its own dma-buf so cache maintenance on acquire/release
+     * touches only that buffer. The software engine gets memfd regions with
+     * synthetic bus addresses laid out from DMA_SOFT_BUS_BASE. */
+    uint32_t soft_bus = DMA_SOFT_BUS_BASE;
+    const char *heap = config->heap_name[0] ? config->heap_name : NULL;
+    
+    for (int i = 0; i <= pool_size; i++) {
+        dma_mem_t *mem = (i < pool_size) ? &(*ctx)->buffer_mem[i] : &(*ctx)->cb_mem;
+        size_t size = (i < pool_size) ? config->buffer_size : pool_size * sizeof(dma_cb_t);
+        
+        result = dma_mem_alloc(mem, size, heap, !software);
+        if (result != MICARRAY_SUCCESS) {
+            dma_cleanup(*ctx);
+            *ctx = NULL;
+            return result;
+        }
+        
+        if (software) {
+            mem->bus_addr = soft_bus;
+            soft_bus += (uint32_t)mem->size;
+        }
+        
+        if (i < pool_size) {
+            (*ctx)->buffers[i] = mem->virt;
         }
-        free((*ctx)->buffers);
-        munmap((void*)(*ctx)->dma_reg, DMA_CHANNEL_SIZE);
-        close((*ctx)->mem_fd);
-        pthread_mutex_destroy(&(*ctx)->mutex);
-        free(*ctx);
-        *ctx = NULL;
-        return MICARRAY_ERROR_MEMORY;
     }
     
-    for (int i = 0; i < config->num_buffers; i++) {
+    (*ctx)->control_blocks = (*ctx)->cb_mem.virt;
+    
+    uint32_t src_bus = config->src_bus_addr ? config->src_bus_addr : DMA_PCM_FIFO_BUS_ADDR;
+    
+    dma_mem_sync_start(&(*ctx)->cb_mem, true);
+    for (int i = 0; i < pool_size; i++) {
         dma_cb_t *cb = &(*ctx)->control_blocks[i];
-        cb->ti = (1 << 26) | (1 << 6) | (1 << 1);
-        cb->source_ad = mem_virt_to_phys(config->src_addr);
-        cb->dest_ad = mem_virt_to_phys((*ctx)->buffers[i]);
+        cb->ti = DMA_TI_NO_WIDE_BURSTS | DMA_TI_PERMAP(DMA_DREQ_PCM_RX) | 
+                 DMA_TI_SRC_DREQ | DMA_TI_DEST_INC | DMA_TI_INTEN;
+        cb->source_ad = src_bus;
+        cb->dest_ad = (*ctx)->buffer_mem[i].bus_addr;
         cb->txfr_len = config->buffer_size;
         cb->stride = 0;
-        
-        if (config->cyclic) {
-            int next_i = (i + 1) % config->num_buffers;
-            cb->nextconbk = mem_virt_to_phys(&(*ctx)->control_blocks[next_i]);
-        } else {
-            cb->nextconbk = 0;
-        }
+        cb->nextconbk = 0;
+        (*ctx)->next_buffer[i] = -1;
     }
+    dma_mem_sync_end(&(*ctx)->cb_mem, true);
     
     return MICARRAY_SUCCESS;
 }
 
+static void dma_stop_engine(dma_context_t *ctx) {
+    if (ctx->engine_running) {
+        __atomic_store_n(&ctx->engine_running, false, __ATOMIC_RELEASE);
+        pthread_join(ctx->engine_thread, NULL);
+    }
+}
+
 int dma_start(dma_context_t *ctx) {
     if (!ctx) {
         return MICARRAY_ERROR_INVALID_PARAM;
@@ -190,18 +616,44 @@ int dma_start(dma_context_t *ctx) {
         return MICARRAY_SUCCESS;
     }
     
-    ctx->dma_reg[0] = (1 << 31);
+    ctx->current_buffer = 0;
+    if (ctx->config.cyclic) {
+        ctx->current_buffer = ctx->spare_buffer;
+        for (int i = 0; i < ctx->config.num_buffers; i++) {
+            if (__atomic_load_n(&ctx->refcount[i], __ATOMIC_ACQUIRE) == 0) {
+                ctx->current_buffer = i;
+                break;
+            }
+        }
+        dma_relink(ctx, ctx->current_buffer);
+    }
+    
+    dma_write_cs(ctx, DMA_CS_RESET);
     usleep(1000);
     
-    ctx->dma_reg[1] = mem_virt_to_phys(&ctx->control_blocks[0]);
+    uint64_t stale;
+    if (read(ctx->wake_fd, &stale, sizeof(stale)) < 0 && errno != EAGAIN) {
+        fprintf(stderr, "Failed to reset DMA wake eventfd: %s\n", strerror(errno));
+    }
     
-    ctx->dma_reg[0] = (1 << 0);
+    dma_write_conblk(ctx, dma_cb_bus_addr(ctx, ctx->current_buffer));
+    
+    if (dma_is_software(ctx)) {
+        ctx->engine_running = true;
+        if (pthread_create(&ctx->engine_thread, NULL, dma_soft_engine_func, ctx) != 0) {
+            ctx->engine_running = false;
+            return MICARRAY_ERROR_INIT;
+        }
+    }
+    
+    dma_write_cs(ctx, DMA_CS_ACTIVE);
     
     ctx->running = true;
     
     if (pthread_create(&ctx->dma_thread, NULL, dma_thread_func, ctx) != 0) {
         ctx->running = false;
-        ctx->dma_reg[0] = (1 << 31);
+        dma_write_cs(ctx, DMA_CS_RESET);
+        dma_stop_engine(ctx);
         return MICARRAY_ERROR_INIT;
     }
     
@@ -217,9 +669,15 @@ int dma_stop(dma_context_t *ctx) {
         return MICARRAY_SUCCESS;
     }
     
-    ctx->running = false;
+    __atomic_store_n(&ctx->running, false, __ATOMIC_RELEASE);
+    
+    dma_write_cs(ctx, DMA_CS_RESET);
+    dma_stop_engine(ctx);
     
-    ctx->dma_reg[0] = (1 << 31);
+    uint64_t one = 1;
+    if (write(ctx->wake_fd, &one, sizeof(one)) < 0) {
+        fprintf(stderr, "Failed to wake DMA thread: %s\n", strerror(errno));
+    }
     
     if (pthread_join(ctx->dma_thread, NULL) != 0) {
         fprintf(stderr, "Failed to join DMA thread\n");
@@ -236,20 +694,22 @@ int dma_cleanup(dma_context_t *ctx) {
     
     dma_stop(ctx);
     
-    if (ctx->control_blocks) {
-        free(ctx->control_blocks);
-    }
-    
-    if (ctx->buffers) {
-        for (int i = 0; i < ctx->config.num_buffers; i++) {
-            if (ctx->buffers[i]) {
-                free(ctx->buffers[i]);
-            }
+    if (ctx->buffer_mem) {
+        for (int i = 0; i <= ctx->config.num_buffers; i++) {
+            dma_mem_free(&ctx->buffer_mem[i]);
         }
-        free(ctx->buffers);
+        free(ctx->buffer_mem);
     }
+    dma_mem_free(&ctx->cb_mem);
+    
+    free(ctx->buffers);
+    free(ctx->next_buffer);
+    free(ctx->in_chain);
+    free(ctx->refcount);
+    free(ctx->buffer_sequence);
+    free(ctx->completion_ring);
     
-    if (ctx->dma_reg != MAP_FAILED) {
+    if (!dma_is_software(ctx) && ctx->dma_reg) {
         munmap((void*)ctx->dma_reg, DMA_CHANNEL_SIZE);
     }
     
@@ -257,6 +717,14 @@ int dma_cleanup(dma_context_t *ctx) {
         close(ctx->mem_fd);
     }
     
+    if (ctx->irq_fd >= 0) {
+        close(ctx->irq_fd);
+    }
+    
+    if (ctx->wake_fd >= 0) {
+        close(ctx->wake_fd);
+    }
+    
     pthread_mutex_destroy(&ctx->mutex);
     free(ctx);
     
@@ -268,23 +736,78 @@ int dma_set_callback(dma_context_t *ctx, dma_callback_t callback, void *user_dat
         return MICARRAY_ERROR_INVALID_PARAM;
     }
     
+    pthread_mutex_lock(&ctx->mutex);
     ctx->callback = callback;
     ctx->callback_user_data = user_data;
+    pthread_mutex_unlock(&ctx->mutex);
     
     return MICARRAY_SUCCESS;
 }
 
+int dma_acquire_buffer(dma_context_t *ctx, dma_lease_t *lease) {
+    if (!ctx || !lease) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    uint32_t tail = __atomic_load_n(&ctx->completion_tail, __ATOMIC_RELAXED);
+    
+    for (;;) {
+        uint32_t head = __atomic_load_n(&ctx->completion_head, __ATOMIC_ACQUIRE);
+        if (tail == head) {
+            return 0;
+        }
+        
+        int index = (int)ctx->completion_ring[tail & ctx->completion_mask];
+        
+        if (__atomic_compare_exchange_n(&ctx->completion_tail, &tail, tail + 1, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            lease->data = ctx->buffers[index];
+            lease->size = ctx->config.buffer_size;
+            lease->index = index;
+            lease->sequence = ctx->buffer_sequence[index];
+            dma_mem_sync_start(&ctx->buffer_mem[index], false);
+            __atomic_add_fetch(&ctx->stats.acquired, 1, __ATOMIC_RELAXED);
+            return 1;
+        }
+    }
+}
+
 int dma_get_buffer(dma_context_t *ctx, void **buffer, size_t *size) {
     if (!ctx || !buffer || !size) {
         return MICARRAY_ERROR_INVALID_PARAM;
     }
     
-    pthread_mutex_lock(&ctx->mutex);
+    dma_lease_t lease;
+    int result = dma_acquire_buffer(ctx, &lease);
+    if (result <= 0) {
+        return (result == 0) ? MICARRAY_ERROR_DMA : result;
+    }
     
-    *buffer = ctx->buffers[ctx->current_buffer];
-    *size = ctx->config.buffer_size;
+    *buffer = lease.data;
+    *size = lease.size;
     
-    pthread_mutex_unlock(&ctx->mutex);
+    return MICARRAY_SUCCESS;
+}
+
+int dma_retain_buffer(dma_context_t *ctx, void *buffer) {
+    if (!ctx || !buffer) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    int index = dma_buffer_index(ctx, buffer);
+    if (index < 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    /* Only count up from a live reference; once the last release has
+     * taken it to 0 the buffer belongs to the engine again. */
+    int refs = __atomic_load_n(&ctx->refcount[index], __ATOMIC_ACQUIRE);
+    do {
+        if (refs <= 0) {
+            return MICARRAY_ERROR_INVALID_PARAM;
+        }
+    } while (!__atomic_compare_exchange_n(&ctx->refcount[index], &refs, refs + 1, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
     
     return MICARRAY_SUCCESS;
 }
@@ -294,6 +817,56 @@ int dma_release_buffer(dma_context_t *ctx, void *buffer) {
         return MICARRAY_ERROR_INVALID_PARAM;
     }
     
+    int index = dma_buffer_index(ctx, buffer);
+    if (index < 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    int refs = __atomic_sub_fetch(&ctx->refcount[index], 1, __ATOMIC_ACQ_REL);
+    if (refs < 0) {
+        __atomic_add_fetch(&ctx->refcount[index], 1, __ATOMIC_ACQ_REL);
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (refs == 0) {
+        dma_mem_sync_end(&ctx->buffer_mem[index], false);
+        __atomic_add_fetch(&ctx->stats.released, 1, __ATOMIC_RELAXED);
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int dma_get_stats(dma_context_t *ctx, dma_stats_t *stats) {
+    if (!ctx || !stats) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    uint32_t head = __atomic_load_n(&ctx->completion_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&ctx->completion_tail, __ATOMIC_ACQUIRE);
+    
+    stats->completed = __atomic_load_n(&ctx->stats.completed, __ATOMIC_RELAXED);
+    stats->acquired = __atomic_load_n(&ctx->stats.acquired, __ATOMIC_RELAXED);
+    stats->released = __atomic_load_n(&ctx->stats.released, __ATOMIC_RELAXED);
+    stats->overruns = __atomic_load_n(&ctx->stats.overruns, __ATOMIC_RELAXED);
+    stats->wakeups = __atomic_load_n(&ctx->stats.wakeups, __ATOMIC_RELAXED);
+    stats->errors = __atomic_load_n(&ctx->stats.errors, __ATOMIC_RELAXED);
+    stats->max_batch = __atomic_load_n(&ctx->stats.max_batch, __ATOMIC_RELAXED);
+    stats->peak_occupancy = __atomic_load_n(&ctx->stats.peak_occupancy, __ATOMIC_RELAXED);
+    stats->num_buffers = ctx->config.num_buffers;
+    stats->buffers_queued = (int)(head - tail);
+    stats->buffers_free = 0;
+    
+    for (int i = 0; i < ctx->config.num_buffers; i++) {
+        if (__atomic_load_n(&ctx->refcount[i], __ATOMIC_RELAXED) == 0) {
+            stats->buffers_free++;
+        }
+    }
+    
+    stats->buffers_leased = stats->num_buffers - stats->buffers_free - stats->buffers_queued;
+    if (stats->buffers_leased < 0) {
+        stats->buffers_leased = 0;
+    }
+    
     return MICARRAY_SUCCESS;
 }
 
@@ -306,5 +879,5 @@ int dma_get_status(dma_context_t *ctx) {
         return -1;
     }
     
-    return (int)ctx->dma_reg[0];
+    return (int)dma_read_cs(ctx);
 }
@@ -11,6 +11,11 @@ extern "C" {
 
 typedef struct dma_context dma_context_t;
 
+typedef enum {
+    DMA_ENGINE_BCM2835 = 0,
+    DMA_ENGINE_SOFTWARE
+} dma_engine_t;
+
 typedef struct {
     int channel;
     size_t buffer_size;
@@ -18,10 +23,37 @@ typedef struct {
     void *src_addr;
     void *dst_addr;
     bool cyclic;
+    dma_engine_t engine;
+    uint32_t src_bus_addr;
+    char heap_name[64];
+    char irq_device[64];
+    int period_us;
 } dma_config_t;
 
 typedef void (*dma_callback_t)(void *buffer, size_t size, void *user_data);
 
+typedef struct {
+    void *data;
+    size_t size;
+    int index;
+    uint64_t sequence;
+} dma_lease_t;
+
+typedef struct {
+    uint64_t completed;
+    uint64_t acquired;
+    uint64_t released;
+    uint64_t overruns;
+    uint64_t wakeups;
+    uint64_t errors;
+    int max_batch;
+    int num_buffers;
+    int buffers_free;
+    int buffers_queued;
+    int buffers_leased;
+    int peak_occupancy;
+} dma_stats_t;
+
 int dma_init(dma_context_t **ctx, const dma_config_t *config);
 int dma_start(dma_context_t *ctx);
 int dma_stop(dma_context_t *ctx);
@@ -29,8 +61,12 @@ int dma_cleanup(dma_context_t *ctx);
 
 int dma_set_callback(dma_context_t *ctx, dma_callback_t callback, void *user_data);
 int dma_get_buffer(dma_context_t *ctx, void **buffer, size_t *size);
+int dma_acquire_buffer(dma_context_t *ctx, dma_lease_t *lease);
+int dma_retain_buffer(dma_context_t *ctx, void *buffer);
 int dma_release_buffer(dma_context_t *ctx, void *buffer);
 
+int dma_get_stats(dma_context_t *ctx, dma_stats_t *stats);
+
 bool dma_is_running(dma_context_t *ctx);
 int dma_get_status(dma_context_t *ctx);
 
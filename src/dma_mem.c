@@ -0,0 +1,253 @@
+#define _GNU_SOURCE
+#include "dma_mem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <linux/dma-heap.h>
+#include <linux/dma-buf.h>
+#include <linux/udmabuf.h>
+
+#define PAGEMAP_PRESENT (1ULL << 63)
+#define PAGEMAP_PFN_MASK ((1ULL << 55) - 1)
+
+static size_t page_align(size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) & ~(page - 1);
+}
+
+static int alloc_from_heap(dma_mem_t *mem, const char *heap_name) {
+    char path[128];
+    snprintf(path, sizeof(path), "/dev/dma_heap/%s", heap_name ? heap_name : DMA_MEM_DEFAULT_HEAP);
+    
+    int heap_fd = open(path, O_RDWR | O_CLOEXEC);
+    if (heap_fd < 0) {
+        return -1;
+    }
+    
+    struct dma_heap_allocation_data data;
+    memset(&data, 0, sizeof(data));
+    data.len = mem->size;
+    data.fd_flags = O_RDWR | O_CLOEXEC;
+    
+    int err = ioctl(heap_fd, DMA_HEAP_IOCTL_ALLOC, &data);
+    close(heap_fd);
+    if (err < 0) {
+        fprintf(stderr, "DMA heap %s allocation of %zu bytes failed: %s\n", path, mem->size, strerror(errno));
+        return -1;
+    }
+    
+    mem->fd = (int)data.fd;
+    mem->source = DMA_MEM_SOURCE_HEAP;
+    return 0;
+}
+
+static int alloc_from_udmabuf(dma_mem_t *mem) {
+    int dev_fd = open("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+    if (dev_fd < 0) {
+        return -1;
+    }
+    
+    int memfd = memfd_create("micarray-dma", MFD_ALLOW_SEALING | MFD_CLOEXEC);
+    if (memfd < 0 || ftruncate(memfd, (off_t)mem->size) < 0 ||
+        fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK) < 0) {
+        if (memfd >= 0) close(memfd);
+        close(dev_fd);
+        return -1;
+    }
+    
+    struct udmabuf_create create;
+    memset(&create, 0, sizeof(create));
+    create.memfd = (uint32_t)memfd;
+    create.flags = UDMABUF_FLAGS_CLOEXEC;
+    create.offset = 0;
+    create.size = mem->size;
+    
+    int fd = ioctl(dev_fd, UDMABUF_CREATE, &create);
+    close(dev_fd);
+    if (fd < 0) {
+        close(memfd);
+        return -1;
+    }
+    
+    mem->fd = fd;
+    mem->memfd = memfd;
+    mem->source = DMA_MEM_SOURCE_UDMABUF;
+    return 0;
+}
+
+static int alloc_from_memfd(dma_mem_t *mem) {
+    int memfd = memfd_create("micarray-dma", MFD_CLOEXEC);
+    if (memfd < 0) {
+        return -1;
+    }
+    
+    if (ftruncate(memfd, (off_t)mem->size) < 0) {
+        close(memfd);
+        return -1;
+    }
+    
+    mem->fd = -1;
+    mem->memfd = memfd;
+    mem->source = DMA_MEM_SOURCE_MEMFD;
+    return 0;
+}
+
+/* The engine needs one contiguous physical range. Resolve every page through
+ * /proc/self/pagemap (requires CAP_SYS_ADMIN; PFNs read back as zero otherwise)
+ * and reject anything that is not contiguous. */
+static int resolve_physical(dma_mem_t *mem) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    int fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open /proc/self/pagemap: %s\n", strerror(errno));
+        return -1;
+    }
+    
+    uint64_t first_pfn = 0;
+    for (size_t offset = 0; offset < mem->size; offset += page) {
+        uintptr_t vaddr = (uintptr_t)mem->virt + offset;
+        uint64_t entry = 0;
+        
+        if (pread(fd, &entry, sizeof(entry), (off_t)(vaddr / page * sizeof(entry))) != sizeof(entry)) {
+            close(fd);
+            return -1;
+        }
+        
+        uint64_t pfn = entry & PAGEMAP_PFN_MASK;
+        if (!(entry & PAGEMAP_PRESENT) || pfn == 0) {
+            fprintf(stderr, "DMA buffer page not resolvable (missing CAP_SYS_ADMIN?)\n");
+            close(fd);
+            return -1;
+        }
+        
+        if (offset == 0) {
+            first_pfn = pfn;
+        } else if (pfn != first_pfn + offset / page) {
+            fprintf(stderr, "DMA buffer is not physically contiguous\n");
+            close(fd);
+            return -1;
+        }
+    }
+    
+    close(fd);
+    
+    mem->phys_addr = first_pfn * page;
+    if (mem->phys_addr + mem->size > 0x40000000ULL) {
+        fprintf(stderr, "DMA buffer at 0x%llx is outside the 1 GiB bus window\n",
+                (unsigned long long)mem->phys_addr);
+        return -1;
+    }
+    
+    mem->bus_addr = (uint32_t)mem->phys_addr | DMA_MEM_BUS_ALIAS;
+    return 0;
+}
+
+int dma_mem_alloc(dma_mem_t *mem, size_t size, const char *heap_name, bool physical) {
+    if (!mem || size == 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    memset(mem, 0, sizeof(*mem));
+    mem->fd = -1;
+    mem->memfd = -1;
+    mem->size = page_align(size);
+    
+    int err;
+    if (physical) {
+        err = alloc_from_heap(mem, heap_name);
+        if (err != 0) {
+            err = alloc_from_udmabuf(mem);
+        }
+    } else {
+        err = alloc_from_memfd(mem);
+    }
+    
+    if (err != 0) {
+        fprintf(stderr, "Failed to allocate %zu bytes of DMA memory\n", mem->size);
+        dma_mem_free(mem);
+        return MICARRAY_ERROR_DMA;
+    }
+    
+    int map_fd = (mem->fd >= 0) ? mem->fd : mem->memfd;
+    mem->virt = mmap(NULL, mem->size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, map_fd, 0);
+    if (mem->virt == MAP_FAILED) {
+        fprintf(stderr, "Failed to map DMA memory: %s\n", strerror(errno));
+        mem->virt = NULL;
+        dma_mem_free(mem);
+        return MICARRAY_ERROR_DMA;
+    }
+    
+    dma_mem_sync_start(mem, true);
+    memset(mem->virt, 0, mem->size);
+    dma_mem_sync_end(mem, true);
+    
+    if (physical && (mlock(mem->virt, mem->size) != 0 || resolve_physical(mem) != 0)) {
+        dma_mem_free(mem);
+        return MICARRAY_ERROR_DMA;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+void dma_mem_free(dma_mem_t *mem) {
+    if (!mem) {
+        return;
+    }
+    
+    if (mem->virt) {
+        munmap(mem->virt, mem->size);
+    }
+    
+    if (mem->fd >= 0) {
+        close(mem->fd);
+    }
+    
+    if (mem->memfd >= 0) {
+        close(mem->memfd);
+    }
+    
+    memset(mem, 0, sizeof(*mem));
+    mem->fd = -1;
+    mem->memfd = -1;
+}
+
+static int dma_mem_sync(dma_mem_t *mem, uint64_t flags) {
+    if (!mem || mem->fd < 0) {
+        return MICARRAY_SUCCESS;
+    }
+    
+    struct dma_buf_sync sync = { .flags = flags };
+    while (ioctl(mem->fd, DMA_BUF_IOCTL_SYNC, &sync) < 0) {
+        if (errno != EINTR && errno != EAGAIN) {
+            return MICARRAY_ERROR_DMA;
+        }
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int dma_mem_sync_start(dma_mem_t *mem, bool write) {
+    return dma_mem_sync(mem, DMA_BUF_SYNC_START | (write ? DMA_BUF_SYNC_WRITE : DMA_BUF_SYNC_READ));
+}
+
+int dma_mem_sync_end(dma_mem_t *mem, bool write) {
+    return dma_mem_sync(mem, DMA_BUF_SYNC_END | (write ? DMA_BUF_SYNC_WRITE : DMA_BUF_SYNC_READ));
+}
+
+bool dma_mem_contains(const dma_mem_t *mem, uint32_t bus_addr, size_t len) {
+    return mem && mem->virt && bus_addr >= mem->bus_addr &&
+           (uint64_t)bus_addr + len <= (uint64_t)mem->bus_addr + mem->size;
+}
+
+uint32_t dma_mem_bus_addr(const dma_mem_t *mem, const void *ptr) {
+    return mem->bus_addr + (uint32_t)((const uint8_t*)ptr - (const uint8_t*)mem->virt);
+}
+
+void* dma_mem_virt_addr(const dma_mem_t *mem, uint32_t bus_addr) {
+    return (uint8_t*)mem->virt + (bus_addr - mem->bus_addr);
+}
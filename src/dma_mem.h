@@ -0,0 +1,49 @@
+#ifndef DMA_MEM_H
+#define DMA_MEM_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DMA_MEM_DEFAULT_HEAP "linux,cma"
+#define DMA_MEM_BUS_ALIAS 0xC0000000u
+
+typedef enum {
+    DMA_MEM_SOURCE_HEAP = 0,
+    DMA_MEM_SOURCE_UDMABUF,
+    DMA_MEM_SOURCE_MEMFD
+} dma_mem_source_t;
+
+typedef struct {
+    dma_mem_source_t source;
+    int fd;
+    int memfd;
+    void *virt;
+    size_t size;
+    uint64_t phys_addr;
+    uint32_t bus_addr;
+} dma_mem_t;
+
+/* With physical set, the region is allocated from /dev/dma_heap/<heap_name>
+ * (falling back to /dev/udmabuf) and must resolve to one physically
+ * contiguous range; bus_addr is then the address the DMA engine sees.
+ * Otherwise it is plain memfd memory and bus_addr is left for the caller. */
+int dma_mem_alloc(dma_mem_t *mem, size_t size, const char *heap_name, bool physical);
+void dma_mem_free(dma_mem_t *mem);
+
+int dma_mem_sync_start(dma_mem_t *mem, bool write);
+int dma_mem_sync_end(dma_mem_t *mem, bool write);
+
+bool dma_mem_contains(const dma_mem_t *mem, uint32_t bus_addr, size_t len);
+uint32_t dma_mem_bus_addr(const dma_mem_t *mem, const void *ptr);
+void* dma_mem_virt_addr(const dma_mem_t *mem, uint32_t bus_addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
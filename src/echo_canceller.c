@@ -0,0 +1,402 @@
+#define _GNU_SOURCE
+#include "echo_canceller.h"
+#include "simd.h"
+#include "kernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <fftw3.h>
+
+#define DEFAULT_STEP_SIZE 0.5f
+#define REFERENCE_SECONDS 1
+#define POWER_FLOOR 1e-6f
+#define DIVERGENCE_RATIO 4.0f
+#define DOUBLE_TALK_RATIO 4.0f
+#define ERLE_SMOOTHING 0.05f
+#define DOUBLE_TALK_SMOOTHING 0.005f
+
+typedef struct {
+    float4_t *wr;
+    float4_t *wi;
+    float echo_power;
+    float error_power;
+} channel_filter_t;
+
+/* Partitioned-block frequency-domain NLMS (overlap-save, FFT size twice
+ * the partition). The reference spectra of the last `partitions` blocks
+ * are shared by every channel, so the per-channel cost is fixed at
+ * partitions complex multiply-adds per bin plus four FFTs per block.
+ * Spectra are stored split into real and imaginary float4_t arrays so the
+ * bin loops run four bins per vector. */
+struct echo_canceller_context {
+    echo_canceller_config_t config;
+    int fft_size;
+    int bins;
+    int vectors;
+    int partitions;
+    int head;
+    int constrain;
+    
+    float4_t *xr;
+    float4_t *xi;
+    float4_t *norm;
+    float4_t *er;
+    float4_t *ei;
+    channel_filter_t *channels;
+    uint32_t active_mask;
+    kernel_complex_mac_t complex_mac;
+    
+    float *ref_time;
+    float *time;
+    fftwf_complex *spectrum;
+    fftwf_plan forward;
+    fftwf_plan inverse;
+    
+    float *fifo;
+    size_t fifo_capacity;
+    size_t fifo_read;
+    size_t fifo_fill;
+};
+
+int echo_canceller_init(echo_canceller_context_t **ctx, const echo_canceller_config_t *config) {
+    if (!ctx || !config || config->num_channels < 1 || config->num_channels > MAX_MICROPHONES ||
+        config->sample_rate <= 0 || config->block_size < SIMD_LANES ||
+        config->block_size > ECHO_CANCELLER_MAX_BLOCK ||
+        (config->block_size & (config->block_size - 1)) != 0 ||
+        config->tail_length < 1 || config->step_size < 0.0f || config->step_size > 1.0f ||
+        config->delay < 0 || config->delay > config->sample_rate * REFERENCE_SECONDS) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(echo_canceller_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    (*ctx)->config = *config;
+    if ((*ctx)->config.step_size == 0.0f) {
+        (*ctx)->config.step_size = DEFAULT_STEP_SIZE;
+    }
+    
+    const int block = config->block_size;
+    (*ctx)->fft_size = 2 * block;
+    (*ctx)->bins = block + 1;
+    (*ctx)->vectors = ((*ctx)->bins + SIMD_LANES - 1) / SIMD_LANES;
+    (*ctx)->complex_mac = kernels_get()->complex_mac;
+    (*ctx)->partitions = (config->tail_length + block - 1) / block;
+    (*ctx)->active_mask = (config->num_channels == 32) ? 0xFFFFFFFFu : ((1u << config->num_channels) - 1);
+    
+    const size_t spectra = (size_t)(*ctx)->partitions * (*ctx)->vectors;
+    (*ctx)->xr = simd_alloc(spectra);
+    (*ctx)->xi = simd_alloc(spectra);
+    (*ctx)->norm = simd_alloc((*ctx)->vectors);
+    (*ctx)->er = simd_alloc((*ctx)->vectors);
+    (*ctx)->ei = simd_alloc((*ctx)->vectors);
+    (*ctx)->channels = calloc(config->num_channels, sizeof(channel_filter_t));
+    (*ctx)->ref_time = fftwf_alloc_real((*ctx)->fft_size);
+    (*ctx)->time = fftwf_alloc_real((*ctx)->fft_size);
+    (*ctx)->spectrum = fftwf_alloc_complex((*ctx)->bins);
+    (*ctx)->fifo_capacity = (size_t)config->sample_rate * REFERENCE_SECONDS + MAX_BUFFER_SIZE;
+    (*ctx)->fifo = calloc((*ctx)->fifo_capacity, sizeof(float));
+    
+    if (!(*ctx)->xr || !(*ctx)->xi || !(*ctx)->norm || !(*ctx)->er || !(*ctx)->ei ||
+        !(*ctx)->channels || !(*ctx)->ref_time || !(*ctx)->time || !(*ctx)->spectrum || !(*ctx)->fifo) {
+        echo_canceller_cleanup(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    for (int c = 0; c < config->num_channels; c++) {
+        (*ctx)->channels[c].wr = simd_alloc(spectra);
+        (*ctx)->channels[c].wi = simd_alloc(spectra);
+        if (!(*ctx)->channels[c].wr || !(*ctx)->channels[c].wi) {
+            echo_canceller_cleanup(*ctx);
+            *ctx = NULL;
+            return MICARRAY_ERROR_MEMORY;
+        }
+    }
+    
+    memset((*ctx)->ref_time, 0, (*ctx)->fft_size * sizeof(float));
+    (*ctx)->fifo_fill = config->delay;
+    
+    (*ctx)->forward = fftwf_plan_dft_r2c_1d((*ctx)->fft_size, (*ctx)->time, (*ctx)->spectrum, FFTW_MEASURE);
+    (*ctx)->inverse = fftwf_plan_dft_c2r_1d((*ctx)->fft_size, (*ctx)->spectrum, (*ctx)->time, FFTW_MEASURE);
+    if (!(*ctx)->forward || !(*ctx)->inverse) {
+        echo_canceller_cleanup(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int echo_canceller_cleanup(echo_canceller_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (ctx->forward) {
+        fftwf_destroy_plan(ctx->forward);
+    }
+    if (ctx->inverse) {
+        fftwf_destroy_plan(ctx->inverse);
+    }
+    
+    if (ctx->channels) {
+        for (int c = 0; c < ctx->config.num_channels; c++) {
+            free(ctx->channels[c].wr);
+            free(ctx->channels[c].wi);
+        }
+        free(ctx->channels);
+    }
+    
+    free(ctx->xr);
+    free(ctx->xi);
+    free(ctx->norm);
+    free(ctx->er);
+    free(ctx->ei);
+    free(ctx->fifo);
+    
+    if (ctx->ref_time) {
+        fftwf_free(ctx->ref_time);
+    }
+    if (ctx->time) {
+        fftwf_free(ctx->time);
+    }
+    if (ctx->spectrum) {
+        fftwf_free(ctx->spectrum);
+    }
+    
+    free(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int echo_canceller_push_reference(echo_canceller_context_t *ctx, const int16_t *stereo, size_t frames) {
+    if (!ctx || !stereo) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    for (size_t i = 0; i < frames; i++) {
+        if (ctx->fifo_fill == ctx->fifo_capacity) {
+            ctx->fifo_read = (ctx->fifo_read + 1) % ctx->fifo_capacity;
+            ctx->fifo_fill--;
+        }
+        
+        size_t pos = (ctx->fifo_read + ctx->fifo_fill) % ctx->fifo_capacity;
+        ctx->fifo[pos] = (stereo[2 * i] + stereo[2 * i + 1]) / 65536.0f;
+        ctx->fifo_fill++;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+/* Missing reference (playback stalled) reads as silence. */
+static void pop_reference(echo_canceller_context_t *ctx, float *out, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        if (ctx->fifo_fill > 0) {
+            out[i] = ctx->fifo[ctx->fifo_read];
+            ctx->fifo_read = (ctx->fifo_read + 1) % ctx->fifo_capacity;
+            ctx->fifo_fill--;
+        } else {
+            out[i] = 0.0f;
+        }
+    }
+}
+
+/* Shifts the next block of reference into the analysis frame and makes
+ * its spectrum the newest partition. */
+static void update_reference(echo_canceller_context_t *ctx) {
+    const int block = ctx->config.block_size;
+    const int vectors = ctx->vectors;
+    
+    memmove(ctx->ref_time, ctx->ref_time + block, block * sizeof(float));
+    pop_reference(ctx, ctx->ref_time + block, block);
+    
+    fftwf_execute_dft_r2c(ctx->forward, ctx->ref_time, ctx->spectrum);
+    
+    ctx->head = (ctx->head + 1) % ctx->partitions;
+    simd_split_complex((const float*)ctx->spectrum, ctx->xr + ctx->head * vectors, ctx->xi + ctx->head * vectors, ctx->bins);
+    
+    /* Step size per bin, normalised by the reference power in the whole
+     * tail. The floor keeps silence from blowing the step up. */
+    const float floor = POWER_FLOOR * ctx->fft_size * ctx->partitions;
+    for (int v = 0; v < vectors; v++) {
+        float4_t power = {floor, floor, floor, floor};
+        for (int p = 0; p < ctx->partitions; p++) {
+            float4_t xr = ctx->xr[p * vectors + v];
+            float4_t xi = ctx->xi[p * vectors + v];
+            power += xr * xr + xi * xi;
+        }
+        ctx->norm[v] = ctx->config.step_size / power;
+    }
+}
+
+static void cancel_channel(echo_canceller_context_t *ctx, channel_filter_t *filter, int16_t *samples) {
+    const int block = ctx->config.block_size;
+    const int vectors = ctx->vectors;
+    const int partitions = ctx->partitions;
+    float4_t *yr = ctx->er;
+    float4_t *yi = ctx->ei;
+    
+    memset(yr, 0, vectors * sizeof(float4_t));
+    memset(yi, 0, vectors * sizeof(float4_t));
+    for (int p = 0; p < partitions; p++) {
+        const int slot = (ctx->head - p + partitions) % partitions;
+        const float4_t *xr = ctx->xr + slot * vectors;
+        const float4_t *xi = ctx->xi + slot * vectors;
+        const float4_t *wr = filter->wr + p * vectors;
+        const float4_t *wi = filter->wi + p * vectors;
+        ctx->complex_mac((float*)yr, (float*)yi, (const float*)wr, (const float*)wi,
+                         (const float*)xr, (const float*)xi, vectors * SIMD_LANES);
+    }
+    
+    simd_merge_complex(yr, yi, (float*)ctx->spectrum, ctx->bins);
+    fftwf_execute(ctx->inverse);
+    
+    /* The last block of the circular result is the linear echo estimate. */
+    const float scale = 1.0f / ctx->fft_size;
+    float mic_energy = 0.0f, error_energy = 0.0f;
+    for (int j = 0; j < block; j++) {
+        float d = samples[j] / 32768.0f;
+        float e = d - ctx->time[block + j] * scale;
+        mic_energy += d * d;
+        error_energy += e * e;
+        ctx->time[j] = 0.0f;
+        ctx->time[block + j] = e;
+    }
+    
+    if (error_energy > DIVERGENCE_RATIO * mic_energy && mic_energy > 0.0f) {
+        memset(filter->wr, 0, (size_t)partitions * vectors * sizeof(float4_t));
+        memset(filter->wi, 0, (size_t)partitions * vectors * sizeof(float4_t));
+        filter->echo_power = 0.0f;
+        filter->error_power = 0.0f;
+        return;
+    }
+    
+    for (int j = 0; j < block; j++) {
+        float e = fmaxf(-1.0f, fminf(1.0f, ctx->time[block + j]));
+        samples[j] = (int16_t)(e * 32767.0f);
+    }
+    
+    /* Once the filter has converged, a jump in the residual means the
+     * near end is talking: hold the coefficients, so speech is not learnt
+     * as echo, while the residual average slowly catches up. A changed echo
+     * path therefore re-adapts after about half a second. */
+    bool double_talk = filter->echo_power > DOUBLE_TALK_RATIO * filter->error_power &&
+                       error_energy > DOUBLE_TALK_RATIO * filter->error_power;
+    
+    filter->echo_power += ERLE_SMOOTHING * (mic_energy - filter->echo_power);
+    if (double_talk) {
+        filter->error_power += DOUBLE_TALK_SMOOTHING * (error_energy - filter->error_power);
+        return;
+    }
+    filter->error_power += ERLE_SMOOTHING * (error_energy - filter->error_power);
+    
+    fftwf_execute(ctx->forward);
+    simd_split_complex((const float*)ctx->spectrum, ctx->er, ctx->ei, ctx->bins);
+    
+    const float4_t *er = ctx->er;
+    const float4_t *ei = ctx->ei;
+    for (int p = 0; p < partitions; p++) {
+        const int slot = (ctx->head - p + partitions) % partitions;
+        const float4_t *xr = ctx->xr + slot * vectors;
+        const float4_t *xi = ctx->xi + slot * vectors;
+        float4_t *wr = filter->wr + p * vectors;
+        float4_t *wi = filter->wi + p * vectors;
+        for (int v = 0; v < vectors; v++) {
+            float4_t mu = ctx->norm[v];
+            wr[v] += mu * (xr[v] * er[v] + xi[v] * ei[v]);
+            wi[v] += mu * (xr[v] * ei[v] - xi[v] * er[v]);
+        }
+    }
+    
+    /* Gradient constraint, one partition per block in turn: drop the
+     * circular wrap-around half of its impulse response. */
+    float4_t *wr = filter->wr + ctx->constrain * vectors;
+    float4_t *wi = filter->wi + ctx->constrain * vectors;
+    simd_merge_complex(wr, wi, (float*)ctx->spectrum, ctx->bins);
+    fftwf_execute(ctx->inverse);
+    for (int j = 0; j < block; j++) {
+        ctx->time[j] *= scale;
+        ctx->time[block + j] = 0.0f;
+    }
+    fftwf_execute(ctx->forward);
+    simd_split_complex((const float*)ctx->spectrum, wr, wi, ctx->bins);
+}
+
+int echo_canceller_process(echo_canceller_context_t *ctx, int16_t **channels, size_t frames,
+                           uint32_t active_mask) {
+    if (!ctx || !channels) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    const size_t block = ctx->config.block_size;
+    ctx->active_mask = active_mask;
+    
+    size_t offset = 0;
+    for (; offset + block <= frames; offset += block) {
+        update_reference(ctx);
+        
+        for (int c = 0; c < ctx->config.num_channels; c++) {
+            if (active_mask & (1u << c)) {
+                cancel_channel(ctx, &ctx->channels[c], channels[c] + offset);
+            }
+        }
+        
+        ctx->constrain = (ctx->constrain + 1) % ctx->partitions;
+    }
+    
+    if (offset < frames) {
+        pop_reference(ctx, ctx->time, frames - offset);
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int echo_canceller_set_delay(echo_canceller_context_t *ctx, int delay) {
+    if (!ctx || delay < 0 || delay > ctx->config.sample_rate * REFERENCE_SECONDS) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    ctx->config.delay = delay;
+    
+    if (ctx->fifo_fill > (size_t)delay) {
+        size_t drop = ctx->fifo_fill - delay;
+        ctx->fifo_read = (ctx->fifo_read + drop) % ctx->fifo_capacity;
+        ctx->fifo_fill = delay;
+    }
+    
+    while (ctx->fifo_fill < (size_t)delay) {
+        ctx->fifo_read = (ctx->fifo_read + ctx->fifo_capacity - 1) % ctx->fifo_capacity;
+        ctx->fifo[ctx->fifo_read] = 0.0f;
+        ctx->fifo_fill++;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int echo_canceller_get_delay(const echo_canceller_context_t *ctx) {
+    return ctx ? ctx->config.delay : -1;
+}
+
+float echo_canceller_get_erle(const echo_canceller_context_t *ctx) {
+    if (!ctx) {
+        return 0.0f;
+    }
+    
+    float sum = 0.0f;
+    int count = 0;
+    for (int c = 0; c < ctx->config.num_channels; c++) {
+        const channel_filter_t *filter = &ctx->channels[c];
+        if (!(ctx->active_mask & (1u << c)) || filter->echo_power <= 0.0f) {
+            continue;
+        }
+        sum += 10.0f * log10f(filter->echo_power / (filter->error_power + 1e-12f));
+        count++;
+    }
+    
+    return count > 0 ? sum / count : 0.0f;
+}
@@ -0,0 +1,51 @@
+#ifndef ECHO_CANCELLER_H
+#define ECHO_CANCELLER_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ECHO_CANCELLER_MAX_BLOCK 256
+
+typedef struct echo_canceller_context echo_canceller_context_t;
+
+/* block_size is the partition length and must be a power of two up to
+ * ECHO_CANCELLER_MAX_BLOCK; tail_length (frames) is rounded up to whole
+ * partitions. delay is the initial playback-to-capture offset in frames. */
+typedef struct {
+    int num_channels;
+    int sample_rate;
+    int block_size;
+    int tail_length;
+    float step_size;
+    int delay;
+} echo_canceller_config_t;
+
+int echo_canceller_init(echo_canceller_context_t **ctx, const echo_canceller_config_t *config);
+int echo_canceller_cleanup(echo_canceller_context_t *ctx);
+
+/* Queues interleaved stereo samples exactly as they were sent to the
+ * output; the two channels are mixed down to one reference. */
+int echo_canceller_push_reference(echo_canceller_context_t *ctx, const int16_t *stereo, size_t frames);
+
+/* Removes the echo from channels[c][0..frames) in place for every channel
+ * in active_mask. Each call consumes frames of reference; a trailing
+ * remainder shorter than block_size is passed through unprocessed. */
+int echo_canceller_process(echo_canceller_context_t *ctx, int16_t **channels, size_t frames,
+                           uint32_t active_mask);
+
+/* Re-aligns the reference so capture sees playback delay frames late. */
+int echo_canceller_set_delay(echo_canceller_context_t *ctx, int delay);
+int echo_canceller_get_delay(const echo_canceller_context_t *ctx);
+
+/* Echo return loss enhancement in dB, averaged over the active channels. */
+float echo_canceller_get_erle(const echo_canceller_context_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,450 @@
+#define _GNU_SOURCE
+#include "hrtf.h"
+#include "simd.h"
+#include "kernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fftw3.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef struct {
+    char magic[8];
+    uint32_t sample_rate;
+    uint32_t taps;
+    uint32_t directions;
+    uint32_t reserved;
+} hrir_header_t;
+
+/* Each ear's filter is `partitions` spectra of B taps; a source holds the
+ * spectra of its current HRIR and of the one it is fading out of. */
+typedef struct {
+    float4_t *hr[2][2];
+    float4_t *hi[2][2];
+    int current;
+    int direction;
+    int previous;
+    
+    float4_t *xr;
+    float4_t *xi;
+    float *input;
+    int head;
+} hrtf_source_t;
+
+/* Uniformly partitioned overlap-save convolution (FFT size twice the
+ * partition). Every source needs its own forward FFT, but the products are
+ * summed per ear in the frequency domain so the whole mix costs two
+ * inverse FFTs per block, four while any source is crossfading. */
+struct hrtf_context {
+    hrtf_config_t config;
+    int fft_size;
+    int bins;
+    int vectors;
+    int partitions;
+    kernel_complex_mac_t complex_mac;
+    
+    void *map;
+    size_t map_size;
+    int taps;
+    int directions;
+    const float *hrir;
+    float *unit;
+    
+    hrtf_source_t *sources;
+    float4_t *accr[2];
+    float4_t *acci[2];
+    float4_t *fader[2];
+    float4_t *fadei[2];
+    
+    float *time;
+    float *ear[2];
+    fftwf_complex *spectrum;
+    fftwf_plan forward;
+    fftwf_plan inverse;
+};
+
+static int map_hrir_file(hrtf_context_t *ctx) {
+    int fd = open(ctx->config.hrir_file, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open HRIR file %s\n", ctx->config.hrir_file);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(hrir_header_t)) {
+        close(fd);
+        fprintf(stderr, "HRIR file %s is truncated\n", ctx->config.hrir_file);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    ctx->map_size = (size_t)st.st_size;
+    ctx->map = mmap(NULL, ctx->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ctx->map == MAP_FAILED) {
+        ctx->map = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    const hrir_header_t *header = ctx->map;
+    size_t expected = sizeof(hrir_header_t) +
+                      (size_t)header->directions * 2 * sizeof(float) * (1 + (size_t)header->taps);
+    if (memcmp(header->magic, HRTF_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->taps == 0 || header->directions == 0 || ctx->map_size < expected) {
+        fprintf(stderr, "HRIR file %s is not a valid HRIR set\n", ctx->config.hrir_file);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if ((int)header->sample_rate != ctx->config.sample_rate) {
+        fprintf(stderr, "HRIR file %s is for %u Hz, not %d Hz\n", ctx->config.hrir_file,
+                header->sample_rate, ctx->config.sample_rate);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    ctx->taps = header->taps;
+    ctx->directions = header->directions;
+    
+    const float *angles = (const float*)(header + 1);
+    ctx->hrir = angles + 2 * (size_t)ctx->directions;
+    
+    ctx->unit = malloc(ctx->directions * 3 * sizeof(float));
+    if (!ctx->unit) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    for (int d = 0; d < ctx->directions; d++) {
+        float azimuth = angles[2 * d] * M_PI / 180.0f;
+        float elevation = angles[2 * d + 1] * M_PI / 180.0f;
+        ctx->unit[3 * d] = cosf(elevation) * cosf(azimuth);
+        ctx->unit[3 * d + 1] = cosf(elevation) * sinf(azimuth);
+        ctx->unit[3 * d + 2] = sinf(elevation);
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int hrtf_init(hrtf_context_t **ctx, const hrtf_config_t *config) {
+    if (!ctx || !config || config->sample_rate <= 0 || config->block_size < SIMD_LANES ||
+        config->block_size > HRTF_MAX_BLOCK || (config->block_size & (config->block_size - 1)) != 0 ||
+        config->max_sources < 1 || config->max_sources > HRTF_MAX_SOURCES) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(hrtf_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    (*ctx)->config = *config;
+    (*ctx)->config.hrir_file[sizeof((*ctx)->config.hrir_file) - 1] = '\0';
+    
+    int result = map_hrir_file(*ctx);
+    if (result != MICARRAY_SUCCESS) {
+        hrtf_cleanup(*ctx);
+        *ctx = NULL;
+        return result;
+    }
+    
+    const int block = config->block_size;
+    (*ctx)->fft_size = 2 * block;
+    (*ctx)->bins = block + 1;
+    (*ctx)->vectors = ((*ctx)->bins + SIMD_LANES - 1) / SIMD_LANES;
+    (*ctx)->partitions = ((*ctx)->taps + block - 1) / block;
+    (*ctx)->complex_mac = kernels_get()->complex_mac;
+    
+    const int vectors = (*ctx)->vectors;
+    const size_t spectra = (size_t)(*ctx)->partitions * vectors;
+    bool ok = true;
+    for (int e = 0; e < 2; e++) {
+        (*ctx)->accr[e] = simd_alloc(vectors);
+        (*ctx)->acci[e] = simd_alloc(vectors);
+        (*ctx)->fader[e] = simd_alloc(vectors);
+        (*ctx)->fadei[e] = simd_alloc(vectors);
+        (*ctx)->ear[e] = fftwf_alloc_real((*ctx)->fft_size);
+        ok = ok && (*ctx)->accr[e] && (*ctx)->acci[e] && (*ctx)->fader[e] && (*ctx)->fadei[e] && (*ctx)->ear[e];
+    }
+    (*ctx)->time = fftwf_alloc_real((*ctx)->fft_size);
+    (*ctx)->spectrum = fftwf_alloc_complex((*ctx)->bins);
+    (*ctx)->sources = calloc(config->max_sources, sizeof(hrtf_source_t));
+    
+    if (!ok || !(*ctx)->time || !(*ctx)->spectrum || !(*ctx)->sources) {
+        hrtf_cleanup(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    for (int s = 0; s < config->max_sources; s++) {
+        hrtf_source_t *source = &(*ctx)->sources[s];
+        for (int slot = 0; slot < 2; slot++) {
+            for (int e = 0; e < 2; e++) {
+                source->hr[slot][e] = simd_alloc(spectra);
+                source->hi[slot][e] = simd_alloc(spectra);
+                ok = ok && source->hr[slot][e] && source->hi[slot][e];
+            }
+        }
+        source->xr = simd_alloc(spectra);
+        source->xi = simd_alloc(spectra);
+        source->input = calloc((*ctx)->fft_size, sizeof(float));
+        source->direction = -1;
+        source->previous = -1;
+        if (!ok || !source->xr || !source->xi || !source->input) {
+            hrtf_cleanup(*ctx);
+            *ctx = NULL;
+            return MICARRAY_ERROR_MEMORY;
+        }
+    }
+    
+    (*ctx)->forward = fftwf_plan_dft_r2c_1d((*ctx)->fft_size, (*ctx)->time, (*ctx)->spectrum, FFTW_MEASURE);
+    (*ctx)->inverse = fftwf_plan_dft_c2r_1d((*ctx)->fft_size, (*ctx)->spectrum, (*ctx)->time, FFTW_MEASURE);
+    if (!(*ctx)->forward || !(*ctx)->inverse) {
+        hrtf_cleanup(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int hrtf_cleanup(hrtf_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (ctx->forward) {
+        fftwf_destroy_plan(ctx->forward);
+    }
+    if (ctx->inverse) {
+        fftwf_destroy_plan(ctx->inverse);
+    }
+    
+    if (ctx->sources) {
+        for (int s = 0; s < ctx->config.max_sources; s++) {
+            hrtf_source_t *source = &ctx->sources[s];
+            for (int slot = 0; slot < 2; slot++) {
+                for (int e = 0; e < 2; e++) {
+                    free(source->hr[slot][e]);
+                    free(source->hi[slot][e]);
+                }
+            }
+            free(source->xr);
+            free(source->xi);
+            free(source->input);
+        }
+        free(ctx->sources);
+    }
+    
+    for (int e = 0; e < 2; e++) {
+        free(ctx->accr[e]);
+        free(ctx->acci[e]);
+        free(ctx->fader[e]);
+        free(ctx->fadei[e]);
+        if (ctx->ear[e]) {
+            fftwf_free(ctx->ear[e]);
+        }
+    }
+    
+    if (ctx->time) {
+        fftwf_free(ctx->time);
+    }
+    if (ctx->spectrum) {
+        fftwf_free(ctx->spectrum);
+    }
+    
+    free(ctx->unit);
+    if (ctx->map) {
+        munmap(ctx->map, ctx->map_size);
+    }
+    
+    free(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+/* The HRIR whose direction is closest to the source's bearing. A source
+ * at the origin has no bearing and is placed straight ahead. */
+static int nearest_direction(const hrtf_context_t *ctx, const sound_location_t *location) {
+    float x = location->x, y = location->y, z = location->z;
+    if (x == 0.0f && y == 0.0f && z == 0.0f) {
+        x = 1.0f;
+    }
+    
+    int best = 0;
+    float best_dot = -INFINITY;
+    for (int d = 0; d < ctx->directions; d++) {
+        float dot = x * ctx->unit[3 * d] + y * ctx->unit[3 * d + 1] + z * ctx->unit[3 * d + 2];
+        if (dot > best_dot) {
+            best_dot = dot;
+            best = d;
+        }
+    }
+    
+    return best;
+}
+
+/* Transforms one ear of an HRIR, straight from the mapping, into the
+ * partition spectra of a source's filter slot. */
+static void load_filter(hrtf_context_t *ctx, int direction, int ear, float4_t *hr, float4_t *hi) {
+    const int block = ctx->config.block_size;
+    const float *hrir = ctx->hrir + ((size_t)direction * 2 + ear) * ctx->taps;
+    
+    for (int p = 0; p < ctx->partitions; p++) {
+        int start = p * block;
+        int count = ctx->taps - start < block ? ctx->taps - start : block;
+        memcpy(ctx->time, hrir + start, count * sizeof(float));
+        memset(ctx->time + count, 0, (ctx->fft_size - count) * sizeof(float));
+        
+        fftwf_execute(ctx->forward);
+        simd_split_complex((const float*)ctx->spectrum, hr + p * ctx->vectors, hi + p * ctx->vectors, ctx->bins);
+    }
+}
+
+static void select_direction(hrtf_context_t *ctx, hrtf_source_t *source, int direction) {
+    if (direction == source->direction) {
+        return;
+    }
+    
+    source->previous = source->direction;
+    source->direction = direction;
+    source->current ^= 1;
+    
+    for (int e = 0; e < 2; e++) {
+        load_filter(ctx, direction, e, source->hr[source->current][e], source->hi[source->current][e]);
+    }
+}
+
+/* Adds one block of a source into the per-ear accumulators. While it is
+ * fading, the difference between its old and new filter output is
+ * gathered separately so a single ramp can blend all fading sources. */
+static bool accumulate_source(hrtf_context_t *ctx, hrtf_source_t *source, const int16_t *samples) {
+    const int block = ctx->config.block_size;
+    const int vectors = ctx->vectors;
+    const int partitions = ctx->partitions;
+    
+    memmove(source->input, source->input + block, block * sizeof(float));
+    for (int j = 0; j < block; j++) {
+        source->input[block + j] = samples[j] / 32768.0f;
+    }
+    
+    memcpy(ctx->time, source->input, ctx->fft_size * sizeof(float));
+    fftwf_execute(ctx->forward);
+    
+    source->head = (source->head + 1) % partitions;
+    simd_split_complex((const float*)ctx->spectrum, source->xr + source->head * vectors,
+                       source->xi + source->head * vectors, ctx->bins);
+    
+    const bool fading = source->previous >= 0;
+    const int old = source->current ^ 1;
+    
+    for (int p = 0; p < partitions; p++) {
+        const int slot = (source->head - p + partitions) % partitions;
+        const float4_t *xr = source->xr + slot * vectors;
+        const float4_t *xi = source->xi + slot * vectors;
+        
+        for (int e = 0; e < 2; e++) {
+            const float4_t *hr = source->hr[source->current][e] + p * vectors;
+            const float4_t *hi = source->hi[source->current][e] + p * vectors;
+            float4_t *yr = ctx->accr[e];
+            float4_t *yi = ctx->acci[e];
+            ctx->complex_mac((float*)yr, (float*)yi, (const float*)hr, (const float*)hi,
+                             (const float*)xr, (const float*)xi, vectors * SIMD_LANES);
+            
+            if (!fading) {
+                continue;
+            }
+            
+            const float4_t *gr = source->hr[old][e] + p * vectors;
+            const float4_t *gi = source->hi[old][e] + p * vectors;
+            float4_t *fr = ctx->fader[e];
+            float4_t *fi = ctx->fadei[e];
+            for (int v = 0; v < vectors; v++) {
+                float4_t dr = gr[v] - hr[v];
+                float4_t di = gi[v] - hi[v];
+                fr[v] += dr * xr[v] - di * xi[v];
+                fi[v] += dr * xi[v] + di * xr[v];
+            }
+        }
+    }
+    
+    source->previous = -1;
+    return fading;
+}
+
+/* Overlap-save output: the last block of the inverse transform. */
+static void inverse_block(hrtf_context_t *ctx, const float4_t *re, const float4_t *im, float *out) {
+    const int block = ctx->config.block_size;
+    simd_merge_complex(re, im, (float*)ctx->spectrum, ctx->bins);
+    fftwf_execute(ctx->inverse);
+    memcpy(out, ctx->time + block, block * sizeof(float));
+}
+
+static int16_t to_sample(float value) {
+    value += (value < 0.0f) ? -0.5f : 0.5f;
+    value = fmaxf(-32768.0f, fminf(32767.0f, value));
+    return (int16_t)value;
+}
+
+int hrtf_render(hrtf_context_t *ctx, const int16_t *const *sources, const sound_location_t *locations,
+                int num_sources, float gain, int16_t *stereo, size_t frames) {
+    if (!ctx || !sources || !locations || !stereo || num_sources < 0 ||
+        num_sources > ctx->config.max_sources || frames % ctx->config.block_size != 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    const size_t block = ctx->config.block_size;
+    const size_t vector_bytes = ctx->vectors * sizeof(float4_t);
+    const float scale = 32768.0f * gain / ctx->fft_size;
+    
+    for (size_t offset = 0; offset < frames; offset += block) {
+        bool fading = false;
+        for (int e = 0; e < 2; e++) {
+            memset(ctx->accr[e], 0, vector_bytes);
+            memset(ctx->acci[e], 0, vector_bytes);
+            memset(ctx->fader[e], 0, vector_bytes);
+            memset(ctx->fadei[e], 0, vector_bytes);
+        }
+        
+        for (int s = 0; s < num_sources; s++) {
+            hrtf_source_t *source = &ctx->sources[s];
+            select_direction(ctx, source, nearest_direction(ctx, &locations[s]));
+            if (accumulate_source(ctx, source, sources[s] + offset)) {
+                fading = true;
+            }
+        }
+        
+        int16_t *out = stereo + 2 * offset;
+        for (int e = 0; e < 2; e++) {
+            float *ear = ctx->ear[e];
+            inverse_block(ctx, ctx->accr[e], ctx->acci[e], ear);
+            
+            /* new + (1 - w) * (old - new), w rising over the block */
+            if (fading) {
+                inverse_block(ctx, ctx->fader[e], ctx->fadei[e], ear + block);
+                for (size_t j = 0; j < block; j++) {
+                    ear[j] += (1.0f - (float)(j + 1) / block) * ear[block + j];
+                }
+            }
+            
+            for (size_t j = 0; j < block; j++) {
+                out[2 * j + e] = to_sample(ear[j] * scale);
+            }
+        }
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int hrtf_get_num_directions(const hrtf_context_t *ctx) {
+    return ctx ? ctx->directions : 0;
+}
+
+int hrtf_get_taps(const hrtf_context_t *ctx) {
+    return ctx ? ctx->taps : 0;
+}
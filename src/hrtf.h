@@ -0,0 +1,53 @@
+#ifndef HRTF_H
+#define HRTF_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HRTF_MAX_BLOCK 1024
+#define HRTF_MAX_SOURCES 8
+#define HRTF_FILE_MAGIC "MICHRIR1"
+
+typedef struct hrtf_context hrtf_context_t;
+
+/* HRIR set file, native byte order:
+ *   char     magic[8]          HRTF_FILE_MAGIC
+ *   uint32_t sample_rate
+ *   uint32_t taps              impulse response length per ear
+ *   uint32_t directions
+ *   uint32_t reserved          0
+ *   float    angles[directions][2]           azimuth, elevation in degrees
+ *   float    hrir[directions][2][taps]       left ear, then right ear
+ * Azimuth is counter-clockwise from the array's +x axis, as in
+ * sound_location_t, and elevation is positive towards +z. */
+typedef struct {
+    char hrir_file[256];
+    int sample_rate;
+    int block_size;
+    int max_sources;
+} hrtf_config_t;
+
+/* block_size is the partition length and must be a power of two up to
+ * HRTF_MAX_BLOCK. The file is memory-mapped for the life of the context. */
+int hrtf_init(hrtf_context_t **ctx, const hrtf_config_t *config);
+int hrtf_cleanup(hrtf_context_t *ctx);
+
+/* Renders sources[s][0..frames) from locations[s] into interleaved stereo,
+ * scaled by gain. frames must be a multiple of block_size. Source s keeps
+ * its own convolution history, so a source should stay in the same slot.
+ * A source that moves to another HRIR is crossfaded over one block. */
+int hrtf_render(hrtf_context_t *ctx, const int16_t *const *sources, const sound_location_t *locations,
+                int num_sources, float gain, int16_t *stereo, size_t frames);
+
+int hrtf_get_num_directions(const hrtf_context_t *ctx);
+int hrtf_get_taps(const hrtf_context_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,147 @@
+#define _GNU_SOURCE
+#include "kernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#if defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#ifndef HWCAP_ASIMDDP
+#define HWCAP_ASIMDDP (1 << 20)
+#endif
+#endif
+
+/* The scalar versions are the reference the others are tested against. */
+static void complex_mac_scalar(float *yr, float *yi, const float *ar, const float *ai,
+                               const float *br, const float *bi, int count) {
+    for (int k = 0; k < count; k++) {
+        yr[k] += ar[k] * br[k] - ai[k] * bi[k];
+        yi[k] += ar[k] * bi[k] + ai[k] * br[k];
+    }
+}
+
+static void gemv_int8_scalar(const int8_t *weight, int rows, int stride, const int8_t *x, int32_t *out) {
+    for (int i = 0; i < rows; i++) {
+        const int8_t *row = weight + (size_t)i * stride;
+        int32_t acc = 0;
+        for (int j = 0; j < stride; j++) {
+            acc += row[j] * x[j];
+        }
+        out[i] = acc;
+    }
+}
+
+/* Ordered from least to most capable; "auto" takes the last one the CPU
+ * supports. */
+static const kernel_table_t tables[] = {
+    {"scalar", "scalar", complex_mac_scalar, "scalar", gemv_int8_scalar},
+#if defined(__x86_64__) || defined(__i386__)
+    {"sse4", "sse4", kernels_complex_mac_sse4, "sse4", kernels_gemv_int8_sse4},
+    {"avx2", "avx2", kernels_complex_mac_avx2, "avx2", kernels_gemv_int8_avx2},
+    {"avx512", "avx512", kernels_complex_mac_avx512, "avx512", kernels_gemv_int8_avx512},
+#endif
+#if defined(__aarch64__)
+    {"neon", "neon", kernels_complex_mac_neon, "neon", kernels_gemv_int8_neon},
+    {"dotprod", "neon", kernels_complex_mac_neon, "dotprod", kernels_gemv_int8_dotprod},
+#endif
+};
+
+static const char *const known_levels[] = {"auto", "scalar", "sse4", "avx2", "avx512", "neon", "dotprod"};
+
+static const kernel_table_t *selected;
+static pthread_mutex_t select_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t default_once = PTHREAD_ONCE_INIT;
+
+static bool cpu_supports(const char *level) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (strcmp(level, "sse4") == 0) {
+        return __builtin_cpu_supports("sse4.1");
+    } else if (strcmp(level, "avx2") == 0) {
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    } else if (strcmp(level, "avx512") == 0) {
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    }
+#endif
+#if defined(__aarch64__)
+    if (strcmp(level, "neon") == 0) {
+        return true;
+    } else if (strcmp(level, "dotprod") == 0) {
+        return (getauxval(AT_HWCAP) & HWCAP_ASIMDDP) != 0;
+    }
+#endif
+    return strcmp(level, "scalar") == 0;
+}
+
+bool kernels_is_known(const char *name) {
+    for (size_t i = 0; name && i < sizeof(known_levels) / sizeof(known_levels[0]); i++) {
+        if (strcmp(name, known_levels[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Resolves name, or the MICARRAY_KERNELS override, to a table this CPU
+ * can run. */
+static int find_table(const char *name, const kernel_table_t **table) {
+    const char *forced = getenv("MICARRAY_KERNELS");
+    if (forced && forced[0]) {
+        name = forced;
+    }
+    if (!kernels_is_known(name)) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *table = NULL;
+    for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); i++) {
+        if (strcmp(name, "auto") == 0 ? cpu_supports(tables[i].level) : strcmp(name, tables[i].level) == 0) {
+            *table = &tables[i];
+        }
+    }
+    
+    /* Known but built for another architecture, or missing from this CPU. */
+    if (!*table || !cpu_supports((*table)->level)) {
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int kernels_select(const char *name) {
+    const kernel_table_t *table;
+    int result = find_table(name, &table);
+    if (result != MICARRAY_SUCCESS) {
+        return result;
+    }
+    
+    pthread_mutex_lock(&select_mutex);
+    selected = table;
+    pthread_mutex_unlock(&select_mutex);
+    
+    return MICARRAY_SUCCESS;
+}
+
+static void select_default(void) {
+    const kernel_table_t *table;
+    if (find_table("auto", &table) != MICARRAY_SUCCESS) {
+        table = &tables[0];
+    }
+    
+    pthread_mutex_lock(&select_mutex);
+    if (!selected) {
+        selected = table;
+    }
+    pthread_mutex_unlock(&select_mutex);
+}
+
+const kernel_table_t* kernels_get(void) {
+    pthread_once(&default_once, select_default);
+    
+    pthread_mutex_lock(&select_mutex);
+    const kernel_table_t *table = selected;
+    pthread_mutex_unlock(&select_mutex);
+    
+    return table;
+}
@@ -0,0 +1,71 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* y += a * b over count complex values held as split real and imaginary
+ * float arrays. count is a multiple of SIMD_LANES and the arrays are
+ * aligned as by simd_alloc(). */
+typedef void (*kernel_complex_mac_t)(float *yr, float *yi, const float *ar, const float *ai,
+                                     const float *br, const float *bi, int count);
+
+/* out[i] = sum of weight[i][j] * x[j] for j < stride, a multiple of 16. */
+typedef void (*kernel_gemv_int8_t)(const int8_t *weight, int rows, int stride, const int8_t *x, int32_t *out);
+
+/* One instruction set's kernels. A level without its own version of a
+ * kernel uses the best one below it, and says so in the *_impl name. */
+typedef struct {
+    const char *level;
+    const char *complex_mac_impl;
+    kernel_complex_mac_t complex_mac;
+    const char *gemv_int8_impl;
+    kernel_gemv_int8_t gemv_int8;
+} kernel_table_t;
+
+/* Selects the kernels used by contexts created from now on. name is
+ * "auto" for the best this CPU supports, or one of "scalar", "sse4",
+ * "avx2", "avx512", "neon" and "dotprod" to force a path. A non-empty
+ * MICARRAY_KERNELS environment variable overrides name. Returns
+ * MICARRAY_ERROR_INVALID_PARAM for an unknown name and MICARRAY_ERROR_INIT
+ * for a level this CPU cannot run; the selection is unchanged then. */
+int kernels_select(const char *name);
+
+/* The selected kernels; the first call selects "auto" if nothing was
+ * selected yet. */
+const kernel_table_t* kernels_get(void);
+
+/* Whether name is "auto" or a level kernels_select() knows, supported
+ * here or not. */
+bool kernels_is_known(const char *name);
+
+/* Per-architecture versions, built only for their architecture. */
+#if defined(__x86_64__) || defined(__i386__)
+void kernels_complex_mac_sse4(float *yr, float *yi, const float *ar, const float *ai,
+                              const float *br, const float *bi, int count);
+void kernels_complex_mac_avx2(float *yr, float *yi, const float *ar, const float *ai,
+                              const float *br, const float *bi, int count);
+void kernels_complex_mac_avx512(float *yr, float *yi, const float *ar, const float *ai,
+                                const float *br, const float *bi, int count);
+void kernels_gemv_int8_sse4(const int8_t *weight, int rows, int stride, const int8_t *x, int32_t *out);
+void kernels_gemv_int8_avx2(const int8_t *weight, int rows, int stride, const int8_t *x, int32_t *out);
+void kernels_gemv_int8_avx512(const int8_t *weight, int rows, int stride, const int8_t *x, int32_t *out);
+#endif
+
+#if defined(__aarch64__)
+void kernels_complex_mac_neon(float *yr, float *yi, const float *ar, const float *ai,
+                              const float *br, const float *bi, int count);
+void kernels_gemv_int8_neon(const int8_t *weight, int rows, int stride, const int8_t *x, int32_t *out);
+void kernels_gemv_int8_dotprod(const int8_t *weight, int rows, int stride, const int8_t *x, int32_t *out);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
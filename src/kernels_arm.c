@@ -0,0 +1,49 @@
+#include "kernels.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+
+/* NEON is part of the AArch64 baseline; only the dot product kernel needs
+ * its own target and is only called when HWCAP reports it. */
+
+void kernels_complex_mac_neon(float *yr, float *yi, const float *ar, const float *ai,
+                              const float *br, const float *bi, int count) {
+    for (int k = 0; k < count; k += 4) {
+        float32x4_t a_re = vld1q_f32(ar + k);
+        float32x4_t a_im = vld1q_f32(ai + k);
+        float32x4_t b_re = vld1q_f32(br + k);
+        float32x4_t b_im = vld1q_f32(bi + k);
+        float32x4_t re = vfmsq_f32(vfmaq_f32(vld1q_f32(yr + k), a_re, b_re), a_im, b_im);
+        float32x4_t im = vfmaq_f32(vfmaq_f32(vld1q_f32(yi + k), a_re, b_im), a_im, b_re);
+        vst1q_f32(yr + k, re);
+        vst1q_f32(yi + k, im);
+    }
+}
+
+void kernels_gemv_int8_neon(const int8_t *weight, int rows, int stride, const int8_t *x, int32_t *out) {
+    for (int i = 0; i < rows; i++) {
+        const int8_t *row = weight + (size_t)i * stride;
+        int32x4_t acc = vdupq_n_s32(0);
+        for (int j = 0; j < stride; j += 16) {
+            int8x16_t w = vld1q_s8(row + j);
+            int8x16_t v = vld1q_s8(x + j);
+            acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(w), vget_low_s8(v)));
+            acc = vpadalq_s16(acc, vmull_high_s8(w, v));
+        }
+        out[i] = vaddvq_s32(acc);
+    }
+}
+
+__attribute__((target("+dotprod")))
+void kernels_gemv_int8_dotprod(const int8_t *weight, int rows, int stride, const int8_t *x, int32_t *out) {
+    for (int i = 0; i < rows; i++) {
+        const int8_t *row = weight + (size_t)i * stride;
+        int32x4_t acc = vdupq_n_s32(0);
+        for (int j = 0; j < stride; j += 16) {
+            acc = vdotq_s32(acc, vld1q_s8(row + j), vld1q_s8(x + j));
+        }
+        out[i] = vaddvq_s32(acc);
+    }
+}
+
+#endif
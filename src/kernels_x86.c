@@ -0,0 +1,131 @@
+#include "kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/* Each function is compiled for its own instruction set, so the rest of
+ * the library keeps the baseline flags and these are only called after
+ * kernels_select() has checked the CPU. */
+
+__attribute__((target("sse4.1")))
+void kernels_complex_mac_sse4(float *yr, float *yi, const float *ar, const float *ai,
+                              const float *br, const float *bi, int count) {
+    for (int k = 0; k < count; k += 4) {
+        __m128 a_re = _mm_load_ps(ar + k);
+        __m128 a_im = _mm_load_ps(ai + k);
+        __m128 b_re = _mm_load_ps(br + k);
+        __m128 b_im = _mm_load_ps(bi + k);
+        __m128 re = _mm_sub_ps(_mm_mul_ps(a_re, b_re), _mm_mul_ps(a_im, b_im));
+        __m128 im = _mm_add_ps(_mm_mul_ps(a_re, b_im), _mm_mul_ps(a_im, b_re));
+        _mm_store_ps(yr + k, _mm_add_ps(_mm_load_ps(yr + k), re));
+        _mm_store_ps(yi + k, _mm_add_ps(_mm_load_ps(yi + k), im));
+    }
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i dot16_sse4(__m128i w, __m128i v) {
+    __m128i lo = _mm_madd_epi16(_mm_cvtepi8_epi16(w), _mm_cvtepi8_epi16(v));
+    __m128i hi = _mm_madd_epi16(_mm_cvtepi8_epi16(_mm_srli_si128(w, 8)),
+                                _mm_cvtepi8_epi16(_mm_srli_si128(v, 8)));
+    return _mm_add_epi32(lo, hi);
+}
+
+__attribute__((target("sse4.1")))
+static inline int32_t hsum_sse4(__m128i v) {
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+}
+
+__attribute__((target("sse4.1")))
+void kernels_gemv_int8_sse4(const int8_t *weight, int rows, int stride, const int8_t *x, int32_t *out) {
+    for (int i = 0; i < rows; i++) {
+        const int8_t *row = weight + (size_t)i * stride;
+        __m128i acc = _mm_setzero_si128();
+        for (int j = 0; j < stride; j += 16) {
+            acc = _mm_add_epi32(acc, dot16_sse4(_mm_loadu_si128((const __m128i *)(row + j)),
+                                                _mm_loadu_si128((const __m128i *)(x + j))));
+        }
+        out[i] = hsum_sse4(acc);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void kernels_complex_mac_avx2(float *yr, float *yi, const float *ar, const float *ai,
+                              const float *br, const float *bi, int count) {
+    int k = 0;
+    for (; k + 8 <= count; k += 8) {
+        __m256 a_re = _mm256_loadu_ps(ar + k);
+        __m256 a_im = _mm256_loadu_ps(ai + k);
+        __m256 b_re = _mm256_loadu_ps(br + k);
+        __m256 b_im = _mm256_loadu_ps(bi + k);
+        __m256 re = _mm256_fnmadd_ps(a_im, b_im, _mm256_fmadd_ps(a_re, b_re, _mm256_loadu_ps(yr + k)));
+        __m256 im = _mm256_fmadd_ps(a_im, b_re, _mm256_fmadd_ps(a_re, b_im, _mm256_loadu_ps(yi + k)));
+        _mm256_storeu_ps(yr + k, re);
+        _mm256_storeu_ps(yi + k, im);
+    }
+    if (k < count) {
+        __m128 a_re = _mm_load_ps(ar + k);
+        __m128 a_im = _mm_load_ps(ai + k);
+        __m128 b_re = _mm_load_ps(br + k);
+        __m128 b_im = _mm_load_ps(bi + k);
+        _mm_store_ps(yr + k, _mm_fnmadd_ps(a_im, b_im, _mm_fmadd_ps(a_re, b_re, _mm_load_ps(yr + k))));
+        _mm_store_ps(yi + k, _mm_fmadd_ps(a_im, b_re, _mm_fmadd_ps(a_re, b_im, _mm_load_ps(yi + k))));
+    }
+}
+
+__attribute__((target("avx2")))
+void kernels_gemv_int8_avx2(const int8_t *weight, int rows, int stride, const int8_t *x, int32_t *out) {
+    for (int i = 0; i < rows; i++) {
+        const int8_t *row = weight + (size_t)i * stride;
+        __m256i acc = _mm256_setzero_si256();
+        for (int j = 0; j < stride; j += 16) {
+            __m256i w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(row + j)));
+            __m256i v = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(x + j)));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(w, v));
+        }
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        out[i] = _mm_cvtsi128_si32(sum);
+    }
+}
+
+__attribute__((target("avx512f")))
+void kernels_complex_mac_avx512(float *yr, float *yi, const float *ar, const float *ai,
+                                const float *br, const float *bi, int count) {
+    for (int k = 0; k < count; k += 16) {
+        /* count is only a multiple of 4, so the last step may be partial. */
+        __mmask16 m = count - k >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (count - k)) - 1);
+        __m512 a_re = _mm512_maskz_loadu_ps(m, ar + k);
+        __m512 a_im = _mm512_maskz_loadu_ps(m, ai + k);
+        __m512 b_re = _mm512_maskz_loadu_ps(m, br + k);
+        __m512 b_im = _mm512_maskz_loadu_ps(m, bi + k);
+        __m512 re = _mm512_fnmadd_ps(a_im, b_im, _mm512_fmadd_ps(a_re, b_re, _mm512_maskz_loadu_ps(m, yr + k)));
+        __m512 im = _mm512_fmadd_ps(a_im, b_re, _mm512_fmadd_ps(a_re, b_im, _mm512_maskz_loadu_ps(m, yi + k)));
+        _mm512_mask_storeu_ps(yr + k, m, re);
+        _mm512_mask_storeu_ps(yi + k, m, im);
+    }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void kernels_gemv_int8_avx512(const int8_t *weight, int rows, int stride, const int8_t *x, int32_t *out) {
+    for (int i = 0; i < rows; i++) {
+        const int8_t *row = weight + (size_t)i * stride;
+        __m512i acc = _mm512_setzero_si512();
+        int j = 0;
+        for (; j + 32 <= stride; j += 32) {
+            __m512i w = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i *)(row + j)));
+            __m512i v = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i *)(x + j)));
+            acc = _mm512_add_epi32(acc, _mm512_madd_epi16(w, v));
+        }
+        if (j < stride) {
+            __m512i w = _mm512_cvtepi8_epi16(_mm256_zextsi128_si256(_mm_loadu_si128((const __m128i *)(row + j))));
+            __m512i v = _mm512_cvtepi8_epi16(_mm256_zextsi128_si256(_mm_loadu_si128((const __m128i *)(x + j))));
+            acc = _mm512_add_epi32(acc, _mm512_madd_epi16(w, v));
+        }
+        out[i] = _mm512_reduce_add_epi32(acc);
+    }
+}
+
+#endif
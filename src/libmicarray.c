@@ -7,12 +7,26 @@
 #include "localization.h"
 #include "audio_output.h"
 #include "logging.h"
+#include "mic_health.h"
+#include "prefilter.h"
+#include "echo_canceller.h"
+#include "hrtf.h"
+#include "panner.h"
+#include "beamformer.h"
+#include "beam_output.h"
+#include "recorder.h"
+#include "stage_graph.h"
+#include "perf_counters.h"
+#include "kernels.h"
+#include "agc.h"
+#include "dereverb.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 #include <signal.h>
 #include <unistd.h>
+#include <time.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
 
@@ -22,20 +36,132 @@
 
 #define LIBMICARRAY_VERSION "1.0.0"
 
+#define LOCALIZATION_WINDOW_SIZE 1024
+#define NR_FRAME_SIZE 1024
+#define GCC_FRAME_SIZE 512
+#define LOW_LATENCY_OUTPUT_BLOCKS 4
+
+/* perf events only count the thread that opened them, so every thread
+ * that runs counted work has a group of its own. A headless context does
+ * all of it on the host's thread, in the processing group. */
+enum {
+    GROUP_PROCESSING = 0,
+    GROUP_CAPTURE,
+    GROUP_LOCALIZATION,
+    COUNTER_GROUPS
+};
+
+/* Work outside the stage graph, reported after its stages. */
+enum {
+    SECTION_CAPTURE = 0,
+    SECTION_HEALTH,
+    SECTION_RECORDER,
+    SECTION_AGC,
+    SECTION_RENDER,
+    SECTION_BEAMS,
+    SECTION_LOCALIZATION,
+    SECTION_COUNT
+};
+
+static const char *const section_names[SECTION_COUNT] = {
+    "capture", "health", "recorder", "agc", "render", "beams", "localization"
+};
+
 struct micarray_context {
     micarray_config_t config;
     
     i2s_context_t *i2s_ctx;
+    /* Never opened: capture reads spidev through i2s_ctx, so there are no
+     * DMA buffers to lease. Kept so cleanup stays symmetric if a DMA
+     * capture path is added. */
     dma_context_t *dma_ctx;
-    noise_reduction_context_t *noise_ctx;
+    noise_reduction_context_t **noise_ctx;
     localization_context_t *loc_ctx;
     audio_output_context_t *audio_ctx;
     logging_context_t *log_ctx;
+    mic_health_context_t *health_ctx;
+    prefilter_context_t *prefilter_ctx;
+    echo_canceller_context_t *echo_ctx;
+    int echo_block;
+    hrtf_context_t *hrtf_ctx;
+    panner_context_t *panner_ctx;
+    agc_context_t *agc_ctx;
+    dereverb_context_t *dereverb_ctx;
+    int16_t *stereo_buffer;
+    
+    /* Beam 0 follows current_location; requests for the others wait in
+     * beam_targets until the processing thread latches them. */
+    beamformer_context_t *beamformer_ctx;
+    beam_output_context_t *beam_ctx;
+    recorder_context_t *recorder_ctx;
+    stage_graph_t *stage_graph;
+    sound_location_t beam_targets[MAX_BEAMS];
+    uint32_t beam_steer_pending;
+    
+    size_t block_size;
+    size_t output_frames;
     
     int16_t **mic_buffers;
+    size_t captured_frames;
+    bool block_ready;
+    pthread_cond_t block_cond;
+    
+    /* Interleaved frames that arrived after mic_buffers filled up, held
+     * until the processing thread takes the block. */
+    int16_t *carry_buffer;
+    size_t carry_frames;
+    
+    int16_t **block_buffers;
     int16_t *processed_buffer;
+    int32_t *mix_buffer;
+    
+    int16_t **history_buffers;
+    int16_t **window_buffers;
+    size_t history_size;
+    size_t history_pos;
+    size_t localization_window;
+    size_t pending_frames;
+    size_t localization_interval;
+    size_t unanalysed_frames;
+    bool localization_incremental;
+    float *noise_psd;
+    bool noise_psd_ready;
+    
+    /* NR runs without data_mutex, so the processing thread copies the
+     * reference channel's estimate here when an update falls due and the
+     * snapshot takes it from this copy. */
+    float *latched_psd;
+    uint32_t latched_psd_mask;
+    bool latched_psd_ready;
+    
+    /* Channels excluded by the health monitor are skipped by NR, the mix
+     * and localization. The worker reads the copy taken with its snapshot. */
+    uint32_t active_mask;
+    uint32_t snapshot_mask;
+    
+    size_t metrics_interval;
+    size_t metrics_pending;
+    
+    /* Bit g of perf_pending is set when group g should be opened by the
+     * next thread of its kind to run. A section belongs to the thread
+     * running it, which copies its totals to section_stats with
+     * data_mutex held. */
+    perf_counters_context_t *counters[COUNTER_GROUPS];
+    uint32_t perf_pending;
+    stage_section_t sections[SECTION_COUNT];
+    micarray_stage_stats_t section_stats[SECTION_COUNT];
+    micarray_stage_stats_t stage_stats[MICARRAY_MAX_STAGES];
+    int num_stage_stats;
+    
+    bool localization_threaded;
+    bool localization_due;
+    pthread_t localization_thread;
+    pthread_cond_t localization_cond;
+    
     sound_location_t current_location;
+    micarray_stats_t stats;
     
+    bool headless;
     bool running;
     pthread_t processing_thread;
     pthread_mutex_t data_mutex;
@@ -47,6 +173,129 @@ static void signal_handler(int sig) {
     g_shutdown_requested = true;
 }
 
+static int16_t** alloc_channel_buffers(int channels, size_t frames) {
+    int16_t **buffers = calloc(channels, sizeof(int16_t*));
+    if (!buffers) {
+        return NULL;
+    }
+    
+    for (int i = 0; i < channels; i++) {
+        buffers[i] = calloc(frames, sizeof(int16_t));
+        if (!buffers[i]) {
+            for (int j = 0; j < i; j++) {
+                free(buffers[j]);
+            }
+            free(buffers);
+            return NULL;
+        }
+    }
+    
+    return buffers;
+}
+
+static void free_channel_buffers(int16_t **buffers, int channels) {
+    if (!buffers) {
+        return;
+    }
+    
+    for (int i = 0; i < channels; i++) {
+        free(buffers[i]);
+    }
+    free(buffers);
+}
+
+/* Called with data_mutex held, on the thread that runs the group's work.
+ * Only the processing group, which also counts the stage graph, decides
+ * micarray_stats_t.perf_counters. */
+static void open_counters(micarray_context_t *ctx, int group) {
+    ctx->perf_pending &= ~(1u << group);
+    if (ctx->counters[group]) {
+        perf_counters_cleanup(ctx->counters[group]);
+        ctx->counters[group] = NULL;
+    }
+    
+    bool available = (perf_counters_init(&ctx->counters[group]) == MICARRAY_SUCCESS);
+    if (group != GROUP_PROCESSING) {
+        return;
+    }
+    
+    stage_graph_set_counters(ctx->stage_graph, ctx->counters[group]);
+    ctx->stats.perf_counters = available;
+    if (available) {
+        LOG_INFO(ctx->log_ctx, "Counting cycles, instructions, cache and branch misses per stage");
+    } else {
+        LOG_WARN(ctx->log_ctx, "Hardware performance counters not available, check perf_event_paranoid");
+    }
+}
+
+static void begin_section(micarray_context_t *ctx, int section, int group) {
+    if (ctx->config.perf_counters) {
+        stage_section_begin(&ctx->sections[section], ctx->counters[group]);
+    }
+}
+
+static void end_section(micarray_context_t *ctx, int section, int group) {
+    if (ctx->config.perf_counters) {
+        stage_section_end(&ctx->sections[section], ctx->counters[group]);
+    }
+}
+
+/* Pseudo-stages are only reported for work the configuration does. */
+static bool section_configured(const micarray_context_t *ctx, int section) {
+    switch (section) {
+        case SECTION_RECORDER:
+            return ctx->recorder_ctx != NULL;
+        case SECTION_AGC:
+            return ctx->agc_ctx != NULL;
+        case SECTION_BEAMS:
+            return ctx->beam_ctx != NULL;
+        case SECTION_LOCALIZATION:
+            return ctx->loc_ctx != NULL;
+        default:
+            return true;
+    }
+}
+
+/* Called with data_mutex held, by the thread that owns the section. */
+static void publish_section(micarray_context_t *ctx, int section) {
+    if (ctx->config.perf_counters) {
+        ctx->section_stats[section] = ctx->sections[section].stats;
+    }
+}
+
+/* Called with data_mutex held, by the thread that runs the stage graph. */
+static void publish_stages(micarray_context_t *ctx) {
+    stage_graph_get_stats(ctx->stage_graph, ctx->stage_stats, MICARRAY_MAX_STAGES, &ctx->num_stage_stats);
+}
+
+/* Called with data_mutex held. Deinterleaves as many frames as fit in the
+ * block being captured and returns that count; a full block goes to the
+ * processing thread. */
+static size_t capture_frames(micarray_context_t *ctx, const int16_t *data, size_t frames) {
+    if (ctx->block_ready) {
+        return 0;
+    }
+    
+    if (frames > ctx->block_size - ctx->captured_frames) {
+        frames = ctx->block_size - ctx->captured_frames;
+    }
+    
+    mic_health_deinterleave(ctx->health_ctx, data, frames, ctx->mic_buffers, ctx->captured_frames);
+    ctx->captured_frames += frames;
+    
+    if (ctx->captured_frames >= ctx->block_size) {
+        ctx->block_ready = true;
+        pthread_cond_signal(&ctx->block_cond);
+    }
+    
+    return frames;
+}
+
+/* Fills mic_buffers from I2S chunks of any length up to one block. The part
+ * of a chunk that crosses a block boundary, and anything arriving while a
+ * full block still waits for the processing thread, is carried into the
+ * next block. Only frames that find the carry full as well are dropped and
+ * counted in capture_overruns. */
 static void audio_callback(int16_t *data, size_t samples, void *user_data) {
     micarray_context_t *ctx = (micarray_context_t*)user_data;
     
@@ -54,103 +303,738 @@ static void audio_callback(int16_t *data, size_t samples, void *user_data) {
         return;
     }
     
+    const int channels = ctx->config.num_microphones;
+    size_t frames = samples / channels;
+    
     pthread_mutex_lock(&ctx->data_mutex);
     
-    for (size_t i = 0; i < samples; i++) {
-        int mic_idx = i % ctx->config.num_microphones;
-        size_t sample_idx = i / ctx->config.num_microphones;
+    if (ctx->perf_pending & (1u << GROUP_CAPTURE)) {
+        open_counters(ctx, GROUP_CAPTURE);
+    }
+    
+    begin_section(ctx, SECTION_CAPTURE, GROUP_CAPTURE);
+    
+    /* The carry is never longer than a block, so once the waiting block has
+     * been taken it drains in one go. */
+    if (ctx->carry_frames > 0 && !ctx->block_ready) {
+        capture_frames(ctx, ctx->carry_buffer, ctx->carry_frames);
+        ctx->carry_frames = 0;
+    }
+    
+    size_t taken = (ctx->carry_frames == 0) ? capture_frames(ctx, data, frames) : 0;
+    size_t rest = frames - taken;
+    if (rest > ctx->block_size - ctx->carry_frames) {
+        ctx->stats.capture_overruns += rest - (ctx->block_size - ctx->carry_frames);
+        rest = ctx->block_size - ctx->carry_frames;
+    }
+    memcpy(ctx->carry_buffer + ctx->carry_frames * channels, data + taken * channels, 
+           rest * channels * sizeof(int16_t));
+    ctx->carry_frames += rest;
+    
+    end_section(ctx, SECTION_CAPTURE, GROUP_CAPTURE);
+    publish_section(ctx, SECTION_CAPTURE);
+    
+    pthread_mutex_unlock(&ctx->data_mutex);
+}
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void record_block_time(micarray_context_t *ctx, size_t frames, uint64_t elapsed_ns) {
+    ctx->stats.blocks_processed++;
+    ctx->stats.frames_processed += frames;
+    ctx->stats.last_block_ns = elapsed_ns;
+    ctx->stats.total_block_ns += elapsed_ns;
+    if (elapsed_ns > ctx->stats.max_block_ns) {
+        ctx->stats.max_block_ns = elapsed_ns;
+    }
+}
+
+static void update_channel_health(micarray_context_t *ctx) {
+    uint32_t changed = mic_health_evaluate(ctx->health_ctx);
+    if (!changed) {
+        return;
+    }
+    
+    ctx->active_mask = mic_health_get_mask(ctx->health_ctx);
+    ctx->stats.active_channel_mask = ctx->active_mask;
+    
+    for (int c = 0; c < ctx->config.num_microphones; c++) {
+        mic_health_status_t status;
+        if (!(changed & (1u << c)) || mic_health_get_status(ctx->health_ctx, c, &status) != MICARRAY_SUCCESS) {
+            continue;
+        }
+        
+        if (!status.active) {
+            ctx->stats.channel_exclusions++;
+        }
+        log_mic_health(ctx->log_ctx, c, status.active, status.dc_offset, status.rms, 
+                       status.clip_rate, status.coherence);
+    }
+}
+
+/* Levels come from the health monitor's copy pass and NR's read-out loop;
+ * this only collects what they accumulated since the last publication. */
+static void publish_metrics(micarray_context_t *ctx) {
+    const int channels = ctx->config.num_microphones;
+    
+    if (mic_health_read_levels(ctx->health_ctx, ctx->stats.channel_rms, ctx->stats.channel_peak, 
+                               channels) == MICARRAY_SUCCESS) {
+        log_audio_levels(ctx->log_ctx, ctx->stats.channel_rms, channels);
+    }
+    
+    if (ctx->echo_ctx) {
+        ctx->stats.echo_erle_db = echo_canceller_get_erle(ctx->echo_ctx);
+    }
+    
+    recorder_stats_t recorder_stats;
+    if (ctx->recorder_ctx && recorder_get_stats(ctx->recorder_ctx, &recorder_stats) == MICARRAY_SUCCESS) {
+        ctx->stats.recording = recorder_stats.recording;
+        ctx->stats.recorded_frames = recorder_stats.frames_written;
+        ctx->stats.recorder_dropped_frames = recorder_stats.frames_dropped;
+    }
+    
+    if (ctx->beam_ctx) {
+        beam_output_get_dropped(ctx->beam_ctx, &ctx->stats.beam_dropped_frames);
+    }
+    
+    if (!ctx->noise_ctx) {
+        return;
+    }
+    
+    double input_energy = 0.0, output_energy = 0.0;
+    int measured = 0;
+    for (int c = 0; c < channels; c++) {
+        float input_rms, output_rms;
+        if (noise_reduction_read_energy(ctx->noise_ctx[c], &input_rms, &output_rms) == MICARRAY_SUCCESS) {
+            input_energy += input_rms * input_rms;
+            output_energy += output_rms * output_rms;
+            measured++;
+        }
+    }
+    
+    if (measured > 0) {
+        ctx->stats.noise_input_rms = (float)sqrt(input_energy / measured);
+        ctx->stats.noise_output_rms = (float)sqrt(output_energy / measured);
+        log_noise_metrics(ctx->log_ctx, ctx->stats.noise_input_rms, ctx->stats.noise_output_rms);
+    }
+}
+
+static void prefilter_stage(void *state, int16_t **channels, size_t frames, uint32_t active_mask) {
+    (void)active_mask;
+    prefilter_process((prefilter_context_t*)state, channels, frames);
+}
+
+static void echo_canceller_stage(void *state, int16_t **channels, size_t frames, uint32_t active_mask) {
+    echo_canceller_process((echo_canceller_context_t*)state, channels, frames, active_mask);
+}
+
+static void dereverb_stage(void *state, int16_t **channels, size_t frames, uint32_t active_mask) {
+    dereverb_process((dereverb_context_t*)state, channels, frames, active_mask);
+}
+
+static void noise_reduction_stage(void *state, int16_t **channels, size_t frames, uint32_t active_mask) {
+    micarray_context_t *ctx = (micarray_context_t*)state;
+    for (int i = 0; i < ctx->config.num_microphones; i++) {
+        if (active_mask & (1u << i)) {
+            noise_reduction_process(ctx->noise_ctx[i], channels[i], channels[i], frames);
+        }
+    }
+}
+
+static void process_channels(micarray_context_t *ctx, int16_t **channels, size_t frames) {
+    const int num_channels = ctx->config.num_microphones;
+    int active = 0;
+    
+    memset(ctx->mix_buffer, 0, frames * sizeof(int32_t));
+    for (int i = 0; i < num_channels; i++) {
+        if (!(ctx->active_mask & (1u << i))) {
+            continue;
+        }
         
-        if (sample_idx < samples / ctx->config.num_microphones) {
-            ctx->mic_buffers[mic_idx][sample_idx] = data[i];
+        for (size_t j = 0; j < frames; j++) {
+            ctx->mix_buffer[j] += channels[i][j];
+        }
+        active++;
+    }
+    
+    for (size_t j = 0; j < frames; j++) {
+        ctx->processed_buffer[j] = (int16_t)(ctx->mix_buffer[j] / active);
+    }
+}
+
+static void push_history(micarray_context_t *ctx, int16_t **channels, size_t frames) {
+    size_t first = ctx->history_size - ctx->history_pos;
+    if (first > frames) {
+        first = frames;
+    }
+    
+    for (int c = 0; c < ctx->config.num_microphones; c++) {
+        memcpy(ctx->history_buffers[c] + ctx->history_pos, channels[c], first * sizeof(int16_t));
+        memcpy(ctx->history_buffers[c], channels[c] + first, (frames - first) * sizeof(int16_t));
+    }
+    
+    ctx->history_pos = (ctx->history_pos + frames) % ctx->history_size;
+    
+    ctx->unanalysed_frames += frames;
+    if (ctx->unanalysed_frames > ctx->history_size) {
+        ctx->unanalysed_frames = ctx->history_size;
+    }
+}
+
+/* Unrolls the analysis window into window_buffers, oldest first, and returns
+ * its length: the whole history ring, or for the incremental estimator only
+ * the frames it has not been fed yet. */
+static size_t snapshot_history(micarray_context_t *ctx) {
+    size_t frames = ctx->localization_incremental ? ctx->unanalysed_frames : ctx->history_size;
+    size_t start = (ctx->history_pos + ctx->history_size - frames) % ctx->history_size;
+    size_t tail = ctx->history_size - start;
+    if (tail > frames) {
+        tail = frames;
+    }
+    
+    for (int c = 0; c < ctx->config.num_microphones; c++) {
+        memcpy(ctx->window_buffers[c], ctx->history_buffers[c] + start, tail * sizeof(int16_t));
+        memcpy(ctx->window_buffers[c] + tail, ctx->history_buffers[c], (frames - tail) * sizeof(int16_t));
+    }
+    
+    ctx->unanalysed_frames = 0;
+    ctx->snapshot_mask = ctx->active_mask;
+    
+    /* A latched estimate taken for other channels may have come from
+     * another reference. */
+    if (ctx->noise_psd) {
+        ctx->noise_psd_ready = ctx->latched_psd_ready && ctx->latched_psd_mask == ctx->snapshot_mask;
+        if (ctx->noise_psd_ready) {
+            memcpy(ctx->noise_psd, ctx->latched_psd, (GCC_FRAME_SIZE / 2 + 1) * sizeof(float));
+        }
+    }
+    
+    return frames;
+}
+
+/* Called with data_mutex held, on the thread that runs the blocks. The
+ * localizer measures against the lowest active microphone, so the noise
+ * PSD comes from that channel; an excluded one skips NR and its estimate
+ * goes stale. */
+static void latch_noise_psd(micarray_context_t *ctx) {
+    if (!ctx->latched_psd) {
+        return;
+    }
+    
+    ctx->latched_psd_mask = ctx->active_mask;
+    ctx->latched_psd_ready = false;
+    if (ctx->active_mask) {
+        int reference = 0;
+        while (!(ctx->active_mask & (1u << reference))) {
+            reference++;
         }
+        ctx->latched_psd_ready = (noise_reduction_get_noise_psd(ctx->noise_ctx[reference], ctx->latched_psd, 
+                                                               GCC_FRAME_SIZE / 2 + 1) == MICARRAY_SUCCESS);
+    }
+}
+
+/* Runs on a snapshot only, so the worker can call it without data_mutex. */
+static void localize_snapshot(micarray_context_t *ctx, size_t frames, sound_location_t *location) {
+    localization_set_active_mask(ctx->loc_ctx, ctx->snapshot_mask);
+    if (ctx->noise_psd_ready) {
+        localization_set_noise_psd(ctx->loc_ctx, ctx->noise_psd, GCC_FRAME_SIZE / 2 + 1);
+    }
+    
+    localization_process(ctx->loc_ctx, ctx->window_buffers, frames, location);
+}
+
+/* Called with data_mutex held by whoever produced the fix, the worker or
+ * the audio path, so both start a confidence-triggered recording. */
+static void publish_location(micarray_context_t *ctx, const sound_location_t *location) {
+    ctx->current_location = *location;
+    ctx->stats.localization_updates++;
+    
+    if (ctx->recorder_ctx && ctx->config.recorder_trigger_confidence > 0.0f && 
+        location->confidence >= ctx->config.recorder_trigger_confidence) {
+        recorder_trigger(ctx->recorder_ctx);
+    }
+}
+
+static void update_location(micarray_context_t *ctx) {
+    if (!ctx->loc_ctx) {
+        return;
+    }
+    
+    size_t frames = snapshot_history(ctx);
+    sound_location_t location;
+    begin_section(ctx, SECTION_LOCALIZATION, GROUP_PROCESSING);
+    localize_snapshot(ctx, frames, &location);
+    end_section(ctx, SECTION_LOCALIZATION, GROUP_PROCESSING);
+    publish_section(ctx, SECTION_LOCALIZATION);
+    publish_location(ctx, &location);
+    
+    log_location_data(ctx->log_ctx, &location);
+}
+
+/* Called with data_mutex held: the health monitor's levels are accumulated
+ * by the capture callback. */
+static void begin_block(micarray_context_t *ctx) {
+    begin_section(ctx, SECTION_HEALTH, GROUP_PROCESSING);
+    update_channel_health(ctx);
+    end_section(ctx, SECTION_HEALTH, GROUP_PROCESSING);
+}
+
+/* Everything in here belongs to the thread that runs the blocks, so the
+ * processing thread calls it without data_mutex while the callback keeps
+ * capturing into mic_buffers. */
+static void run_block(micarray_context_t *ctx, size_t frames) {
+    if (ctx->recorder_ctx) {
+        begin_section(ctx, SECTION_RECORDER, GROUP_PROCESSING);
+        recorder_push(ctx->recorder_ctx, ctx->block_buffers, frames);
+        end_section(ctx, SECTION_RECORDER, GROUP_PROCESSING);
+    }
+    
+    stage_graph_process(ctx->stage_graph, ctx->block_buffers, frames, ctx->active_mask);
+    
+    process_channels(ctx, ctx->block_buffers, frames);
+    
+    if (ctx->agc_ctx) {
+        begin_section(ctx, SECTION_AGC, GROUP_PROCESSING);
+        agc_process(ctx->agc_ctx, ctx->processed_buffer, frames);
+        end_section(ctx, SECTION_AGC, GROUP_PROCESSING);
+    }
+}
+
+/* Called with data_mutex held after run_block(). Localization runs every
+ * localization_interval frames regardless of the block size. With a
+ * worker thread the audio path only flags the update; a flag still set
+ * from the previous interval counts as an overrun and the two requests
+ * are coalesced. */
+static void finish_block(micarray_context_t *ctx, size_t frames) {
+    if (ctx->agc_ctx) {
+        ctx->stats.agc_gain_db = agc_get_gain_db(ctx->agc_ctx);
+        ctx->stats.limiter_gain_db = agc_get_limiter_db(ctx->agc_ctx);
+    }
+    
+    push_history(ctx, ctx->block_buffers, frames);
+    
+    if (ctx->metrics_interval > 0) {
+        ctx->metrics_pending += frames;
+        if (ctx->metrics_pending >= ctx->metrics_interval) {
+            ctx->metrics_pending = 0;
+            publish_metrics(ctx);
+        }
+    }
+    
+    ctx->pending_frames += frames;
+    if (ctx->pending_frames < ctx->localization_interval) {
+        return;
+    }
+    
+    ctx->pending_frames -= ctx->localization_interval;
+    if (ctx->pending_frames >= ctx->localization_interval) {
+        ctx->pending_frames = 0;
+    }
+    
+    latch_noise_psd(ctx);
+    if (ctx->localization_threaded) {
+        if (ctx->localization_due) {
+            ctx->stats.localization_overruns++;
+        }
+        ctx->localization_due = true;
+        pthread_cond_signal(&ctx->localization_cond);
+    } else {
+        update_location(ctx);
+    }
+}
+
+static void* localization_thread_func(void *arg) {
+    micarray_context_t *ctx = (micarray_context_t*)arg;
+    
+    LOG_INFO(ctx->log_ctx, "Localization thread started");
+    
+    pthread_mutex_lock(&ctx->data_mutex);
+    
+    if (ctx->perf_pending & (1u << GROUP_LOCALIZATION)) {
+        open_counters(ctx, GROUP_LOCALIZATION);
+    }
+    
+    while (ctx->running && !g_shutdown_requested) {
+        if (!ctx->localization_due) {
+            pthread_cond_wait(&ctx->localization_cond, &ctx->data_mutex);
+            continue;
+        }
+        
+        ctx->localization_due = false;
+        size_t frames = snapshot_history(ctx);
+        
+        pthread_mutex_unlock(&ctx->data_mutex);
+        
+        sound_location_t location;
+        begin_section(ctx, SECTION_LOCALIZATION, GROUP_LOCALIZATION);
+        localize_snapshot(ctx, frames, &location);
+        end_section(ctx, SECTION_LOCALIZATION, GROUP_LOCALIZATION);
+        log_location_data(ctx->log_ctx, &location);
+        
+        pthread_mutex_lock(&ctx->data_mutex);
+        publish_section(ctx, SECTION_LOCALIZATION);
+        publish_location(ctx, &location);
     }
     
     pthread_mutex_unlock(&ctx->data_mutex);
+    
+    LOG_INFO(ctx->log_ctx, "Localization thread stopped");
+    return NULL;
+}
+
+/* Places processed_buffer at location, a copy of current_location taken
+ * with data_mutex held since the worker may publish a new fix meanwhile.
+ * Blocks that are not a whole number of HRTF partitions fall back to the
+ * ITD/ILD panner. */
+static void render_output(micarray_context_t *ctx, const sound_location_t *location, int16_t *stereo, 
+                          size_t frames) {
+    begin_section(ctx, SECTION_RENDER, GROUP_PROCESSING);
+    
+    const int16_t *sources[1] = {ctx->processed_buffer};
+    if (!ctx->hrtf_ctx || hrtf_render(ctx->hrtf_ctx, sources, location, 1, ctx->config.volume, 
+                                      stereo, frames) != MICARRAY_SUCCESS) {
+        panner_render(ctx->panner_ctx, ctx->processed_buffer, location, ctx->config.volume, stereo, frames);
+    }
+    
+    end_section(ctx, SECTION_RENDER, GROUP_PROCESSING);
+}
+
+/* The output hands back exactly what ALSA accepted. It calls this from the
+ * processing thread's own write, so the reference needs no extra locking. */
+static void playback_callback(const int16_t *stereo, size_t frames, void *user_data) {
+    micarray_context_t *ctx = (micarray_context_t*)user_data;
+    echo_canceller_push_reference(ctx->echo_ctx, stereo, frames);
+}
+
+/* With delay_ms < 0 the reference is kept as far behind as the output
+ * queue is long, re-aligned only when that moves by more than a partition
+ * so the filter is not disturbed by jitter. */
+static void align_echo_reference(micarray_context_t *ctx) {
+    if (!ctx->echo_ctx || ctx->config.aec_delay_ms >= 0) {
+        return;
+    }
+    
+    int latency_ms = audio_output_get_latency(ctx->audio_ctx);
+    if (latency_ms < 0) {
+        return;
+    }
+    
+    int delay = latency_ms * ctx->config.sample_rate / 1000;
+    if (delay > ctx->config.sample_rate) {
+        delay = ctx->config.sample_rate;
+    }
+    if (abs(delay - echo_canceller_get_delay(ctx->echo_ctx)) > ctx->echo_block) {
+        echo_canceller_set_delay(ctx->echo_ctx, delay);
+    }
+}
+
+/* Called with data_mutex held, so beamformer state is then only touched by
+ * whoever runs the block. */
+static void latch_beam_targets(micarray_context_t *ctx) {
+    if (!ctx->beamformer_ctx) {
+        return;
+    }
+    
+    if (ctx->current_location.confidence > 0.0f) {
+        beamformer_steer(ctx->beamformer_ctx, 0, &ctx->current_location);
+    }
+    
+    for (int b = 1; b < ctx->config.beam_count; b++) {
+        if (ctx->beam_steer_pending & (1u << b)) {
+            beamformer_steer(ctx->beamformer_ctx, b, &ctx->beam_targets[b]);
+        }
+    }
+    ctx->beam_steer_pending = 0;
+}
+
+/* Renders the beams of the last block straight into the sink, as many
+ * chunks as the sink's contiguous space requires. */
+static void write_beams(micarray_context_t *ctx, size_t frames) {
+    if (!ctx->beam_ctx) {
+        return;
+    }
+    
+    begin_section(ctx, SECTION_BEAMS, GROUP_PROCESSING);
+    
+    int16_t *channels[MAX_MICROPHONES];
+    for (size_t offset = 0; offset < frames;) {
+        size_t count = frames - offset;
+        int16_t *out = beam_output_acquire(ctx->beam_ctx, &count);
+        if (!out) {
+            break;
+        }
+        
+        for (int m = 0; m < ctx->config.num_microphones; m++) {
+            channels[m] = ctx->block_buffers[m] + offset;
+        }
+        beamformer_process(ctx->beamformer_ctx, channels, count, ctx->active_mask, out, ctx->config.beam_count);
+        beam_output_commit(ctx->beam_ctx, count);
+        offset += count;
+    }
+    
+    end_section(ctx, SECTION_BEAMS, GROUP_PROCESSING);
 }
 
 static void* processing_thread_func(void *arg) {
     micarray_context_t *ctx = (micarray_context_t*)arg;
-    const size_t buffer_size = ctx->config.dma_buffer_size;
+    const size_t block_size = ctx->block_size;
     
     LOG_INFO(ctx->log_ctx, "Processing thread started");
     
+    if (ctx->perf_pending & (1u << GROUP_PROCESSING)) {
+        pthread_mutex_lock(&ctx->data_mutex);
+        open_counters(ctx, GROUP_PROCESSING);
+        pthread_mutex_unlock(&ctx->data_mutex);
+    }
+    
     while (ctx->running && !g_shutdown_requested) {
         pthread_mutex_lock(&ctx->data_mutex);
         
-        if (ctx->config.noise_reduction_enable && ctx->noise_ctx) {
-            for (int i = 0; i < ctx->config.num_microphones; i++) {
-                noise_reduction_process(ctx->noise_ctx, 
-                                      ctx->mic_buffers[i], 
-                                      ctx->mic_buffers[i], 
-                                      buffer_size);
+        while (!ctx->block_ready && ctx->running && !g_shutdown_requested) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 100000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_nsec -= 1000000000L;
+                deadline.tv_sec++;
             }
+            pthread_cond_timedwait(&ctx->block_cond, &ctx->data_mutex, &deadline);
         }
         
-        if (ctx->loc_ctx) {
-            localization_process(ctx->loc_ctx, 
-                               ctx->mic_buffers, 
-                               buffer_size, 
-                               &ctx->current_location);
-            
-            log_location_data(ctx->log_ctx, &ctx->current_location);
+        if (!ctx->block_ready) {
+            pthread_mutex_unlock(&ctx->data_mutex);
+            continue;
         }
         
-        memset(ctx->processed_buffer, 0, buffer_size * sizeof(int16_t));
-        for (int i = 0; i < ctx->config.num_microphones; i++) {
-            for (size_t j = 0; j < buffer_size; j++) {
-                int32_t sum = ctx->processed_buffer[j] + ctx->mic_buffers[i][j];
-                ctx->processed_buffer[j] = (int16_t)(sum / ctx->config.num_microphones);
-            }
+        int16_t **captured = ctx->mic_buffers;
+        ctx->mic_buffers = ctx->block_buffers;
+        ctx->block_buffers = captured;
+        ctx->captured_frames = 0;
+        ctx->block_ready = false;
+        
+        uint64_t start_ns = monotonic_ns();
+        begin_block(ctx);
+        pthread_mutex_unlock(&ctx->data_mutex);
+        
+        run_block(ctx, block_size);
+        
+        pthread_mutex_lock(&ctx->data_mutex);
+        finish_block(ctx, block_size);
+        record_block_time(ctx, block_size, monotonic_ns() - start_ns);
+        
+        /* Render and beams are those of the previous block. */
+        for (int s = SECTION_HEALTH; s <= SECTION_BEAMS; s++) {
+            publish_section(ctx, s);
         }
+        publish_stages(ctx);
+        latch_beam_targets(ctx);
+        sound_location_t location = ctx->current_location;
         
         pthread_mutex_unlock(&ctx->data_mutex);
         
         if (ctx->audio_ctx) {
-            audio_output_write_localized(ctx->audio_ctx, 
-                                       ctx->processed_buffer, 
-                                       buffer_size, 
-                                       &ctx->current_location);
+            align_echo_reference(ctx);
+            render_output(ctx, &location, ctx->stereo_buffer, block_size);
+            audio_output_write_interleaved(ctx->audio_ctx, ctx->stereo_buffer, block_size);
         }
         
-        usleep(1000);
+        write_beams(ctx, block_size);
     }
     
     LOG_INFO(ctx->log_ctx, "Processing thread stopped");
     return NULL;
 }
 
-int micarray_init(micarray_context_t **ctx, const char *config_file) {
-    if (!ctx || !config_file) {
-        return MICARRAY_ERROR_INVALID_PARAM;
+/* Partitions are the largest power of two up to ECHO_CANCELLER_MAX_BLOCK
+ * that divides the processing block, so no block leaves a remainder. */
+static int init_echo_canceller(micarray_context_t *ctx) {
+    int block = ECHO_CANCELLER_MAX_BLOCK;
+    while (block > 1 && ctx->block_size % block != 0) {
+        block /= 2;
     }
     
-    *ctx = calloc(1, sizeof(micarray_context_t));
-    if (!*ctx) {
-        return MICARRAY_ERROR_MEMORY;
+    echo_canceller_config_t echo_config = {
+        .num_channels = ctx->config.num_microphones,
+        .sample_rate = ctx->config.sample_rate,
+        .block_size = block,
+        .tail_length = ctx->config.aec_tail_ms * ctx->config.sample_rate / 1000,
+        .step_size = ctx->config.aec_step,
+        .delay = ctx->config.aec_delay_ms > 0 ? ctx->config.aec_delay_ms * ctx->config.sample_rate / 1000 : 0
+    };
+    
+    int result = echo_canceller_init(&ctx->echo_ctx, &echo_config);
+    if (result != MICARRAY_SUCCESS) {
+        return result;
     }
+    ctx->echo_block = block;
     
-    config_set_defaults(&(*ctx)->config);
+    if (ctx->audio_ctx) {
+        audio_output_set_playback_callback(ctx->audio_ctx, playback_callback, ctx);
+    }
     
-    int result = config_parse_file(config_file, &(*ctx)->config);
+    LOG_INFO(ctx->log_ctx, "Echo canceller: %d-frame partitions, %d-frame tail", 
+             block, echo_config.tail_length);
+    return MICARRAY_SUCCESS;
+}
+
+static int init_hrtf_renderer(micarray_context_t *ctx) {
+    int block = HRTF_MAX_BLOCK;
+    while (block > 1 && ctx->block_size % block != 0) {
+        block /= 2;
+    }
+    
+    hrtf_config_t hrtf_config = {
+        .sample_rate = ctx->config.sample_rate,
+        .block_size = block,
+        .max_sources = 1
+    };
+    strcpy(hrtf_config.hrir_file, ctx->config.hrtf_file);
+    
+    int result = hrtf_init(&ctx->hrtf_ctx, &hrtf_config);
     if (result != MICARRAY_SUCCESS) {
-        free(*ctx);
-        *ctx = NULL;
         return result;
     }
     
-    result = config_validate(&(*ctx)->config);
+    LOG_INFO(ctx->log_ctx, "HRTF renderer: %d directions, %d taps, %d-frame partitions", 
+             hrtf_get_num_directions(ctx->hrtf_ctx), hrtf_get_taps(ctx->hrtf_ctx), block);
+    return MICARRAY_SUCCESS;
+}
+
+static int init_beam_output(micarray_context_t *ctx) {
+    beam_output_config_t beam_config = {
+        .channels = ctx->config.beam_count,
+        .sample_rate = ctx->config.sample_rate,
+        .block_frames = ctx->config.dma_buffer_size,
+        .ring_frames = ctx->config.beam_ring_ms * ctx->config.sample_rate / 1000
+    };
+    strcpy(beam_config.target, ctx->config.beam_target);
+    
+    if (strcmp(ctx->config.beam_sink, "alsa") == 0) {
+        beam_config.sink = BEAM_SINK_ALSA;
+        beam_config.block_frames = (int)ctx->output_frames;
+    } else if (strcmp(ctx->config.beam_sink, "shm") == 0) {
+        beam_config.sink = BEAM_SINK_SHM;
+    } else {
+        beam_config.sink = BEAM_SINK_FILE;
+    }
+    
+    /* micarray_process_block() must not block on I/O, so a headless
+     * context can only publish to the ring. */
+    if (ctx->headless && beam_config.sink != BEAM_SINK_SHM) {
+        LOG_ERROR(ctx->log_ctx, "Headless beam output needs the shm sink");
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (beam_config.ring_frames < 2 * beam_config.block_frames) {
+        beam_config.ring_frames = 2 * beam_config.block_frames;
+    }
+    
+    int result = beam_output_init(&ctx->beam_ctx, &beam_config);
+    if (result != MICARRAY_SUCCESS) {
+        return result;
+    }
+    
+    LOG_INFO(ctx->log_ctx, "Beam output: %d beams to %s %s", ctx->config.beam_count, 
+             ctx->config.beam_sink, ctx->config.beam_target);
+    return MICARRAY_SUCCESS;
+}
+
+/* Builds the per-channel stage graph from [Pipeline] stages, a comma
+ * separated list of "name" or "name:args". The built-in stages join only
+ * when their section enables them; any other name must have been
+ * registered with micarray_register_stage(). */
+static int init_stage_graph(micarray_context_t *ctx) {
+    micarray_stage_format_t format = {
+        .num_channels = ctx->config.num_microphones,
+        .sample_rate = ctx->config.sample_rate,
+        .max_frames = ctx->config.dma_buffer_size
+    };
+    
+    int result = stage_graph_init(&ctx->stage_graph, &format);
     if (result != MICARRAY_SUCCESS) {
-        free(*ctx);
-        *ctx = NULL;
         return result;
     }
     
+    char list[sizeof(ctx->config.pipeline_stages)];
+    strcpy(list, ctx->config.pipeline_stages[0] ? ctx->config.pipeline_stages : MICARRAY_DEFAULT_STAGES);
+    
+    char *saveptr = NULL;
+    for (char *item = strtok_r(list, ",", &saveptr); item; item = strtok_r(NULL, ",", &saveptr)) {
+        while (*item == ' ' || *item == '\t') {
+            item++;
+        }
+        char *end = item + strlen(item);
+        while (end > item && (end[-1] == ' ' || end[-1] == '\t')) {
+            *--end = '\0';
+        }
+        
+        char *args = strchr(item, ':');
+        if (args) {
+            *args++ = '\0';
+        }
+        
+        if (strcmp(item, "prefilter") == 0) {
+            if (ctx->prefilter_ctx) {
+                result = stage_graph_add_pcm(ctx->stage_graph, item, prefilter_stage, ctx->prefilter_ctx);
+            }
+        } else if (strcmp(item, "aec") == 0) {
+            if (ctx->echo_ctx) {
+                result = stage_graph_add_pcm(ctx->stage_graph, item, echo_canceller_stage, ctx->echo_ctx);
+            }
+        } else if (strcmp(item, "dereverb") == 0) {
+            if (ctx->dereverb_ctx) {
+                result = stage_graph_add_pcm(ctx->stage_graph, item, dereverb_stage, ctx->dereverb_ctx);
+            }
+        } else if (strcmp(item, "noise_reduction") == 0) {
+            if (ctx->noise_ctx) {
+                result = stage_graph_add_pcm(ctx->stage_graph, item, noise_reduction_stage, ctx);
+            }
+        } else {
+            const micarray_stage_t *stage = stage_registry_find(item);
+            if (!stage) {
+                LOG_ERROR(ctx->log_ctx, "Unknown pipeline stage '%s'", item);
+                return MICARRAY_ERROR_CONFIG;
+            }
+            result = stage_graph_add(ctx->stage_graph, stage, args);
+        }
+        
+        if (result != MICARRAY_SUCCESS) {
+            LOG_ERROR(ctx->log_ctx, "Failed to add pipeline stage '%s'", item);
+            return result;
+        }
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+static int micarray_init_components(micarray_context_t **ctx) {
+    int result;
+    
     if (pthread_mutex_init(&(*ctx)->data_mutex, NULL) != 0) {
         free(*ctx);
         *ctx = NULL;
         return MICARRAY_ERROR_INIT;
     }
     
+    if (pthread_cond_init(&(*ctx)->block_cond, NULL) != 0) {
+        pthread_mutex_destroy(&(*ctx)->data_mutex);
+        free(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    if (pthread_cond_init(&(*ctx)->localization_cond, NULL) != 0) {
+        pthread_cond_destroy(&(*ctx)->block_cond);
+        pthread_mutex_destroy(&(*ctx)->data_mutex);
+        free(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_INIT;
+    }
+    
     logging_config_t log_config = {
         .enable_serial_logging = (*ctx)->config.enable_serial_logging,
         .enable_file_logging = (strlen((*ctx)->config.log_file) > 0),
@@ -170,6 +1054,8 @@ int micarray_init(micarray_context_t **ctx, const char *config_file) {
     
     result = logging_init(&(*ctx)->log_ctx, &log_config);
     if (result != MICARRAY_SUCCESS) {
+        pthread_cond_destroy(&(*ctx)->localization_cond);
+        pthread_cond_destroy(&(*ctx)->block_cond);
         pthread_mutex_destroy(&(*ctx)->data_mutex);
         free(*ctx);
         *ctx = NULL;
@@ -179,136 +1065,453 @@ int micarray_init(micarray_context_t **ctx, const char *config_file) {
     LOG_INFO((*ctx)->log_ctx, "Initializing libmicarray v%s", LIBMICARRAY_VERSION);
     config_print(&(*ctx)->config);
     
-    (*ctx)->mic_buffers = malloc((*ctx)->config.num_microphones * sizeof(int16_t*));
-    if (!(*ctx)->mic_buffers) {
-        logging_cleanup((*ctx)->log_ctx);
-        pthread_mutex_destroy(&(*ctx)->data_mutex);
-        free(*ctx);
+    /* Contexts pick up the kernels when they are created, so this has to
+     * come before any of them. */
+    const char *kernels = getenv("MICARRAY_KERNELS");
+    if (!kernels || !kernels[0]) {
+        kernels = (*ctx)->config.kernels[0] ? (*ctx)->config.kernels : "auto";
+    }
+    /* Whatever an earlier context or caller selected is replaced, so a
+     * level this CPU lacks falls back to the best it has. */
+    if (kernels_select(kernels) != MICARRAY_SUCCESS) {
+        kernels_select("auto");
+        LOG_WARN((*ctx)->log_ctx, "SIMD kernels %s not available, using %s", kernels, kernels_get()->level);
+    }
+    const kernel_table_t *table = kernels_get();
+    LOG_INFO((*ctx)->log_ctx, "SIMD kernels: %s (complex_mac %s, gemv_int8 %s)",
+             table->level, table->complex_mac_impl, table->gemv_int8_impl);
+    
+    const int channels = (*ctx)->config.num_microphones;
+    
+    (*ctx)->active_mask = (1u << channels) - 1;
+    (*ctx)->snapshot_mask = (*ctx)->active_mask;
+    (*ctx)->stats.active_channel_mask = (*ctx)->active_mask;
+    
+    /* The monitor always does the deinterleave, since that pass also
+     * meters the channels; with health_monitor off it never drops any. */
+    mic_health_config_t health_config = {
+        .num_channels = channels,
+        .sample_rate = (*ctx)->config.sample_rate,
+        .monitor_only = !(*ctx)->config.health_monitor
+    };
+    
+    result = mic_health_init(&(*ctx)->health_ctx, &health_config);
+    if (result != MICARRAY_SUCCESS) {
+        LOG_ERROR((*ctx)->log_ctx, "Failed to initialize microphone health monitor");
+        micarray_cleanup(*ctx);
+        *ctx = NULL;
+        return result;
+    }
+    
+    if ((*ctx)->config.prefilter_enable) {
+        prefilter_config_t prefilter_config = {
+            .num_channels = channels,
+            .sample_rate = (*ctx)->config.sample_rate,
+            .dc_removal = (*ctx)->config.prefilter_dc_removal,
+            .highpass_hz = (*ctx)->config.prefilter_highpass,
+            .lowpass_hz = (*ctx)->config.prefilter_lowpass
+        };
+        
+        result = prefilter_init(&(*ctx)->prefilter_ctx, &prefilter_config);
+        if (result != MICARRAY_SUCCESS) {
+            LOG_ERROR((*ctx)->log_ctx, "Failed to initialize pre-filter");
+            micarray_cleanup(*ctx);
+            *ctx = NULL;
+            return result;
+        }
+    }
+    
+    if ((*ctx)->config.metrics_rate > 0.0f) {
+        (*ctx)->metrics_interval = (size_t)((*ctx)->config.sample_rate / (*ctx)->config.metrics_rate);
+        if ((*ctx)->metrics_interval == 0) {
+            (*ctx)->metrics_interval = 1;
+        }
+    }
+    
+    if ((*ctx)->config.low_latency) {
+        (*ctx)->block_size = (*ctx)->config.hop_size;
+        (*ctx)->output_frames = (*ctx)->block_size * LOW_LATENCY_OUTPUT_BLOCKS;
+    } else {
+        (*ctx)->block_size = (*ctx)->config.dma_buffer_size;
+        (*ctx)->output_frames = (*ctx)->block_size;
+    }
+    
+    /* A window of 0 keeps the historic behaviour of analysing the last
+     * max(dma_buffer_size, LOCALIZATION_WINDOW_SIZE) frames, and a rate of 0
+     * localizes once per dma_buffer_size frames. */
+    if ((*ctx)->config.localization_window > 0) {
+        (*ctx)->history_size = (*ctx)->config.localization_window;
+    } else {
+        (*ctx)->history_size = (*ctx)->config.dma_buffer_size;
+        if ((*ctx)->history_size < LOCALIZATION_WINDOW_SIZE) {
+            (*ctx)->history_size = LOCALIZATION_WINDOW_SIZE;
+        }
+    }
+    
+    if ((*ctx)->config.localization_rate > 0.0f) {
+        (*ctx)->localization_interval = (size_t)((*ctx)->config.sample_rate / (*ctx)->config.localization_rate);
+        if ((*ctx)->localization_interval == 0) {
+            (*ctx)->localization_interval = 1;
+        }
+    } else {
+        (*ctx)->localization_interval = (*ctx)->config.dma_buffer_size;
+    }
+    
+    /* The incremental estimator is fed everything captured since the last
+     * fix, so the ring must hold a full interval plus a block of slack for
+     * a worker that is running behind. */
+    (*ctx)->localization_window = (*ctx)->history_size;
+    (*ctx)->localization_incremental = (strcmp((*ctx)->config.localization_method, "xcorr") != 0);
+    if ((*ctx)->localization_incremental && 
+        (*ctx)->history_size < (*ctx)->localization_interval + (*ctx)->block_size) {
+        (*ctx)->history_size = (*ctx)->localization_interval + (*ctx)->block_size;
+    }
+    
+    (*ctx)->mic_buffers = alloc_channel_buffers(channels, (*ctx)->config.dma_buffer_size);
+    (*ctx)->block_buffers = alloc_channel_buffers(channels, (*ctx)->config.dma_buffer_size);
+    (*ctx)->history_buffers = alloc_channel_buffers(channels, (*ctx)->history_size);
+    (*ctx)->window_buffers = alloc_channel_buffers(channels, (*ctx)->history_size);
+    (*ctx)->processed_buffer = calloc((*ctx)->config.dma_buffer_size, sizeof(int16_t));
+    (*ctx)->mix_buffer = calloc((*ctx)->config.dma_buffer_size, sizeof(int32_t));
+    (*ctx)->stereo_buffer = calloc(2 * (size_t)(*ctx)->config.dma_buffer_size, sizeof(int16_t));
+    
+    if (!(*ctx)->mic_buffers || !(*ctx)->block_buffers || !(*ctx)->history_buffers || 
+        !(*ctx)->window_buffers || !(*ctx)->processed_buffer || !(*ctx)->mix_buffer || 
+        !(*ctx)->stereo_buffer) {
+        micarray_cleanup(*ctx);
         *ctx = NULL;
         return MICARRAY_ERROR_MEMORY;
     }
     
-    for (int i = 0; i < (*ctx)->config.num_microphones; i++) {
-        (*ctx)->mic_buffers[i] = calloc((*ctx)->config.dma_buffer_size, sizeof(int16_t));
-        if (!(*ctx)->mic_buffers[i]) {
-            for (int j = 0; j < i; j++) {
-                free((*ctx)->mic_buffers[j]);
-            }
-            free((*ctx)->mic_buffers);
-            logging_cleanup((*ctx)->log_ctx);
-            pthread_mutex_destroy(&(*ctx)->data_mutex);
-            free(*ctx);
+    if (!(*ctx)->headless) {
+        i2s_config_t i2s_config = {
+            .bus_id = (*ctx)->config.i2s_bus,
+            .sample_rate = (*ctx)->config.sample_rate,
+            .channels = (*ctx)->config.num_microphones,
+            .bits_per_sample = 16,
+            .buffer_size = (int)(*ctx)->block_size * channels
+        };
+        
+        result = i2s_init(&(*ctx)->i2s_ctx, &i2s_config);
+        if (result != MICARRAY_SUCCESS) {
+            LOG_ERROR((*ctx)->log_ctx, "Failed to initialize I2S interface");
+            micarray_cleanup(*ctx);
+            *ctx = NULL;
+            return result;
+        }
+        
+        i2s_set_callback((*ctx)->i2s_ctx, audio_callback, *ctx);
+        
+        (*ctx)->carry_buffer = calloc((*ctx)->block_size * channels, sizeof(int16_t));
+        if (!(*ctx)->carry_buffer) {
+            micarray_cleanup(*ctx);
+            *ctx = NULL;
+            return MICARRAY_ERROR_MEMORY;
+        }
+    }
+    
+    if ((*ctx)->config.dereverb_enable) {
+        dereverb_config_t dereverb_config = {
+            .num_channels = channels,
+            .sample_rate = (*ctx)->config.sample_rate,
+            .frame_size = (*ctx)->config.dereverb_frame_size,
+            .order = (*ctx)->config.dereverb_order,
+            .delay = (*ctx)->config.dereverb_delay,
+            .forgetting = (*ctx)->config.dereverb_forgetting
+        };
+        
+        result = dereverb_init(&(*ctx)->dereverb_ctx, &dereverb_config);
+        if (result != MICARRAY_SUCCESS) {
+            LOG_ERROR((*ctx)->log_ctx, "Failed to initialize dereverberation");
+            micarray_cleanup(*ctx);
+            *ctx = NULL;
+            return result;
+        }
+    }
+    
+    if ((*ctx)->config.noise_reduction_enable) {
+        /* Low-latency mode synthesises short frames of two hops, so NR adds
+         * 2 * hop_size of delay instead of a full NR_FRAME_SIZE frame. */
+        int frame_size = (*ctx)->config.low_latency ? 2 * (*ctx)->config.hop_size : NR_FRAME_SIZE;
+        
+        noise_reduction_config_t noise_config = {
+            .noise_threshold = (*ctx)->config.noise_threshold,
+            .frame_size = frame_size,
+            .overlap = frame_size / 2,
+            .alpha = 2.0f,
+            .beta = 0.1f,
+            .sample_rate = (*ctx)->config.sample_rate
+        };
+        strcpy(noise_config.algorithm, (*ctx)->config.algorithm);
+        strcpy(noise_config.model_file, (*ctx)->config.nn_model);
+        
+        (*ctx)->noise_ctx = calloc(channels, sizeof(noise_reduction_context_t*));
+        if (!(*ctx)->noise_ctx) {
+            micarray_cleanup(*ctx);
+            *ctx = NULL;
+            return MICARRAY_ERROR_MEMORY;
+        }
+        
+        for (int i = 0; i < channels; i++) {
+            result = noise_reduction_init(&(*ctx)->noise_ctx[i], &noise_config);
+            if (result != MICARRAY_SUCCESS) {
+                LOG_ERROR((*ctx)->log_ctx, "Failed to initialize noise reduction");
+                micarray_cleanup(*ctx);
+                *ctx = NULL;
+                return result;
+            }
+        }
+    }
+    
+    microphone_position_t *mic_positions = malloc((*ctx)->config.num_microphones * sizeof(microphone_position_t));
+    if (!mic_positions) {
+        micarray_cleanup(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    for (int i = 0; i < (*ctx)->config.num_microphones; i++) {
+        float angle = 2.0f * M_PI * i / (*ctx)->config.num_microphones;
+        mic_positions[i].x = (*ctx)->config.mic_spacing * cosf(angle) / 1000.0f;
+        mic_positions[i].y = (*ctx)->config.mic_spacing * sinf(angle) / 1000.0f;
+        mic_positions[i].z = 0.0f;
+    }
+    
+    localization_config_t loc_config = {
+        .num_microphones = (*ctx)->config.num_microphones,
+        .mic_positions = mic_positions,
+        .mic_spacing = (*ctx)->config.mic_spacing / 1000.0f,
+        .sample_rate = (*ctx)->config.sample_rate,
+        .speed_of_sound = 343.0f,
+        .correlation_window_size = (int)(*ctx)->localization_window,
+        .min_confidence_threshold = 0.3f,
+        .gcc_frame_size = (*ctx)->localization_incremental ? GCC_FRAME_SIZE : 0,
+        .gcc_smoothing = (*ctx)->config.localization_smoothing,
+        .band_low_hz = (*ctx)->config.localization_band_low,
+        .band_high_hz = (*ctx)->config.localization_band_high,
+        .max_bins = (*ctx)->config.localization_max_bins
+    };
+    
+    result = localization_init(&(*ctx)->loc_ctx, &loc_config);
+    if (result != MICARRAY_SUCCESS) {
+        free(mic_positions);
+        LOG_ERROR((*ctx)->log_ctx, "Failed to initialize localization");
+        micarray_cleanup(*ctx);
+        *ctx = NULL;
+        return result;
+    }
+    
+    if ((*ctx)->config.beam_enable) {
+        beamformer_config_t beamformer_config = {
+            .num_microphones = (*ctx)->config.num_microphones,
+            .mic_positions = mic_positions,
+            .sample_rate = (*ctx)->config.sample_rate,
+            .speed_of_sound = 343.0f,
+            .num_beams = (*ctx)->config.beam_count
+        };
+        
+        result = beamformer_init(&(*ctx)->beamformer_ctx, &beamformer_config);
+        if (result != MICARRAY_SUCCESS) {
+            free(mic_positions);
+            LOG_ERROR((*ctx)->log_ctx, "Failed to initialize beamformer");
+            micarray_cleanup(*ctx);
+            *ctx = NULL;
+            return result;
+        }
+    }
+    free(mic_positions);
+    
+    /* The reference channel's noise estimate ranks GCC-PHAT bins by SNR. */
+    if ((*ctx)->localization_incremental && (*ctx)->noise_ctx) {
+        (*ctx)->noise_psd = calloc(GCC_FRAME_SIZE / 2 + 1, sizeof(float));
+        (*ctx)->latched_psd = calloc(GCC_FRAME_SIZE / 2 + 1, sizeof(float));
+        if (!(*ctx)->noise_psd || !(*ctx)->latched_psd) {
+            micarray_cleanup(*ctx);
+            *ctx = NULL;
+            return MICARRAY_ERROR_MEMORY;
+        }
+    }
+    
+    if (!(*ctx)->headless) {
+        audio_output_config_t audio_config = {
+            .sample_rate = (*ctx)->config.sample_rate,
+            .channels = 2,
+            .bits_per_sample = 16,
+            .buffer_size = (int)(*ctx)->output_frames,
+            .volume = (*ctx)->config.volume
+        };
+        strcpy(audio_config.device_name, "default");
+        
+        result = audio_output_init(&(*ctx)->audio_ctx, &audio_config);
+        if (result != MICARRAY_SUCCESS) {
+            LOG_ERROR((*ctx)->log_ctx, "Failed to initialize audio output");
+            micarray_cleanup(*ctx);
+            *ctx = NULL;
+            return result;
+        }
+    }
+    
+    panner_config_t panner_config = { .sample_rate = (*ctx)->config.sample_rate };
+    result = panner_init(&(*ctx)->panner_ctx, &panner_config);
+    if (result != MICARRAY_SUCCESS) {
+        LOG_ERROR((*ctx)->log_ctx, "Failed to initialize panner");
+        micarray_cleanup(*ctx);
+        *ctx = NULL;
+        return result;
+    }
+    
+    if ((*ctx)->config.agc_enable) {
+        agc_config_t agc_config = {
+            .sample_rate = (*ctx)->config.sample_rate,
+            .target_level_db = (*ctx)->config.agc_target_db,
+            .max_gain_db = (*ctx)->config.agc_max_gain_db,
+            .gate_db = (*ctx)->config.agc_gate_db,
+            .attack_ms = (*ctx)->config.agc_attack_ms,
+            .release_ms = (*ctx)->config.agc_release_ms,
+            .ceiling_db = (*ctx)->config.agc_ceiling_db,
+            .lookahead_ms = (*ctx)->config.agc_lookahead_ms
+        };
+        
+        result = agc_init(&(*ctx)->agc_ctx, &agc_config);
+        if (result != MICARRAY_SUCCESS) {
+            LOG_ERROR((*ctx)->log_ctx, "Failed to initialize AGC");
+            micarray_cleanup(*ctx);
             *ctx = NULL;
-            return MICARRAY_ERROR_MEMORY;
+            return result;
         }
     }
     
-    (*ctx)->processed_buffer = calloc((*ctx)->config.dma_buffer_size, sizeof(int16_t));
-    if (!(*ctx)->processed_buffer) {
-        for (int i = 0; i < (*ctx)->config.num_microphones; i++) {
-            free((*ctx)->mic_buffers[i]);
+    if (strcmp((*ctx)->config.output_renderer, "hrtf") == 0) {
+        result = init_hrtf_renderer(*ctx);
+        if (result != MICARRAY_SUCCESS) {
+            LOG_ERROR((*ctx)->log_ctx, "Failed to initialize HRTF renderer");
+            micarray_cleanup(*ctx);
+            *ctx = NULL;
+            return result;
         }
-        free((*ctx)->mic_buffers);
-        logging_cleanup((*ctx)->log_ctx);
-        pthread_mutex_destroy(&(*ctx)->data_mutex);
-        free(*ctx);
-        *ctx = NULL;
-        return MICARRAY_ERROR_MEMORY;
     }
     
-    i2s_config_t i2s_config = {
-        .bus_id = (*ctx)->config.i2s_bus,
-        .sample_rate = (*ctx)->config.sample_rate,
-        .channels = (*ctx)->config.num_microphones,
-        .bits_per_sample = 16,
-        .buffer_size = (*ctx)->config.dma_buffer_size
-    };
-    
-    result = i2s_init(&(*ctx)->i2s_ctx, &i2s_config);
-    if (result != MICARRAY_SUCCESS) {
-        LOG_ERROR((*ctx)->log_ctx, "Failed to initialize I2S interface");
-        micarray_cleanup(*ctx);
-        *ctx = NULL;
-        return result;
+    if ((*ctx)->config.aec_enable) {
+        result = init_echo_canceller(*ctx);
+        if (result != MICARRAY_SUCCESS) {
+            LOG_ERROR((*ctx)->log_ctx, "Failed to initialize echo canceller");
+            micarray_cleanup(*ctx);
+            *ctx = NULL;
+            return result;
+        }
     }
     
-    i2s_set_callback((*ctx)->i2s_ctx, audio_callback, *ctx);
-    
-    if ((*ctx)->config.noise_reduction_enable) {
-        noise_reduction_config_t noise_config = {
-            .noise_threshold = (*ctx)->config.noise_threshold,
-            .frame_size = 1024,
-            .overlap = 512,
-            .alpha = 2.0f,
-            .beta = 0.1f,
-            .sample_rate = (*ctx)->config.sample_rate
+    if ((*ctx)->config.recorder_enable) {
+        recorder_config_t recorder_config = {
+            .num_channels = channels,
+            .sample_rate = (*ctx)->config.sample_rate,
+            .format = strcmp((*ctx)->config.recorder_format, "lossless") == 0 ? 
+                      RECORDER_FORMAT_LOSSLESS : RECORDER_FORMAT_WAV,
+            .pre_trigger_frames = (int)((int64_t)(*ctx)->config.recorder_pre_ms * (*ctx)->config.sample_rate / 1000),
+            .post_trigger_frames = (int)((int64_t)(*ctx)->config.recorder_post_ms * (*ctx)->config.sample_rate / 1000),
+            .trigger_level_db = (*ctx)->config.recorder_trigger_db
         };
-        strcpy(noise_config.algorithm, (*ctx)->config.algorithm);
+        strcpy(recorder_config.directory, (*ctx)->config.recorder_directory);
         
-        result = noise_reduction_init(&(*ctx)->noise_ctx, &noise_config);
+        result = recorder_init(&(*ctx)->recorder_ctx, &recorder_config);
         if (result != MICARRAY_SUCCESS) {
-            LOG_ERROR((*ctx)->log_ctx, "Failed to initialize noise reduction");
+            LOG_ERROR((*ctx)->log_ctx, "Failed to initialize recorder");
             micarray_cleanup(*ctx);
             *ctx = NULL;
             return result;
         }
     }
     
-    microphone_position_t *mic_positions = malloc((*ctx)->config.num_microphones * sizeof(microphone_position_t));
-    if (!mic_positions) {
+    if ((*ctx)->config.beam_enable) {
+        result = init_beam_output(*ctx);
+        if (result != MICARRAY_SUCCESS) {
+            LOG_ERROR((*ctx)->log_ctx, "Failed to initialize beam output");
+            micarray_cleanup(*ctx);
+            *ctx = NULL;
+            return result;
+        }
+    }
+    
+    result = init_stage_graph(*ctx);
+    if (result != MICARRAY_SUCCESS) {
+        LOG_ERROR((*ctx)->log_ctx, "Failed to build processing pipeline");
         micarray_cleanup(*ctx);
         *ctx = NULL;
-        return MICARRAY_ERROR_MEMORY;
+        return result;
     }
+    publish_stages(*ctx);
     
-    for (int i = 0; i < (*ctx)->config.num_microphones; i++) {
-        float angle = 2.0f * M_PI * i / (*ctx)->config.num_microphones;
-        mic_positions[i].x = (*ctx)->config.mic_spacing * cosf(angle) / 1000.0f;
-        mic_positions[i].y = (*ctx)->config.mic_spacing * sinf(angle) / 1000.0f;
-        mic_positions[i].z = 0.0f;
+    (*ctx)->running = false;
+    (*ctx)->perf_pending = (*ctx)->config.perf_counters ? 1u << GROUP_PROCESSING : 0;
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        stage_section_init(&(*ctx)->sections[s], section_names[s]);
+        (*ctx)->section_stats[s] = (*ctx)->sections[s].stats;
     }
     
-    localization_config_t loc_config = {
-        .num_microphones = (*ctx)->config.num_microphones,
-        .mic_positions = mic_positions,
-        .mic_spacing = (*ctx)->config.mic_spacing / 1000.0f,
-        .sample_rate = (*ctx)->config.sample_rate,
-        .speed_of_sound = 343.0f,
-        .correlation_window_size = 1024,
-        .min_confidence_threshold = 0.3f
-    };
+    micarray_latency_t latency;
+    micarray_get_latency(*ctx, &latency);
+    LOG_INFO((*ctx)->log_ctx, "Latency: block %d + dereverb %d + NR %d + AGC %d + output %d frames = "
+             "%.1f ms audio, localization window %d every %d frames = %.1f ms", 
+             latency.block_frames, latency.dereverb_frames, latency.noise_reduction_frames, 
+             latency.agc_frames, latency.output_frames, 
+             latency.audio_latency_ms, latency.localization_window_frames, 
+             latency.localization_interval_frames, latency.localization_latency_ms);
     
-    result = localization_init(&(*ctx)->loc_ctx, &loc_config);
-    free(mic_positions);
+    LOG_INFO((*ctx)->log_ctx, "libmicarray initialization complete");
+    
+    return MICARRAY_SUCCESS;
+}
+
+int micarray_init(micarray_context_t **ctx, const char *config_file) {
+    if (!ctx || !config_file) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(micarray_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    config_set_defaults(&(*ctx)->config);
+    
+    int result = config_parse_file(config_file, &(*ctx)->config);
     if (result != MICARRAY_SUCCESS) {
-        LOG_ERROR((*ctx)->log_ctx, "Failed to initialize localization");
-        micarray_cleanup(*ctx);
+        free(*ctx);
         *ctx = NULL;
         return result;
     }
     
-    audio_output_config_t audio_config = {
-        .sample_rate = (*ctx)->config.sample_rate,
-        .channels = 2,
-        .bits_per_sample = 16,
-        .buffer_size = (*ctx)->config.dma_buffer_size,
-        .volume = (*ctx)->config.volume
-    };
-    strcpy(audio_config.device_name, "default");
-    
-    result = audio_output_init(&(*ctx)->audio_ctx, &audio_config);
+    result = config_validate(&(*ctx)->config);
     if (result != MICARRAY_SUCCESS) {
-        LOG_ERROR((*ctx)->log_ctx, "Failed to initialize audio output");
-        micarray_cleanup(*ctx);
+        free(*ctx);
         *ctx = NULL;
         return result;
     }
     
-    (*ctx)->running = false;
+    return micarray_init_components(ctx);
+}
+
+int micarray_init_headless(micarray_context_t **ctx, const micarray_config_t *config) {
+    if (!ctx || !config) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
     
-    LOG_INFO((*ctx)->log_ctx, "libmicarray initialization complete");
+    *ctx = calloc(1, sizeof(micarray_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
     
-    return MICARRAY_SUCCESS;
+    (*ctx)->config = *config;
+    (*ctx)->headless = true;
+    
+    int result = config_validate(&(*ctx)->config);
+    if (result != MICARRAY_SUCCESS) {
+        free(*ctx);
+        *ctx = NULL;
+        return result;
+    }
+    
+    return micarray_init_components(ctx);
 }
 
 int micarray_start(micarray_context_t *ctx) {
@@ -320,6 +1523,11 @@ int micarray_start(micarray_context_t *ctx) {
         return MICARRAY_SUCCESS;
     }
     
+    if (ctx->headless) {
+        LOG_ERROR(ctx->log_ctx, "Headless context is driven by micarray_process_block");
+        return MICARRAY_ERROR_INIT;
+    }
+    
     LOG_INFO(ctx->log_ctx, "Starting microphone array processing");
     
     int result = i2s_start(ctx->i2s_ctx);
@@ -335,10 +1543,51 @@ int micarray_start(micarray_context_t *ctx) {
         return result;
     }
     
+    pthread_mutex_lock(&ctx->data_mutex);
+    ctx->captured_frames = 0;
+    ctx->carry_frames = 0;
+    ctx->block_ready = false;
+    ctx->localization_due = false;
+    ctx->localization_threaded = (ctx->loc_ctx != NULL);
+    ctx->perf_pending = 0;
+    if (ctx->config.perf_counters) {
+        ctx->perf_pending = (1u << GROUP_PROCESSING) | (1u << GROUP_CAPTURE);
+        if (ctx->localization_threaded) {
+            ctx->perf_pending |= 1u << GROUP_LOCALIZATION;
+        }
+    }
+    stage_graph_reset(ctx->stage_graph);
+    publish_stages(ctx);
+    if (ctx->dereverb_ctx) {
+        dereverb_reset(ctx->dereverb_ctx);
+    }
+    if (ctx->agc_ctx) {
+        agc_reset(ctx->agc_ctx);
+    }
     ctx->running = true;
+    pthread_mutex_unlock(&ctx->data_mutex);
+    
+    if (ctx->localization_threaded && 
+        pthread_create(&ctx->localization_thread, NULL, localization_thread_func, ctx) != 0) {
+        ctx->localization_threaded = false;
+        ctx->running = false;
+        audio_output_stop(ctx->audio_ctx);
+        i2s_stop(ctx->i2s_ctx);
+        LOG_ERROR(ctx->log_ctx, "Failed to create localization thread");
+        return MICARRAY_ERROR_INIT;
+    }
     
     if (pthread_create(&ctx->processing_thread, NULL, processing_thread_func, ctx) != 0) {
+        pthread_mutex_lock(&ctx->data_mutex);
         ctx->running = false;
+        pthread_cond_broadcast(&ctx->localization_cond);
+        pthread_mutex_unlock(&ctx->data_mutex);
+        
+        if (ctx->localization_threaded) {
+            pthread_join(ctx->localization_thread, NULL);
+            ctx->localization_threaded = false;
+        }
+        
         audio_output_stop(ctx->audio_ctx);
         i2s_stop(ctx->i2s_ctx);
         LOG_ERROR(ctx->log_ctx, "Failed to create processing thread");
@@ -361,12 +1610,23 @@ int micarray_stop(micarray_context_t *ctx) {
     
     LOG_INFO(ctx->log_ctx, "Stopping microphone array processing");
     
+    pthread_mutex_lock(&ctx->data_mutex);
     ctx->running = false;
+    pthread_cond_broadcast(&ctx->block_cond);
+    pthread_cond_broadcast(&ctx->localization_cond);
+    pthread_mutex_unlock(&ctx->data_mutex);
     
     if (pthread_join(ctx->processing_thread, NULL) != 0) {
         LOG_ERROR(ctx->log_ctx, "Failed to join processing thread");
     }
     
+    if (ctx->localization_threaded) {
+        if (pthread_join(ctx->localization_thread, NULL) != 0) {
+            LOG_ERROR(ctx->log_ctx, "Failed to join localization thread");
+        }
+        ctx->localization_threaded = false;
+    }
+    
     audio_output_stop(ctx->audio_ctx);
     i2s_stop(ctx->i2s_ctx);
     
@@ -390,8 +1650,17 @@ int micarray_cleanup(micarray_context_t *ctx) {
         localization_cleanup(ctx->loc_ctx);
     }
     
+    if (ctx->dereverb_ctx) {
+        dereverb_cleanup(ctx->dereverb_ctx);
+    }
+    
     if (ctx->noise_ctx) {
-        noise_reduction_cleanup(ctx->noise_ctx);
+        for (int i = 0; i < ctx->config.num_microphones; i++) {
+            if (ctx->noise_ctx[i]) {
+                noise_reduction_cleanup(ctx->noise_ctx[i]);
+            }
+        }
+        free(ctx->noise_ctx);
     }
     
     if (ctx->i2s_ctx) {
@@ -402,13 +1671,61 @@ int micarray_cleanup(micarray_context_t *ctx) {
         dma_cleanup(ctx->dma_ctx);
     }
     
-    if (ctx->mic_buffers) {
-        for (int i = 0; i < ctx->config.num_microphones; i++) {
-            free(ctx->mic_buffers[i]);
+    free_channel_buffers(ctx->mic_buffers, ctx->config.num_microphones);
+    free_channel_buffers(ctx->block_buffers, ctx->config.num_microphones);
+    free(ctx->carry_buffer);
+    free_channel_buffers(ctx->history_buffers, ctx->config.num_microphones);
+    free_channel_buffers(ctx->window_buffers, ctx->config.num_microphones);
+    free(ctx->noise_psd);
+    free(ctx->latched_psd);
+    free(ctx->mix_buffer);
+    
+    if (ctx->stage_graph) {
+        stage_graph_cleanup(ctx->stage_graph);
+    }
+    
+    for (int g = 0; g < COUNTER_GROUPS; g++) {
+        if (ctx->counters[g]) {
+            perf_counters_cleanup(ctx->counters[g]);
         }
-        free(ctx->mic_buffers);
     }
     
+    if (ctx->prefilter_ctx) {
+        prefilter_cleanup(ctx->prefilter_ctx);
+    }
+    
+    if (ctx->echo_ctx) {
+        echo_canceller_cleanup(ctx->echo_ctx);
+    }
+    
+    if (ctx->hrtf_ctx) {
+        hrtf_cleanup(ctx->hrtf_ctx);
+    }
+    
+    if (ctx->panner_ctx) {
+        panner_cleanup(ctx->panner_ctx);
+    }
+    
+    if (ctx->agc_ctx) {
+        agc_cleanup(ctx->agc_ctx);
+    }
+    free(ctx->stereo_buffer);
+    
+    if (ctx->beam_ctx) {
+        beam_output_cleanup(ctx->beam_ctx);
+    }
+    
+    if (ctx->beamformer_ctx) {
+        beamformer_cleanup(ctx->beamformer_ctx);
+    }
+    
+    if (ctx->recorder_ctx) {
+        recorder_cleanup(ctx->recorder_ctx);
+    }
+    
+    if (ctx->health_ctx) {
+        mic_health_cleanup(ctx->health_ctx);
+    }
     free(ctx->processed_buffer);
     
     if (ctx->log_ctx) {
@@ -416,6 +1733,8 @@ int micarray_cleanup(micarray_context_t *ctx) {
         logging_cleanup(ctx->log_ctx);
     }
     
+    pthread_cond_destroy(&ctx->localization_cond);
+    pthread_cond_destroy(&ctx->block_cond);
     pthread_mutex_destroy(&ctx->data_mutex);
     free(ctx);
     
@@ -434,6 +1753,182 @@ int micarray_get_location(micarray_context_t *ctx, sound_location_t *location) {
     return MICARRAY_SUCCESS;
 }
 
+/* The host's audio callback path: deinterleave into block_buffers and run
+ * the same stages as the processing thread. Headless contexts have no
+ * worker, so a due localization update runs inline; work per call is
+ * bounded by dma_buffer_size frames plus at most one update. */
+int micarray_process_block(micarray_context_t *ctx, const int16_t *input, micarray_layout_t layout, 
+                           size_t frames, int16_t *output, sound_location_t *location) {
+    if (!ctx || !input || !output || frames == 0 || frames > (size_t)ctx->config.dma_buffer_size) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (ctx->running) {
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    pthread_mutex_lock(&ctx->data_mutex);
+    if (ctx->perf_pending & (1u << GROUP_PROCESSING)) {
+        open_counters(ctx, GROUP_PROCESSING);
+    }
+    uint64_t start_ns = monotonic_ns();
+    
+    begin_section(ctx, SECTION_CAPTURE, GROUP_PROCESSING);
+    if (layout == MICARRAY_LAYOUT_PLANAR) {
+        mic_health_copy_planar(ctx->health_ctx, input, frames, ctx->block_buffers);
+    } else {
+        mic_health_deinterleave(ctx->health_ctx, input, frames, ctx->block_buffers, 0);
+    }
+    end_section(ctx, SECTION_CAPTURE, GROUP_PROCESSING);
+    
+    begin_block(ctx);
+    run_block(ctx, frames);
+    finish_block(ctx, frames);
+    
+    render_output(ctx, &ctx->current_location, output, frames);
+    
+    if (ctx->echo_ctx) {
+        echo_canceller_push_reference(ctx->echo_ctx, output, frames);
+    }
+    
+    latch_beam_targets(ctx);
+    write_beams(ctx, frames);
+    
+    if (location) {
+        *location = ctx->current_location;
+    }
+    
+    record_block_time(ctx, frames, monotonic_ns() - start_ns);
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        publish_section(ctx, s);
+    }
+    publish_stages(ctx);
+    pthread_mutex_unlock(&ctx->data_mutex);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int micarray_steer_beam(micarray_context_t *ctx, int beam, const sound_location_t *target) {
+    if (!ctx || !target) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (!ctx->beamformer_ctx) {
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    if (beam < 1 || beam >= ctx->config.beam_count) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&ctx->data_mutex);
+    ctx->beam_targets[beam] = *target;
+    ctx->beam_steer_pending |= 1u << beam;
+    pthread_mutex_unlock(&ctx->data_mutex);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int micarray_trigger_recording(micarray_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    return ctx->recorder_ctx ? recorder_trigger(ctx->recorder_ctx) : MICARRAY_ERROR_INIT;
+}
+
+int micarray_stop_recording(micarray_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    return ctx->recorder_ctx ? recorder_stop(ctx->recorder_ctx) : MICARRAY_ERROR_INIT;
+}
+
+int micarray_get_stats(micarray_context_t *ctx, micarray_stats_t *stats) {
+    if (!ctx || !stats) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&ctx->data_mutex);
+    *stats = ctx->stats;
+    pthread_mutex_unlock(&ctx->data_mutex);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int micarray_register_stage(const micarray_stage_t *stage) {
+    if (!stage || !stage->name) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    static const char *const builtin[] = {"prefilter", "aec", "dereverb", "noise_reduction"};
+    for (size_t i = 0; i < sizeof(builtin) / sizeof(builtin[0]); i++) {
+        if (strcmp(stage->name, builtin[i]) == 0) {
+            return MICARRAY_ERROR_INVALID_PARAM;
+        }
+    }
+    
+    return stage_registry_add(stage);
+}
+
+int micarray_get_stage_stats(micarray_context_t *ctx, micarray_stage_stats_t *stats, int max_stages, 
+                             int *num_stages) {
+    if (!ctx || !num_stages || max_stages < 0 || (!stats && max_stages > 0)) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&ctx->data_mutex);
+    *num_stages = 0;
+    for (int i = 0; i < ctx->num_stage_stats; i++) {
+        if (*num_stages < max_stages) {
+            stats[*num_stages] = ctx->stage_stats[i];
+        }
+        (*num_stages)++;
+    }
+    
+    for (int s = 0; s < SECTION_COUNT && ctx->config.perf_counters; s++) {
+        if (!section_configured(ctx, s)) {
+            continue;
+        }
+        if (*num_stages < max_stages) {
+            stats[*num_stages] = ctx->section_stats[s];
+        }
+        (*num_stages)++;
+    }
+    pthread_mutex_unlock(&ctx->data_mutex);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int micarray_get_latency(micarray_context_t *ctx, micarray_latency_t *latency) {
+    if (!ctx || !latency) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    memset(latency, 0, sizeof(*latency));
+    latency->block_frames = (int)ctx->block_size;
+    latency->output_frames = ctx->headless ? 0 : (int)ctx->output_frames;
+    latency->localization_window_frames = (int)ctx->localization_window;
+    latency->localization_interval_frames = (int)ctx->localization_interval;
+    
+    if (ctx->noise_ctx && ctx->noise_ctx[0]) {
+        latency->noise_reduction_frames = noise_reduction_get_latency(ctx->noise_ctx[0]);
+    }
+    
+    latency->dereverb_frames = dereverb_get_latency(ctx->dereverb_ctx);
+    latency->agc_frames = agc_get_latency(ctx->agc_ctx);
+    
+    float ms_per_frame = 1000.0f / ctx->config.sample_rate;
+    latency->audio_latency_ms = (latency->block_frames + latency->dereverb_frames + 
+                                 latency->noise_reduction_frames + latency->agc_frames + 
+                                 latency->output_frames) * ms_per_frame;
+    latency->localization_latency_ms = (latency->localization_window_frames + 
+                                        latency->localization_interval_frames) * ms_per_frame;
+    
+    return MICARRAY_SUCCESS;
+}
+
 int micarray_set_volume(micarray_context_t *ctx, float volume) {
     if (!ctx) {
         return MICARRAY_ERROR_INVALID_PARAM;
@@ -11,7 +11,12 @@ extern "C" {
 
 #define MAX_MICROPHONES 16
 #define MAX_BUFFER_SIZE 8192
+#define MAX_BEAMS 8
 #define DEFAULT_SAMPLE_RATE 16000
+#define DEFAULT_HOP_SIZE 128
+#define MIN_HOP_SIZE 16
+#define MIN_LOCALIZATION_WINDOW 256
+#define MAX_LOCALIZATION_WINDOW 32768
 
 typedef struct {
     int num_microphones;
@@ -19,16 +24,70 @@ typedef struct {
     int i2s_bus;
     int dma_buffer_size;
     int sample_rate;
+    bool health_monitor;
+    bool low_latency;
+    int hop_size;
+    float localization_rate;
+    int localization_window;
+    char localization_method[16];
+    float localization_smoothing;
+    float localization_band_low;
+    float localization_band_high;
+    int localization_max_bins;
+    bool prefilter_enable;
+    bool prefilter_dc_removal;
+    float prefilter_highpass;
+    float prefilter_lowpass;
+    bool aec_enable;
+    int aec_tail_ms;
+    float aec_step;
+    int aec_delay_ms;
+    bool dereverb_enable;
+    int dereverb_order;
+    int dereverb_delay;
+    int dereverb_frame_size;
+    float dereverb_forgetting;
     bool noise_reduction_enable;
     float noise_threshold;
     char algorithm[64];
+    char nn_model[256];
+    bool agc_enable;
+    float agc_target_db;
+    float agc_max_gain_db;
+    float agc_gate_db;
+    float agc_attack_ms;
+    float agc_release_ms;
+    float agc_ceiling_db;
+    float agc_lookahead_ms;
     char output_device[64];
     float volume;
+    char output_renderer[16];
+    char hrtf_file[256];
+    bool beam_enable;
+    int beam_count;
+    char beam_sink[16];
+    char beam_target[256];
+    int beam_ring_ms;
+    bool recorder_enable;
+    char recorder_directory[256];
+    char recorder_format[16];
+    int recorder_pre_ms;
+    int recorder_post_ms;
+    float recorder_trigger_db;
+    float recorder_trigger_confidence;
+    char pipeline_stages[256];
     bool enable_serial_logging;
     char log_file[256];
     char log_level[16];
+    char kernels[16];
+    float metrics_rate;
+    bool perf_counters;
 } micarray_config_t;
 
+/* Metres from the array centre. +x is straight ahead of the listener, +y
+ * to the listener's left and +z up, so azimuth runs counter-clockwise from
+ * +x seen from above (+90 degrees is hard left). The panners, the HRTF
+ * renderer and the beamformer all follow this. */
 typedef struct {
     float x;
     float y;
@@ -44,6 +103,94 @@ typedef struct {
     int sample_rate;
 } audio_buffer_t;
 
+typedef enum {
+    MICARRAY_LAYOUT_INTERLEAVED = 0,
+    MICARRAY_LAYOUT_PLANAR
+} micarray_layout_t;
+
+typedef struct {
+    uint64_t blocks_processed;
+    uint64_t frames_processed;
+    uint64_t localization_updates;
+    uint64_t localization_overruns;
+    uint64_t capture_overruns;
+    uint32_t active_channel_mask;
+    uint64_t channel_exclusions;
+    float channel_rms[MAX_MICROPHONES];
+    float channel_peak[MAX_MICROPHONES];
+    float noise_input_rms;
+    float noise_output_rms;
+    float echo_erle_db;
+    float agc_gain_db;
+    float limiter_gain_db;
+    bool recording;
+    uint64_t recorded_frames;
+    uint64_t recorder_dropped_frames;
+    uint64_t beam_dropped_frames;
+    uint64_t last_block_ns;
+    uint64_t max_block_ns;
+    uint64_t total_block_ns;
+    bool perf_counters;
+} micarray_stats_t;
+
+/* Algorithmic latency of the current configuration. Audio latency is
+ * capture block + dereverberation and NR synthesis delays + limiter
+ * look-ahead + output buffer; localization latency is the worst case
+ * until a fix covers a full window of new sound. */
+typedef struct {
+    int block_frames;
+    int dereverb_frames;
+    int noise_reduction_frames;
+    int agc_frames;
+    int output_frames;
+    int localization_window_frames;
+    int localization_interval_frames;
+    float audio_latency_ms;
+    float localization_latency_ms;
+} micarray_latency_t;
+
+/* A custom processing stage. Blocks are planar float, one buffer of up to
+ * max_frames samples per microphone, scaled so int16 full scale is 1.0.
+ * An in-place stage is handed the same buffers as input and output; any
+ * other gets separate ones and must write every channel. init parses the
+ * args given after "name:" in [Pipeline] stages; reset is called when
+ * processing restarts. Every callback but process may be NULL. */
+#define MICARRAY_STAGE_IN_PLACE 0x1u
+#define MICARRAY_MAX_STAGES 16
+#define MICARRAY_PSEUDO_STAGES 7
+#define MICARRAY_DEFAULT_STAGES "prefilter, aec, dereverb, noise_reduction"
+
+typedef struct {
+    int num_channels;
+    int sample_rate;
+    int max_frames;
+} micarray_stage_format_t;
+
+typedef struct {
+    const char *name;
+    uint32_t flags;
+    int (*init)(void **state, const micarray_stage_format_t *format, const char *args);
+    void (*process)(void *state, float *const *input, float *const *output, size_t frames, 
+                    uint32_t active_mask);
+    void (*reset)(void *state);
+    void (*cleanup)(void *state);
+} micarray_stage_t;
+
+/* The event totals come from hardware counters read around each call and
+ * stay 0 unless [Logging] perf_counters is on and perf events are
+ * available; micarray_stats_t.perf_counters says which. */
+typedef struct {
+    char name[32];
+    uint64_t calls;
+    uint64_t last_ns;
+    uint64_t max_ns;
+    uint64_t total_ns;
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t cache_misses;
+    uint64_t branch_misses;
+} micarray_stage_stats_t;
+
 typedef struct micarray_context micarray_context_t;
 
 int micarray_init(micarray_context_t **ctx, const char *config_file);
@@ -51,7 +198,44 @@ int micarray_start(micarray_context_t *ctx);
 int micarray_stop(micarray_context_t *ctx);
 int micarray_cleanup(micarray_context_t *ctx);
 
+/* Headless contexts own no I2S, ALSA or processing threads (only the
+ * recorder's disk writer, when enabled); the host drives them with
+ * micarray_process_block() from its own audio callback. */
+int micarray_init_headless(micarray_context_t **ctx, const micarray_config_t *config);
+
+/* Processes one block of num_microphones channels, frames <= dma_buffer_size,
+ * and writes 2 * frames interleaved stereo samples to output. Planar input
+ * holds each channel as a contiguous run of frames. Never allocates or
+ * blocks on I/O; location (optional) receives the latest fix. */
+int micarray_process_block(micarray_context_t *ctx, const int16_t *input, micarray_layout_t layout, 
+                           size_t frames, int16_t *output, sound_location_t *location);
+
 int micarray_get_location(micarray_context_t *ctx, sound_location_t *location);
+
+/* With [BeamOutput] enabled, beam 0 follows the tracked source and beams
+ * 1..beams-1 face evenly spaced azimuths until steered here; the new
+ * direction takes effect from the next block. */
+int micarray_steer_beam(micarray_context_t *ctx, int beam, const sound_location_t *target);
+
+/* With [Recorder] enabled, starts a recording that begins pre_trigger_ms
+ * in the past, or extends the current one; stop ends it. Both only flag
+ * the recorder's writer thread and are async-signal-safe. */
+int micarray_trigger_recording(micarray_context_t *ctx);
+int micarray_stop_recording(micarray_context_t *ctx);
+int micarray_get_stats(micarray_context_t *ctx, micarray_stats_t *stats);
+
+/* Makes stage available to [Pipeline] stages of contexts created after
+ * this call; stage must stay valid until the process exits. */
+int micarray_register_stage(const micarray_stage_t *stage);
+
+/* Timing of each stage of the processing graph, in order. With
+ * perf_counters on they are followed by pseudo-stages for the work done
+ * outside the graph, as far as it is configured: "capture" (deinterleave
+ * and health metering), "health", "recorder", "agc", "render", "beams" and
+ * "localization", each counted on the thread that runs it. */
+int micarray_get_stage_stats(micarray_context_t *ctx, micarray_stage_stats_t *stats, int max_stages, 
+                             int *num_stages);
+int micarray_get_latency(micarray_context_t *ctx, micarray_latency_t *latency);
 int micarray_set_volume(micarray_context_t *ctx, float volume);
 
 const char* micarray_get_version(void);
@@ -5,6 +5,7 @@
 #include <string.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <fftw3.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -12,6 +13,9 @@
 
 #define MAX_DELAY_SAMPLES 1000
 #define DEFAULT_SPEED_OF_SOUND 343.0f
+#define DEFAULT_GCC_SMOOTHING 0.25f
+
+typedef void (*gcc_estimate_fn)(localization_context_t *ctx, int mic, float *delay, float *confidence);
 
 struct localization_context {
     localization_config_t config;
@@ -23,6 +27,36 @@ struct localization_context {
     
     int16_t **mic_buffers;
     size_t buffer_size;
+    
+    /* Delays are measured against the lowest active microphone. */
+    uint32_t active_mask;
+    int reference;
+    
+    /* Incremental GCC-PHAT state, used when gcc_frame_size > 0. */
+    int gcc_bins;
+    int gcc_bin_low;
+    int gcc_bin_high;
+    int gcc_num_selected;
+    int gcc_fill;
+    int gcc_max_lag;
+    gcc_estimate_fn gcc_estimate;
+    uint64_t gcc_hops;
+    float *gcc_window;
+    float **gcc_frames;
+    float *gcc_input;
+    fftwf_complex *gcc_spectrum;
+    fftwf_complex *gcc_reference;
+    fftwf_complex **gcc_cross;
+    float *gcc_cos;
+    float *gcc_sin;
+    float *gcc_lags;
+    float *gcc_power;
+    float *gcc_noise;
+    float *gcc_snr;
+    int *gcc_selected;
+    float gcc_window_energy;
+    bool gcc_noise_ready;
+    fftwf_plan gcc_plan;
 };
 
 static float cross_correlate(int16_t *sig1, int16_t *sig2, size_t len, int delay) {
@@ -63,16 +97,310 @@ static float estimate_delay(int16_t *ref_signal, int16_t *target_signal, size_t
     return best_delay;
 }
 
+static int max_delay_samples(const localization_context_t *ctx) {
+    int max_delay = (int)(ctx->config.mic_spacing * 2.0f / ctx->config.speed_of_sound * ctx->config.sample_rate);
+    return (max_delay < MAX_DELAY_SAMPLES) ? max_delay : MAX_DELAY_SAMPLES;
+}
+
+static int gcc_init(localization_context_t *ctx) {
+    const int frame_size = ctx->config.gcc_frame_size;
+    const int channels = ctx->config.num_microphones;
+    
+    ctx->gcc_bins = frame_size / 2 + 1;
+    ctx->gcc_fill = frame_size / 2;
+    
+    /* DC and Nyquist never carry usable phase. */
+    ctx->gcc_bin_low = (int)ceilf(ctx->config.band_low_hz * frame_size / ctx->config.sample_rate);
+    if (ctx->gcc_bin_low < 1) {
+        ctx->gcc_bin_low = 1;
+    }
+    ctx->gcc_bin_high = frame_size / 2 - 1;
+    if (ctx->config.band_high_hz > 0.0f && 
+        ctx->config.band_high_hz * frame_size / ctx->config.sample_rate < ctx->gcc_bin_high) {
+        ctx->gcc_bin_high = (int)(ctx->config.band_high_hz * frame_size / ctx->config.sample_rate);
+    }
+    if (ctx->gcc_bin_low > ctx->gcc_bin_high) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    /* One extra lag on each side so the peak can be interpolated at the
+     * edge of the physically possible range. */
+    ctx->gcc_max_lag = max_delay_samples(ctx) + 1;
+    if (ctx->gcc_max_lag > frame_size / 2 - 1) {
+        ctx->gcc_max_lag = frame_size / 2 - 1;
+    }
+    
+    ctx->gcc_window = malloc(frame_size * sizeof(float));
+    ctx->gcc_frames = calloc(channels, sizeof(float*));
+    ctx->gcc_cross = calloc(channels, sizeof(fftwf_complex*));
+    ctx->gcc_input = fftwf_alloc_real(frame_size);
+    ctx->gcc_spectrum = fftwf_alloc_complex(ctx->gcc_bins);
+    ctx->gcc_reference = fftwf_alloc_complex(ctx->gcc_bins);
+    ctx->gcc_cos = malloc((ctx->gcc_max_lag + 1) * ctx->gcc_bins * sizeof(float));
+    ctx->gcc_sin = malloc((ctx->gcc_max_lag + 1) * ctx->gcc_bins * sizeof(float));
+    ctx->gcc_lags = malloc((2 * ctx->gcc_max_lag + 1) * sizeof(float));
+    ctx->gcc_power = calloc(ctx->gcc_bins, sizeof(float));
+    ctx->gcc_noise = calloc(ctx->gcc_bins, sizeof(float));
+    ctx->gcc_snr = calloc(ctx->gcc_bins, sizeof(float));
+    ctx->gcc_selected = calloc(ctx->gcc_bins, sizeof(int));
+    
+    if (!ctx->gcc_window || !ctx->gcc_frames || !ctx->gcc_cross || !ctx->gcc_input || 
+        !ctx->gcc_spectrum || !ctx->gcc_reference || !ctx->gcc_cos || !ctx->gcc_sin || 
+        !ctx->gcc_lags || !ctx->gcc_power || !ctx->gcc_noise || !ctx->gcc_snr || !ctx->gcc_selected) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    for (int c = 0; c < channels; c++) {
+        ctx->gcc_frames[c] = calloc(frame_size, sizeof(float));
+        ctx->gcc_cross[c] = fftwf_alloc_complex(ctx->gcc_bins);
+        if (!ctx->gcc_frames[c] || !ctx->gcc_cross[c]) {
+            return MICARRAY_ERROR_MEMORY;
+        }
+        memset(ctx->gcc_cross[c], 0, ctx->gcc_bins * sizeof(fftwf_complex));
+    }
+    
+    for (int i = 0; i < frame_size; i++) {
+        ctx->gcc_window[i] = 0.5f * (1.0f - cosf(2.0f * M_PI * i / frame_size));
+        ctx->gcc_window_energy += ctx->gcc_window[i] * ctx->gcc_window[i];
+    }
+    
+    for (int lag = 0; lag <= ctx->gcc_max_lag; lag++) {
+        for (int k = 0; k < ctx->gcc_bins; k++) {
+            double phase = 2.0 * M_PI * k * lag / frame_size;
+            ctx->gcc_cos[lag * ctx->gcc_bins + k] = (float)cos(phase);
+            ctx->gcc_sin[lag * ctx->gcc_bins + k] = (float)sin(phase);
+        }
+    }
+    
+    ctx->gcc_plan = fftwf_plan_dft_r2c_1d(frame_size, ctx->gcc_input, ctx->gcc_spectrum, FFTW_MEASURE);
+    if (!ctx->gcc_plan) {
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+/* One hop: transform each channel's frame once and fold conj(X0) * Xi into
+ * the exponentially averaged cross-power spectrum of pair (0, i). Only bins
+ * inside the configured band are kept. */
+static void gcc_transform(localization_context_t *ctx, int channel) {
+    for (int i = 0; i < ctx->config.gcc_frame_size; i++) {
+        ctx->gcc_input[i] = ctx->gcc_frames[channel][i] * ctx->gcc_window[i];
+    }
+    
+    fftwf_execute(ctx->gcc_plan);
+}
+
+static void gcc_update_hop(localization_context_t *ctx) {
+    const float smoothing = ctx->config.gcc_smoothing;
+    
+    gcc_transform(ctx, ctx->reference);
+    memcpy(ctx->gcc_reference, ctx->gcc_spectrum, ctx->gcc_bins * sizeof(fftwf_complex));
+    for (int k = ctx->gcc_bin_low; k <= ctx->gcc_bin_high; k++) {
+        float power = ctx->gcc_spectrum[k][0] * ctx->gcc_spectrum[k][0] + 
+                      ctx->gcc_spectrum[k][1] * ctx->gcc_spectrum[k][1];
+        ctx->gcc_power[k] += smoothing * (power - ctx->gcc_power[k]);
+    }
+    
+    for (int c = 0; c < ctx->config.num_microphones; c++) {
+        if (c == ctx->reference || !(ctx->active_mask & (1u << c))) {
+            continue;
+        }
+        
+        gcc_transform(ctx, c);
+        
+        fftwf_complex *cross = ctx->gcc_cross[c];
+        for (int k = ctx->gcc_bin_low; k <= ctx->gcc_bin_high; k++) {
+            float ar = ctx->gcc_reference[k][0], ai = ctx->gcc_reference[k][1];
+            float br = ctx->gcc_spectrum[k][0], bi = ctx->gcc_spectrum[k][1];
+            cross[k][0] += smoothing * ((ar * br + ai * bi) - cross[k][0]);
+            cross[k][1] += smoothing * ((ar * bi - ai * br) - cross[k][1]);
+        }
+    }
+    
+    ctx->gcc_hops++;
+}
+
+static void gcc_feed(localization_context_t *ctx, int16_t **mic_data, size_t samples) {
+    const int frame_size = ctx->config.gcc_frame_size;
+    const int hop_size = frame_size / 2;
+    size_t pos = 0;
+    
+    while (pos < samples) {
+        size_t count = (size_t)(frame_size - ctx->gcc_fill);
+        if (count > samples - pos) {
+            count = samples - pos;
+        }
+        
+        for (int c = 0; c < ctx->config.num_microphones; c++) {
+            float *frame = ctx->gcc_frames[c] + ctx->gcc_fill;
+            for (size_t i = 0; i < count; i++) {
+                frame[i] = mic_data[c][pos + i] / 32768.0f;
+            }
+        }
+        
+        pos += count;
+        ctx->gcc_fill += (int)count;
+        
+        if (ctx->gcc_fill == frame_size) {
+            gcc_update_hop(ctx);
+            for (int c = 0; c < ctx->config.num_microphones; c++) {
+                memmove(ctx->gcc_frames[c], ctx->gcc_frames[c] + hop_size, 
+                        (frame_size - hop_size) * sizeof(float));
+            }
+            ctx->gcc_fill = frame_size - hop_size;
+        }
+    }
+}
+
+/* Quickselect, descending: moves the count indices with the largest keys
+ * to the front of indices, in no particular order. */
+static void select_largest(int *indices, const float *keys, int n, int count) {
+    int lo = 0;
+    int hi = n - 1;
+    
+    while (lo < hi) {
+        float pivot = keys[indices[(lo + hi) / 2]];
+        int i = lo;
+        int j = hi;
+        
+        while (i <= j) {
+            while (keys[indices[i]] > pivot) i++;
+            while (keys[indices[j]] < pivot) j--;
+            if (i <= j) {
+                int temp = indices[i];
+                indices[i] = indices[j];
+                indices[j] = temp;
+                i++;
+                j--;
+            }
+        }
+        
+        if (count - 1 <= j) {
+            hi = j;
+        } else if (count - 1 >= i) {
+            lo = i;
+        } else {
+            break;
+        }
+    }
+}
+
+/* Picks the bins each fix evaluates: the whole band, or its max_bins bins
+ * with the highest SNR of the reference channel against the noise PSD from
+ * localization_set_noise_psd() (or simply the loudest bins without one). */
+static void gcc_select_bins(localization_context_t *ctx) {
+    int count = 0;
+    for (int k = ctx->gcc_bin_low; k <= ctx->gcc_bin_high; k++) {
+        float signal = ctx->gcc_power[k] / ctx->gcc_window_energy;
+        ctx->gcc_snr[k] = ctx->gcc_noise_ready ? signal / (ctx->gcc_noise[k] + 1e-20f) : signal;
+        ctx->gcc_selected[count++] = k;
+    }
+    
+    if (ctx->config.max_bins > 0 && ctx->config.max_bins < count) {
+        select_largest(ctx->gcc_selected, ctx->gcc_snr, count, ctx->config.max_bins);
+        count = ctx->config.max_bins;
+    }
+    
+    ctx->gcc_num_selected = count;
+}
+
+/* PHAT-weighted correlation of pair (0, mic) over the selected bins,
+ * evaluated directly at the ±gcc_max_lag lags only, so a perfectly
+ * coherent pair peaks at 1. With max_lag and bins constant the lag loop
+ * unrolls, the table offsets fold and the lags live in registers. */
+static inline __attribute__((always_inline))
+void gcc_estimate_span(localization_context_t *ctx, int mic, float *delay, float *confidence,
+                       float *lag_buffer, const int max_lag, const int bins) {
+    const fftwf_complex *cross = ctx->gcc_cross[mic];
+    float *lags = lag_buffer + max_lag;
+    
+    for (int lag = -max_lag; lag <= max_lag; lag++) {
+        lags[lag] = 0.0f;
+    }
+    
+    for (int n = 0; n < ctx->gcc_num_selected; n++) {
+        int k = ctx->gcc_selected[n];
+        float magnitude = sqrtf(cross[k][0] * cross[k][0] + cross[k][1] * cross[k][1]);
+        if (magnitude < 1e-20f) {
+            continue;
+        }
+        
+        float re = cross[k][0] / magnitude;
+        float im = cross[k][1] / magnitude;
+        
+        lags[0] += re;
+#pragma GCC unroll 8
+        for (int lag = 1; lag <= max_lag; lag++) {
+            float c = ctx->gcc_cos[lag * bins + k];
+            float s = ctx->gcc_sin[lag * bins + k];
+            lags[lag] += re * c - im * s;
+            lags[-lag] += re * c + im * s;
+        }
+    }
+    
+    int best = 0;
+    for (int lag = -max_lag; lag <= max_lag; lag++) {
+        if (lags[lag] > lags[best]) {
+            best = lag;
+        }
+    }
+    
+    float offset = 0.0f;
+    if (best > -max_lag && best < max_lag) {
+        float denominator = lags[best - 1] - 2.0f * lags[best] + lags[best + 1];
+        if (denominator < 0.0f) {
+            offset = 0.5f * (lags[best - 1] - lags[best + 1]) / denominator;
+        }
+    }
+    
+    *delay = best + offset;
+    *confidence = fmaxf(lags[best] / ctx->gcc_num_selected, 0.0f);
+}
+
+static void gcc_estimate_any(localization_context_t *ctx, int mic, float *delay, float *confidence) {
+    gcc_estimate_span(ctx, mic, delay, confidence, ctx->gcc_lags, ctx->gcc_max_lag, ctx->gcc_bins);
+}
+
+static void gcc_estimate_2_257(localization_context_t *ctx, int mic, float *delay, float *confidence) {
+    float lags[2 * 2 + 1];
+    gcc_estimate_span(ctx, mic, delay, confidence, lags, 2, 257);
+}
+
+static void gcc_estimate_5_257(localization_context_t *ctx, int mic, float *delay, float *confidence) {
+    float lags[2 * 5 + 1];
+    gcc_estimate_span(ctx, mic, delay, confidence, lags, 5, 257);
+}
+
+static float mean_confidence(const localization_context_t *ctx) {
+    float sum = 0.0f;
+    int count = 0;
+    
+    for (int i = 0; i < ctx->config.num_microphones; i++) {
+        if (ctx->active_mask & (1u << i)) {
+            sum += ctx->confidence_values[i];
+            count++;
+        }
+    }
+    
+    return (count > 0) ? sum / count : 0.0f;
+}
+
 static void trilaterate_3d(localization_context_t *ctx, float *delays, sound_location_t *location) {
+    const microphone_position_t *ref = &ctx->mic_positions[ctx->reference];
     float A[3][4];
     int num_equations = 0;
     
-    for (int i = 1; i < ctx->config.num_microphones && num_equations < 3; i++) {
-        float dx = ctx->mic_positions[i].x - ctx->mic_positions[0].x;
-        float dy = ctx->mic_positions[i].y - ctx->mic_positions[0].y;
-        float dz = ctx->mic_positions[i].z - ctx->mic_positions[0].z;
+    for (int i = 0; i < ctx->config.num_microphones && num_equations < 3; i++) {
+        if (i == ctx->reference || !(ctx->active_mask & (1u << i))) {
+            continue;
+        }
+        
+        float dx = ctx->mic_positions[i].x - ref->x;
+        float dy = ctx->mic_positions[i].y - ref->y;
+        float dz = ctx->mic_positions[i].z - ref->z;
         
-        float distance_diff = delays[i] * ctx->config.speed_of_sound;
+        float distance_diff = delays[i] / ctx->config.sample_rate * ctx->config.speed_of_sound;
         
         A[num_equations][0] = 2.0f * dx;
         A[num_equations][1] = 2.0f * dy;
@@ -135,16 +463,12 @@ static void trilaterate_3d(localization_context_t *ctx, float *delays, sound_loc
     location->x = x[0];
     location->y = x[1];
     location->z = x[2];
-    
-    float avg_confidence = 0.0f;
-    for (int i = 0; i < ctx->config.num_microphones; i++) {
-        avg_confidence += ctx->confidence_values[i];
-    }
-    location->confidence = avg_confidence / ctx->config.num_microphones;
+    location->confidence = mean_confidence(ctx);
 }
 
 int localization_init(localization_context_t **ctx, const localization_config_t *config) {
-    if (!ctx || !config) {
+    if (!ctx || !config || config->gcc_frame_size < 0 || 
+        (config->gcc_frame_size > 0 && (config->gcc_frame_size < 8 || config->gcc_frame_size % 2 != 0))) {
         return MICARRAY_ERROR_INVALID_PARAM;
     }
     
@@ -154,6 +478,8 @@ int localization_init(localization_context_t **ctx, const localization_config_t
     }
     
     (*ctx)->config = *config;
+    (*ctx)->active_mask = (config->num_microphones >= 32) ? 0xFFFFFFFFu : ((1u << config->num_microphones) - 1);
+    (*ctx)->reference = 0;
     
     if ((*ctx)->config.speed_of_sound <= 0.0f) {
         (*ctx)->config.speed_of_sound = DEFAULT_SPEED_OF_SOUND;
@@ -197,6 +523,28 @@ int localization_init(localization_context_t **ctx, const localization_config_t
         }
     }
     
+    if (config->gcc_frame_size > 0) {
+        if ((*ctx)->config.gcc_smoothing <= 0.0f || (*ctx)->config.gcc_smoothing > 1.0f) {
+            (*ctx)->config.gcc_smoothing = DEFAULT_GCC_SMOOTHING;
+        }
+        
+        int result = gcc_init(*ctx);
+        if (result != MICARRAY_SUCCESS) {
+            localization_cleanup(*ctx);
+            *ctx = NULL;
+            return result;
+        }
+        
+        (*ctx)->gcc_estimate = gcc_estimate_any;
+        if (!config->generic && (*ctx)->gcc_bins == 257) {
+            if ((*ctx)->gcc_max_lag == 2) {
+                (*ctx)->gcc_estimate = gcc_estimate_2_257;
+            } else if ((*ctx)->gcc_max_lag == 5) {
+                (*ctx)->gcc_estimate = gcc_estimate_5_257;
+            }
+        }
+    }
+    
     return MICARRAY_SUCCESS;
 }
 
@@ -205,7 +553,15 @@ int localization_process(localization_context_t *ctx, int16_t **mic_data, size_t
         return MICARRAY_ERROR_INVALID_PARAM;
     }
     
-    if (samples < ctx->config.correlation_window_size) {
+    bool ready;
+    if (ctx->config.gcc_frame_size > 0) {
+        gcc_feed(ctx, mic_data, samples);
+        ready = (ctx->gcc_hops > 0);
+    } else {
+        ready = (samples >= (size_t)ctx->config.correlation_window_size);
+    }
+    
+    if (!ready) {
         location->x = 0.0f;
         location->y = 0.0f;
         location->z = 0.0f;
@@ -213,15 +569,23 @@ int localization_process(localization_context_t *ctx, int16_t **mic_data, size_t
         return MICARRAY_SUCCESS;
     }
     
-    int max_delay = (int)(ctx->config.mic_spacing * 2.0f / ctx->config.speed_of_sound * ctx->config.sample_rate);
-    max_delay = fminf(max_delay, MAX_DELAY_SAMPLES);
+    if (ctx->config.gcc_frame_size > 0) {
+        gcc_select_bins(ctx);
+    }
+    
+    int max_delay = max_delay_samples(ctx);
     
-    int16_t *reference_mic = mic_data[0];
+    int16_t *reference_mic = mic_data[ctx->reference];
     
     for (int i = 0; i < ctx->config.num_microphones; i++) {
-        if (i == 0) {
+        if (i == ctx->reference) {
             ctx->delay_estimates[i] = 0.0f;
             ctx->confidence_values[i] = 1.0f;
+        } else if (!(ctx->active_mask & (1u << i))) {
+            ctx->delay_estimates[i] = 0.0f;
+            ctx->confidence_values[i] = 0.0f;
+        } else if (ctx->config.gcc_frame_size > 0) {
+            ctx->gcc_estimate(ctx, i, &ctx->delay_estimates[i], &ctx->confidence_values[i]);
         } else {
             ctx->delay_estimates[i] = estimate_delay(reference_mic, mic_data[i], samples, max_delay);
             
@@ -236,11 +600,7 @@ int localization_process(localization_context_t *ctx, int16_t **mic_data, size_t
         }
     }
     
-    float avg_confidence = 0.0f;
-    for (int i = 0; i < ctx->config.num_microphones; i++) {
-        avg_confidence += ctx->confidence_values[i];
-    }
-    avg_confidence /= ctx->config.num_microphones;
+    float avg_confidence = mean_confidence(ctx);
     
     if (avg_confidence < ctx->config.min_confidence_threshold) {
         location->x = 0.0f;
@@ -250,11 +610,84 @@ int localization_process(localization_context_t *ctx, int16_t **mic_data, size_t
         return MICARRAY_SUCCESS;
     }
     
-    for (int i = 0; i < ctx->config.num_microphones; i++) {
-        ctx->delay_estimates[i] /= ctx->config.sample_rate;
+    trilaterate_3d(ctx, ctx->delay_estimates, location);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int localization_get_delays(localization_context_t *ctx, float *delays, float *confidences, int count) {
+    if (!ctx || count != ctx->config.num_microphones) {
+        return MICARRAY_ERROR_INVALID_PARAM;
     }
     
-    trilaterate_3d(ctx, ctx->delay_estimates, location);
+    if (delays) {
+        memcpy(delays, ctx->delay_estimates, count * sizeof(float));
+    }
+    if (confidences) {
+        memcpy(confidences, ctx->confidence_values, count * sizeof(float));
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int localization_set_noise_psd(localization_context_t *ctx, const float *psd, int bins) {
+    if (!ctx || !psd || ctx->config.gcc_frame_size == 0 || bins != ctx->gcc_bins) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    memcpy(ctx->gcc_noise, psd, bins * sizeof(float));
+    ctx->gcc_noise_ready = true;
+    
+    return MICARRAY_SUCCESS;
+}
+
+int localization_get_lag_search(const localization_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (ctx->gcc_estimate == gcc_estimate_2_257) {
+        return 2;
+    }
+    if (ctx->gcc_estimate == gcc_estimate_5_257) {
+        return 5;
+    }
+    return 0;
+}
+
+/* Inactive microphones are neither transformed nor used in a fix. Moving
+ * the reference restarts every pair's average; otherwise only re-admitted
+ * microphones start over. */
+int localization_set_active_mask(localization_context_t *ctx, uint32_t mask) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    uint32_t all = (ctx->config.num_microphones >= 32) ? 0xFFFFFFFFu : ((1u << ctx->config.num_microphones) - 1);
+    mask &= all;
+    if (mask == 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    int reference = 0;
+    while (!(mask & (1u << reference))) {
+        reference++;
+    }
+    
+    uint32_t restart = (reference != ctx->reference) ? all : (mask & ~ctx->active_mask);
+    if (ctx->config.gcc_frame_size > 0) {
+        for (int i = 0; i < ctx->config.num_microphones; i++) {
+            if (restart & (1u << i)) {
+                memset(ctx->gcc_cross[i], 0, ctx->gcc_bins * sizeof(fftwf_complex));
+            }
+        }
+        if (reference != ctx->reference) {
+            memset(ctx->gcc_power, 0, ctx->gcc_bins * sizeof(float));
+        }
+    }
+    
+    ctx->active_mask = mask;
+    ctx->reference = reference;
     
     return MICARRAY_SUCCESS;
 }
@@ -289,6 +722,36 @@ int localization_cleanup(localization_context_t *ctx) {
         free(ctx->correlation_buffers);
     }
     
+    if (ctx->gcc_frames) {
+        for (int i = 0; i < ctx->config.num_microphones; i++) {
+            free(ctx->gcc_frames[i]);
+        }
+        free(ctx->gcc_frames);
+    }
+    
+    if (ctx->gcc_cross) {
+        for (int i = 0; i < ctx->config.num_microphones; i++) {
+            fftwf_free(ctx->gcc_cross[i]);
+        }
+        free(ctx->gcc_cross);
+    }
+    
+    if (ctx->gcc_plan) {
+        fftwf_destroy_plan(ctx->gcc_plan);
+    }
+    
+    fftwf_free(ctx->gcc_input);
+    fftwf_free(ctx->gcc_spectrum);
+    fftwf_free(ctx->gcc_reference);
+    free(ctx->gcc_window);
+    free(ctx->gcc_cos);
+    free(ctx->gcc_sin);
+    free(ctx->gcc_lags);
+    free(ctx->gcc_power);
+    free(ctx->gcc_noise);
+    free(ctx->gcc_snr);
+    free(ctx->gcc_selected);
+    
     free(ctx->mic_positions);
     free(ctx->delay_estimates);
     free(ctx->confidence_values);
@@ -24,12 +24,49 @@ typedef struct {
     float speed_of_sound;
     int correlation_window_size;
     float min_confidence_threshold;
+    
+    /* gcc_frame_size > 0 selects the incremental GCC-PHAT estimator: every
+     * call feeds only its new samples, each frame_size / 2 hop updates the
+     * exponentially averaged cross-power spectra (weight gcc_smoothing of
+     * the new hop, 0 for the default), and fixes are read from those.
+     * 0 keeps the full time-domain correlation over each call's samples. */
+    int gcc_frame_size;
+    float gcc_smoothing;
+    
+    /* GCC-PHAT only: bins outside [band_low_hz, band_high_hz] are ignored
+     * (0 for the band edge means DC or Nyquist) and each fix uses at most
+     * max_bins of them, ranked by SNR (0 for all). */
+    float band_low_hz;
+    float band_high_hz;
+    int max_bins;
+    
+    /* The lag search has instances for 512-sample frames and a span of 2
+     * or 5 lags, which is what the 15 mm circle gives at 16 and 48 kHz;
+     * any geometry with the same span uses them. Only the loop bounds are
+     * fixed, the twiddles still come from the table built at init.
+     * generic forces the loop that takes both from the context. */
+    bool generic;
 } localization_config_t;
 
 int localization_init(localization_context_t **ctx, const localization_config_t *config);
 int localization_process(localization_context_t *ctx, int16_t **mic_data, size_t samples, sound_location_t *location);
 int localization_cleanup(localization_context_t *ctx);
 
+/* Per-microphone delay relative to mic 0 (samples) and confidence from the
+ * last localization_process() call. */
+int localization_get_delays(localization_context_t *ctx, float *delays, float *confidences, int count);
+
+/* Noise PSD for SNR ranking, gcc_frame_size / 2 + 1 points from DC to
+ * Nyquist, as produced by noise_reduction_get_noise_psd(). */
+int localization_set_noise_psd(localization_context_t *ctx, const float *psd, int bins);
+
+/* Debugging aid: the lag span the GCC-PHAT search was specialised for,
+ * or 0 when it runs the generic loop. */
+int localization_get_lag_search(const localization_context_t *ctx);
+
+/* Bit i set keeps microphone i in the estimate; at least one must be set. */
+int localization_set_active_mask(localization_context_t *ctx, uint32_t mask);
+
 int localization_set_mic_positions(localization_context_t *ctx, const microphone_position_t *positions, int count);
 int localization_calibrate(localization_context_t *ctx, int16_t **calibration_data, size_t samples);
 
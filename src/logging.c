@@ -232,6 +232,17 @@ void log_audio_levels(logging_context_t *ctx, float *levels, int num_channels) {
     LOG_INFO(ctx, "AUDIO_LEVELS: %s", level_str);
 }
 
+void log_mic_health(logging_context_t *ctx, int channel, bool active, float dc_offset, 
+                    float rms, float clip_rate, float coherence) {
+    if (!ctx) {
+        return;
+    }
+    
+    log_message(ctx, active ? LOG_LEVEL_INFO : LOG_LEVEL_WARN, 
+                "MIC_HEALTH: ch%d=%s, dc=%.3f, rms=%.5f, clip=%.3f, coherence=%.2f", 
+                channel, active ? "active" : "excluded", dc_offset, rms, clip_rate, coherence);
+}
+
 int logging_set_level(logging_context_t *ctx, log_level_t level) {
     if (!ctx) {
         return MICARRAY_ERROR_INVALID_PARAM;
@@ -33,6 +33,8 @@ void log_message(logging_context_t *ctx, log_level_t level, const char *format,
 void log_location_data(logging_context_t *ctx, const sound_location_t *location);
 void log_noise_metrics(logging_context_t *ctx, float noise_before, float noise_after);
 void log_audio_levels(logging_context_t *ctx, float *levels, int num_channels);
+void log_mic_health(logging_context_t *ctx, int channel, bool active, float dc_offset, 
+                    float rms, float clip_rate, float coherence);
 
 int logging_set_level(logging_context_t *ctx, log_level_t level);
 
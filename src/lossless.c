@@ -0,0 +1,919 @@
+#define _GNU_SOURCE
+#include "lossless.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#define MAX_ORDER 4
+#define MAX_RICE 30
+#define MAX_PARTITIONS (LOSSLESS_MAX_BLOCK / LOSSLESS_PARTITION)
+
+enum {
+    METHOD_CONSTANT = 0,
+    METHOD_VERBATIM = 1,
+    METHOD_FIXED = 2
+};
+
+/* Scratch and output of one channel; each is touched by one worker. */
+typedef struct {
+    int32_t *samples;
+    uint32_t *residual;
+    uint8_t rice[MAX_PARTITIONS];
+    uint8_t *stream;
+    uint32_t bytes;
+} channel_coder_t;
+
+typedef struct {
+    lossless_writer_t *writer;
+    int index;
+} worker_arg_t;
+
+struct lossless_writer {
+    lossless_config_t config;
+    
+    int fd;
+    uint64_t offset;
+    uint64_t total_frames;
+    bool failed;
+    
+    int16_t *block;
+    size_t buffered;
+    channel_coder_t *coders;
+    uint32_t *sizes;
+    
+    lossless_index_entry_t *index;
+    size_t index_count;
+    size_t index_capacity;
+    
+    /* Worker w encodes channels w, w + num_threads, ...; the caller of
+     * encode_block() is worker 0. */
+    int num_threads;
+    pthread_t *threads;
+    worker_arg_t *args;
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    uint64_t generation;
+    int pending;
+    size_t job_frames;
+    bool shutdown;
+};
+
+struct lossless_reader {
+    const uint8_t *map;
+    size_t map_size;
+    lossless_info_t info;
+    lossless_index_entry_t *index;
+    
+    int16_t *block;
+    size_t block_frames;
+    uint64_t block_first;
+    uint64_t position;
+    int32_t *samples;
+};
+
+typedef struct {
+    uint8_t *out;
+    size_t pos;
+    uint64_t acc;
+    int bits;
+} bit_writer_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    uint64_t acc;
+    int bits;
+} bit_reader_t;
+
+static void put_bits(bit_writer_t *w, uint32_t value, int count) {
+    if (count == 0) {
+        return;
+    }
+    w->acc = (w->acc << count) | (value & (0xFFFFFFFFu >> (32 - count)));
+    w->bits += count;
+    while (w->bits >= 8) {
+        w->bits -= 8;
+        w->out[w->pos++] = (uint8_t)(w->acc >> w->bits);
+    }
+}
+
+static void put_rice(bit_writer_t *w, uint32_t value, int k) {
+    uint32_t q = value >> k;
+    while (q >= 32) {
+        put_bits(w, 0, 32);
+        q -= 32;
+    }
+    put_bits(w, 1, (int)q + 1);
+    put_bits(w, value, k);
+}
+
+static size_t flush_bits(bit_writer_t *w) {
+    if (w->bits > 0) {
+        w->out[w->pos++] = (uint8_t)(w->acc << (8 - w->bits));
+        w->bits = 0;
+    }
+    return w->pos;
+}
+
+/* Keeps at least 57 bits in the accumulator, left-aligned; reading past
+ * the end yields zeros, which the caller catches by checking pos. */
+static void refill(bit_reader_t *r) {
+    while (r->bits <= 56) {
+        uint8_t byte = r->pos < r->size ? r->data[r->pos] : 0;
+        r->pos++;
+        r->acc |= (uint64_t)byte << (56 - r->bits);
+        r->bits += 8;
+    }
+}
+
+static uint32_t get_bits(bit_reader_t *r, int count) {
+    if (count == 0) {
+        return 0;
+    }
+    refill(r);
+    uint32_t value = (uint32_t)(r->acc >> (64 - count));
+    r->acc <<= count;
+    r->bits -= count;
+    return value;
+}
+
+static int get_rice(bit_reader_t *r, int k, uint32_t *value) {
+    uint32_t q = 0;
+    refill(r);
+    while (r->acc == 0) {
+        q += (uint32_t)r->bits;
+        r->bits = 0;
+        if (r->pos > r->size + 8) {
+            return -1;
+        }
+        refill(r);
+    }
+    
+    int zeros = __builtin_clzll(r->acc);
+    r->acc = (r->acc << zeros) << 1;
+    r->bits -= zeros + 1;
+    *value = ((q + (uint32_t)zeros) << k) | get_bits(r, k);
+    return 0;
+}
+
+static inline uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static int32_t predict(const int32_t *x, size_t n, int order) {
+    switch (order) {
+        case 1: return x[n - 1];
+        case 2: return 2 * x[n - 1] - x[n - 2];
+        case 3: return 3 * x[n - 1] - 3 * x[n - 2] + x[n - 3];
+        case 4: return 4 * x[n - 1] - 6 * x[n - 2] + 4 * x[n - 3] - x[n - 4];
+        default: return 0;
+    }
+}
+
+/* Sum of |residual| for every order over the samples all of them predict,
+ * from the running differences, which is how FLAC picks a fixed order. */
+static int choose_order(const int32_t *x, size_t frames) {
+    if (frames <= MAX_ORDER) {
+        return 0;
+    }
+    
+    uint64_t error[MAX_ORDER + 1] = {0};
+    int32_t d1 = x[3] - x[2];
+    int32_t d2 = d1 - (x[2] - x[1]);
+    int32_t d3 = d2 - ((x[2] - x[1]) - (x[1] - x[0]));
+    for (size_t n = MAX_ORDER; n < frames; n++) {
+        int32_t e1 = x[n] - x[n - 1];
+        int32_t e2 = e1 - d1;
+        int32_t e3 = e2 - d2;
+        int32_t e4 = e3 - d3;
+        error[0] += (uint64_t)abs(x[n]);
+        error[1] += (uint64_t)abs(e1);
+        error[2] += (uint64_t)abs(e2);
+        error[3] += (uint64_t)abs(e3);
+        error[4] += (uint64_t)abs(e4);
+        d1 = e1;
+        d2 = e2;
+        d3 = e3;
+    }
+    
+    int best = 0;
+    for (int order = 1; order <= MAX_ORDER; order++) {
+        if (error[order] < error[best]) {
+            best = order;
+        }
+    }
+    return best;
+}
+
+/* Picks the cheapest Rice parameter next to the one the mean suggests and
+ * returns the partition's size in bits. */
+static uint64_t choose_rice(const uint32_t *u, size_t count, uint8_t *parameter) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += u[i];
+    }
+    
+    int guess = 0;
+    while (guess < MAX_RICE && ((uint64_t)count << (guess + 1)) <= sum) {
+        guess++;
+    }
+    
+    uint64_t best_bits = UINT64_MAX;
+    for (int k = guess > 0 ? guess - 1 : 0; k <= guess + 1 && k <= MAX_RICE; k++) {
+        uint64_t bits = (uint64_t)count * (k + 1);
+        for (size_t i = 0; i < count; i++) {
+            bits += u[i] >> k;
+        }
+        if (bits < best_bits) {
+            best_bits = bits;
+            *parameter = (uint8_t)k;
+        }
+    }
+    return best_bits;
+}
+
+static void encode_channel(channel_coder_t *coder, const int16_t *block, int channels, int channel, size_t frames) {
+    int32_t *x = coder->samples;
+    bool constant = true;
+    for (size_t n = 0; n < frames; n++) {
+        x[n] = block[n * channels + channel];
+        constant = constant && x[n] == x[0];
+    }
+    
+    bit_writer_t w = { coder->stream, 0, 0, 0 };
+    if (constant) {
+        put_bits(&w, METHOD_CONSTANT, 8);
+        put_bits(&w, (uint16_t)x[0], 16);
+        coder->bytes = (uint32_t)flush_bits(&w);
+        return;
+    }
+    
+    int order = choose_order(x, frames);
+    size_t count = frames - order;
+    for (size_t n = order; n < frames; n++) {
+        coder->residual[n - order] = zigzag(x[n] - predict(x, n, order));
+    }
+    
+    uint64_t bits = 8 + 16 * (uint64_t)order;
+    size_t partitions = (count + LOSSLESS_PARTITION - 1) / LOSSLESS_PARTITION;
+    for (size_t p = 0; p < partitions; p++) {
+        size_t start = p * LOSSLESS_PARTITION;
+        size_t length = count - start < LOSSLESS_PARTITION ? count - start : LOSSLESS_PARTITION;
+        bits += 5 + choose_rice(coder->residual + start, length, &coder->rice[p]);
+    }
+    
+    /* Noise that does not predict stays verbatim, which also bounds the
+     * stream at 1 + 2 * frames bytes. */
+    if (bits >= 8 + 16 * (uint64_t)frames) {
+        put_bits(&w, METHOD_VERBATIM, 8);
+        for (size_t n = 0; n < frames; n++) {
+            put_bits(&w, (uint16_t)x[n], 16);
+        }
+        coder->bytes = (uint32_t)flush_bits(&w);
+        return;
+    }
+    
+    put_bits(&w, METHOD_FIXED + order, 8);
+    for (int n = 0; n < order; n++) {
+        put_bits(&w, (uint16_t)x[n], 16);
+    }
+    for (size_t p = 0; p < partitions; p++) {
+        size_t start = p * LOSSLESS_PARTITION;
+        size_t end = count - start < LOSSLESS_PARTITION ? count : start + LOSSLESS_PARTITION;
+        int k = coder->rice[p];
+        put_bits(&w, (uint32_t)k, 5);
+        for (size_t i = start; i < end; i++) {
+            put_rice(&w, coder->residual[i], k);
+        }
+    }
+    coder->bytes = (uint32_t)flush_bits(&w);
+}
+
+static int decode_channel(const uint8_t *data, size_t size, int32_t *x, size_t frames) {
+    bit_reader_t r = { data, size, 0, 0, 0 };
+    
+    uint32_t method = get_bits(&r, 8);
+    if (method == METHOD_CONSTANT) {
+        int32_t value = (int16_t)get_bits(&r, 16);
+        for (size_t n = 0; n < frames; n++) {
+            x[n] = value;
+        }
+    } else if (method == METHOD_VERBATIM) {
+        for (size_t n = 0; n < frames; n++) {
+            x[n] = (int16_t)get_bits(&r, 16);
+        }
+    } else if (method <= METHOD_FIXED + MAX_ORDER && method - METHOD_FIXED <= frames) {
+        int order = (int)(method - METHOD_FIXED);
+        for (int n = 0; n < order; n++) {
+            x[n] = (int16_t)get_bits(&r, 16);
+        }
+        
+        for (size_t start = order; start < frames; start += LOSSLESS_PARTITION) {
+            size_t end = frames - start < LOSSLESS_PARTITION ? frames : start + LOSSLESS_PARTITION;
+            int k = (int)get_bits(&r, 5);
+            for (size_t n = start; n < end; n++) {
+                uint32_t u;
+                if (get_rice(&r, k, &u) != 0) {
+                    return -1;
+                }
+                x[n] = predict(x, n, order) + unzigzag(u);
+            }
+        }
+    } else {
+        return -1;
+    }
+    
+    /* Bytes pulled into the accumulator but not consumed are not overrun. */
+    return r.pos - r.bits / 8 <= size ? 0 : -1;
+}
+
+static void encode_share(lossless_writer_t *ctx, int worker, size_t frames) {
+    for (int c = worker; c < ctx->config.channels; c += ctx->num_threads) {
+        encode_channel(&ctx->coders[c], ctx->block, ctx->config.channels, c, frames);
+    }
+}
+
+static void* encoder_thread_func(void *arg) {
+    worker_arg_t *worker = (worker_arg_t*)arg;
+    lossless_writer_t *ctx = worker->writer;
+    uint64_t seen = 0;
+    
+    pthread_mutex_lock(&ctx->mutex);
+    while (true) {
+        while (!ctx->shutdown && ctx->generation == seen) {
+            pthread_cond_wait(&ctx->work_cond, &ctx->mutex);
+        }
+        if (ctx->shutdown) {
+            break;
+        }
+        seen = ctx->generation;
+        size_t frames = ctx->job_frames;
+        pthread_mutex_unlock(&ctx->mutex);
+        
+        encode_share(ctx, worker->index, frames);
+        
+        pthread_mutex_lock(&ctx->mutex);
+        if (--ctx->pending == 0) {
+            pthread_cond_signal(&ctx->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+    
+    return NULL;
+}
+
+static int write_all(int fd, struct iovec *iov, int iovcnt, off_t offset) {
+    while (iovcnt > 0) {
+        ssize_t written = pwritev(fd, iov, iovcnt, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        
+        offset += written;
+        while (iovcnt > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (uint8_t*)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return 0;
+}
+
+static int encode_block(lossless_writer_t *ctx) {
+    const size_t frames = ctx->buffered;
+    const int channels = ctx->config.channels;
+    ctx->buffered = 0;
+    
+    if (ctx->num_threads > 1) {
+        pthread_mutex_lock(&ctx->mutex);
+        ctx->job_frames = frames;
+        ctx->pending = ctx->num_threads - 1;
+        ctx->generation++;
+        pthread_cond_broadcast(&ctx->work_cond);
+        pthread_mutex_unlock(&ctx->mutex);
+    }
+    
+    encode_share(ctx, 0, frames);
+    
+    if (ctx->num_threads > 1) {
+        pthread_mutex_lock(&ctx->mutex);
+        while (ctx->pending > 0) {
+            pthread_cond_wait(&ctx->done_cond, &ctx->mutex);
+        }
+        pthread_mutex_unlock(&ctx->mutex);
+    }
+    
+    lossless_block_header_t header = {
+        .sync = LOSSLESS_SYNC,
+        .frames = (uint32_t)frames,
+        .first_frame = ctx->total_frames,
+        .bytes = (uint32_t)(channels * sizeof(uint32_t))
+    };
+    
+    struct iovec iov[2 + MAX_MICROPHONES];
+    iov[0] = (struct iovec){ &header, sizeof(header) };
+    iov[1] = (struct iovec){ ctx->sizes, channels * sizeof(uint32_t) };
+    for (int c = 0; c < channels; c++) {
+        ctx->sizes[c] = ctx->coders[c].bytes;
+        header.bytes += ctx->coders[c].bytes;
+        iov[2 + c] = (struct iovec){ ctx->coders[c].stream, ctx->coders[c].bytes };
+    }
+    
+    if (ctx->index_count == ctx->index_capacity) {
+        size_t capacity = ctx->index_capacity ? 2 * ctx->index_capacity : 256;
+        lossless_index_entry_t *index = realloc(ctx->index, capacity * sizeof(*index));
+        if (!index) {
+            return MICARRAY_ERROR_MEMORY;
+        }
+        ctx->index = index;
+        ctx->index_capacity = capacity;
+    }
+    
+    if (write_all(ctx->fd, iov, 2 + channels, (off_t)ctx->offset) != 0) {
+        return MICARRAY_ERROR_AUDIO_OUTPUT;
+    }
+    
+    ctx->index[ctx->index_count++] = (lossless_index_entry_t){ ctx->total_frames, ctx->offset };
+    ctx->offset += sizeof(header) + header.bytes;
+    ctx->total_frames += frames;
+    return MICARRAY_SUCCESS;
+}
+
+static int write_header(lossless_writer_t *ctx, uint64_t index_offset) {
+    lossless_header_t header = {
+        .channels = (uint16_t)ctx->config.channels,
+        .bits_per_sample = 16,
+        .sample_rate = (uint32_t)ctx->config.sample_rate,
+        .block_frames = (uint32_t)ctx->config.block_frames,
+        .total_frames = index_offset ? ctx->total_frames : 0,
+        .index_offset = index_offset,
+        .index_blocks = index_offset ? ctx->index_count : 0
+    };
+    memcpy(header.magic, LOSSLESS_MAGIC, sizeof(header.magic));
+    
+    if (pwrite(ctx->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        return MICARRAY_ERROR_AUDIO_OUTPUT;
+    }
+    return MICARRAY_SUCCESS;
+}
+
+static void stop_workers(lossless_writer_t *ctx, int started) {
+    pthread_mutex_lock(&ctx->mutex);
+    ctx->shutdown = true;
+    pthread_cond_broadcast(&ctx->work_cond);
+    pthread_mutex_unlock(&ctx->mutex);
+    
+    for (int t = 1; t < started; t++) {
+        pthread_join(ctx->threads[t], NULL);
+    }
+}
+
+static void free_writer(lossless_writer_t *ctx) {
+    if (ctx->coders) {
+        for (int c = 0; c < ctx->config.channels; c++) {
+            free(ctx->coders[c].samples);
+            free(ctx->coders[c].residual);
+            free(ctx->coders[c].stream);
+        }
+        free(ctx->coders);
+    }
+    
+    pthread_cond_destroy(&ctx->done_cond);
+    pthread_cond_destroy(&ctx->work_cond);
+    pthread_mutex_destroy(&ctx->mutex);
+    free(ctx->threads);
+    free(ctx->args);
+    free(ctx->sizes);
+    free(ctx->block);
+    free(ctx->index);
+    free(ctx);
+}
+
+int lossless_writer_init(lossless_writer_t **ctx, const lossless_config_t *config) {
+    if (!ctx || !config || config->channels < 1 || config->channels > MAX_MICROPHONES ||
+        config->sample_rate <= 0 || config->block_frames < 1 || config->block_frames > LOSSLESS_MAX_BLOCK ||
+        config->threads < 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(lossless_writer_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    lossless_writer_t *writer = *ctx;
+    writer->config = *config;
+    writer->fd = -1;
+    
+    int threads = config->threads;
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    writer->num_threads = threads < config->channels ? threads : config->channels;
+    
+    pthread_mutex_init(&writer->mutex, NULL);
+    pthread_cond_init(&writer->work_cond, NULL);
+    pthread_cond_init(&writer->done_cond, NULL);
+    
+    const size_t frames = (size_t)config->block_frames;
+    writer->block = malloc(frames * config->channels * sizeof(int16_t));
+    writer->sizes = calloc(config->channels, sizeof(uint32_t));
+    writer->coders = calloc(config->channels, sizeof(channel_coder_t));
+    writer->threads = calloc(writer->num_threads, sizeof(pthread_t));
+    writer->args = calloc(writer->num_threads, sizeof(worker_arg_t));
+    if (!writer->block || !writer->sizes || !writer->coders || !writer->threads || !writer->args) {
+        free_writer(writer);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    for (int c = 0; c < config->channels; c++) {
+        channel_coder_t *coder = &writer->coders[c];
+        coder->samples = malloc(frames * sizeof(int32_t));
+        coder->residual = malloc(frames * sizeof(uint32_t));
+        coder->stream = malloc(1 + 2 * frames + 8);
+        if (!coder->samples || !coder->residual || !coder->stream) {
+            free_writer(writer);
+            *ctx = NULL;
+            return MICARRAY_ERROR_MEMORY;
+        }
+    }
+    
+    for (int t = 1; t < writer->num_threads; t++) {
+        writer->args[t] = (worker_arg_t){ writer, t };
+        if (pthread_create(&writer->threads[t], NULL, encoder_thread_func, &writer->args[t]) != 0) {
+            stop_workers(writer, t);
+            free_writer(writer);
+            *ctx = NULL;
+            return MICARRAY_ERROR_INIT;
+        }
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int lossless_writer_cleanup(lossless_writer_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    stop_workers(ctx, ctx->num_threads);
+    free_writer(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int lossless_writer_begin(lossless_writer_t *ctx, int fd) {
+    if (!ctx || fd < 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    ctx->fd = fd;
+    ctx->offset = sizeof(lossless_header_t);
+    ctx->total_frames = 0;
+    ctx->buffered = 0;
+    ctx->index_count = 0;
+    ctx->failed = false;
+    
+    int result = write_header(ctx, 0);
+    ctx->failed = (result != MICARRAY_SUCCESS);
+    return result;
+}
+
+int lossless_writer_write(lossless_writer_t *ctx, const int16_t *interleaved, size_t frames) {
+    if (!ctx || !interleaved || ctx->fd < 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (ctx->failed) {
+        return MICARRAY_ERROR_AUDIO_OUTPUT;
+    }
+    
+    const int channels = ctx->config.channels;
+    const size_t block_frames = (size_t)ctx->config.block_frames;
+    while (frames > 0) {
+        size_t count = block_frames - ctx->buffered;
+        if (count > frames) {
+            count = frames;
+        }
+        
+        memcpy(ctx->block + ctx->buffered * channels, interleaved, count * channels * sizeof(int16_t));
+        ctx->buffered += count;
+        interleaved += count * channels;
+        frames -= count;
+        
+        if (ctx->buffered == block_frames) {
+            int result = encode_block(ctx);
+            if (result != MICARRAY_SUCCESS) {
+                ctx->failed = true;
+                return result;
+            }
+        }
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int lossless_writer_finish(lossless_writer_t *ctx) {
+    if (!ctx || ctx->fd < 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    int result = ctx->failed ? MICARRAY_ERROR_AUDIO_OUTPUT : MICARRAY_SUCCESS;
+    if (result == MICARRAY_SUCCESS && ctx->buffered > 0) {
+        result = encode_block(ctx);
+    }
+    
+    if (result == MICARRAY_SUCCESS) {
+        size_t bytes = ctx->index_count * sizeof(lossless_index_entry_t);
+        if (bytes > 0 && pwrite(ctx->fd, ctx->index, bytes, (off_t)ctx->offset) != (ssize_t)bytes) {
+            result = MICARRAY_ERROR_AUDIO_OUTPUT;
+        } else {
+            result = write_header(ctx, ctx->offset);
+        }
+    }
+    
+    ctx->fd = -1;
+    return result;
+}
+
+/* Walks the block headers of a file whose writer never finished and keeps
+ * every block that is whole. */
+static int scan_blocks(lossless_reader_t *ctx) {
+    const lossless_header_t *header = (const lossless_header_t*)ctx->map;
+    size_t capacity = 0;
+    size_t offset = sizeof(*header);
+    uint64_t frames = 0;
+    
+    while (ctx->map_size - offset >= sizeof(lossless_block_header_t)) {
+        lossless_block_header_t block;
+        memcpy(&block, ctx->map + offset, sizeof(block));
+        if (block.sync != LOSSLESS_SYNC || block.first_frame != frames || block.frames == 0 ||
+            block.frames > header->block_frames || block.bytes > ctx->map_size - offset - sizeof(block)) {
+            break;
+        }
+        
+        if (ctx->info.blocks == capacity) {
+            capacity = capacity ? 2 * capacity : 256;
+            lossless_index_entry_t *index = realloc(ctx->index, capacity * sizeof(*index));
+            if (!index) {
+                return MICARRAY_ERROR_MEMORY;
+            }
+            ctx->index = index;
+        }
+        
+        ctx->index[ctx->info.blocks++] = (lossless_index_entry_t){ frames, offset };
+        frames += block.frames;
+        offset += sizeof(block) + block.bytes;
+    }
+    
+    ctx->info.frames = frames;
+    return MICARRAY_SUCCESS;
+}
+
+static int load_index(lossless_reader_t *ctx) {
+    const lossless_header_t *header = (const lossless_header_t*)ctx->map;
+    if (header->index_offset == 0) {
+        return scan_blocks(ctx);
+    }
+    
+    if (header->index_offset > ctx->map_size ||
+        header->index_blocks > (ctx->map_size - header->index_offset) / sizeof(lossless_index_entry_t)) {
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    if (header->index_blocks == 0) {
+        return MICARRAY_SUCCESS;
+    }
+    
+    ctx->index = malloc(header->index_blocks * sizeof(lossless_index_entry_t));
+    if (!ctx->index) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    memcpy(ctx->index, ctx->map + header->index_offset, header->index_blocks * sizeof(lossless_index_entry_t));
+    ctx->info.blocks = header->index_blocks;
+    ctx->info.frames = header->total_frames;
+    
+    /* Blocks must tile the recording from frame 0, each but the last full,
+     * so every frame below total_frames lands in exactly one of them. */
+    const uint64_t block_frames = header->block_frames;
+    for (uint64_t i = 0; i < header->index_blocks; i++) {
+        if (ctx->index[i].first_frame != i * block_frames) {
+            return MICARRAY_ERROR_CONFIG;
+        }
+    }
+    uint64_t last = ctx->index[header->index_blocks - 1].first_frame;
+    if (header->total_frames <= last || header->total_frames - last > block_frames) {
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int lossless_reader_open(lossless_reader_t **ctx, const char *path) {
+    if (!ctx || !path) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open recording %s\n", path);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(lossless_header_t)) {
+        close(fd);
+        fprintf(stderr, "Recording %s is truncated\n", path);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    *ctx = calloc(1, sizeof(lossless_reader_t));
+    if (!*ctx) {
+        close(fd);
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    lossless_reader_t *reader = *ctx;
+    reader->map_size = (size_t)st.st_size;
+    void *map = mmap(NULL, reader->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        free(reader);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    reader->map = map;
+    madvise(map, reader->map_size, MADV_SEQUENTIAL);
+    
+    const lossless_header_t *header = map;
+    if (memcmp(header->magic, LOSSLESS_MAGIC, sizeof(header->magic)) != 0 || header->bits_per_sample != 16 ||
+        header->channels < 1 || header->channels > MAX_MICROPHONES || header->sample_rate == 0 ||
+        header->block_frames < 1 || header->block_frames > LOSSLESS_MAX_BLOCK) {
+        fprintf(stderr, "Recording %s is not a lossless micarray capture\n", path);
+        lossless_reader_close(reader);
+        *ctx = NULL;
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    reader->info.channels = header->channels;
+    reader->info.sample_rate = (int)header->sample_rate;
+    reader->info.block_frames = (int)header->block_frames;
+    
+    int result = load_index(reader);
+    if (result == MICARRAY_SUCCESS) {
+        reader->block = malloc((size_t)header->block_frames * header->channels * sizeof(int16_t));
+        reader->samples = malloc((size_t)header->block_frames * sizeof(int32_t));
+        if (!reader->block || !reader->samples) {
+            result = MICARRAY_ERROR_MEMORY;
+        }
+    }
+    
+    if (result != MICARRAY_SUCCESS) {
+        lossless_reader_close(reader);
+        *ctx = NULL;
+        return result;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int lossless_reader_close(lossless_reader_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (ctx->map) {
+        munmap((void*)ctx->map, ctx->map_size);
+    }
+    free(ctx->index);
+    free(ctx->block);
+    free(ctx->samples);
+    free(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int lossless_reader_get_info(lossless_reader_t *ctx, lossless_info_t *info) {
+    if (!ctx || !info) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *info = ctx->info;
+    return MICARRAY_SUCCESS;
+}
+
+int lossless_reader_seek(lossless_reader_t *ctx, uint64_t frame) {
+    if (!ctx || frame > ctx->info.frames) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    ctx->position = frame;
+    return MICARRAY_SUCCESS;
+}
+
+/* Decodes the block holding frame, found by binary search of the index. */
+static int load_block(lossless_reader_t *ctx, uint64_t frame) {
+    size_t lo = 0, hi = ctx->info.blocks;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (ctx->index[mid].first_frame <= frame) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    
+    const lossless_index_entry_t *entry = &ctx->index[lo];
+    const int channels = ctx->info.channels;
+    lossless_block_header_t block;
+    if (entry->offset > ctx->map_size || ctx->map_size - entry->offset < sizeof(block)) {
+        return MICARRAY_ERROR_CONFIG;
+    }
+    memcpy(&block, ctx->map + entry->offset, sizeof(block));
+    
+    size_t payload = entry->offset + sizeof(block);
+    size_t table = channels * sizeof(uint32_t);
+    if (block.sync != LOSSLESS_SYNC || block.first_frame != entry->first_frame || block.frames == 0 ||
+        block.frames > (uint32_t)ctx->info.block_frames || block.bytes < table ||
+        block.bytes > ctx->map_size - payload) {
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    const uint8_t *data = ctx->map + payload + table;
+    size_t remaining = block.bytes - table;
+    for (int c = 0; c < channels; c++) {
+        uint32_t size;
+        memcpy(&size, ctx->map + payload + c * sizeof(uint32_t), sizeof(size));
+        if (size > remaining || decode_channel(data, size, ctx->samples, block.frames) != 0) {
+            return MICARRAY_ERROR_CONFIG;
+        }
+        
+        for (uint32_t n = 0; n < block.frames; n++) {
+            ctx->block[(size_t)n * channels + c] = (int16_t)ctx->samples[n];
+        }
+        data += size;
+        remaining -= size;
+    }
+    
+    /* A short block in the middle would leave frame uncovered */
+    if (frame < block.first_frame || frame - block.first_frame >= block.frames) {
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    ctx->block_first = block.first_frame;
+    ctx->block_frames = block.frames;
+    return MICARRAY_SUCCESS;
+}
+
+int lossless_reader_read(lossless_reader_t *ctx, int16_t *interleaved, size_t frames, size_t *frames_read) {
+    if (!ctx || !interleaved || !frames_read) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    const int channels = ctx->info.channels;
+    size_t done = 0;
+    while (done < frames && ctx->position < ctx->info.frames) {
+        if (ctx->position < ctx->block_first || ctx->position >= ctx->block_first + ctx->block_frames) {
+            int result = load_block(ctx, ctx->position);
+            if (result != MICARRAY_SUCCESS) {
+                *frames_read = done;
+                return result;
+            }
+        }
+        
+        size_t offset = (size_t)(ctx->position - ctx->block_first);
+        size_t count = ctx->block_frames - offset;
+        if (count > frames - done) {
+            count = frames - done;
+        }
+        
+        memcpy(interleaved + done * channels, ctx->block + offset * channels, count * channels * sizeof(int16_t));
+        done += count;
+        ctx->position += count;
+    }
+    
+    *frames_read = done;
+    return MICARRAY_SUCCESS;
+}
@@ -0,0 +1,99 @@
+#ifndef LOSSLESS_H
+#define LOSSLESS_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOSSLESS_MAGIC "MICLOSS1"
+#define LOSSLESS_SYNC 0x4B4C424Du
+#define LOSSLESS_DEFAULT_BLOCK 4096
+#define LOSSLESS_MAX_BLOCK 65536
+#define LOSSLESS_PARTITION 256
+
+/* A file is this header, the blocks back to back, then the index: one
+ * lossless_index_entry_t per block. All fields are little-endian. The
+ * writer puts the header down with index_offset 0 and patches it when it
+ * finishes, so a reader of a file cut short scans the blocks instead. */
+typedef struct {
+    char magic[8];
+    uint16_t channels;
+    uint16_t bits_per_sample;
+    uint32_t sample_rate;
+    uint32_t block_frames;
+    uint32_t reserved;
+    uint64_t total_frames;
+    uint64_t index_offset;
+    uint64_t index_blocks;
+} lossless_header_t;
+
+/* Every block holds block_frames frames (the last may hold fewer) and
+ * starts with this header, then a uint32_t byte count per channel, then
+ * each channel's bitstream. A channel is coded on its own: a method byte
+ * (constant, verbatim, or fixed polynomial predictor of order 0-4 as in
+ * FLAC), then for predictors the warm-up samples and zigzagged residuals
+ * Rice-coded in partitions of LOSSLESS_PARTITION, each with a 5-bit
+ * parameter. */
+typedef struct {
+    uint32_t sync;
+    uint32_t frames;
+    uint64_t first_frame;
+    uint32_t bytes;
+    uint32_t reserved;
+} lossless_block_header_t;
+
+typedef struct {
+    uint64_t first_frame;
+    uint64_t offset;
+} lossless_index_entry_t;
+
+typedef struct lossless_writer lossless_writer_t;
+typedef struct lossless_reader lossless_reader_t;
+
+/* threads of 0 uses one per channel up to the number of online CPUs. */
+typedef struct {
+    int channels;
+    int sample_rate;
+    int block_frames;
+    int threads;
+} lossless_config_t;
+
+typedef struct {
+    int channels;
+    int sample_rate;
+    int block_frames;
+    uint64_t frames;
+    uint64_t blocks;
+} lossless_info_t;
+
+/* Starts the encoder's worker threads, which are reused across files. */
+int lossless_writer_init(lossless_writer_t **ctx, const lossless_config_t *config);
+int lossless_writer_cleanup(lossless_writer_t *ctx);
+
+/* Writes a header to fd, which must be empty and stays the caller's. */
+int lossless_writer_begin(lossless_writer_t *ctx, int fd);
+
+/* Buffers interleaved frames and writes every block that fills, each
+ * channel encoded by its own worker. */
+int lossless_writer_write(lossless_writer_t *ctx, const int16_t *interleaved, size_t frames);
+
+/* Writes the partial block, the index and the final header. */
+int lossless_writer_finish(lossless_writer_t *ctx);
+
+/* Maps path; the index is loaded, or rebuilt if the writer never finished. */
+int lossless_reader_open(lossless_reader_t **ctx, const char *path);
+int lossless_reader_close(lossless_reader_t *ctx);
+int lossless_reader_get_info(lossless_reader_t *ctx, lossless_info_t *info);
+int lossless_reader_seek(lossless_reader_t *ctx, uint64_t frame);
+
+/* Decodes up to frames interleaved frames; *frames_read is 0 at the end. */
+int lossless_reader_read(lossless_reader_t *ctx, int16_t *interleaved, size_t frames, size_t *frames_read);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,11 +1,14 @@
 #define _GNU_SOURCE
 #include "libmicarray.h"
+#include "config.h"
+#include "lossless.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
@@ -21,17 +24,35 @@ static void signal_handler(int sig) {
     }
 }
 
+/* SIGUSR1 starts or extends a recording, SIGUSR2 ends it. */
+static void recording_signal_handler(int sig) {
+    if (!g_micarray_ctx) {
+        return;
+    }
+    
+    if (sig == SIGUSR1) {
+        micarray_trigger_recording(g_micarray_ctx);
+    } else {
+        micarray_stop_recording(g_micarray_ctx);
+    }
+}
+
 static void print_usage(const char *program_name) {
     printf("Usage: %s [OPTIONS]\n", program_name);
     printf("\nOptions:\n");
     printf("  -c, --config FILE    Configuration file path (default: micarray.conf)\n");
     printf("  -v, --volume LEVEL   Set volume level (0.0-1.0)\n");
     printf("  -d, --daemon         Run as daemon\n");
+    printf("  -r, --replay FILE    Process a lossless recording instead of the array\n");
     printf("  -h, --help           Show this help message\n");
     printf("  --version            Show version information\n");
+    printf("\nSignals (with [Recorder] enabled):\n");
+    printf("  SIGUSR1              Start or extend a recording\n");
+    printf("  SIGUSR2              Stop recording\n");
     printf("\nExamples:\n");
     printf("  %s --config /etc/micarray.conf\n", program_name);
     printf("  %s --volume 0.8 --daemon\n", program_name);
+    printf("  %s --replay /var/lib/micarray/micarray-20240101-120000-0.mla\n", program_name);
 }
 
 static void print_version(void) {
@@ -50,15 +71,98 @@ static void print_status(micarray_context_t *ctx) {
     }
 }
 
+/* Feeds a recording through a headless context as fast as it decodes, so
+ * a capture can be re-analysed with a different configuration. */
+static int run_replay(const char *config_file, const char *path) {
+    micarray_config_t config;
+    config_set_defaults(&config);
+    int result = config_parse_file(config_file, &config);
+    if (result != MICARRAY_SUCCESS) {
+        fprintf(stderr, "Error: Failed to load configuration: %s\n", micarray_get_error_string(result));
+        return EXIT_FAILURE;
+    }
+    
+    lossless_reader_t *reader = NULL;
+    result = lossless_reader_open(&reader, path);
+    if (result != MICARRAY_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    
+    lossless_info_t info;
+    lossless_reader_get_info(reader, &info);
+    if (info.channels != config.num_microphones || info.sample_rate != config.sample_rate) {
+        fprintf(stderr, "Error: Recording has %d channels at %d Hz, configuration expects %d at %d Hz\n", 
+                info.channels, info.sample_rate, config.num_microphones, config.sample_rate);
+        lossless_reader_close(reader);
+        return EXIT_FAILURE;
+    }
+    
+    result = micarray_init_headless(&g_micarray_ctx, &config);
+    if (result != MICARRAY_SUCCESS) {
+        fprintf(stderr, "Error: Failed to initialize libmicarray: %s\n", 
+                micarray_get_error_string(result));
+        lossless_reader_close(reader);
+        return EXIT_FAILURE;
+    }
+    
+    const size_t block = (size_t)config.dma_buffer_size;
+    int16_t *input = malloc(block * info.channels * sizeof(int16_t));
+    int16_t *output = malloc(2 * block * sizeof(int16_t));
+    if (!input || !output) {
+        fprintf(stderr, "Error: Out of memory\n");
+        result = MICARRAY_ERROR_MEMORY;
+    }
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    uint64_t frames_done = 0;
+    sound_location_t location = {0};
+    while (result == MICARRAY_SUCCESS && g_running) {
+        size_t frames;
+        result = lossless_reader_read(reader, input, block, &frames);
+        if (result != MICARRAY_SUCCESS || frames == 0) {
+            break;
+        }
+        
+        result = micarray_process_block(g_micarray_ctx, input, MICARRAY_LAYOUT_INTERLEAVED, frames, 
+                                        output, &location);
+        frames_done += frames;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double audio = (double)frames_done / info.sample_rate;
+    
+    if (result != MICARRAY_SUCCESS) {
+        fprintf(stderr, "Error: Replay stopped after %.1f s: %s\n", audio, micarray_get_error_string(result));
+    } else {
+        printf("Replayed %.1f s of audio in %.2f s (%.1fx real time)\n", audio, elapsed, 
+               elapsed > 0.0 ? audio / elapsed : 0.0);
+        printf("Last location: x=%.2f, y=%.2f, z=%.2f, confidence=%.2f\n", 
+               location.x, location.y, location.z, location.confidence);
+    }
+    
+    free(input);
+    free(output);
+    micarray_cleanup(g_micarray_ctx);
+    g_micarray_ctx = NULL;
+    lossless_reader_close(reader);
+    
+    return result == MICARRAY_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int main(int argc, char *argv[]) {
     const char *config_file = "micarray.conf";
     float volume = -1.0f;
     bool daemon_mode = false;
+    const char *replay_file = NULL;
     
     static struct option long_options[] = {
         {"config", required_argument, 0, 'c'},
         {"volume", required_argument, 0, 'v'},
         {"daemon", no_argument, 0, 'd'},
+        {"replay", required_argument, 0, 'r'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 0},
         {0, 0, 0, 0}
@@ -67,7 +171,7 @@ int main(int argc, char *argv[]) {
     int opt;
     int option_index = 0;
     
-    while ((opt = getopt_long(argc, argv, "c:v:dh", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "c:v:dr:h", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'c':
                 config_file = optarg;
@@ -82,6 +186,9 @@ int main(int argc, char *argv[]) {
             case 'd':
                 daemon_mode = true;
                 break;
+            case 'r':
+                replay_file = optarg;
+                break;
             case 'h':
                 print_usage(argv[0]);
                 return EXIT_SUCCESS;
@@ -104,6 +211,12 @@ int main(int argc, char *argv[]) {
     
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGUSR1, recording_signal_handler);
+    signal(SIGUSR2, recording_signal_handler);
+    
+    if (replay_file) {
+        return run_replay(config_file, replay_file);
+    }
     
     printf("libmicarray %s - Multi-microphone array processing\n", micarray_get_version());
     printf("Configuration file: %s\n", config_file);
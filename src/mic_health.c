@@ -0,0 +1,350 @@
+#define _GNU_SOURCE
+#include "mic_health.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DEFAULT_WINDOW_SECONDS 0.1f
+#define DEFAULT_DC_THRESHOLD 0.1f
+#define DEFAULT_MIN_RMS 1e-5f
+#define DEFAULT_MAX_CLIP_RATE 0.01f
+#define DEFAULT_MIN_COHERENCE 0.2f
+#define DEFAULT_DROP_WINDOWS 5
+#define DEFAULT_RECOVER_WINDOWS 20
+#define CLIP_LEVEL 32767
+
+typedef struct {
+    int64_t sum;
+    int64_t sum_sq;
+    int64_t sum_mix;
+    uint32_t clipped;
+    
+    int64_t level_sum_sq;
+    int32_t level_peak;
+    
+    int bad_windows;
+    int good_windows;
+    mic_health_status_t status;
+} channel_health_t;
+
+typedef void (*deinterleave_fn)(mic_health_context_t *ctx, const int16_t *input, size_t frames,
+                                int16_t **output, size_t offset);
+
+struct mic_health_context {
+    mic_health_config_t config;
+    deinterleave_fn deinterleave;
+    channel_health_t *channels;
+    int32_t *mix;
+    
+    size_t window_frames;
+    size_t frames;
+    size_t level_frames;
+    int64_t mix_sum;
+    int64_t mix_sum_sq;
+    uint32_t active_mask;
+};
+
+/* Frame-major copy into the planar buffers. Called with a constant
+ * channel count the stride folds and the channel loop unrolls, so the
+ * instances below cost one function each. */
+static inline __attribute__((always_inline))
+void deinterleave_channels(mic_health_context_t *ctx, const int16_t *input, size_t frames,
+                           int16_t **output, size_t offset, const int channels) {
+    int16_t *out[32];
+    int32_t weight[32];
+    for (int c = 0; c < channels; c++) {
+        out[c] = output[c] + offset;
+        weight[c] = ctx->channels[c].status.active;
+    }
+    
+    for (size_t j = 0; j < frames; j++) {
+        const int16_t *frame = input + j * channels;
+        int32_t mix = 0;
+#pragma GCC unroll 8
+        for (int c = 0; c < channels; c++) {
+            out[c][j] = frame[c];
+            mix += frame[c] * weight[c];
+        }
+        ctx->mix[j] = mix;
+    }
+}
+
+static void deinterleave_any(mic_health_context_t *ctx, const int16_t *input, size_t frames,
+                             int16_t **output, size_t offset) {
+    deinterleave_channels(ctx, input, frames, output, offset, ctx->config.num_channels);
+}
+
+static void deinterleave_2(mic_health_context_t *ctx, const int16_t *input, size_t frames,
+                           int16_t **output, size_t offset) {
+    deinterleave_channels(ctx, input, frames, output, offset, 2);
+}
+
+static void deinterleave_4(mic_health_context_t *ctx, const int16_t *input, size_t frames,
+                           int16_t **output, size_t offset) {
+    deinterleave_channels(ctx, input, frames, output, offset, 4);
+}
+
+static void deinterleave_8(mic_health_context_t *ctx, const int16_t *input, size_t frames,
+                           int16_t **output, size_t offset) {
+    deinterleave_channels(ctx, input, frames, output, offset, 8);
+}
+
+int mic_health_init(mic_health_context_t **ctx, const mic_health_config_t *config) {
+    if (!ctx || !config || config->num_channels < 1 || config->num_channels > 32 ||
+        config->sample_rate <= 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(mic_health_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    (*ctx)->config = *config;
+    mic_health_config_t *cfg = &(*ctx)->config;
+    
+    if (cfg->window_seconds <= 0.0f) cfg->window_seconds = DEFAULT_WINDOW_SECONDS;
+    if (cfg->dc_threshold <= 0.0f) cfg->dc_threshold = DEFAULT_DC_THRESHOLD;
+    if (cfg->min_rms <= 0.0f) cfg->min_rms = DEFAULT_MIN_RMS;
+    if (cfg->max_clip_rate <= 0.0f) cfg->max_clip_rate = DEFAULT_MAX_CLIP_RATE;
+    if (cfg->min_coherence <= 0.0f) cfg->min_coherence = DEFAULT_MIN_COHERENCE;
+    if (cfg->drop_windows <= 0) cfg->drop_windows = DEFAULT_DROP_WINDOWS;
+    if (cfg->recover_windows <= 0) cfg->recover_windows = DEFAULT_RECOVER_WINDOWS;
+    
+    (*ctx)->window_frames = (size_t)(cfg->window_seconds * cfg->sample_rate);
+    if ((*ctx)->window_frames == 0) {
+        (*ctx)->window_frames = 1;
+    }
+    
+    (*ctx)->channels = calloc(cfg->num_channels, sizeof(channel_health_t));
+    (*ctx)->mix = calloc(MAX_BUFFER_SIZE, sizeof(int32_t));
+    if (!(*ctx)->channels || !(*ctx)->mix) {
+        mic_health_cleanup(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    for (int c = 0; c < cfg->num_channels; c++) {
+        (*ctx)->channels[c].status.active = true;
+        (*ctx)->channels[c].status.coherence = 1.0f;
+    }
+    (*ctx)->active_mask = (cfg->num_channels == 32) ? 0xFFFFFFFFu : ((1u << cfg->num_channels) - 1);
+    
+    (*ctx)->deinterleave = deinterleave_any;
+    if (!cfg->generic) {
+        switch (cfg->num_channels) {
+            case 2: (*ctx)->deinterleave = deinterleave_2; break;
+            case 4: (*ctx)->deinterleave = deinterleave_4; break;
+            case 8: (*ctx)->deinterleave = deinterleave_8; break;
+        }
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int mic_health_cleanup(mic_health_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    free(ctx->channels);
+    free(ctx->mix);
+    free(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+/* Second half of both copy paths: the per-frame sum of the active channels
+ * is the common signal each channel's coherence is measured against, so a
+ * channel that has already been dropped cannot drag the others down. The
+ * level meter rides on the same loop; it is branch-free so it vectorizes. */
+static void accumulate(mic_health_context_t *ctx, int16_t **output, size_t offset, size_t frames) {
+    const int channels = ctx->config.num_channels;
+    
+    for (size_t j = 0; j < frames; j++) {
+        int32_t mix = ctx->mix[j];
+        ctx->mix_sum += mix;
+        ctx->mix_sum_sq += (int64_t)mix * mix;
+    }
+    
+    for (int c = 0; c < channels; c++) {
+        channel_health_t *ch = &ctx->channels[c];
+        const int16_t *x = output[c] + offset;
+        int64_t sum = 0, sum_sq = 0, sum_mix = 0;
+        uint32_t clipped = 0;
+        int32_t peak = ch->level_peak;
+        
+        for (size_t j = 0; j < frames; j++) {
+            int32_t s = x[j];
+            int32_t a = s < 0 ? -s : s;
+            sum += s;
+            sum_sq += s * s;
+            sum_mix += (int64_t)s * ctx->mix[j];
+            clipped += (a >= CLIP_LEVEL);
+            peak = a > peak ? a : peak;
+        }
+        
+        ch->sum += sum;
+        ch->sum_sq += sum_sq;
+        ch->sum_mix += sum_mix;
+        ch->clipped += clipped;
+        ch->level_sum_sq += sum_sq;
+        ch->level_peak = peak;
+    }
+    
+    ctx->frames += frames;
+    ctx->level_frames += frames;
+}
+
+void mic_health_deinterleave(mic_health_context_t *ctx, const int16_t *input, size_t frames,
+                             int16_t **output, size_t offset) {
+    ctx->deinterleave(ctx, input, frames, output, offset);
+    accumulate(ctx, output, offset, frames);
+}
+
+void mic_health_copy_planar(mic_health_context_t *ctx, const int16_t *input, size_t frames,
+                            int16_t **output) {
+    const int channels = ctx->config.num_channels;
+    
+    memset(ctx->mix, 0, frames * sizeof(int32_t));
+    for (int c = 0; c < channels; c++) {
+        const int16_t *src = input + (size_t)c * frames;
+        memcpy(output[c], src, frames * sizeof(int16_t));
+        if (!ctx->channels[c].status.active) {
+            continue;
+        }
+        for (size_t j = 0; j < frames; j++) {
+            ctx->mix[j] += src[j];
+        }
+    }
+    
+    accumulate(ctx, output, 0, frames);
+}
+
+static void measure(mic_health_context_t *ctx, channel_health_t *ch) {
+    const double n = (double)ctx->frames;
+    
+    double mean_x = ch->sum / n;
+    double var_x = ch->sum_sq / n - mean_x * mean_x;
+    
+    /* Statistics of the other active channels, o = mix - x (or the whole
+     * mix for an excluded channel), from the same sums. */
+    double sum_o = (double)ctx->mix_sum;
+    double sum_xo = (double)ch->sum_mix;
+    double sum_oo = (double)ctx->mix_sum_sq;
+    if (ch->status.active) {
+        sum_o -= ch->sum;
+        sum_xo -= ch->sum_sq;
+        sum_oo += ch->sum_sq - 2.0 * ch->sum_mix;
+    }
+    double mean_o = sum_o / n;
+    double var_o = sum_oo / n - mean_o * mean_o;
+    double cov = sum_xo / n - mean_x * mean_o;
+    
+    ch->status.dc_offset = (float)(mean_x / 32768.0);
+    ch->status.rms = (float)(sqrt(var_x > 0.0 ? var_x : 0.0) / 32768.0);
+    ch->status.clip_rate = (float)(ch->clipped / n);
+    
+    if (ctx->config.num_channels < 2 || var_o <= 0.0) {
+        ch->status.coherence = 1.0f;
+    } else if (var_x <= 0.0) {
+        ch->status.coherence = 0.0f;
+    } else {
+        ch->status.coherence = (float)(cov / sqrt(var_x * var_o));
+    }
+}
+
+uint32_t mic_health_evaluate(mic_health_context_t *ctx) {
+    if (!ctx || ctx->frames < ctx->window_frames) {
+        return 0;
+    }
+    
+    const mic_health_config_t *cfg = &ctx->config;
+    int coherent = 0;
+    
+    for (int c = 0; c < cfg->num_channels; c++) {
+        measure(ctx, &ctx->channels[c]);
+        if (ctx->channels[c].status.active && ctx->channels[c].status.coherence >= cfg->min_coherence) {
+            coherent++;
+        }
+    }
+    
+    /* Coherence only says something while most of the array hears a common
+     * sound; in a quiet room every channel is just its own self-noise. */
+    int active = __builtin_popcount(ctx->active_mask);
+    bool check_coherence = (active >= 3 && 2 * coherent > active);
+    uint32_t changed = 0;
+    
+    for (int c = 0; c < cfg->num_channels; c++) {
+        channel_health_t *ch = &ctx->channels[c];
+        bool bad = fabsf(ch->status.dc_offset) > cfg->dc_threshold ||
+                   ch->status.rms < cfg->min_rms ||
+                   ch->status.clip_rate > cfg->max_clip_rate ||
+                   (check_coherence && ch->status.coherence < cfg->min_coherence);
+        
+        if (bad) {
+            ch->good_windows = 0;
+            ch->bad_windows++;
+        } else {
+            ch->bad_windows = 0;
+            ch->good_windows++;
+        }
+        
+        uint32_t bit = 1u << c;
+        if (!cfg->monitor_only && ch->status.active && ch->bad_windows >= cfg->drop_windows && ctx->active_mask != bit) {
+            ch->status.active = false;
+            ctx->active_mask &= ~bit;
+            changed |= bit;
+        } else if (!ch->status.active && ch->good_windows >= cfg->recover_windows) {
+            ch->status.active = true;
+            ctx->active_mask |= bit;
+            changed |= bit;
+        }
+        
+        ch->sum = 0;
+        ch->sum_sq = 0;
+        ch->sum_mix = 0;
+        ch->clipped = 0;
+    }
+    
+    ctx->frames = 0;
+    ctx->mix_sum = 0;
+    ctx->mix_sum_sq = 0;
+    
+    return changed;
+}
+
+uint32_t mic_health_get_mask(const mic_health_context_t *ctx) {
+    return ctx ? ctx->active_mask : 0;
+}
+
+int mic_health_get_status(const mic_health_context_t *ctx, int channel, mic_health_status_t *status) {
+    if (!ctx || !status || channel < 0 || channel >= ctx->config.num_channels) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *status = ctx->channels[channel].status;
+    return MICARRAY_SUCCESS;
+}
+
+int mic_health_read_levels(mic_health_context_t *ctx, float *rms, float *peak, int count) {
+    if (!ctx || !rms || !peak || count > ctx->config.num_channels) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (ctx->level_frames == 0) {
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    for (int c = 0; c < count; c++) {
+        channel_health_t *ch = &ctx->channels[c];
+        rms[c] = (float)(sqrt((double)ch->level_sum_sq / ctx->level_frames) / 32768.0);
+        peak[c] = ch->level_peak / 32768.0f;
+        ch->level_sum_sq = 0;
+        ch->level_peak = 0;
+    }
+    ctx->level_frames = 0;
+    
+    return MICARRAY_SUCCESS;
+}
@@ -0,0 +1,67 @@
+#ifndef MIC_HEALTH_H
+#define MIC_HEALTH_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mic_health_context mic_health_context_t;
+
+/* Zero fields take defaults. Levels are fractions of full scale; a channel
+ * is dropped after drop_windows consecutive bad windows and re-admitted
+ * after recover_windows consecutive good ones. A monitor_only context
+ * measures but never changes the mask. 2, 4 and 8 channels deinterleave
+ * through loops built for that count unless generic is set. */
+typedef struct {
+    int num_channels;
+    int sample_rate;
+    float window_seconds;
+    float dc_threshold;
+    float min_rms;
+    float max_clip_rate;
+    float min_coherence;
+    int drop_windows;
+    int recover_windows;
+    bool monitor_only;
+    bool generic;
+} mic_health_config_t;
+
+typedef struct {
+    float dc_offset;
+    float rms;
+    float clip_rate;
+    float coherence;
+    bool active;
+} mic_health_status_t;
+
+int mic_health_init(mic_health_context_t **ctx, const mic_health_config_t *config);
+int mic_health_cleanup(mic_health_context_t *ctx);
+
+/* Copy frames into output[c][offset...] and accumulate the statistics in
+ * the same pass. */
+void mic_health_deinterleave(mic_health_context_t *ctx, const int16_t *input, size_t frames,
+                             int16_t **output, size_t offset);
+void mic_health_copy_planar(mic_health_context_t *ctx, const int16_t *input, size_t frames,
+                            int16_t **output);
+
+/* Closes the window once enough frames have been seen. Returns the mask of
+ * channels whose active state changed, 0 otherwise. */
+uint32_t mic_health_evaluate(mic_health_context_t *ctx);
+
+uint32_t mic_health_get_mask(const mic_health_context_t *ctx);
+int mic_health_get_status(const mic_health_context_t *ctx, int channel, mic_health_status_t *status);
+
+/* RMS and peak of every channel, as fractions of full scale, over all
+ * frames copied since the previous call. Returns MICARRAY_ERROR_INIT if
+ * nothing has been copied. */
+int mic_health_read_levels(mic_health_context_t *ctx, float *rms, float *peak, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,318 @@
+#ifndef MICARRAY_HPP
+#define MICARRAY_HPP
+
+/* Header-only C++17 interface over the C API. Contexts are move-only and
+ * released on destruction, blocks are passed as views over the caller's
+ * buffers, and custom stages are registered from a factory lambda. Errors
+ * are thrown as micarray::error carrying the MICARRAY_ERROR_* code. */
+
+#include "libmicarray.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace micarray {
+
+class error : public std::runtime_error {
+public:
+    explicit error(int code) : std::runtime_error(micarray_get_error_string(code)), code_(code) {}
+    int code() const noexcept { return code_; }
+
+private:
+    int code_;
+};
+
+inline void check(int result) {
+    if (result != MICARRAY_SUCCESS) {
+        throw error(result);
+    }
+}
+
+/* A pointer and a length, as std::span<T> in C++20. */
+template <class T>
+class span {
+public:
+    constexpr span() noexcept = default;
+    constexpr span(T *data, std::size_t size) noexcept : data_(data), size_(size) {}
+    template <std::size_t N>
+    constexpr span(T (&array)[N]) noexcept : data_(array), size_(N) {}
+    template <class Container, class = std::enable_if_t<
+        std::is_convertible_v<decltype(std::declval<Container&>().data()), T*>>>
+    constexpr span(Container &container) noexcept : data_(container.data()), size_(container.size()) {}
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+    constexpr span(const span<U> &other) noexcept : data_(other.data()), size_(other.size()) {}
+    
+    constexpr T *data() const noexcept { return data_; }
+    constexpr std::size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+    constexpr T *begin() const noexcept { return data_; }
+    constexpr T *end() const noexcept { return data_ + size_; }
+    constexpr T &operator[](std::size_t i) const noexcept { return data_[i]; }
+    constexpr span subspan(std::size_t offset, std::size_t count) const noexcept {
+        return span(data_ + offset, count);
+    }
+
+private:
+    T *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+/* channels x frames samples in one buffer, channel c starting at
+ * data + c * stride; view(c, j) indexes like a 2-D mdspan. */
+template <class T>
+class planar_view {
+public:
+    constexpr planar_view(T *data, std::size_t channels, std::size_t frames) noexcept
+        : data_(data), channels_(channels), frames_(frames), stride_(frames) {}
+    constexpr planar_view(T *data, std::size_t channels, std::size_t frames, std::size_t stride) noexcept
+        : data_(data), channels_(channels), frames_(frames), stride_(stride) {}
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+    constexpr planar_view(const planar_view<U> &other) noexcept
+        : data_(other.data()), channels_(other.channels()), frames_(other.frames()), stride_(other.stride()) {}
+    
+    constexpr T *data() const noexcept { return data_; }
+    constexpr std::size_t channels() const noexcept { return channels_; }
+    constexpr std::size_t frames() const noexcept { return frames_; }
+    constexpr std::size_t stride() const noexcept { return stride_; }
+    constexpr bool contiguous() const noexcept { return stride_ == frames_ || channels_ <= 1; }
+    constexpr span<T> operator[](std::size_t c) const noexcept { return span<T>(data_ + c * stride_, frames_); }
+    constexpr T &operator()(std::size_t c, std::size_t j) const noexcept { return data_[c * stride_ + j]; }
+    
+    /* frames [offset, offset + count) of every channel */
+    constexpr planar_view slice(std::size_t offset, std::size_t count) const noexcept {
+        return planar_view(data_ + offset, channels_, count, stride_);
+    }
+
+private:
+    T *data_;
+    std::size_t channels_;
+    std::size_t frames_;
+    std::size_t stride_;
+};
+
+/* One buffer per channel, as custom stages are handed them. */
+template <class T>
+class channel_view {
+public:
+    constexpr channel_view(T *const *channels, std::size_t count, std::size_t frames) noexcept
+        : channels_(channels), count_(count), frames_(frames) {}
+    
+    constexpr std::size_t channels() const noexcept { return count_; }
+    constexpr std::size_t frames() const noexcept { return frames_; }
+    constexpr span<T> operator[](std::size_t c) const noexcept { return span<T>(channels_[c], frames_); }
+    constexpr T &operator()(std::size_t c, std::size_t j) const noexcept { return channels_[c][j]; }
+
+private:
+    T *const *channels_;
+    std::size_t count_;
+    std::size_t frames_;
+};
+
+class context {
+public:
+    /* Opens the I2S capture and audio output described by config_file. */
+    explicit context(const char *config_file) {
+        check(micarray_init(&ctx_, config_file));
+    }
+    
+    /* No capture or playback threads; drive it with process(). */
+    static context headless(const micarray_config_t &config) {
+        micarray_context_t *ctx = nullptr;
+        check(micarray_init_headless(&ctx, &config));
+        return context(ctx, config.num_microphones);
+    }
+    
+    context(const context &) = delete;
+    context &operator=(const context &) = delete;
+    
+    context(context &&other) noexcept
+        : ctx_(std::exchange(other.ctx_, nullptr)), channels_(other.channels_) {}
+    
+    context &operator=(context &&other) noexcept {
+        if (this != &other) {
+            reset();
+            ctx_ = std::exchange(other.ctx_, nullptr);
+            channels_ = other.channels_;
+        }
+        return *this;
+    }
+    
+    ~context() { reset(); }
+    
+    micarray_context_t *get() const noexcept { return ctx_; }
+    explicit operator bool() const noexcept { return ctx_ != nullptr; }
+    
+    void start() { check(micarray_start(ctx_)); }
+    void stop() { check(micarray_stop(ctx_)); }
+    
+    /* Processes one planar block in place of micarray_process_block();
+     * output receives 2 * frames interleaved stereo samples. Only throws
+     * on invalid arguments, so it never allocates on the audio path. */
+    void process(planar_view<const int16_t> input, span<int16_t> output,
+                 sound_location_t *location = nullptr) {
+        if (!input.contiguous() || (channels_ && input.channels() != channels_) ||
+            output.size() < 2 * input.frames()) {
+            throw error(MICARRAY_ERROR_INVALID_PARAM);
+        }
+        check(micarray_process_block(ctx_, input.data(), MICARRAY_LAYOUT_PLANAR, input.frames(),
+                                     output.data(), location));
+    }
+    
+    void process_interleaved(span<const int16_t> input, std::size_t frames, span<int16_t> output,
+                             sound_location_t *location = nullptr) {
+        if ((channels_ && input.size() < frames * channels_) || output.size() < 2 * frames) {
+            throw error(MICARRAY_ERROR_INVALID_PARAM);
+        }
+        check(micarray_process_block(ctx_, input.data(), MICARRAY_LAYOUT_INTERLEAVED, frames,
+                                     output.data(), location));
+    }
+    
+    sound_location_t location() const {
+        sound_location_t location;
+        check(micarray_get_location(ctx_, &location));
+        return location;
+    }
+    
+    micarray_stats_t stats() const {
+        micarray_stats_t stats;
+        check(micarray_get_stats(ctx_, &stats));
+        return stats;
+    }
+    
+    micarray_latency_t latency() const {
+        micarray_latency_t latency;
+        check(micarray_get_latency(ctx_, &latency));
+        return latency;
+    }
+    
+    /* Fills stats from the front and returns how many stages there are. */
+    int stage_stats(span<micarray_stage_stats_t> stats) const {
+        int count = 0;
+        check(micarray_get_stage_stats(ctx_, stats.data(), static_cast<int>(stats.size()), &count));
+        return count;
+    }
+    
+    void steer_beam(int beam, const sound_location_t &target) { check(micarray_steer_beam(ctx_, beam, &target)); }
+    void trigger_recording() { check(micarray_trigger_recording(ctx_)); }
+    void stop_recording() { check(micarray_stop_recording(ctx_)); }
+    void set_volume(float volume) { check(micarray_set_volume(ctx_, volume)); }
+
+private:
+    context(micarray_context_t *ctx, int channels) noexcept
+        : ctx_(ctx), channels_(channels > 0 ? static_cast<std::size_t>(channels) : 0) {}
+    
+    void reset() noexcept {
+        if (ctx_) {
+            micarray_cleanup(ctx_);
+            ctx_ = nullptr;
+        }
+    }
+    
+    micarray_context_t *ctx_ = nullptr;
+    std::size_t channels_ = 0;  /* 0 when only the config file knows */
+};
+
+namespace detail {
+
+template <class T, class = void>
+struct has_reset : std::false_type {};
+template <class T>
+struct has_reset<T, std::void_t<decltype(std::declval<T&>().reset())>> : std::true_type {};
+
+/* The C callbacks carry no user pointer besides the per-context state, so
+ * each factory type gets its own static slot and set of thunks. */
+template <class Factory>
+struct stage_binding {
+    using processor = std::decay_t<std::invoke_result_t<Factory&, const micarray_stage_format_t&,
+                                                        std::string_view>>;
+    
+    struct instance {
+        processor proc;
+        std::size_t channels;
+    };
+    
+    static inline Factory *factory = nullptr;
+    static inline char name[sizeof(micarray_stage_stats_t::name)];
+    static inline micarray_stage_t stage = {};
+    
+    static int init(void **state, const micarray_stage_format_t *format, const char *args) noexcept {
+        try {
+            *state = new instance{(*factory)(*format, std::string_view(args ? args : "")),
+                                  static_cast<std::size_t>(format->num_channels)};
+            return MICARRAY_SUCCESS;
+        } catch (const error &e) {
+            return e.code();
+        } catch (const std::bad_alloc &) {
+            return MICARRAY_ERROR_MEMORY;
+        } catch (...) {
+            return MICARRAY_ERROR_INIT;
+        }
+    }
+    
+    static void process(void *state, float *const *input, float *const *output, std::size_t frames,
+                        uint32_t active_mask) noexcept {
+        instance *self = static_cast<instance*>(state);
+        self->proc(channel_view<const float>(input, self->channels, frames),
+                   channel_view<float>(output, self->channels, frames), active_mask);
+    }
+    
+    static void reset(void *state) noexcept {
+        static_cast<instance*>(state)->proc.reset();
+    }
+    
+    static void cleanup(void *state) noexcept {
+        delete static_cast<instance*>(state);
+    }
+};
+
+} /* namespace detail */
+
+/* Makes a stage available to the [Pipeline] stages of contexts created
+ * afterwards. factory(format, args) runs at context init and returns the
+ * per-context processor, which is then called for every block as
+ * proc(channel_view<const float> in, channel_view<float> out, active_mask)
+ * and must not throw; a reset() member, if present, is called when
+ * processing restarts. Each lambda expression is its own type and can be
+ * registered once; the factory is kept until the process exits. */
+template <class Factory>
+void register_stage(const char *name, Factory factory, uint32_t flags = 0) {
+    using binding = detail::stage_binding<Factory>;
+    static_assert(std::is_invocable_v<typename binding::processor&, channel_view<const float>,
+                                      channel_view<float>, uint32_t>,
+                  "stage processors are called as proc(in, out, active_mask)");
+    
+    if (binding::factory) {
+        throw error(MICARRAY_ERROR_INVALID_PARAM);
+    }
+    
+    if (!name || std::strlen(name) >= sizeof(binding::name)) {
+        throw error(MICARRAY_ERROR_INVALID_PARAM);
+    }
+    std::strcpy(binding::name, name);
+    binding::stage.name = binding::name;
+    binding::stage.flags = flags;
+    binding::stage.init = binding::init;
+    binding::stage.process = binding::process;
+    if constexpr (detail::has_reset<typename binding::processor>::value) {
+        binding::stage.reset = binding::reset;
+    }
+    binding::stage.cleanup = binding::cleanup;
+    
+    binding::factory = new Factory(std::move(factory));
+    int result = micarray_register_stage(&binding::stage);
+    if (result != MICARRAY_SUCCESS) {
+        delete binding::factory;
+        binding::factory = nullptr;
+        throw error(result);
+    }
+}
+
+} /* namespace micarray */
+
+#endif /* MICARRAY_HPP */
@@ -0,0 +1,288 @@
+#define _GNU_SOURCE
+#include "nn_suppressor.h"
+#include "kernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define NN_LAYERS 4
+#define ALIGN_UP(n) (((n) + NN_ALIGN - 1) / NN_ALIGN * NN_ALIGN)
+
+static const float band_edges_hz[NN_BANDS] = {
+    0, 200, 400, 600, 800, 1000, 1200, 1400, 1600, 2000, 2400, 2800, 3200, 4000, 4800, 5600, 6800, 8000
+};
+
+typedef struct {
+    char magic[8];
+    uint32_t bands;
+    uint32_t dense_units;
+    uint32_t gru_units;
+    uint32_t reserved;
+} nn_header_t;
+
+typedef struct {
+    uint32_t rows;
+    uint32_t cols;
+    float weight_scale;
+    float bias_scale;
+} nn_layer_header_t;
+
+typedef struct {
+    int rows;
+    int stride;
+    float weight_scale;
+    float bias_scale;
+    const int16_t *bias;
+    const int8_t *weight;
+} nn_layer_t;
+
+/* Weights stay in the mapping; everything a frame touches besides them is
+ * in the context, sized for NN_MAX_UNITS. The int8 vectors are zero past
+ * their length so they can be fed to the GEMV as padded rows. */
+struct nn_suppressor_context {
+    nn_suppressor_config_t config;
+    void *map;
+    size_t map_size;
+    kernel_gemv_int8_t gemv_int8;
+    nn_layer_t layers[NN_LAYERS];
+    int dense_units;
+    int gru_units;
+    
+    int bins;
+    uint8_t *band;
+    float *frac;
+    
+    int8_t features[NN_MAX_UNITS];
+    int8_t hidden[NN_MAX_UNITS];
+    int8_t state_q[NN_MAX_UNITS];
+    int32_t acc[3 * NN_MAX_UNITS];
+    float dense[NN_MAX_UNITS];
+    float gates_x[3 * NN_MAX_UNITS];
+    float gates_s[3 * NN_MAX_UNITS];
+    float state[NN_MAX_UNITS];
+    float energy[NN_BANDS + 1];
+    float band_gain[NN_BANDS + 1];
+};
+
+static void apply_layer(nn_suppressor_context_t *ctx, const nn_layer_t *layer, const int8_t *x, float *out) {
+    int32_t *acc = ctx->acc;
+    ctx->gemv_int8(layer->weight, layer->rows, layer->stride, x, acc);
+    
+    const float scale = layer->weight_scale / 127.0f;
+    for (int i = 0; i < layer->rows; i++) {
+        out[i] = acc[i] * scale + layer->bias[i] * layer->bias_scale;
+    }
+}
+
+static void quantize(const float *x, int count, int8_t *q) {
+    for (int i = 0; i < count; i++) {
+        q[i] = (int8_t)lrintf(fmaxf(-1.0f, fminf(1.0f, x[i])) * 127.0f);
+    }
+}
+
+static float sigmoid(float x) {
+    return 1.0f / (1.0f + expf(-x));
+}
+
+/* Checks one layer's header against the expected shape and points it into
+ * the mapping, advancing offset past it. */
+static int map_layer(nn_suppressor_context_t *ctx, size_t *offset, int index, int rows, int cols) {
+    if (*offset + sizeof(nn_layer_header_t) > ctx->map_size) {
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    const nn_layer_header_t *header = (const nn_layer_header_t*)((const uint8_t*)ctx->map + *offset);
+    if ((int)header->rows != rows || (int)header->cols != cols) {
+        return MICARRAY_ERROR_CONFIG;
+    }
+    *offset += sizeof(nn_layer_header_t);
+    
+    nn_layer_t *layer = &ctx->layers[index];
+    size_t size = ALIGN_UP(rows) * sizeof(int16_t) + (size_t)rows * ALIGN_UP(cols);
+    if (*offset + size > ctx->map_size) {
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    layer->rows = rows;
+    layer->stride = ALIGN_UP(cols);
+    layer->weight_scale = header->weight_scale;
+    layer->bias_scale = header->bias_scale;
+    layer->bias = (const int16_t*)((const uint8_t*)ctx->map + *offset);
+    layer->weight = (const int8_t*)(layer->bias + ALIGN_UP(rows));
+    *offset += size;
+    
+    return MICARRAY_SUCCESS;
+}
+
+static int map_model_file(nn_suppressor_context_t *ctx) {
+    int fd = open(ctx->config.model_file, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open noise model %s\n", ctx->config.model_file);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(nn_header_t)) {
+        close(fd);
+        fprintf(stderr, "Noise model %s is truncated\n", ctx->config.model_file);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    ctx->map_size = (size_t)st.st_size;
+    ctx->map = mmap(NULL, ctx->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ctx->map == MAP_FAILED) {
+        ctx->map = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    const nn_header_t *header = ctx->map;
+    int dense = (int)header->dense_units;
+    int gru = (int)header->gru_units;
+    if (memcmp(header->magic, NN_FILE_MAGIC, sizeof(header->magic)) != 0 || header->bands != NN_BANDS ||
+        dense < 1 || dense > NN_MAX_UNITS || gru < 1 || gru > NN_MAX_UNITS) {
+        fprintf(stderr, "Noise model %s is not a valid model\n", ctx->config.model_file);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    size_t offset = sizeof(nn_header_t);
+    if (map_layer(ctx, &offset, 0, dense, NN_BANDS) != MICARRAY_SUCCESS ||
+        map_layer(ctx, &offset, 1, 3 * gru, dense) != MICARRAY_SUCCESS ||
+        map_layer(ctx, &offset, 2, 3 * gru, gru) != MICARRAY_SUCCESS ||
+        map_layer(ctx, &offset, 3, NN_BANDS, gru) != MICARRAY_SUCCESS) {
+        fprintf(stderr, "Noise model %s has malformed layers\n", ctx->config.model_file);
+        return MICARRAY_ERROR_CONFIG;
+    }
+    
+    ctx->dense_units = dense;
+    ctx->gru_units = gru;
+    
+    return MICARRAY_SUCCESS;
+}
+
+int nn_suppressor_init(nn_suppressor_context_t **ctx, const nn_suppressor_config_t *config) {
+    if (!ctx || !config || config->frame_size <= 0 || config->sample_rate <= 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(nn_suppressor_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    nn_suppressor_context_t *nn = *ctx;
+    nn->config = *config;
+    nn->bins = config->frame_size / 2 + 1;
+    nn->gemv_int8 = kernels_get()->gemv_int8;
+    
+    int result = map_model_file(nn);
+    if (result != MICARRAY_SUCCESS) {
+        nn_suppressor_cleanup(nn);
+        *ctx = NULL;
+        return result;
+    }
+    
+    nn->band = malloc(nn->bins * sizeof(uint8_t));
+    nn->frac = malloc(nn->bins * sizeof(float));
+    if (!nn->band || !nn->frac) {
+        nn_suppressor_cleanup(nn);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    /* Bins past the last edge belong to the last band alone. */
+    for (int k = 0; k < nn->bins; k++) {
+        float hz = (float)k * config->sample_rate / config->frame_size;
+        int b = 0;
+        while (b < NN_BANDS - 1 && hz >= band_edges_hz[b + 1]) {
+            b++;
+        }
+        nn->band[k] = (uint8_t)b;
+        nn->frac[k] = (b < NN_BANDS - 1) ? (hz - band_edges_hz[b]) / (band_edges_hz[b + 1] - band_edges_hz[b]) : 0.0f;
+    }
+    
+    nn_suppressor_reset(nn);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int nn_suppressor_cleanup(nn_suppressor_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (ctx->map) {
+        munmap(ctx->map, ctx->map_size);
+    }
+    free(ctx->band);
+    free(ctx->frac);
+    free(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int nn_suppressor_reset(nn_suppressor_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    memset(ctx->state, 0, sizeof(ctx->state));
+    memset(ctx->state_q, 0, sizeof(ctx->state_q));
+    
+    return MICARRAY_SUCCESS;
+}
+
+int nn_suppressor_process(nn_suppressor_context_t *ctx, const float *power, float *gains) {
+    if (!ctx || !power || !gains) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    const int gru = ctx->gru_units;
+    const float norm = 1.0f / ((float)ctx->config.frame_size * ctx->config.frame_size);
+    
+    memset(ctx->energy, 0, sizeof(ctx->energy));
+    for (int k = 0; k < ctx->bins; k++) {
+        ctx->energy[ctx->band[k]] += (1.0f - ctx->frac[k]) * power[k];
+        ctx->energy[ctx->band[k] + 1] += ctx->frac[k] * power[k];
+    }
+    
+    float features[NN_BANDS];
+    for (int b = 0; b < NN_BANDS; b++) {
+        features[b] = log10f(ctx->energy[b] * norm + 1e-10f) / 5.0f + 1.0f;
+    }
+    quantize(features, NN_BANDS, ctx->features);
+    
+    apply_layer(ctx, &ctx->layers[0], ctx->features, ctx->dense);
+    for (int i = 0; i < ctx->dense_units; i++) {
+        ctx->dense[i] = tanhf(ctx->dense[i]);
+    }
+    quantize(ctx->dense, ctx->dense_units, ctx->hidden);
+    
+    apply_layer(ctx, &ctx->layers[1], ctx->hidden, ctx->gates_x);
+    apply_layer(ctx, &ctx->layers[2], ctx->state_q, ctx->gates_s);
+    for (int i = 0; i < gru; i++) {
+        float z = sigmoid(ctx->gates_x[i] + ctx->gates_s[i]);
+        float r = sigmoid(ctx->gates_x[gru + i] + ctx->gates_s[gru + i]);
+        float n = tanhf(ctx->gates_x[2 * gru + i] + r * ctx->gates_s[2 * gru + i]);
+        ctx->state[i] = z * ctx->state[i] + (1.0f - z) * n;
+    }
+    quantize(ctx->state, gru, ctx->state_q);
+    
+    apply_layer(ctx, &ctx->layers[3], ctx->state_q, ctx->band_gain);
+    for (int b = 0; b < NN_BANDS; b++) {
+        ctx->band_gain[b] = sigmoid(ctx->band_gain[b]);
+    }
+    ctx->band_gain[NN_BANDS] = ctx->band_gain[NN_BANDS - 1];
+    
+    for (int k = 0; k < ctx->bins; k++) {
+        int b = ctx->band[k];
+        gains[k] = (1.0f - ctx->frac[k]) * ctx->band_gain[b] + ctx->frac[k] * ctx->band_gain[b + 1];
+    }
+    
+    return MICARRAY_SUCCESS;
+}
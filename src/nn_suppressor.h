@@ -0,0 +1,62 @@
+#ifndef NN_SUPPRESSOR_H
+#define NN_SUPPRESSOR_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NN_FILE_MAGIC "MICNNNS1"
+#define NN_BANDS 18
+#define NN_MAX_UNITS 256
+#define NN_ALIGN 16
+
+typedef struct nn_suppressor_context nn_suppressor_context_t;
+
+/* Model file, native byte order:
+ *   char     magic[8]          NN_FILE_MAGIC
+ *   uint32_t bands             NN_BANDS
+ *   uint32_t dense_units
+ *   uint32_t gru_units
+ *   uint32_t reserved          0
+ * followed by four layers, each
+ *   uint32_t rows, cols
+ *   float    weight_scale, bias_scale
+ *   int16_t  bias[align(rows)]
+ *   int8_t   weight[rows][align(cols)]
+ * where align() rounds up to NN_ALIGN and the padding is zero. In order
+ * the layers are the input layer (dense_units x bands, tanh), the GRU's
+ * input and recurrent weights (3 * gru_units x dense_units and
+ * 3 * gru_units x gru_units, gates in z, r, n order, reset applied after
+ * the recurrent product) and the output layer (bands x gru_units,
+ * sigmoid), whose outputs are the band gains. A weight is worth
+ * weight * weight_scale and a bias bias * bias_scale; activations are
+ * quantised to int8 with 1.0 as 127.
+ *
+ * Band b is a triangle peaking at the b-th of the band edges (0, 200, ...
+ * 8000 Hz) and feature b is log10 of its power over frame_size^2, divided
+ * by 5, plus 1, clamped to [-1, 1]. Gains are interpolated across bins
+ * along the same triangles. */
+typedef struct {
+    char model_file[256];
+    int frame_size;
+    int sample_rate;
+} nn_suppressor_config_t;
+
+/* The model is memory-mapped for the life of the context, so contexts for
+ * several channels share its pages. Units are limited to NN_MAX_UNITS. */
+int nn_suppressor_init(nn_suppressor_context_t **ctx, const nn_suppressor_config_t *config);
+int nn_suppressor_cleanup(nn_suppressor_context_t *ctx);
+
+/* Turns the power spectrum of one frame (frame_size / 2 + 1 bins) into a
+ * gain in [0, 1] per bin, advancing the GRU state. Does not allocate. */
+int nn_suppressor_process(nn_suppressor_context_t *ctx, const float *power, float *gains);
+int nn_suppressor_reset(nn_suppressor_context_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,5 +1,6 @@
 #define _GNU_SOURCE
 #include "noise_reduction.h"
+#include "nn_suppressor.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,6 +9,7 @@
 #include <fftw3.h>
 
 #define PI 3.14159265358979323846
+#define NOISE_FLOOR_RISE 1.01f
 
 struct noise_reduction_context {
     noise_reduction_config_t config;
@@ -15,7 +17,8 @@ struct noise_reduction_context {
     float *window;
     float *input_buffer;
     float *output_buffer;
-    float *overlap_buffer;
+    float *output_fifo;
+    float synthesis_scale;
     
     fftwf_complex *fft_input;
     fftwf_complex *fft_output;
@@ -23,17 +26,35 @@ struct noise_reduction_context {
     fftwf_plan inverse_plan;
     
     float *noise_spectrum;
+    float *noise_floor;
     float *magnitude_spectrum;
     float *phase_spectrum;
     
+    nn_suppressor_context_t *nn_ctx;
+    float *nn_power;
+    float *nn_gains;
+    
     int buffer_pos;
     bool noise_profile_ready;
+    bool noise_floor_ready;
+    
+    double input_energy;
+    double output_energy;
+    size_t energy_samples;
 };
 
-static void apply_hanning_window(float *data, int size) {
-    for (int i = 0; i < size; i++) {
-        float w = 0.5f * (1.0f - cosf(2.0f * PI * i / (size - 1)));
-        data[i] *= w;
+static void nn_suppression(noise_reduction_context_t *ctx, fftwf_complex *spectrum, int size) {
+    float *bins = (float*)spectrum;
+    
+    for (int i = 0; i < size / 2 + 1; i++) {
+        ctx->nn_power[i] = bins[2*i] * bins[2*i] + bins[2*i + 1] * bins[2*i + 1];
+    }
+    
+    nn_suppressor_process(ctx->nn_ctx, ctx->nn_power, ctx->nn_gains);
+    
+    for (int i = 0; i < size / 2 + 1; i++) {
+        bins[2*i] *= ctx->nn_gains[i];
+        bins[2*i + 1] *= ctx->nn_gains[i];
     }
 }
 
@@ -69,7 +90,8 @@ static void spectral_subtraction(noise_reduction_context_t *ctx, fftwf_complex *
 }
 
 int noise_reduction_init(noise_reduction_context_t **ctx, const noise_reduction_config_t *config) {
-    if (!ctx || !config) {
+    if (!ctx || !config || config->frame_size <= 0 || 
+        config->overlap < 0 || config->overlap >= config->frame_size) {
         return MICARRAY_ERROR_INVALID_PARAM;
     }
     
@@ -78,32 +100,59 @@ int noise_reduction_init(noise_reduction_context_t **ctx, const noise_reduction_
         return MICARRAY_ERROR_MEMORY;
     }
     
+    int hop_size = config->frame_size - config->overlap;
+    
     (*ctx)->config = *config;
-    (*ctx)->buffer_pos = 0;
+    (*ctx)->buffer_pos = config->overlap;
     (*ctx)->noise_profile_ready = false;
     
     (*ctx)->window = malloc(config->frame_size * sizeof(float));
     (*ctx)->input_buffer = calloc(config->frame_size, sizeof(float));
     (*ctx)->output_buffer = calloc(config->frame_size, sizeof(float));
-    (*ctx)->overlap_buffer = calloc(config->overlap, sizeof(float));
+    (*ctx)->output_fifo = calloc(hop_size, sizeof(float));
     
     (*ctx)->fft_input = fftwf_alloc_complex(config->frame_size);
     (*ctx)->fft_output = fftwf_alloc_complex(config->frame_size);
     
     (*ctx)->noise_spectrum = calloc(config->frame_size / 2 + 1, sizeof(float));
+    (*ctx)->noise_floor = calloc(config->frame_size / 2 + 1, sizeof(float));
     (*ctx)->magnitude_spectrum = calloc(config->frame_size / 2 + 1, sizeof(float));
     (*ctx)->phase_spectrum = calloc(config->frame_size / 2 + 1, sizeof(float));
     
     if (!(*ctx)->window || !(*ctx)->input_buffer || !(*ctx)->output_buffer || 
-        !(*ctx)->overlap_buffer || !(*ctx)->fft_input || !(*ctx)->fft_output ||
-        !(*ctx)->noise_spectrum || !(*ctx)->magnitude_spectrum || !(*ctx)->phase_spectrum) {
+        !(*ctx)->output_fifo || !(*ctx)->fft_input || !(*ctx)->fft_output ||
+        !(*ctx)->noise_spectrum || !(*ctx)->noise_floor || !(*ctx)->magnitude_spectrum || !(*ctx)->phase_spectrum) {
         noise_reduction_cleanup(*ctx);
         *ctx = NULL;
         return MICARRAY_ERROR_MEMORY;
     }
     
+    /* Periodic sqrt-Hann on both analysis and synthesis: the squared window
+     * overlap-adds to frame_size / (2 * hop_size) for any hop that divides
+     * the frame, so short frames reconstruct exactly when no gain is applied. */
     for (int i = 0; i < config->frame_size; i++) {
-        (*ctx)->window[i] = 0.5f * (1.0f - cosf(2.0f * PI * i / (config->frame_size - 1)));
+        (*ctx)->window[i] = sqrtf(0.5f * (1.0f - cosf(2.0f * PI * i / config->frame_size)));
+    }
+    (*ctx)->synthesis_scale = 2.0f * hop_size / ((float)config->frame_size * config->frame_size);
+    
+    if (strcmp(config->algorithm, "nn") == 0) {
+        nn_suppressor_config_t nn_config = {
+            .frame_size = config->frame_size,
+            .sample_rate = config->sample_rate
+        };
+        strcpy(nn_config.model_file, config->model_file);
+        
+        int result = nn_suppressor_init(&(*ctx)->nn_ctx, &nn_config);
+        (*ctx)->nn_power = malloc((config->frame_size / 2 + 1) * sizeof(float));
+        (*ctx)->nn_gains = malloc((config->frame_size / 2 + 1) * sizeof(float));
+        if (result == MICARRAY_SUCCESS && (!(*ctx)->nn_power || !(*ctx)->nn_gains)) {
+            result = MICARRAY_ERROR_MEMORY;
+        }
+        if (result != MICARRAY_SUCCESS) {
+            noise_reduction_cleanup(*ctx);
+            *ctx = NULL;
+            return result;
+        }
     }
     
     (*ctx)->forward_plan = fftwf_plan_dft_r2c_1d(config->frame_size, 
@@ -125,62 +174,88 @@ int noise_reduction_init(noise_reduction_context_t **ctx, const noise_reduction_
     return MICARRAY_SUCCESS;
 }
 
+/* Per-bin power floor of the input: follows dips immediately and creeps up
+ * by NOISE_FLOOR_RISE per frame, so sustained sound is not mistaken for
+ * noise. Tracked whether or not a profile has been learned. */
+static void track_noise_floor(noise_reduction_context_t *ctx) {
+    const int bins = ctx->config.frame_size / 2 + 1;
+    
+    for (int i = 0; i < bins; i++) {
+        float real = ((float*)ctx->fft_output)[2*i];
+        float imag = ((float*)ctx->fft_output)[2*i + 1];
+        float power = real * real + imag * imag;
+        
+        if (!ctx->noise_floor_ready || power < ctx->noise_floor[i]) {
+            ctx->noise_floor[i] = power;
+        } else {
+            ctx->noise_floor[i] *= NOISE_FLOOR_RISE;
+        }
+    }
+    
+    ctx->noise_floor_ready = true;
+}
+
+static void process_frame(noise_reduction_context_t *ctx) {
+    const int frame_size = ctx->config.frame_size;
+    const int hop_size = frame_size - ctx->config.overlap;
+    float *frame = (float*)ctx->fft_input;
+    
+    for (int i = 0; i < frame_size; i++) {
+        frame[i] = ctx->input_buffer[i] * ctx->window[i];
+    }
+    
+    fftwf_execute(ctx->forward_plan);
+    track_noise_floor(ctx);
+    
+    if (strcmp(ctx->config.algorithm, "spectral_subtraction") == 0) {
+        spectral_subtraction(ctx, ctx->fft_output, frame_size);
+    } else if (ctx->nn_ctx) {
+        nn_suppression(ctx, ctx->fft_output, frame_size);
+    }
+    
+    fftwf_execute(ctx->inverse_plan);
+    
+    for (int i = 0; i < frame_size; i++) {
+        ctx->output_buffer[i] += frame[i] * ctx->window[i] * ctx->synthesis_scale;
+    }
+    
+    memcpy(ctx->output_fifo, ctx->output_buffer, hop_size * sizeof(float));
+    memmove(ctx->output_buffer, &ctx->output_buffer[hop_size], (frame_size - hop_size) * sizeof(float));
+    memset(&ctx->output_buffer[frame_size - hop_size], 0, hop_size * sizeof(float));
+    
+    memmove(ctx->input_buffer, &ctx->input_buffer[hop_size], ctx->config.overlap * sizeof(float));
+}
+
+/* Streaming STFT: any block length works and the output is the processed
+ * input delayed by exactly frame_size samples (noise_reduction_get_latency). */
 int noise_reduction_process(noise_reduction_context_t *ctx, int16_t *input, int16_t *output, size_t samples) {
     if (!ctx || !input || !output) {
         return MICARRAY_ERROR_INVALID_PARAM;
     }
     
-    size_t processed = 0;
-    int hop_size = ctx->config.frame_size - ctx->config.overlap;
+    const int latency = ctx->config.overlap;
+    float input_energy = 0.0f, output_energy = 0.0f;
     
-    while (processed < samples) {
-        size_t to_copy = fminf(samples - processed, ctx->config.frame_size - ctx->buffer_pos);
-        
-        for (size_t i = 0; i < to_copy; i++) {
-            ctx->input_buffer[ctx->buffer_pos + i] = input[processed + i] / 32768.0f;
-        }
+    for (size_t i = 0; i < samples; i++) {
+        float x = input[i] / 32768.0f;
+        ctx->input_buffer[ctx->buffer_pos] = x;
+        input_energy += x * x;
         
-        ctx->buffer_pos += to_copy;
-        processed += to_copy;
+        float sample = ctx->output_fifo[ctx->buffer_pos - latency];
+        sample = fmaxf(-1.0f, fminf(1.0f, sample));
+        output[i] = (int16_t)(sample * 32767.0f);
+        output_energy += sample * sample;
         
-        if (ctx->buffer_pos >= ctx->config.frame_size) {
-            memcpy(ctx->fft_input, ctx->input_buffer, ctx->config.frame_size * sizeof(float));
-            apply_hanning_window((float*)ctx->fft_input, ctx->config.frame_size);
-            
-            fftwf_execute(ctx->forward_plan);
-            
-            if (strcmp(ctx->config.algorithm, "spectral_subtraction") == 0) {
-                spectral_subtraction(ctx, ctx->fft_output, ctx->config.frame_size);
-            }
-            
-            fftwf_execute(ctx->inverse_plan);
-            
-            for (int i = 0; i < ctx->config.frame_size; i++) {
-                ((float*)ctx->fft_input)[i] /= ctx->config.frame_size;
-            }
-            
-            apply_hanning_window((float*)ctx->fft_input, ctx->config.frame_size);
-            
-            for (int i = 0; i < ctx->config.overlap; i++) {
-                ((float*)ctx->fft_input)[i] += ctx->overlap_buffer[i];
-            }
-            
-            size_t output_samples = fminf(hop_size, samples - (processed - to_copy));
-            for (size_t i = 0; i < output_samples; i++) {
-                float sample = ((float*)ctx->fft_input)[i];
-                sample = fmaxf(-1.0f, fminf(1.0f, sample));
-                output[processed - to_copy + i] = (int16_t)(sample * 32767.0f);
-            }
-            
-            memcpy(ctx->overlap_buffer, &((float*)ctx->fft_input)[hop_size], 
-                   ctx->config.overlap * sizeof(float));
-            
-            memmove(ctx->input_buffer, &ctx->input_buffer[hop_size], 
-                    (ctx->config.frame_size - hop_size) * sizeof(float));
-            ctx->buffer_pos -= hop_size;
+        if (++ctx->buffer_pos >= ctx->config.frame_size) {
+            ctx->buffer_pos = latency;
+            process_frame(ctx);
         }
     }
     
+    ctx->input_energy += input_energy;
+    ctx->output_energy += output_energy;
+    ctx->energy_samples += samples;
+    
     return MICARRAY_SUCCESS;
 }
 
@@ -196,10 +271,9 @@ int noise_reduction_update_noise_profile(noise_reduction_context_t *ctx, int16_t
     
     while (processed + ctx->config.frame_size <= samples) {
         for (int i = 0; i < ctx->config.frame_size; i++) {
-            ((float*)ctx->fft_input)[i] = noise_samples[processed + i] / 32768.0f;
+            ((float*)ctx->fft_input)[i] = noise_samples[processed + i] / 32768.0f * ctx->window[i];
         }
         
-        apply_hanning_window((float*)ctx->fft_input, ctx->config.frame_size);
         fftwf_execute(ctx->forward_plan);
         
         for (int i = 0; i < ctx->config.frame_size / 2 + 1; i++) {
@@ -232,6 +306,54 @@ int noise_reduction_set_threshold(noise_reduction_context_t *ctx, float threshol
     return MICARRAY_SUCCESS;
 }
 
+/* Power spectral density of the noise, resampled to bins points spanning
+ * DC to Nyquist and normalised by the window energy so callers with a
+ * different FFT size can compare it against their own |X|^2 / sum(w^2).
+ * The learned profile wins over the tracked floor. */
+int noise_reduction_get_noise_psd(noise_reduction_context_t *ctx, float *psd, int bins) {
+    if (!ctx || !psd || bins < 2) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (!ctx->noise_profile_ready && !ctx->noise_floor_ready) {
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    const int own_bins = ctx->config.frame_size / 2 + 1;
+    float window_energy = 0.0f;
+    for (int i = 0; i < ctx->config.frame_size; i++) {
+        window_energy += ctx->window[i] * ctx->window[i];
+    }
+    
+    for (int k = 0; k < bins; k++) {
+        float pos = (float)k * (own_bins - 1) / (bins - 1);
+        int lo = (int)pos;
+        int hi = (lo + 1 < own_bins) ? lo + 1 : lo;
+        float frac = pos - lo;
+        
+        float a, b;
+        if (ctx->noise_profile_ready) {
+            a = ctx->noise_spectrum[lo] * ctx->noise_spectrum[lo];
+            b = ctx->noise_spectrum[hi] * ctx->noise_spectrum[hi];
+        } else {
+            a = ctx->noise_floor[lo];
+            b = ctx->noise_floor[hi];
+        }
+        
+        psd[k] = (a + frac * (b - a)) / window_energy;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int noise_reduction_get_latency(noise_reduction_context_t *ctx) {
+    if (!ctx) {
+        return -1;
+    }
+    
+    return ctx->config.frame_size;
+}
+
 int noise_reduction_cleanup(noise_reduction_context_t *ctx) {
     if (!ctx) {
         return MICARRAY_ERROR_INVALID_PARAM;
@@ -246,12 +368,38 @@ int noise_reduction_cleanup(noise_reduction_context_t *ctx) {
     free(ctx->window);
     free(ctx->input_buffer);
     free(ctx->output_buffer);
-    free(ctx->overlap_buffer);
+    free(ctx->output_fifo);
     free(ctx->noise_spectrum);
+    free(ctx->noise_floor);
     free(ctx->magnitude_spectrum);
     free(ctx->phase_spectrum);
     
+    if (ctx->nn_ctx) {
+        nn_suppressor_cleanup(ctx->nn_ctx);
+    }
+    free(ctx->nn_power);
+    free(ctx->nn_gains);
+    
     free(ctx);
     
     return MICARRAY_SUCCESS;
 }
+
+int noise_reduction_read_energy(noise_reduction_context_t *ctx, float *input_rms, float *output_rms) {
+    if (!ctx || !input_rms || !output_rms) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (ctx->energy_samples == 0) {
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    *input_rms = (float)sqrt(ctx->input_energy / ctx->energy_samples);
+    *output_rms = (float)sqrt(ctx->output_energy / ctx->energy_samples);
+    
+    ctx->input_energy = 0.0;
+    ctx->output_energy = 0.0;
+    ctx->energy_samples = 0;
+    
+    return MICARRAY_SUCCESS;
+}
@@ -19,14 +19,24 @@ typedef struct {
     float alpha;
     float beta;
     int sample_rate;
+    char model_file[256];
 } noise_reduction_config_t;
 
+/* algorithm is "spectral_subtraction", or "nn" for the int8 GRU
+ * suppressor of nn_suppressor.h, which loads model_file. */
+
 int noise_reduction_init(noise_reduction_context_t **ctx, const noise_reduction_config_t *config);
 int noise_reduction_process(noise_reduction_context_t *ctx, int16_t *input, int16_t *output, size_t samples);
 int noise_reduction_cleanup(noise_reduction_context_t *ctx);
 
 int noise_reduction_update_noise_profile(noise_reduction_context_t *ctx, int16_t *noise_samples, size_t samples);
 int noise_reduction_set_threshold(noise_reduction_context_t *ctx, float threshold);
+int noise_reduction_get_latency(noise_reduction_context_t *ctx);
+int noise_reduction_get_noise_psd(noise_reduction_context_t *ctx, float *psd, int bins);
+
+/* RMS of the input and of the output, as fractions of full scale, over all
+ * samples processed since the previous call. */
+int noise_reduction_read_energy(noise_reduction_context_t *ctx, float *input_rms, float *output_rms);
 
 #ifdef __cplusplus
 }
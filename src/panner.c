@@ -0,0 +1,180 @@
+#define _GNU_SOURCE
+#include "panner.h"
+#include "simd.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define HEAD_RADIUS 0.0875f
+#define SPEED_OF_SOUND 343.0f
+#define MAX_ILD_DB 10.0f
+
+struct panner_context {
+    panner_config_t config;
+    
+    /* The last `history` input samples followed by the current block, so
+     * a delayed read never has to wrap. */
+    float *line;
+    int history;
+    
+    float gain[2];
+    float delay[2];
+    bool primed;
+};
+
+int panner_init(panner_context_t **ctx, const panner_config_t *config) {
+    if (!ctx || !config || config->sample_rate <= 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(panner_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    (*ctx)->config = *config;
+    
+    /* Woodworth's ITD for a source at 90 degrees, plus the sample the
+     * interpolation reads past the integer delay. */
+    float max_itd = HEAD_RADIUS / SPEED_OF_SOUND * (M_PI / 2.0f + 1.0f) * config->sample_rate;
+    int history = (int)ceilf(max_itd) + 2;
+    (*ctx)->history = (history + SIMD_LANES - 1) / SIMD_LANES * SIMD_LANES;
+    
+    float4_t *line = simd_alloc(((*ctx)->history + MAX_BUFFER_SIZE) / SIMD_LANES);
+    if (!line) {
+        free(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    (*ctx)->line = (float*)line;
+    
+    return MICARRAY_SUCCESS;
+}
+
+int panner_cleanup(panner_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    free(ctx->line);
+    free(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int panner_reset(panner_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    memset(ctx->line, 0, ctx->history * sizeof(float));
+    ctx->primed = false;
+    
+    return MICARRAY_SUCCESS;
+}
+
+/* Lateral angle from the median plane drives both cues: the far ear lags
+ * by Woodworth's spherical-head ITD and loses up to MAX_ILD_DB. Distance
+ * attenuation matches the gain panner's. */
+static void compute_targets(const panner_context_t *ctx, const sound_location_t *location, float volume,
+                            float *gain, float *delay) {
+    float distance = sqrtf(location->x * location->x + location->y * location->y + location->z * location->z);
+    float lateral = distance > 0.0f ? asinf(fmaxf(-1.0f, fminf(1.0f, location->y / distance))) : 0.0f;
+    float side = fabsf(lateral);
+    
+    float itd = HEAD_RADIUS / SPEED_OF_SOUND * (side + sinf(side)) * ctx->config.sample_rate;
+    float far_gain = powf(10.0f, -MAX_ILD_DB * sinf(side) / 20.0f);
+    
+    float planar = sqrtf(location->x * location->x + location->y * location->y);
+    float attenuation = fmaxf(0.1f, fminf(1.0f, 1.0f / (1.0f + planar * 0.1f)));
+    float level = volume * attenuation;
+    
+    int far = lateral > 0.0f ? 1 : 0;
+    gain[far] = level * far_gain;
+    gain[1 - far] = level;
+    delay[far] = itd;
+    delay[1 - far] = 0.0f;
+}
+
+static inline float4_t load4(const float *p) {
+    float4_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline int16_t to_sample(float value) {
+    value += (value < 0.0f) ? -0.5f : 0.5f;
+    value = fmaxf(-32768.0f, fminf(32767.0f, value));
+    return (int16_t)value;
+}
+
+/* Renders one ear. A steady delay is a fixed two-tap interpolation over
+ * contiguous samples and runs a vector at a time; a moving delay is
+ * resolved per sample. The gain always ramps linearly. */
+static void render_ear(const panner_context_t *ctx, int ear, float gain0, float gain1, float delay0,
+                       float delay1, int16_t *stereo, size_t frames) {
+    const float *x = ctx->line + ctx->history;
+    const float gain_step = (gain1 - gain0) / frames;
+    size_t j = 0;
+    
+    if (delay0 == delay1) {
+        const int whole = (int)delay1;
+        const float frac = delay1 - whole;
+        const float4_t lane = {1.0f, 2.0f, 3.0f, 4.0f};
+        
+        for (; j + SIMD_LANES <= frames; j += SIMD_LANES) {
+            float4_t a = load4(x + j - whole);
+            float4_t b = load4(x + j - whole - 1);
+            float4_t gain = gain0 + gain_step * (lane + (float)j);
+            float4_t y = (a + frac * (b - a)) * gain;
+            for (int k = 0; k < SIMD_LANES; k++) {
+                stereo[2 * (j + k) + ear] = to_sample(y[k]);
+            }
+        }
+    }
+    
+    const float delay_step = (delay1 - delay0) / frames;
+    for (; j < frames; j++) {
+        float delay = delay0 + delay_step * (j + 1);
+        int whole = (int)delay;
+        float frac = delay - whole;
+        float a = x[(long)j - whole];
+        float b = x[(long)j - whole - 1];
+        stereo[2 * j + ear] = to_sample((a + frac * (b - a)) * (gain0 + gain_step * (j + 1)));
+    }
+}
+
+int panner_render(panner_context_t *ctx, const int16_t *mono, const sound_location_t *location,
+                  float volume, int16_t *stereo, size_t frames) {
+    if (!ctx || !mono || !location || !stereo || frames == 0 || frames > MAX_BUFFER_SIZE) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    float gain[2], delay[2];
+    compute_targets(ctx, location, volume, gain, delay);
+    if (!ctx->primed) {
+        memcpy(ctx->gain, gain, sizeof(gain));
+        memcpy(ctx->delay, delay, sizeof(delay));
+        ctx->primed = true;
+    }
+    
+    float *x = ctx->line + ctx->history;
+    for (size_t j = 0; j < frames; j++) {
+        x[j] = mono[j];
+    }
+    
+    for (int ear = 0; ear < 2; ear++) {
+        render_ear(ctx, ear, ctx->gain[ear], gain[ear], ctx->delay[ear], delay[ear], stereo, frames);
+        ctx->gain[ear] = gain[ear];
+        ctx->delay[ear] = delay[ear];
+    }
+    
+    memmove(ctx->line, x + frames - ctx->history, ctx->history * sizeof(float));
+    
+    return MICARRAY_SUCCESS;
+}
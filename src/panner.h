@@ -0,0 +1,36 @@
+#ifndef PANNER_H
+#define PANNER_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct panner_context panner_context_t;
+
+typedef struct {
+    int sample_rate;
+} panner_config_t;
+
+int panner_init(panner_context_t **ctx, const panner_config_t *config);
+int panner_cleanup(panner_context_t *ctx);
+
+/* Places mono[0..frames) at location in interleaved stereo, frames up to
+ * MAX_BUFFER_SIZE. The far ear is delayed by the interaural time
+ * difference and attenuated by the level difference; delays and gains
+ * ramp from the previous call's values across the block. y > 0 is to the
+ * listener's left, as in sound_location_t. Confidence does not affect the
+ * level. Does not allocate. */
+int panner_render(panner_context_t *ctx, const int16_t *mono, const sound_location_t *location,
+                  float volume, int16_t *stereo, size_t frames);
+
+/* Restarts from silence with no ramp, e.g. after a gap in the stream. */
+int panner_reset(panner_context_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,93 @@
+#define _GNU_SOURCE
+#include "perf_counters.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+struct perf_counters_context {
+    int fds[PERF_COUNTER_COUNT];
+    int slot[PERF_COUNTER_COUNT];
+    int members;
+};
+
+static const uint64_t event_configs[PERF_COUNTER_COUNT] = {
+    [PERF_COUNTER_CYCLES] = PERF_COUNT_HW_CPU_CYCLES,
+    [PERF_COUNTER_INSTRUCTIONS] = PERF_COUNT_HW_INSTRUCTIONS,
+    [PERF_COUNTER_CACHE_MISSES] = PERF_COUNT_HW_CACHE_MISSES,
+    [PERF_COUNTER_BRANCH_MISSES] = PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static int open_event(uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+int perf_counters_init(perf_counters_context_t **ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(perf_counters_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    /* Cycles lead the group, so every member is scheduled with them. */
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        int group_fd = i == PERF_COUNTER_CYCLES ? -1 : (*ctx)->fds[PERF_COUNTER_CYCLES];
+        (*ctx)->fds[i] = open_event(event_configs[i], group_fd);
+        (*ctx)->slot[i] = (*ctx)->fds[i] >= 0 ? (*ctx)->members++ : -1;
+        
+        if (i == PERF_COUNTER_CYCLES && (*ctx)->fds[i] < 0) {
+            free(*ctx);
+            *ctx = NULL;
+            return MICARRAY_ERROR_INIT;
+        }
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int perf_counters_cleanup(perf_counters_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    for (int i = PERF_COUNTER_COUNT - 1; i >= 0; i--) {
+        if (ctx->fds[i] >= 0) {
+            close(ctx->fds[i]);
+        }
+    }
+    free(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int perf_counters_read(perf_counters_context_t *ctx, uint64_t values[PERF_COUNTER_COUNT]) {
+    if (!ctx || !values) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    /* PERF_FORMAT_GROUP: the member count, then one value per member. */
+    uint64_t group[1 + PERF_COUNTER_COUNT];
+    ssize_t size = read(ctx->fds[PERF_COUNTER_CYCLES], group, sizeof(group));
+    if (size < (ssize_t)((1 + ctx->members) * sizeof(uint64_t))) {
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        values[i] = ctx->slot[i] >= 0 ? group[1 + ctx->slot[i]] : 0;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
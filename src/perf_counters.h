@@ -0,0 +1,35 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PERF_COUNTER_CYCLES = 0,
+    PERF_COUNTER_INSTRUCTIONS,
+    PERF_COUNTER_CACHE_MISSES,
+    PERF_COUNTER_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+} perf_counter_t;
+
+typedef struct perf_counters_context perf_counters_context_t;
+
+/* Opens one perf_event group counting user-space events of the calling
+ * thread only. Events the PMU lacks are left out and read as 0; fails with
+ * MICARRAY_ERROR_INIT when not even cycles can be counted, as without a
+ * PMU, under a restrictive perf_event_paranoid or inside a seccomp jail. */
+int perf_counters_init(perf_counters_context_t **ctx);
+int perf_counters_cleanup(perf_counters_context_t *ctx);
+
+/* Running totals of every event, taken with a single read() of the group. */
+int perf_counters_read(perf_counters_context_t *ctx, uint64_t values[PERF_COUNTER_COUNT]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,182 @@
+#define _GNU_SOURCE
+#include "prefilter.h"
+#include "simd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define PREFILTER_CHUNK 64
+
+typedef struct {
+    float b0, b1, b2;
+    float a1, a2;
+} biquad_t;
+
+/* Channels are the vector lanes: a chunk of frames is transposed into
+ * work[frame][vectors] so every section updates all channels with a few
+ * vector operations, and the state of section s lives in
+ * z1/z2[s * vectors]. */
+struct prefilter_context {
+    prefilter_config_t config;
+    biquad_t sections[PREFILTER_MAX_SECTIONS];
+    int num_sections;
+    int vectors;
+    
+    float4_t *z1;
+    float4_t *z2;
+    float4_t *work;
+};
+
+static biquad_t design_dc_blocker(float cutoff, int sample_rate) {
+    float r = expf(-2.0f * (float)M_PI * cutoff / sample_rate);
+    float g = 0.5f * (1.0f + r);
+    biquad_t q = { g, -g, 0.0f, -r, 0.0f };
+    return q;
+}
+
+static biquad_t design_butterworth(float cutoff, int sample_rate, bool highpass) {
+    float w0 = 2.0f * (float)M_PI * cutoff / sample_rate;
+    float cw = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * (float)M_SQRT1_2);
+    float a0 = 1.0f + alpha;
+    float b = highpass ? (1.0f + cw) : (1.0f - cw);
+    
+    biquad_t q;
+    q.b0 = 0.5f * b / a0;
+    q.b1 = (highpass ? -b : b) / a0;
+    q.b2 = q.b0;
+    q.a1 = -2.0f * cw / a0;
+    q.a2 = (1.0f - alpha) / a0;
+    return q;
+}
+
+int prefilter_init(prefilter_context_t **ctx, const prefilter_config_t *config) {
+    if (!ctx || !config || config->num_channels < 1 || config->num_channels > MAX_MICROPHONES ||
+        config->sample_rate <= 0) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    const float nyquist = config->sample_rate / 2.0f;
+    if (config->highpass_hz < 0.0f || config->highpass_hz >= nyquist ||
+        config->lowpass_hz < 0.0f || config->lowpass_hz >= nyquist ||
+        (config->highpass_hz > 0.0f && config->lowpass_hz > 0.0f &&
+         config->lowpass_hz <= config->highpass_hz)) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(prefilter_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    (*ctx)->config = *config;
+    
+    if (config->dc_removal) {
+        (*ctx)->sections[(*ctx)->num_sections++] = design_dc_blocker(PREFILTER_DC_HZ, config->sample_rate);
+    }
+    if (config->highpass_hz > 0.0f) {
+        (*ctx)->sections[(*ctx)->num_sections++] = design_butterworth(config->highpass_hz, config->sample_rate, true);
+    }
+    if (config->lowpass_hz > 0.0f) {
+        (*ctx)->sections[(*ctx)->num_sections++] = design_butterworth(config->lowpass_hz, config->sample_rate, false);
+    }
+    
+    (*ctx)->vectors = (config->num_channels + SIMD_LANES - 1) / SIMD_LANES;
+    
+    (*ctx)->z1 = simd_alloc((size_t)PREFILTER_MAX_SECTIONS * (*ctx)->vectors);
+    (*ctx)->z2 = simd_alloc((size_t)PREFILTER_MAX_SECTIONS * (*ctx)->vectors);
+    (*ctx)->work = simd_alloc((size_t)PREFILTER_CHUNK * (*ctx)->vectors);
+    
+    if (!(*ctx)->z1 || !(*ctx)->z2 || !(*ctx)->work) {
+        prefilter_cleanup(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int prefilter_cleanup(prefilter_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    free(ctx->z1);
+    free(ctx->z2);
+    free(ctx->work);
+    free(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+/* Transposed direct form II over one frame of every channel. The padding
+ * lanes only ever see zeros. */
+static void run_section(const biquad_t *q, float4_t *x, float4_t *z1, float4_t *z2, int vectors) {
+    const float b0 = q->b0, b1 = q->b1, b2 = q->b2, a1 = q->a1, a2 = q->a2;
+    
+    for (int v = 0; v < vectors; v++) {
+        float4_t in = x[v];
+        float4_t y = b0 * in + z1[v];
+        z1[v] = b1 * in - a1 * y + z2[v];
+        z2[v] = b2 * in - a2 * y;
+        x[v] = y;
+    }
+}
+
+int prefilter_process(prefilter_context_t *ctx, int16_t **channels, size_t frames) {
+    if (!ctx || !channels) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    if (ctx->num_sections == 0) {
+        return MICARRAY_SUCCESS;
+    }
+    
+    const int num_channels = ctx->config.num_channels;
+    const int vectors = ctx->vectors;
+    const int stride = vectors * SIMD_LANES;
+    float *work = (float*)ctx->work;
+    
+    for (size_t done = 0; done < frames; done += PREFILTER_CHUNK) {
+        size_t n = frames - done;
+        if (n > PREFILTER_CHUNK) {
+            n = PREFILTER_CHUNK;
+        }
+        
+        for (int c = 0; c < num_channels; c++) {
+            const int16_t *src = channels[c] + done;
+            for (size_t j = 0; j < n; j++) {
+                work[j * stride + c] = src[j];
+            }
+        }
+        
+        for (size_t j = 0; j < n; j++) {
+            float4_t *x = ctx->work + j * vectors;
+            for (int s = 0; s < ctx->num_sections; s++) {
+                run_section(&ctx->sections[s], x, ctx->z1 + s * vectors, ctx->z2 + s * vectors, vectors);
+            }
+        }
+        
+        for (int c = 0; c < num_channels; c++) {
+            int16_t *dst = channels[c] + done;
+            for (size_t j = 0; j < n; j++) {
+                float y = work[j * stride + c];
+                y += (y < 0.0f) ? -0.5f : 0.5f;
+                y = fmaxf(-32768.0f, fminf(32767.0f, y));
+                dst[j] = (int16_t)y;
+            }
+        }
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int prefilter_get_num_sections(const prefilter_context_t *ctx) {
+    return ctx ? ctx->num_sections : 0;
+}
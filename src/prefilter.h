@@ -0,0 +1,39 @@
+#ifndef PREFILTER_H
+#define PREFILTER_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PREFILTER_MAX_SECTIONS 3
+#define PREFILTER_DC_HZ 10.0f
+
+typedef struct prefilter_context prefilter_context_t;
+
+/* Each enabled stage is one biquad of the cascade: a one-pole DC blocker,
+ * a Butterworth high-pass at highpass_hz and a Butterworth low-pass at
+ * lowpass_hz. A cutoff of 0 leaves that stage out. */
+typedef struct {
+    int num_channels;
+    int sample_rate;
+    bool dc_removal;
+    float highpass_hz;
+    float lowpass_hz;
+} prefilter_config_t;
+
+int prefilter_init(prefilter_context_t **ctx, const prefilter_config_t *config);
+int prefilter_cleanup(prefilter_context_t *ctx);
+
+/* Filters channels[c][0..frames) in place, all channels in one pass. */
+int prefilter_process(prefilter_context_t *ctx, int16_t **channels, size_t frames);
+int prefilter_get_num_sections(const prefilter_context_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,450 @@
+#define _GNU_SOURCE
+#include "recorder.h"
+#include "wav.h"
+#include "lossless.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#define RECORDER_PAGE 4096
+#define RECORDER_CHUNK_SECONDS 0.25f
+#define RECORDER_WAKE_NS 50000000L
+
+struct recorder_context {
+    recorder_config_t config;
+    
+    /* Interleaved frames; frame n lives in slot n % capacity. capacity and
+     * chunk_frames are whole multiples of align_frames, so chunks start on
+     * page boundaries in the ring and, after the page-sized header, in the
+     * file too. */
+    int16_t *ring;
+    uint64_t capacity;
+    uint64_t align_frames;
+    uint64_t chunk_frames;
+    float trigger_power;
+    lossless_writer_t *encoder;
+    
+    /* Written by the capture side, read by the writer. */
+    uint64_t write_pos;
+    int trigger_requested;
+    int stop_requested;
+    
+    /* Owned by the writer thread. */
+    int fd;
+    uint64_t read_pos;
+    uint64_t stop_pos;
+    uint64_t file_bytes;
+    
+    bool recording;
+    uint64_t files;
+    uint64_t frames_written;
+    uint64_t frames_dropped;
+    uint64_t write_errors;
+    
+    bool shutdown;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+static uint64_t gcd(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static void open_file(recorder_context_t *ctx, uint64_t head) {
+    char stamp[32];
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+    
+    char path[512];
+    snprintf(path, sizeof(path), "%s/micarray-%s-%llu.%s", ctx->config.directory, stamp,
+             (unsigned long long)ctx->files, ctx->encoder ? "mla" : "wav");
+    
+    ctx->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (ctx->fd < 0) {
+        __atomic_add_fetch(&ctx->write_errors, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    
+    int result = MICARRAY_SUCCESS;
+    if (ctx->encoder) {
+        result = lossless_writer_begin(ctx->encoder, ctx->fd);
+    } else {
+        uint8_t header[RECORDER_PAGE];
+        wav_build_header(header, sizeof(header), ctx->config.num_channels, ctx->config.sample_rate, 0);
+        if (pwrite(ctx->fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+            result = MICARRAY_ERROR_AUDIO_OUTPUT;
+        }
+    }
+    
+    if (result != MICARRAY_SUCCESS) {
+        __atomic_add_fetch(&ctx->write_errors, 1, __ATOMIC_RELAXED);
+        close(ctx->fd);
+        ctx->fd = -1;
+        return;
+    }
+    
+    /* Start on an aligned frame, which costs at most a few extra frames of
+     * pre-trigger audio. */
+    uint64_t pre = (uint64_t)ctx->config.pre_trigger_frames;
+    uint64_t start = head > pre ? head - pre : 0;
+    ctx->read_pos = start - start % ctx->align_frames;
+    ctx->file_bytes = 0;
+    
+    __atomic_add_fetch(&ctx->files, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&ctx->recording, true, __ATOMIC_RELAXED);
+}
+
+static void close_file(recorder_context_t *ctx) {
+    if (ctx->encoder) {
+        if (lossless_writer_finish(ctx->encoder) != MICARRAY_SUCCESS) {
+            __atomic_add_fetch(&ctx->write_errors, 1, __ATOMIC_RELAXED);
+        }
+    } else {
+        uint8_t header[RECORDER_PAGE];
+        wav_build_header(header, sizeof(header), ctx->config.num_channels, ctx->config.sample_rate, ctx->file_bytes);
+        if (pwrite(ctx->fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+            ftruncate(ctx->fd, RECORDER_PAGE + (off_t)ctx->file_bytes) != 0) {
+            __atomic_add_fetch(&ctx->write_errors, 1, __ATOMIC_RELAXED);
+        }
+    }
+    
+    close(ctx->fd);
+    ctx->fd = -1;
+    __atomic_store_n(&ctx->recording, false, __ATOMIC_RELAXED);
+}
+
+/* One gathered write of frames [read_pos, read_pos + count), which wraps
+ * at most once. The lossless encoder compresses on its own workers while
+ * this thread waits, so the capture side never sees the cost. */
+static int write_frames(recorder_context_t *ctx, uint64_t count) {
+    const size_t frame_bytes = (size_t)ctx->config.num_channels * sizeof(int16_t);
+    uint64_t start = ctx->read_pos % ctx->capacity;
+    uint64_t first = count < ctx->capacity - start ? count : ctx->capacity - start;
+    
+    if (ctx->encoder) {
+        const int16_t *frames = ctx->ring + start * ctx->config.num_channels;
+        if (lossless_writer_write(ctx->encoder, frames, first) != MICARRAY_SUCCESS ||
+            (count > first && lossless_writer_write(ctx->encoder, ctx->ring, count - first) != MICARRAY_SUCCESS)) {
+            return -1;
+        }
+        return 0;
+    }
+    
+    struct iovec iov[2] = {
+        { ctx->ring + start * ctx->config.num_channels, first * frame_bytes },
+        { ctx->ring, (count - first) * frame_bytes }
+    };
+    int iovcnt = count > first ? 2 : 1;
+    
+    off_t offset = RECORDER_PAGE + (off_t)ctx->file_bytes;
+    size_t remaining = count * frame_bytes;
+    while (remaining > 0) {
+        ssize_t written = pwritev(ctx->fd, iov, iovcnt, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        
+        offset += written;
+        remaining -= written;
+        for (int i = 0; i < iovcnt && written > 0; i++) {
+            size_t used = (size_t)written < iov[i].iov_len ? (size_t)written : iov[i].iov_len;
+            iov[i].iov_base = (uint8_t*)iov[i].iov_base + used;
+            iov[i].iov_len -= used;
+            written -= used;
+        }
+    }
+    
+    ctx->file_bytes += count * frame_bytes;
+    return 0;
+}
+
+/* A writer so far behind that the capture side could overwrite what it is
+ * about to read skips ahead to an aligned frame and counts the gap. */
+static void skip_ahead(recorder_context_t *ctx, uint64_t head) {
+    const uint64_t limit = ctx->capacity - MAX_BUFFER_SIZE;
+    if (head - ctx->read_pos > limit) {
+        uint64_t skip = head - ctx->read_pos - limit;
+        skip += ctx->align_frames - 1 - (ctx->read_pos + skip + ctx->align_frames - 1) % ctx->align_frames;
+        __atomic_add_fetch(&ctx->frames_dropped, skip, __ATOMIC_RELAXED);
+        ctx->read_pos += skip;
+    }
+}
+
+/* Handles requests and drains whole chunks; a stop, or closing, flushes
+ * the remainder. The ring is checked again after every chunk, since the
+ * capture side keeps going while a write stalls. */
+static void service(recorder_context_t *ctx, bool closing) {
+    uint64_t head = __atomic_load_n(&ctx->write_pos, __ATOMIC_ACQUIRE);
+    
+    if (__atomic_exchange_n(&ctx->trigger_requested, 0, __ATOMIC_ACQ_REL)) {
+        if (ctx->fd < 0) {
+            open_file(ctx, head);
+        }
+        ctx->stop_pos = ctx->config.post_trigger_frames > 0 ? head + ctx->config.post_trigger_frames : UINT64_MAX;
+    }
+    
+    if (ctx->fd < 0) {
+        __atomic_store_n(&ctx->stop_requested, 0, __ATOMIC_RELAXED);
+        return;
+    }
+    
+    if (__atomic_exchange_n(&ctx->stop_requested, 0, __ATOMIC_ACQ_REL) || closing) {
+        if (ctx->stop_pos > head) {
+            ctx->stop_pos = head;
+        }
+    }
+    
+    skip_ahead(ctx, head);
+    
+    const uint64_t limit = ctx->capacity - MAX_BUFFER_SIZE;
+    const size_t frame_bytes = (size_t)ctx->config.num_channels * sizeof(int16_t);
+    uint64_t end = head < ctx->stop_pos ? head : ctx->stop_pos;
+    while (ctx->read_pos < end && (end - ctx->read_pos >= ctx->chunk_frames || end == ctx->stop_pos)) {
+        uint64_t count = end - ctx->read_pos;
+        if (count > ctx->chunk_frames) {
+            count = ctx->chunk_frames;
+        }
+        
+        uint64_t first = ctx->read_pos;
+        if (write_frames(ctx, count) != 0) {
+            __atomic_add_fetch(&ctx->write_errors, 1, __ATOMIC_RELAXED);
+            close_file(ctx);
+            return;
+        }
+        ctx->read_pos += count;
+        
+        /* If the capture side lapped the chunk while it was being written,
+         * part of it is newer audio: count it as dropped, and for WAV let
+         * the next chunk overwrite it. The lossless encoder has already
+         * taken it, so it stays in that stream. */
+        head = __atomic_load_n(&ctx->write_pos, __ATOMIC_ACQUIRE);
+        if (head - first > limit) {
+            __atomic_add_fetch(&ctx->frames_dropped, count, __ATOMIC_RELAXED);
+            if (!ctx->encoder) {
+                ctx->file_bytes -= count * frame_bytes;
+            }
+            skip_ahead(ctx, head);
+            end = head < ctx->stop_pos ? head : ctx->stop_pos;
+        } else {
+            __atomic_add_fetch(&ctx->frames_written, count, __ATOMIC_RELAXED);
+        }
+    }
+    
+    if (ctx->read_pos >= ctx->stop_pos) {
+        close_file(ctx);
+    }
+}
+
+static void* writer_thread_func(void *arg) {
+    recorder_context_t *ctx = (recorder_context_t*)arg;
+    
+    pthread_mutex_lock(&ctx->mutex);
+    while (!ctx->shutdown) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += RECORDER_WAKE_NS;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_nsec -= 1000000000L;
+            deadline.tv_sec++;
+        }
+        pthread_cond_timedwait(&ctx->cond, &ctx->mutex, &deadline);
+        
+        pthread_mutex_unlock(&ctx->mutex);
+        service(ctx, false);
+        pthread_mutex_lock(&ctx->mutex);
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+    
+    service(ctx, true);
+    return NULL;
+}
+
+int recorder_init(recorder_context_t **ctx, const recorder_config_t *config) {
+    if (!ctx || !config || config->num_channels < 1 || config->num_channels > MAX_MICROPHONES ||
+        config->sample_rate <= 0 || config->pre_trigger_frames < 0 || config->post_trigger_frames < 0 ||
+        config->directory[0] == '\0' || config->format > RECORDER_FORMAT_LOSSLESS) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *ctx = calloc(1, sizeof(recorder_context_t));
+    if (!*ctx) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    (*ctx)->config = *config;
+    (*ctx)->fd = -1;
+    
+    const uint64_t frame_bytes = (uint64_t)config->num_channels * sizeof(int16_t);
+    const uint64_t align = RECORDER_PAGE / gcd(RECORDER_PAGE, frame_bytes);
+    uint64_t chunk = (uint64_t)(config->sample_rate * RECORDER_CHUNK_SECONDS);
+    
+    /* The pre-trigger audio, a second of slack for the writer and room for
+     * the block being pushed while it reads. */
+    uint64_t capacity = (uint64_t)config->pre_trigger_frames + config->sample_rate + MAX_BUFFER_SIZE + chunk;
+    (*ctx)->align_frames = align;
+    (*ctx)->chunk_frames = (chunk + align - 1) / align * align;
+    (*ctx)->capacity = (capacity + align - 1) / align * align;
+    
+    if (config->trigger_level_db < 0.0f) {
+        float level = 32768.0f * powf(10.0f, config->trigger_level_db / 20.0f);
+        (*ctx)->trigger_power = level * level;
+    }
+    
+    void *ring = NULL;
+    if (posix_memalign(&ring, RECORDER_PAGE, (*ctx)->capacity * frame_bytes) != 0) {
+        free(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_MEMORY;
+    }
+    (*ctx)->ring = ring;
+    
+    if (pthread_mutex_init(&(*ctx)->mutex, NULL) != 0) {
+        free((*ctx)->ring);
+        free(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    if (pthread_cond_init(&(*ctx)->cond, NULL) != 0) {
+        pthread_mutex_destroy(&(*ctx)->mutex);
+        free((*ctx)->ring);
+        free(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    if (config->format == RECORDER_FORMAT_LOSSLESS) {
+        lossless_config_t encoder_config = {
+            .channels = config->num_channels,
+            .sample_rate = config->sample_rate,
+            .block_frames = LOSSLESS_DEFAULT_BLOCK
+        };
+        
+        int result = lossless_writer_init(&(*ctx)->encoder, &encoder_config);
+        if (result != MICARRAY_SUCCESS) {
+            pthread_cond_destroy(&(*ctx)->cond);
+            pthread_mutex_destroy(&(*ctx)->mutex);
+            free((*ctx)->ring);
+            free(*ctx);
+            *ctx = NULL;
+            return result;
+        }
+    }
+    
+    if (pthread_create(&(*ctx)->thread, NULL, writer_thread_func, *ctx) != 0) {
+        if ((*ctx)->encoder) {
+            lossless_writer_cleanup((*ctx)->encoder);
+        }
+        pthread_cond_destroy(&(*ctx)->cond);
+        pthread_mutex_destroy(&(*ctx)->mutex);
+        free((*ctx)->ring);
+        free(*ctx);
+        *ctx = NULL;
+        return MICARRAY_ERROR_INIT;
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int recorder_cleanup(recorder_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&ctx->mutex);
+    ctx->shutdown = true;
+    pthread_cond_signal(&ctx->cond);
+    pthread_mutex_unlock(&ctx->mutex);
+    pthread_join(ctx->thread, NULL);
+    
+    pthread_cond_destroy(&ctx->cond);
+    pthread_mutex_destroy(&ctx->mutex);
+    if (ctx->encoder) {
+        lossless_writer_cleanup(ctx->encoder);
+    }
+    free(ctx->ring);
+    free(ctx);
+    
+    return MICARRAY_SUCCESS;
+}
+
+int recorder_push(recorder_context_t *ctx, int16_t *const *channels, size_t frames) {
+    if (!ctx || !channels || frames == 0 || frames > MAX_BUFFER_SIZE) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    const int num_channels = ctx->config.num_channels;
+    const uint64_t head = ctx->write_pos;
+    uint64_t slot = head % ctx->capacity;
+    float energy = 0.0f;
+    
+    for (size_t j = 0; j < frames; j++) {
+        int16_t *frame = ctx->ring + slot * num_channels;
+        for (int c = 0; c < num_channels; c++) {
+            int16_t sample = channels[c][j];
+            frame[c] = sample;
+            energy += (float)sample * sample;
+        }
+        if (++slot == ctx->capacity) {
+            slot = 0;
+        }
+    }
+    
+    __atomic_store_n(&ctx->write_pos, head + frames, __ATOMIC_RELEASE);
+    
+    if (ctx->trigger_power > 0.0f && energy >= ctx->trigger_power * frames * num_channels) {
+        __atomic_store_n(&ctx->trigger_requested, 1, __ATOMIC_RELEASE);
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int recorder_trigger(recorder_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    __atomic_store_n(&ctx->trigger_requested, 1, __ATOMIC_RELEASE);
+    return MICARRAY_SUCCESS;
+}
+
+int recorder_stop(recorder_context_t *ctx) {
+    if (!ctx) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    __atomic_store_n(&ctx->stop_requested, 1, __ATOMIC_RELEASE);
+    return MICARRAY_SUCCESS;
+}
+
+int recorder_get_stats(recorder_context_t *ctx, recorder_stats_t *stats) {
+    if (!ctx || !stats) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    stats->recording = __atomic_load_n(&ctx->recording, __ATOMIC_RELAXED);
+    stats->files = __atomic_load_n(&ctx->files, __ATOMIC_RELAXED);
+    stats->frames_written = __atomic_load_n(&ctx->frames_written, __ATOMIC_RELAXED);
+    stats->frames_dropped = __atomic_load_n(&ctx->frames_dropped, __ATOMIC_RELAXED);
+    stats->write_errors = __atomic_load_n(&ctx->write_errors, __ATOMIC_RELAXED);
+    
+    return MICARRAY_SUCCESS;
+}
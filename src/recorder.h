@@ -0,0 +1,59 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include "libmicarray.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct recorder_context recorder_context_t;
+
+typedef enum {
+    RECORDER_FORMAT_WAV = 0,
+    RECORDER_FORMAT_LOSSLESS
+} recorder_format_t;
+
+/* A level trigger of 0 dBFS or more is off, as is a post-trigger length of
+ * 0, which records until recorder_stop(). */
+typedef struct {
+    int num_channels;
+    int sample_rate;
+    char directory[256];
+    recorder_format_t format;
+    int pre_trigger_frames;
+    int post_trigger_frames;
+    float trigger_level_db;
+} recorder_config_t;
+
+typedef struct {
+    bool recording;
+    uint64_t files;
+    uint64_t frames_written;
+    uint64_t frames_dropped;
+    uint64_t write_errors;
+} recorder_stats_t;
+
+/* Starts the background writer thread. */
+int recorder_init(recorder_context_t **ctx, const recorder_config_t *config);
+int recorder_cleanup(recorder_context_t *ctx);
+
+/* Interleaves channels[0..num_channels)[0..frames) into the ring, frames up
+ * to MAX_BUFFER_SIZE, and checks the level trigger on the way. Never blocks
+ * or allocates: the writer thread drains the ring to disk. */
+int recorder_push(recorder_context_t *ctx, int16_t *const *channels, size_t frames);
+
+/* Starts a file with the last pre_trigger_frames of input, or extends the
+ * current one by post_trigger_frames. Both only set a flag for the writer,
+ * so they are safe from any thread and from signal handlers. */
+int recorder_trigger(recorder_context_t *ctx);
+int recorder_stop(recorder_context_t *ctx);
+
+int recorder_get_stats(recorder_context_t *ctx, recorder_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,32 @@
+#define _GNU_SOURCE
+#include "simd.h"
+#include <stdlib.h>
+#include <string.h>
+
+float4_t* simd_alloc(size_t count) {
+    void *ptr = NULL;
+    if (count == 0 || posix_memalign(&ptr, sizeof(float4_t), count * sizeof(float4_t)) != 0) {
+        return NULL;
+    }
+    
+    memset(ptr, 0, count * sizeof(float4_t));
+    return ptr;
+}
+
+void simd_split_complex(const float *interleaved, float4_t *re, float4_t *im, int count) {
+    float *r = (float*)re;
+    float *i = (float*)im;
+    for (int k = 0; k < count; k++) {
+        r[k] = interleaved[2 * k];
+        i[k] = interleaved[2 * k + 1];
+    }
+}
+
+void simd_merge_complex(const float4_t *re, const float4_t *im, float *interleaved, int count) {
+    const float *r = (const float*)re;
+    const float *i = (const float*)im;
+    for (int k = 0; k < count; k++) {
+        interleaved[2 * k] = r[k];
+        interleaved[2 * k + 1] = i[k];
+    }
+}
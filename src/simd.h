@@ -0,0 +1,29 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Four floats per 128-bit vector; GCC and clang lower arithmetic on this
+ * type to SSE on x86 and NEON on ARM. */
+#define SIMD_LANES 4
+
+typedef float float4_t __attribute__((vector_size(SIMD_LANES * sizeof(float))));
+
+/* Zeroed and aligned for float4_t; release with free(). */
+float4_t* simd_alloc(size_t count);
+
+/* Converts between interleaved complex values (re, im, re, im, ...) and
+ * separate real and imaginary arrays, so bin loops can run a vector of
+ * bins at a time. */
+void simd_split_complex(const float *interleaved, float4_t *re, float4_t *im, int count);
+void simd_merge_complex(const float4_t *re, const float4_t *im, float *interleaved, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
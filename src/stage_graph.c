@@ -0,0 +1,325 @@
+#define _GNU_SOURCE
+#include "stage_graph.h"
+#include "simd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+
+#define MAX_REGISTERED_STAGES 32
+
+typedef struct {
+    const micarray_stage_t *stage;
+    void *state;
+    stage_pcm_process_t pcm;
+    stage_section_t section;
+} stage_node_t;
+
+struct stage_graph {
+    micarray_stage_format_t format;
+    stage_node_t nodes[MICARRAY_MAX_STAGES];
+    int num_nodes;
+    
+    /* Two sets of planar float buffers; current is where the block lives
+     * while it is in float, and an out-of-place stage writes to the other
+     * set before the two swap. */
+    float *storage[2][MAX_MICROPHONES];
+    float **current;
+    float **spare;
+    
+    perf_counters_context_t *counters;
+};
+
+static const micarray_stage_t *registry[MAX_REGISTERED_STAGES];
+static int registry_count;
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int stage_registry_add(const micarray_stage_t *stage) {
+    if (!stage || !stage->name || !stage->process || stage->name[0] == '\0' ||
+        strlen(stage->name) >= sizeof(((micarray_stage_stats_t*)0)->name)) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&registry_mutex);
+    int result = MICARRAY_SUCCESS;
+    for (int i = 0; i < registry_count; i++) {
+        if (strcmp(registry[i]->name, stage->name) == 0) {
+            result = MICARRAY_ERROR_INVALID_PARAM;
+        }
+    }
+    
+    if (result == MICARRAY_SUCCESS && registry_count == MAX_REGISTERED_STAGES) {
+        result = MICARRAY_ERROR_MEMORY;
+    }
+    
+    if (result == MICARRAY_SUCCESS) {
+        registry[registry_count++] = stage;
+    }
+    pthread_mutex_unlock(&registry_mutex);
+    
+    return result;
+}
+
+const micarray_stage_t* stage_registry_find(const char *name) {
+    const micarray_stage_t *found = NULL;
+    
+    pthread_mutex_lock(&registry_mutex);
+    for (int i = 0; i < registry_count && name; i++) {
+        if (strcmp(registry[i]->name, name) == 0) {
+            found = registry[i];
+        }
+    }
+    pthread_mutex_unlock(&registry_mutex);
+    
+    return found;
+}
+
+int stage_graph_init(stage_graph_t **graph, const micarray_stage_format_t *format) {
+    if (!graph || !format || format->num_channels < 1 || format->num_channels > MAX_MICROPHONES ||
+        format->sample_rate <= 0 || format->max_frames < 1 || format->max_frames > MAX_BUFFER_SIZE) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    *graph = calloc(1, sizeof(stage_graph_t));
+    if (!*graph) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    
+    (*graph)->format = *format;
+    (*graph)->current = (*graph)->storage[0];
+    (*graph)->spare = (*graph)->storage[1];
+    
+    return MICARRAY_SUCCESS;
+}
+
+int stage_graph_cleanup(stage_graph_t *graph) {
+    if (!graph) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    for (int i = 0; i < graph->num_nodes; i++) {
+        const micarray_stage_t *stage = graph->nodes[i].stage;
+        if (stage && stage->cleanup) {
+            stage->cleanup(graph->nodes[i].state);
+        }
+    }
+    
+    for (int s = 0; s < 2; s++) {
+        for (int c = 0; c < graph->format.num_channels; c++) {
+            free(graph->storage[s][c]);
+        }
+    }
+    free(graph);
+    
+    return MICARRAY_SUCCESS;
+}
+
+static stage_node_t* append_node(stage_graph_t *graph, const char *name) {
+    if (graph->num_nodes == MICARRAY_MAX_STAGES || strlen(name) >= sizeof(graph->nodes[0].section.stats.name)) {
+        return NULL;
+    }
+    
+    stage_node_t *node = &graph->nodes[graph->num_nodes];
+    memset(node, 0, sizeof(*node));
+    stage_section_init(&node->section, name);
+    return node;
+}
+
+int stage_graph_add_pcm(stage_graph_t *graph, const char *name, stage_pcm_process_t process, void *state) {
+    if (!graph || !name || !process) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    stage_node_t *node = append_node(graph, name);
+    if (!node) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    node->pcm = process;
+    node->state = state;
+    graph->num_nodes++;
+    
+    return MICARRAY_SUCCESS;
+}
+
+int stage_graph_add(stage_graph_t *graph, const micarray_stage_t *stage, const char *args) {
+    if (!graph || !stage || !stage->name || !stage->process) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    stage_node_t *node = append_node(graph, stage->name);
+    if (!node) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    /* Float buffers are only needed once there is a float stage; the
+     * spare set only once one of them is out of place. */
+    const int channels = graph->format.num_channels;
+    const size_t vectors = ((size_t)graph->format.max_frames + SIMD_LANES - 1) / SIMD_LANES;
+    int sets = (stage->flags & MICARRAY_STAGE_IN_PLACE) ? 1 : 2;
+    for (int s = 0; s < sets; s++) {
+        for (int c = 0; c < channels; c++) {
+            if (!graph->storage[s][c]) {
+                graph->storage[s][c] = (float*)simd_alloc(vectors);
+                if (!graph->storage[s][c]) {
+                    return MICARRAY_ERROR_MEMORY;
+                }
+            }
+        }
+    }
+    
+    if (stage->init) {
+        int result = stage->init(&node->state, &graph->format, args ? args : "");
+        if (result != MICARRAY_SUCCESS) {
+            return result;
+        }
+    }
+    
+    node->stage = stage;
+    graph->num_nodes++;
+    
+    return MICARRAY_SUCCESS;
+}
+
+static void to_float(int16_t **channels, float **out, int num_channels, size_t frames) {
+    const float scale = 1.0f / 32768.0f;
+    for (int c = 0; c < num_channels; c++) {
+        for (size_t j = 0; j < frames; j++) {
+            out[c][j] = channels[c][j] * scale;
+        }
+    }
+}
+
+static void to_pcm(float **in, int16_t **channels, int num_channels, size_t frames) {
+    for (int c = 0; c < num_channels; c++) {
+        for (size_t j = 0; j < frames; j++) {
+            float sample = in[c][j] * 32768.0f;
+            if (sample > 32767.0f) {
+                sample = 32767.0f;
+            } else if (sample < -32768.0f) {
+                sample = -32768.0f;
+            }
+            channels[c][j] = (int16_t)lrintf(sample);
+        }
+    }
+}
+
+void stage_section_init(stage_section_t *section, const char *name) {
+    memset(section, 0, sizeof(*section));
+    snprintf(section->stats.name, sizeof(section->stats.name), "%s", name);
+}
+
+/* Counters are read outside the timed span, so timing stays comparable
+ * with and without them. */
+void stage_section_begin(stage_section_t *section, perf_counters_context_t *counters) {
+    section->counted = counters && perf_counters_read(counters, section->before) == MICARRAY_SUCCESS;
+    section->start_ns = monotonic_ns();
+}
+
+void stage_section_end(stage_section_t *section, perf_counters_context_t *counters) {
+    uint64_t elapsed = monotonic_ns() - section->start_ns;
+    micarray_stage_stats_t *stats = &section->stats;
+    
+    uint64_t after[PERF_COUNTER_COUNT];
+    if (section->counted && perf_counters_read(counters, after) == MICARRAY_SUCCESS) {
+        stats->cycles += after[PERF_COUNTER_CYCLES] - section->before[PERF_COUNTER_CYCLES];
+        stats->instructions += after[PERF_COUNTER_INSTRUCTIONS] - section->before[PERF_COUNTER_INSTRUCTIONS];
+        stats->cache_misses += after[PERF_COUNTER_CACHE_MISSES] - section->before[PERF_COUNTER_CACHE_MISSES];
+        stats->branch_misses += after[PERF_COUNTER_BRANCH_MISSES] - section->before[PERF_COUNTER_BRANCH_MISSES];
+    }
+    
+    stats->calls++;
+    stats->last_ns = elapsed;
+    stats->total_ns += elapsed;
+    if (elapsed > stats->max_ns) {
+        stats->max_ns = elapsed;
+    }
+}
+
+int stage_graph_process(stage_graph_t *graph, int16_t **channels, size_t frames, uint32_t active_mask) {
+    if (!graph || !channels || frames == 0 || frames > (size_t)graph->format.max_frames) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    const int num_channels = graph->format.num_channels;
+    bool in_float = false;
+    
+    for (int i = 0; i < graph->num_nodes; i++) {
+        stage_node_t *node = &graph->nodes[i];
+        
+        if (node->pcm && in_float) {
+            to_pcm(graph->current, channels, num_channels, frames);
+            in_float = false;
+        } else if (node->stage && !in_float) {
+            to_float(channels, graph->current, num_channels, frames);
+            in_float = true;
+        }
+        
+        stage_section_begin(&node->section, graph->counters);
+        if (node->pcm) {
+            node->pcm(node->state, channels, frames, active_mask);
+        } else if (node->stage->flags & MICARRAY_STAGE_IN_PLACE) {
+            node->stage->process(node->state, graph->current, graph->current, frames, active_mask);
+        } else {
+            node->stage->process(node->state, graph->current, graph->spare, frames, active_mask);
+            float **swap = graph->current;
+            graph->current = graph->spare;
+            graph->spare = swap;
+        }
+        stage_section_end(&node->section, graph->counters);
+    }
+    
+    if (in_float) {
+        to_pcm(graph->current, channels, num_channels, frames);
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int stage_graph_reset(stage_graph_t *graph) {
+    if (!graph) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    for (int i = 0; i < graph->num_nodes; i++) {
+        const micarray_stage_t *stage = graph->nodes[i].stage;
+        if (stage && stage->reset) {
+            stage->reset(graph->nodes[i].state);
+        }
+    }
+    
+    return MICARRAY_SUCCESS;
+}
+
+int stage_graph_set_counters(stage_graph_t *graph, perf_counters_context_t *counters) {
+    if (!graph) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    graph->counters = counters;
+    
+    return MICARRAY_SUCCESS;
+}
+
+int stage_graph_get_stats(const stage_graph_t *graph, micarray_stage_stats_t *stats, int max_stages,
+                          int *num_stages) {
+    if (!graph || !num_stages || max_stages < 0 || (!stats && max_stages > 0)) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    int count = graph->num_nodes < max_stages ? graph->num_nodes : max_stages;
+    for (int i = 0; i < count; i++) {
+        stats[i] = graph->nodes[i].section.stats;
+    }
+    *num_stages = graph->num_nodes;
+    
+    return MICARRAY_SUCCESS;
+}
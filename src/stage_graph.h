@@ -0,0 +1,62 @@
+#ifndef STAGE_GRAPH_H
+#define STAGE_GRAPH_H
+
+#include "libmicarray.h"
+#include "perf_counters.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct stage_graph stage_graph_t;
+
+/* Timing and hardware counts of one piece of work, a stage or code run
+ * outside the graph. begin and end must be called on the same thread,
+ * and counters, when not NULL, must have been opened by that thread. */
+typedef struct {
+    micarray_stage_stats_t stats;
+    uint64_t start_ns;
+    uint64_t before[PERF_COUNTER_COUNT];
+    bool counted;
+} stage_section_t;
+
+void stage_section_init(stage_section_t *section, const char *name);
+void stage_section_begin(stage_section_t *section, perf_counters_context_t *counters);
+void stage_section_end(stage_section_t *section, perf_counters_context_t *counters);
+
+/* Built-in stages work on the int16 channel buffers directly. */
+typedef void (*stage_pcm_process_t)(void *state, int16_t **channels, size_t frames, uint32_t active_mask);
+
+/* Process-wide registry of custom stages, looked up by name. */
+int stage_registry_add(const micarray_stage_t *stage);
+const micarray_stage_t* stage_registry_find(const char *name);
+
+int stage_graph_init(stage_graph_t **graph, const micarray_stage_format_t *format);
+int stage_graph_cleanup(stage_graph_t *graph);
+
+/* Stages run in the order they are added, up to MICARRAY_MAX_STAGES. */
+int stage_graph_add_pcm(stage_graph_t *graph, const char *name, stage_pcm_process_t process, void *state);
+int stage_graph_add(stage_graph_t *graph, const micarray_stage_t *stage, const char *args);
+
+/* Runs every stage over channels in place. Consecutive float stages pass
+ * their buffers along without copying; samples are only converted where
+ * the graph switches between int16 and float stages. Does not allocate. */
+int stage_graph_process(stage_graph_t *graph, int16_t **channels, size_t frames, uint32_t active_mask);
+int stage_graph_reset(stage_graph_t *graph);
+
+/* Counts hardware events per stage in counters, which stay owned by the
+ * caller and must have been opened by the thread that goes on to call
+ * stage_graph_process(); NULL turns counting off. Without counters a
+ * stage costs one extra branch. */
+int stage_graph_set_counters(stage_graph_t *graph, perf_counters_context_t *counters);
+
+int stage_graph_get_stats(const stage_graph_t *graph, micarray_stage_stats_t *stats, int max_stages,
+                          int *num_stages);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
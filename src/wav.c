@@ -0,0 +1,36 @@
+#include "wav.h"
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t value) {
+    memcpy(p, &value, sizeof(value));
+}
+
+static void put_u32(uint8_t *p, uint32_t value) {
+    memcpy(p, &value, sizeof(value));
+}
+
+void wav_build_header(uint8_t *header, size_t header_size, int channels, int sample_rate, uint64_t data_bytes) {
+    const uint32_t overhead = (uint32_t)header_size - 8;
+    uint32_t size = data_bytes > UINT32_MAX - overhead ? UINT32_MAX - overhead : (uint32_t)data_bytes;
+    
+    memset(header, 0, header_size);
+    memcpy(header, "RIFF", 4);
+    put_u32(header + 4, overhead + size);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_u32(header + 16, 16);
+    put_u16(header + 20, 1);
+    put_u16(header + 22, (uint16_t)channels);
+    put_u32(header + 24, (uint32_t)sample_rate);
+    put_u32(header + 28, (uint32_t)(sample_rate * channels * 2));
+    put_u16(header + 32, (uint16_t)(channels * 2));
+    put_u16(header + 34, 16);
+    
+    uint8_t *data = header + 36;
+    if (header_size > WAV_HEADER_SIZE) {
+        memcpy(data, "JUNK", 4);
+        put_u32(data + 4, (uint32_t)(header_size - WAV_HEADER_SIZE - 8));
+        data = header + header_size - 8;
+    }
+    memcpy(data, "data", 4);
+    put_u32(data + 4, size);
+}
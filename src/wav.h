@@ -0,0 +1,24 @@
+#ifndef WAV_H
+#define WAV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WAV_HEADER_SIZE 44
+
+/* A canonical 16-bit PCM header for data_bytes of interleaved samples.
+ * header_size is WAV_HEADER_SIZE, or at least 8 more to pad the header
+ * with a JUNK chunk so the samples start at that offset, e.g. a page.
+ * Writers put one down with a length of 0 and patch it when they close,
+ * so a file cut short by a crash still has its samples. */
+void wav_build_header(uint8_t *header, size_t header_size, int channels, int sample_rate, uint64_t data_bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -12,8 +12,23 @@ typedef struct {
 static test_case_t test_cases[] = {
     {"Configuration Parser", "./test_config"},
     {"Noise Reduction", "./test_noise_reduction"},
+    {"NN Suppressor", "./test_nn_suppressor"},
     {"Localization", "./test_localization"},
     {"Logging System", "./test_logging"},
+    {"DMA Engine", "./test_dma"},
+    {"Microphone Health", "./test_mic_health"},
+    {"Pre-filter", "./test_prefilter"},
+    {"Echo Canceller", "./test_echo_canceller"},
+    {"HRTF Renderer", "./test_hrtf"},
+    {"Panner", "./test_panner"},
+    {"AGC", "./test_agc"},
+    {"Dereverberation", "./test_dereverb"},
+    {"Beamformer", "./test_beamformer"},
+    {"Recorder", "./test_recorder"},
+    {"Lossless", "./test_lossless"},
+    {"StageGraph", "./test_stage_graph"},
+    {"SIMD Kernels", "./test_kernels"},
+    {"C++ API", "./test_cpp_api"},
     {"Library Integration", "./test_libmicarray"}
 };
 
@@ -0,0 +1,166 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "../src/agc.h"
+
+#define TEST_RATE 16000
+#define TEST_BLOCK 250
+
+static agc_config_t default_config(void) {
+    agc_config_t config = {
+        .sample_rate = TEST_RATE,
+        .target_level_db = -20.0f,
+        .max_gain_db = 30.0f,
+        .gate_db = -60.0f,
+        .attack_ms = 20.0f,
+        .release_ms = 200.0f,
+        .ceiling_db = -1.0f,
+        .lookahead_ms = 5.0f
+    };
+    return config;
+}
+
+static void fill_tone(int16_t *samples, size_t frames, size_t offset, float amplitude) {
+    for (size_t j = 0; j < frames; j++) {
+        samples[j] = (int16_t)(amplitude * 32767.0f * sinf(2.0f * (float)M_PI * 300.0f * (offset + j) / TEST_RATE));
+    }
+}
+
+static float rms_db(const int16_t *samples, size_t frames) {
+    double energy = 0.0;
+    for (size_t j = 0; j < frames; j++) {
+        energy += (double)samples[j] * samples[j];
+    }
+    return 10.0f * log10f((float)(energy / frames) / (32768.0f * 32768.0f));
+}
+
+static void test_agc_invalid_params(void) {
+    printf("Testing AGC invalid parameters...\n");
+    
+    agc_context_t *ctx = NULL;
+    agc_config_t config = default_config();
+    assert(agc_init(NULL, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(agc_init(&ctx, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config.lookahead_ms = AGC_MAX_LOOKAHEAD_MS + 1.0f;
+    assert(agc_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    config = default_config();
+    config.ceiling_db = 3.0f;
+    assert(agc_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    config = default_config();
+    config.max_gain_db = -6.0f;
+    assert(agc_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config = default_config();
+    assert(agc_init(&ctx, &config) == MICARRAY_SUCCESS);
+    assert(agc_get_latency(ctx) == 80);
+    assert(agc_process(ctx, NULL, 10) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(agc_cleanup(ctx) == MICARRAY_SUCCESS);
+    assert(agc_cleanup(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ AGC invalid parameters test passed\n");
+}
+
+static void test_agc_levels(void) {
+    printf("Testing AGC levelling...\n");
+    
+    agc_context_t *ctx = NULL;
+    agc_config_t config = default_config();
+    assert(agc_init(&ctx, &config) == MICARRAY_SUCCESS);
+    
+    // A far talker 20 dB under the target is brought up to it
+    int16_t block[TEST_BLOCK];
+    size_t offset = 0;
+    for (int i = 0; i < 100; i++, offset += TEST_BLOCK) {
+        fill_tone(block, TEST_BLOCK, offset, 0.01f * sqrtf(2.0f));
+        assert(agc_process(ctx, block, TEST_BLOCK) == MICARRAY_SUCCESS);
+    }
+    assert(fabsf(rms_db(block, TEST_BLOCK) + 20.0f) < 1.0f);
+    assert(fabsf(agc_get_gain_db(ctx) - 20.0f) < 1.0f);
+    
+    // Silence below the gate holds the gain instead of raising it
+    float held = agc_get_gain_db(ctx);
+    for (int i = 0; i < 100; i++) {
+        memset(block, 0, sizeof(block));
+        agc_process(ctx, block, TEST_BLOCK);
+    }
+    assert(fabsf(agc_get_gain_db(ctx) - held) < 0.01f);
+    
+    // A near talker 14 dB over the target is brought down to it
+    for (int i = 0; i < 100; i++, offset += TEST_BLOCK) {
+        fill_tone(block, TEST_BLOCK, offset, 0.5f * sqrtf(2.0f));
+        agc_process(ctx, block, TEST_BLOCK);
+    }
+    assert(fabsf(rms_db(block, TEST_BLOCK) + 20.0f) < 1.0f);
+    
+    agc_cleanup(ctx);
+    
+    printf("✓ AGC levelling test passed\n");
+}
+
+static void test_agc_limiter(void) {
+    printf("Testing look-ahead limiter...\n");
+    
+    // No AGC gain: a lone small impulse comes out unchanged, one
+    // look-ahead later
+    agc_context_t *ctx = NULL;
+    agc_config_t config = default_config();
+    config.max_gain_db = 0.0f;
+    assert(agc_init(&ctx, &config) == MICARRAY_SUCCESS);
+    const int lookahead = agc_get_latency(ctx);
+    
+    int16_t block[TEST_BLOCK] = {0};
+    block[10] = 1000;
+    agc_process(ctx, block, TEST_BLOCK);
+    for (int j = 0; j < TEST_BLOCK; j++) {
+        assert(block[j] == (j == 10 + lookahead ? 1000 : 0));
+    }
+    assert(agc_get_limiter_db(ctx) == 0.0f);
+    
+    // Full-scale bursts in noise never cross the ceiling, and the limiter
+    // lets go again once they have passed
+    const int16_t ceiling = (int16_t)lrintf(32768.0f * powf(10.0f, config.ceiling_db / 20.0f));
+    uint32_t seed = 5;
+    float deepest = 0.0f;
+    for (int i = 0; i < 40; i++) {
+        for (int j = 0; j < TEST_BLOCK; j++) {
+            seed = seed * 1664525u + 1013904223u;
+            block[j] = (int16_t)(((int32_t)(seed >> 16) - 32768) / 16);
+            if (i % 8 == 3 && i < 32 && j % 50 < 4) {
+                block[j] = (j % 2) ? 32767 : -32768;
+            }
+        }
+        agc_process(ctx, block, TEST_BLOCK);
+        for (int j = 0; j < TEST_BLOCK; j++) {
+            assert(abs(block[j]) <= ceiling);
+        }
+        deepest = fminf(deepest, agc_get_limiter_db(ctx));
+    }
+    assert(deepest < -0.9f);
+    assert(agc_get_limiter_db(ctx) > -0.1f);
+    
+    // Reset starts from silence again
+    assert(agc_reset(ctx) == MICARRAY_SUCCESS);
+    memset(block, 0, sizeof(block));
+    block[0] = 500;
+    agc_process(ctx, block, TEST_BLOCK);
+    assert(block[lookahead] == 500);
+    
+    agc_cleanup(ctx);
+    
+    printf("✓ Look-ahead limiter test passed\n");
+}
+
+int main(void) {
+    printf("Running AGC tests...\n\n");
+    
+    test_agc_invalid_params();
+    test_agc_levels();
+    test_agc_limiter();
+    
+    printf("\n✅ All AGC tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,334 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "../src/beamformer.h"
+#include "../src/beam_output.h"
+
+#define TEST_MICS 4
+#define TEST_FRAMES 256
+#define TEST_BLOCKS 6
+#define TEST_LEAD 2
+
+/* With the speed of sound equal to the sample rate, one metre is one
+ * sample, so a plane wave along x reaches each microphone a whole number
+ * of samples early and delay-and-sum is exact. */
+static const microphone_position_t line_array[TEST_MICS] = {
+    {-2.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {2.0f, 0.0f, 0.0f}
+};
+
+static int16_t source[TEST_FRAMES * TEST_BLOCKS + 2 * TEST_LEAD];
+static int16_t mics[TEST_MICS][TEST_FRAMES * TEST_BLOCKS];
+
+static void fill_plane_wave(void) {
+    uint32_t seed = 17;
+    for (size_t j = 0; j < sizeof(source) / sizeof(source[0]); j++) {
+        seed = seed * 1664525u + 1013904223u;
+        source[j] = (int16_t)(((int32_t)(seed >> 16) - 32768) / 4);
+    }
+    
+    for (int m = 0; m < TEST_MICS; m++) {
+        for (int j = 0; j < TEST_FRAMES * TEST_BLOCKS; j++) {
+            mics[m][j] = source[j + TEST_LEAD + (int)line_array[m].x];
+        }
+    }
+}
+
+static beamformer_context_t* create_beamformer(int beams) {
+    beamformer_config_t config = {
+        .num_microphones = TEST_MICS,
+        .mic_positions = line_array,
+        .sample_rate = 16000,
+        .speed_of_sound = 16000.0f,
+        .num_beams = beams
+    };
+    
+    beamformer_context_t *ctx = NULL;
+    int result = beamformer_init(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    return ctx;
+}
+
+static void process_block(beamformer_context_t *ctx, int block, uint32_t mask, int16_t *out, size_t stride) {
+    int16_t *channels[TEST_MICS];
+    for (int m = 0; m < TEST_MICS; m++) {
+        channels[m] = mics[m] + block * TEST_FRAMES;
+    }
+    int result = beamformer_process(ctx, channels, TEST_FRAMES, mask, out, stride);
+    assert(result == MICARRAY_SUCCESS);
+}
+
+static void test_beamformer_invalid_params(void) {
+    printf("Testing beamformer invalid parameters...\n");
+    
+    beamformer_context_t *ctx = NULL;
+    beamformer_config_t config = {
+        .num_microphones = TEST_MICS,
+        .mic_positions = line_array,
+        .sample_rate = 16000,
+        .speed_of_sound = 343.0f,
+        .num_beams = MAX_BEAMS + 1
+    };
+    
+    assert(beamformer_init(NULL, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(beamformer_init(&ctx, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(beamformer_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    ctx = create_beamformer(2);
+    sound_location_t ahead = {1.0f, 0.0f, 0.0f, 1.0f};
+    int16_t out[2 * TEST_FRAMES];
+    int16_t *channels[TEST_MICS] = {mics[0], mics[1], mics[2], mics[3]};
+    assert(beamformer_steer(ctx, 2, &ahead) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(beamformer_steer(ctx, 0, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(beamformer_process(ctx, channels, TEST_FRAMES, 0xF, out, 1) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(beamformer_process(ctx, channels, MAX_BUFFER_SIZE + 1, 0xF, out, 2) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    assert(beamformer_cleanup(ctx) == MICARRAY_SUCCESS);
+    assert(beamformer_cleanup(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Beamformer invalid parameters test passed\n");
+}
+
+static void test_beamformer_steering(void) {
+    printf("Testing delay-and-sum steering...\n");
+    
+    // Beam 0 starts facing +x, beam 1 faces -x; the third channel is not
+    // the beamformer's and must be left alone
+    beamformer_context_t *ctx = create_beamformer(2);
+    int16_t *out = malloc(3 * TEST_FRAMES * sizeof(int16_t));
+    
+    for (int b = 0; b < TEST_BLOCKS; b++) {
+        for (int j = 0; j < 3 * TEST_FRAMES; j++) {
+            out[j] = 12345;
+        }
+        
+        // Beam 1 turns to +x after two blocks; the third ramps over
+        if (b == 2) {
+            sound_location_t ahead = {3.0f, 0.0f, 0.0f, 0.2f};
+            assert(beamformer_steer(ctx, 1, &ahead) == MICARRAY_SUCCESS);
+        }
+        
+        // Dropping a microphone keeps the beam aligned
+        uint32_t mask = b == 4 ? 0xE : 0xF;
+        process_block(ctx, b, mask, out, 3);
+        
+        double on_axis = 0.0, off_axis = 0.0, reference = 0.0;
+        for (int j = 0; j < TEST_FRAMES; j++) {
+            int n = b * TEST_FRAMES + j;
+            assert(out[3 * j + 2] == 12345);
+            if (n >= 2 * TEST_LEAD) {
+                assert(out[3 * j] == source[n]);
+            }
+            if (b >= 3) {
+                assert(out[3 * j + 1] == source[n]);
+            }
+            on_axis += (double)out[3 * j] * out[3 * j];
+            off_axis += (double)out[3 * j + 1] * out[3 * j + 1];
+            reference += (double)source[n] * source[n];
+        }
+        
+        // Facing away, the four copies are misaligned and partly cancel
+        if (b < 2) {
+            assert(off_axis < 0.5 * reference);
+            assert(on_axis > 0.9 * reference);
+        }
+    }
+    
+    free(out);
+    beamformer_cleanup(ctx);
+    
+    printf("✓ Steering test passed\n");
+}
+
+static void test_beamformer_specialized(void) {
+    printf("Testing fixed-count beam sum...\n");
+    
+    // Fractional delays, a ragged block length, a steer and a dropped
+    // microphone: the 4-microphone loop must match the generic path
+    beamformer_config_t config = {
+        .num_microphones = TEST_MICS,
+        .mic_positions = line_array,
+        .sample_rate = 16000,
+        .speed_of_sound = 21000.0f,
+        .num_beams = 3
+    };
+    beamformer_context_t *fixed = NULL, *generic = NULL;
+    assert(beamformer_init(&fixed, &config) == MICARRAY_SUCCESS);
+    config.generic = true;
+    assert(beamformer_init(&generic, &config) == MICARRAY_SUCCESS);
+    
+    int16_t out_fixed[3 * TEST_FRAMES], out_generic[3 * TEST_FRAMES];
+    for (int b = 0; b < TEST_BLOCKS; b++) {
+        if (b == 2) {
+            sound_location_t target = {0.3f, 0.8f, 0.1f, 1.0f};
+            assert(beamformer_steer(fixed, 2, &target) == MICARRAY_SUCCESS);
+            assert(beamformer_steer(generic, 2, &target) == MICARRAY_SUCCESS);
+        }
+        
+        int16_t *channels[TEST_MICS];
+        for (int m = 0; m < TEST_MICS; m++) {
+            channels[m] = mics[m] + b * TEST_FRAMES;
+        }
+        uint32_t mask = b == 4 ? 0x7 : 0xF;
+        assert(beamformer_process(fixed, channels, TEST_FRAMES - 1, mask, out_fixed, 3) == MICARRAY_SUCCESS);
+        assert(beamformer_process(generic, channels, TEST_FRAMES - 1, mask, out_generic, 3) == MICARRAY_SUCCESS);
+        assert(memcmp(out_fixed, out_generic, 3 * (TEST_FRAMES - 1) * sizeof(int16_t)) == 0);
+    }
+    
+    beamformer_cleanup(fixed);
+    beamformer_cleanup(generic);
+    
+    printf("✓ Fixed-count beam sum test passed\n");
+}
+
+static void test_beam_output_file(void) {
+    printf("Testing WAV file beam sink...\n");
+    
+    beam_output_config_t config = {
+        .sink = BEAM_SINK_FILE,
+        .channels = 3,
+        .sample_rate = 16000,
+        .block_frames = 64
+    };
+    strcpy(config.target, "test_beams.wav");
+    
+    beam_output_context_t *ctx = NULL;
+    assert(beam_output_init(&ctx, &config) == MICARRAY_SUCCESS);
+    
+    for (int chunk = 0; chunk < 3; chunk++) {
+        size_t frames = 100;
+        int16_t *out = beam_output_acquire(ctx, &frames);
+        assert(out != NULL && frames == 64);
+        for (size_t j = 0; j < 3 * frames; j++) {
+            out[j] = (int16_t)(chunk * 1000 + j);
+        }
+        assert(beam_output_commit(ctx, frames) == MICARRAY_SUCCESS);
+    }
+    assert(beam_output_cleanup(ctx) == MICARRAY_SUCCESS);
+    
+    FILE *file = fopen("test_beams.wav", "rb");
+    assert(file != NULL);
+    uint8_t header[44];
+    assert(fread(header, 1, sizeof(header), file) == sizeof(header));
+    
+    uint16_t channels, bits;
+    uint32_t rate, data_size;
+    memcpy(&channels, header + 22, 2);
+    memcpy(&rate, header + 24, 4);
+    memcpy(&bits, header + 34, 2);
+    memcpy(&data_size, header + 40, 4);
+    assert(memcmp(header, "RIFF", 4) == 0 && memcmp(header + 8, "WAVE", 4) == 0);
+    assert(channels == 3 && rate == 16000 && bits == 16);
+    assert(data_size == 3 * 64 * 3 * sizeof(int16_t));
+    
+    int16_t sample;
+    fseek(file, 44 + (2 * 3 * 64 + 5) * sizeof(int16_t), SEEK_SET);
+    assert(fread(&sample, sizeof(sample), 1, file) == 1);
+    assert(sample == 2005);
+    
+    fclose(file);
+    
+    // Three seconds at once overrun the queue; whatever the writer could
+    // not take is counted, never blocked on
+    assert(beam_output_init(&ctx, &config) == MICARRAY_SUCCESS);
+    const size_t total = 3 * 16000;
+    for (size_t offset = 0; offset < total;) {
+        size_t frames = total - offset;
+        int16_t *out = beam_output_acquire(ctx, &frames);
+        if (!out) {
+            offset += frames;
+            continue;
+        }
+        memset(out, 0, frames * 3 * sizeof(int16_t));
+        assert(beam_output_commit(ctx, frames) == MICARRAY_SUCCESS);
+        offset += frames;
+    }
+    uint64_t dropped = 0;
+    assert(beam_output_get_dropped(ctx, &dropped) == MICARRAY_SUCCESS);
+    assert(beam_output_cleanup(ctx) == MICARRAY_SUCCESS);
+    
+    file = fopen("test_beams.wav", "rb");
+    assert(file != NULL);
+    assert(fread(header, 1, sizeof(header), file) == sizeof(header));
+    memcpy(&data_size, header + 40, 4);
+    assert(data_size / (3 * sizeof(int16_t)) + dropped == total);
+    assert(dropped < total);
+    fclose(file);
+    unlink("test_beams.wav");
+    
+    printf("✓ WAV file sink test passed\n");
+}
+
+static void test_beam_output_ring(void) {
+    printf("Testing shared-memory beam ring...\n");
+    
+    beam_output_config_t config = {
+        .sink = BEAM_SINK_SHM,
+        .channels = 2,
+        .sample_rate = 16000,
+        .block_frames = 64,
+        .ring_frames = 100
+    };
+    strcpy(config.target, "/micarray-test-beams");
+    
+    beam_output_context_t *ctx = NULL;
+    assert(beam_output_init(&ctx, &config) == MICARRAY_SUCCESS);
+    
+    int fd = shm_open(config.target, O_RDONLY, 0);
+    assert(fd >= 0);
+    size_t size = sizeof(beam_ring_header_t) + 100 * 2 * sizeof(int16_t);
+    const beam_ring_header_t *ring = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    assert(ring != MAP_FAILED);
+    const int16_t *slots = (const int16_t*)(ring + 1);
+    assert(memcmp(ring->magic, BEAM_RING_MAGIC, 8) == 0);
+    assert(ring->channels == 2 && ring->capacity == 100);
+    
+    // 64 frames, then the 36 left before the wrap, then from slot 0 again
+    static const size_t expected[3] = {64, 36, 64};
+    uint64_t total = 0;
+    for (int chunk = 0; chunk < 3; chunk++) {
+        size_t frames = 64;
+        int16_t *out = beam_output_acquire(ctx, &frames);
+        assert(out != NULL && frames == expected[chunk]);
+        for (size_t j = 0; j < 2 * frames; j++) {
+            out[j] = (int16_t)(total * 2 + j);
+        }
+        assert(beam_output_commit(ctx, frames) == MICARRAY_SUCCESS);
+        assert(slots[2 * (total % 100)] == (int16_t)(total * 2));
+        total += frames;
+        assert(__atomic_load_n(&ring->write_frames, __ATOMIC_ACQUIRE) == total);
+    }
+    
+    // Frame 130 overwrote slot 30
+    assert(slots[2 * 30] == 2 * 130);
+    assert(slots[2 * 99 + 1] == 2 * 99 + 1);
+    
+    munmap((void*)ring, size);
+    close(fd);
+    assert(beam_output_cleanup(ctx) == MICARRAY_SUCCESS);
+    shm_unlink(config.target);
+    
+    config.ring_frames = 32;
+    assert(beam_output_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Shared-memory ring test passed\n");
+}
+
+int main(void) {
+    printf("Running beamformer tests...\n\n");
+    
+    fill_plane_wave();
+    
+    test_beamformer_invalid_params();
+    test_beamformer_steering();
+    test_beamformer_specialized();
+    test_beam_output_file();
+    test_beam_output_ring();
+    
+    printf("\n✅ All beamformer tests passed!\n");
+    return 0;
+}
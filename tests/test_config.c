@@ -17,12 +17,40 @@ static void test_config_defaults(void) {
     assert(config.i2s_bus == 1);
     assert(config.dma_buffer_size == 1024);
     assert(config.sample_rate == DEFAULT_SAMPLE_RATE);
+    assert(config.low_latency == false);
+    assert(config.hop_size == DEFAULT_HOP_SIZE);
+    assert(config.dereverb_enable == false);
+    assert(config.dereverb_order == 4);
+    assert(config.dereverb_delay == 2);
+    assert(config.dereverb_frame_size == 512);
     assert(config.noise_reduction_enable == true);
     assert(config.noise_threshold == 0.05f);
     assert(strcmp(config.algorithm, "spectral_subtraction") == 0);
+    assert(config.agc_enable == false);
+    assert(config.agc_target_db == -20.0f);
+    assert(config.agc_ceiling_db == -1.0f);
+    assert(config.agc_lookahead_ms == 5.0f);
     assert(strcmp(config.output_device, "headphones") == 0);
     assert(config.volume == 0.8f);
+    assert(strcmp(config.output_renderer, "pan") == 0);
     assert(config.enable_serial_logging == true);
+    assert(config.metrics_rate == 1.0f);
+    assert(config.perf_counters == false);
+    assert(config.prefilter_enable == true);
+    assert(config.prefilter_dc_removal == true);
+    assert(config.prefilter_highpass == 80.0f);
+    assert(config.aec_enable == false);
+    assert(config.aec_tail_ms == 64);
+    assert(config.aec_delay_ms == -1);
+    assert(config.beam_enable == false);
+    assert(config.beam_count == 2);
+    assert(strcmp(config.beam_sink, "file") == 0);
+    assert(config.recorder_enable == false);
+    assert(config.recorder_pre_ms == 5000);
+    assert(strcmp(config.recorder_format, "wav") == 0);
+    assert(config.recorder_trigger_db == 0.0f);
+    assert(strcmp(config.pipeline_stages, MICARRAY_DEFAULT_STAGES) == 0);
+    assert(strcmp(config.kernels, "auto") == 0);
     
     printf("✓ Config defaults test passed\n");
 }
@@ -69,6 +97,158 @@ static void test_config_validation(void) {
     config.volume = 1.1f;
     assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
     
+    // The HRTF renderer needs an HRIR set
+    config_set_defaults(&config);
+    strcpy(config.output_renderer, "hrtf");
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    strcpy(config.hrtf_file, "/usr/share/micarray/hrir.bin");
+    assert(config_validate(&config) == MICARRAY_SUCCESS);
+    
+    strcpy(config.output_renderer, "ambisonic");
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config_set_defaults(&config);
+    config.metrics_rate = -1.0f;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config_set_defaults(&config);
+    config.prefilter_lowpass = 50.0f;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config.prefilter_lowpass = 9000.0f;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    // Echo cancellation settings only matter once it is enabled
+    config_set_defaults(&config);
+    config.aec_tail_ms = 0;
+    assert(config_validate(&config) == MICARRAY_SUCCESS);
+    
+    config.aec_enable = true;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config.aec_tail_ms = 64;
+    config.aec_step = 0.0f;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    // The nn suppressor cannot run without its model
+    config_set_defaults(&config);
+    strcpy(config.algorithm, "nn");
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    strcpy(config.nn_model, "/usr/share/micarray/nr.model");
+    assert(config_validate(&config) == MICARRAY_SUCCESS);
+    
+    // Dereverberation frames are powers of two and the taps are bounded
+    config_set_defaults(&config);
+    config.dereverb_enable = true;
+    assert(config_validate(&config) == MICARRAY_SUCCESS);
+    config.dereverb_frame_size = 500;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    config.dereverb_frame_size = 512;
+    config.dereverb_order = 9;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    // Forgetting factors in [0.9, 1) are accepted, as the message says
+    config.dereverb_order = 4;
+    config.dereverb_forgetting = 0.9f;
+    assert(config_validate(&config) == MICARRAY_SUCCESS);
+    config.dereverb_forgetting = 0.89f;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    config.dereverb_forgetting = 1.0f;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    // The AGC target must sit under the limiter ceiling
+    config_set_defaults(&config);
+    config.agc_enable = true;
+    config.agc_target_db = 0.0f;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config.agc_target_db = -20.0f;
+    config.agc_lookahead_ms = 50.0f;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    // Beam output needs a known sink, and the ring a shared-memory name
+    config_set_defaults(&config);
+    config.beam_count = 0;
+    assert(config_validate(&config) == MICARRAY_SUCCESS);
+    
+    config.beam_enable = true;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config.beam_count = MAX_BEAMS;
+    assert(config_validate(&config) == MICARRAY_SUCCESS);
+    
+    strcpy(config.beam_sink, "udp");
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    strcpy(config.beam_sink, "shm");
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    strcpy(config.beam_target, "/micarray-beams");
+    assert(config_validate(&config) == MICARRAY_SUCCESS);
+    
+    // The pre-trigger window is bounded because it is held in memory
+    config_set_defaults(&config);
+    config.recorder_enable = true;
+    config.recorder_pre_ms = 60001;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config.recorder_pre_ms = 0;
+    config.recorder_trigger_confidence = 1.5f;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config.recorder_trigger_confidence = 0.8f;
+    assert(config_validate(&config) == MICARRAY_SUCCESS);
+    
+    strcpy(config.recorder_format, "flac");
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    // Hop size is only checked in low-latency mode
+    config_set_defaults(&config);
+    config.hop_size = 0;
+    assert(config_validate(&config) == MICARRAY_SUCCESS);
+    
+    config.low_latency = true;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config.hop_size = config.dma_buffer_size + 1;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config.hop_size = 64;
+    assert(config_validate(&config) == MICARRAY_SUCCESS);
+    
+    // Localization rate and window
+    config_set_defaults(&config);
+    config.localization_rate = -1.0f;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config_set_defaults(&config);
+    config.localization_window = MAX_LOCALIZATION_WINDOW + 1;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config_set_defaults(&config);
+    strcpy(config.localization_method, "music");
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config_set_defaults(&config);
+    config.localization_smoothing = 1.5f;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config_set_defaults(&config);
+    config.localization_band_low = 4000.0f;
+    config.localization_band_high = 3000.0f;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    config.localization_band_high = config.sample_rate;
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
+    // Levels for another architecture are valid; init falls back from them
+    config_set_defaults(&config);
+    strcpy(config.kernels, "neon");
+    assert(config_validate(&config) == MICARRAY_SUCCESS);
+    strcpy(config.kernels, "sse2");
+    assert(config_validate(&config) == MICARRAY_ERROR_CONFIG);
+    
     printf("✓ Config validation test passed\n");
 }
 
@@ -82,6 +262,7 @@ static void test_config_file_parsing(void) {
     fprintf(test_file, 
         "[General]\n"
         "log_level = \"DEBUG\"\n"
+        "kernels = \"scalar\"\n"
         "\n"
         "[MicrophoneArray]\n"
         "num_microphones = 6\n"
@@ -89,19 +270,82 @@ static void test_config_file_parsing(void) {
         "i2s_bus = 2\n"
         "dma_buffer_size = 2048\n"
         "sample_rate = 48000\n"
+        "low_latency = true\n"
+        "hop_size = 64\n"
+        "\n"
+        "[Localization]\n"
+        "rate = 15\n"
+        "window = 4096\n"
+        "method = \"xcorr\"\n"
+        "smoothing = 0.5\n"
+        "band_low = 200\n"
+        "band_high = 6000\n"
+        "max_bins = 48\n"
+        "\n"
+        "[PreFilter]\n"
+        "dc_removal = false\n"
+        "highpass = 120\n"
+        "lowpass = 7000\n"
+        "\n"
+        "[EchoCancellation]\n"
+        "enable = true\n"
+        "tail_ms = 128\n"
+        "step = 0.25\n"
+        "delay_ms = 30\n"
+        "\n"
+        "[Dereverberation]\n"
+        "enable = true\n"
+        "order = 6\n"
+        "delay = 3\n"
+        "frame_size = 256\n"
+        "forgetting = 0.995\n"
         "\n"
         "[NoiseReduction]\n"
         "enable = false\n"
         "noise_threshold = 0.1\n"
         "algorithm = \"wiener_filter\"\n"
+        "model = \"/tmp/nr.model\"\n"
+        "\n"
+        "[AGC]\n"
+        "enable = true\n"
+        "target_level_db = -16\n"
+        "max_gain_db = 24\n"
+        "gate_db = -50\n"
+        "attack_ms = 10\n"
+        "release_ms = 800\n"
+        "limiter_ceiling_db = -2\n"
+        "lookahead_ms = 3\n"
         "\n"
         "[AudioOutput]\n"
         "output_device = \"speakers\"\n"
         "volume = 0.5\n"
+        "renderer = \"hrtf\"\n"
+        "hrtf_file = \"/tmp/hrir.bin\"\n"
+        "\n"
+        "[BeamOutput]\n"
+        "enable = true\n"
+        "beams = 4\n"
+        "sink = \"shm\"\n"
+        "target = \"/micarray-beams\"\n"
+        "ring_ms = 500\n"
+        "\n"
+        "[Recorder]\n"
+        "enable = true\n"
+        "directory = \"/tmp/recordings\"\n"
+        "format = \"lossless\"\n"
+        "pre_trigger_ms = 2000\n"
+        "post_trigger_ms = 0\n"
+        "trigger_level_db = -20\n"
+        "trigger_confidence = 0.7\n"
+        "\n"
+        "[Pipeline]\n"
+        "stages = \"aec, gain:0.5, prefilter\"\n"
         "\n"
         "[Logging]\n"
         "enable_serial_logging = false\n"
-        "log_file = \"/tmp/test.log\"\n");
+        "log_file = \"/tmp/test.log\"\n"
+        "metrics_rate = 4\n"
+        "perf_counters = true\n");
     
     fclose(test_file);
     
@@ -112,18 +356,66 @@ static void test_config_file_parsing(void) {
     assert(result == MICARRAY_SUCCESS);
     
     assert(strcmp(config.log_level, "DEBUG") == 0);
+    assert(strcmp(config.kernels, "scalar") == 0);
     assert(config.num_microphones == 6);
     assert(config.mic_spacing == 20.0f);
     assert(config.i2s_bus == 2);
     assert(config.dma_buffer_size == 2048);
     assert(config.sample_rate == 48000);
+    assert(config.low_latency == true);
+    assert(config.hop_size == 64);
+    assert(config.localization_rate == 15.0f);
+    assert(config.localization_window == 4096);
+    assert(strcmp(config.localization_method, "xcorr") == 0);
+    assert(config.localization_smoothing == 0.5f);
+    assert(config.localization_band_low == 200.0f);
+    assert(config.localization_band_high == 6000.0f);
+    assert(config.localization_max_bins == 48);
+    assert(config.prefilter_dc_removal == false);
+    assert(config.prefilter_highpass == 120.0f);
+    assert(config.prefilter_lowpass == 7000.0f);
+    assert(config.aec_enable == true);
+    assert(config.aec_tail_ms == 128);
+    assert(config.aec_step == 0.25f);
+    assert(config.aec_delay_ms == 30);
+    assert(config.dereverb_enable == true);
+    assert(config.dereverb_order == 6);
+    assert(config.dereverb_delay == 3);
+    assert(config.dereverb_frame_size == 256);
+    assert(config.dereverb_forgetting == 0.995f);
     assert(config.noise_reduction_enable == false);
     assert(config.noise_threshold == 0.1f);
     assert(strcmp(config.algorithm, "wiener_filter") == 0);
+    assert(strcmp(config.nn_model, "/tmp/nr.model") == 0);
+    assert(config.agc_enable == true);
+    assert(config.agc_target_db == -16.0f);
+    assert(config.agc_max_gain_db == 24.0f);
+    assert(config.agc_gate_db == -50.0f);
+    assert(config.agc_attack_ms == 10.0f);
+    assert(config.agc_release_ms == 800.0f);
+    assert(config.agc_ceiling_db == -2.0f);
+    assert(config.agc_lookahead_ms == 3.0f);
     assert(strcmp(config.output_device, "speakers") == 0);
     assert(config.volume == 0.5f);
+    assert(strcmp(config.output_renderer, "hrtf") == 0);
+    assert(strcmp(config.hrtf_file, "/tmp/hrir.bin") == 0);
+    assert(config.beam_enable == true);
+    assert(config.beam_count == 4);
+    assert(strcmp(config.beam_sink, "shm") == 0);
+    assert(strcmp(config.beam_target, "/micarray-beams") == 0);
+    assert(config.beam_ring_ms == 500);
+    assert(config.recorder_enable == true);
+    assert(strcmp(config.recorder_directory, "/tmp/recordings") == 0);
+    assert(strcmp(config.recorder_format, "lossless") == 0);
+    assert(config.recorder_pre_ms == 2000);
+    assert(config.recorder_post_ms == 0);
+    assert(config.recorder_trigger_db == -20.0f);
+    assert(config.recorder_trigger_confidence == 0.7f);
+    assert(strcmp(config.pipeline_stages, "aec, gain:0.5, prefilter") == 0);
     assert(config.enable_serial_logging == false);
     assert(strcmp(config.log_file, "/tmp/test.log") == 0);
+    assert(config.metrics_rate == 4.0f);
+    assert(config.perf_counters == true);
     
     // Clean up
     unlink("test_config.conf");
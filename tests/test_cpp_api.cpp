@@ -0,0 +1,207 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "../src/micarray.hpp"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TEST_CHANNELS 4
+#define TEST_BLOCK 256
+
+static_assert(!std::is_copy_constructible_v<micarray::context>, "contexts are move-only");
+static_assert(!std::is_copy_assignable_v<micarray::context>, "contexts are move-only");
+static_assert(std::is_nothrow_move_constructible_v<micarray::context>, "moves must not throw");
+
+static micarray_config_t headless_config() {
+    micarray_config_t config;
+    std::memset(&config, 0, sizeof(config));
+    config.num_microphones = TEST_CHANNELS;
+    config.mic_spacing = 15.0f;
+    config.dma_buffer_size = 1024;
+    config.sample_rate = 16000;
+    config.volume = 0.8f;
+    std::strcpy(config.log_level, "ERROR");
+    return config;
+}
+
+static void fill_block(std::vector<int16_t> &planar, std::vector<int16_t> &interleaved, int block) {
+    for (int j = 0; j < TEST_BLOCK; j++) {
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            int16_t sample = (int16_t)(8000.0f * sinf(2.0f * (float)M_PI * 440.0f * (block * TEST_BLOCK + j + c) / 16000.0f));
+            planar[c * TEST_BLOCK + j] = sample;
+            interleaved[j * TEST_CHANNELS + c] = sample;
+        }
+    }
+}
+
+static void test_cpp_views() {
+    printf("Testing span and planar views...\n");
+    
+    int16_t buffer[3 * 8];
+    for (int i = 0; i < 3 * 8; i++) {
+        buffer[i] = (int16_t)i;
+    }
+    
+    micarray::planar_view<int16_t> view(buffer, 3, 8);
+    assert(view.contiguous());
+    assert(view(2, 5) == 21);
+    assert(view[1].size() == 8 && view[1][0] == 8);
+    
+    // A window of frames keeps the channel stride and aliases the buffer
+    micarray::planar_view<const int16_t> window = view.slice(2, 4);
+    assert(window.frames() == 4 && window.stride() == 8 && !window.contiguous());
+    assert(window(1, 0) == 10 && &window(1, 0) == &buffer[10]);
+    
+    std::vector<float> samples(5, 1.0f);
+    micarray::span<float> from_vector(samples);
+    micarray::span<const float> as_const = from_vector;
+    assert(as_const.size() == 5 && as_const.data() == samples.data());
+    assert(micarray::span<int16_t>(buffer).size() == 24);
+    
+    printf("✓ View test passed\n");
+}
+
+static void test_cpp_context() {
+    printf("Testing move-only context...\n");
+    
+    micarray_config_t config = headless_config();
+    micarray::context a = micarray::context::headless(config);
+    micarray::context b = micarray::context::headless(config);
+    assert(a && b);
+    
+    // Headless contexts have no capture thread to start
+    try {
+        a.start();
+        assert(false);
+    } catch (const micarray::error &e) {
+        assert(e.code() == MICARRAY_ERROR_INIT);
+    }
+    
+    std::vector<int16_t> planar(TEST_CHANNELS * TEST_BLOCK);
+    std::vector<int16_t> interleaved(TEST_CHANNELS * TEST_BLOCK);
+    std::vector<int16_t> out_a(2 * TEST_BLOCK);
+    std::vector<int16_t> out_b(2 * TEST_BLOCK);
+    
+    for (int block = 0; block < 4; block++) {
+        fill_block(planar, interleaved, block);
+        a.process(micarray::planar_view<const int16_t>(planar.data(), TEST_CHANNELS, TEST_BLOCK), out_a);
+        b.process_interleaved(interleaved, TEST_BLOCK, out_b);
+        assert(out_a == out_b);
+    }
+    
+    // The native handle moves with the object and is released once
+    micarray_context_t *handle = a.get();
+    micarray::context moved(std::move(a));
+    assert(!a && moved.get() == handle);
+    assert(moved.stats().blocks_processed == 4);
+    b = std::move(moved);
+    assert(!moved && b.get() == handle);
+    assert(b.latency().block_frames > 0);
+    
+    // Views the C API cannot take without a copy are refused
+    micarray::planar_view<const int16_t> strided(planar.data(), 2, TEST_BLOCK / 2, TEST_BLOCK);
+    try {
+        b.process(strided, out_a);
+        assert(false);
+    } catch (const micarray::error &e) {
+        assert(e.code() == MICARRAY_ERROR_INVALID_PARAM);
+    }
+    try {
+        b.process_interleaved(interleaved, TEST_BLOCK, micarray::span<int16_t>(out_a.data(), TEST_BLOCK));
+        assert(false);
+    } catch (const micarray::error &e) {
+        assert(e.code() == MICARRAY_ERROR_INVALID_PARAM);
+    }
+    
+    printf("✓ Context test passed\n");
+}
+
+struct scaler {
+    float gain;
+    
+    void operator()(micarray::channel_view<const float> in, micarray::channel_view<float> out, uint32_t) {
+        for (size_t c = 0; c < out.channels(); c++) {
+            for (size_t j = 0; j < out.frames(); j++) {
+                out(c, j) = in(c, j) * gain;
+            }
+        }
+    }
+    
+    void reset() {}
+};
+
+static int scaler_inits = 0;
+
+static void test_cpp_stage() {
+    printf("Testing lambda stage registration...\n");
+    
+    auto factory = [](const micarray_stage_format_t &format, std::string_view args) {
+        assert(format.num_channels == TEST_CHANNELS);
+        scaler_inits++;
+        return scaler{std::stof(std::string(args))};
+    };
+    micarray::register_stage("scale", factory, MICARRAY_STAGE_IN_PLACE);
+    
+    // One registration per factory type, and built-in names stay reserved
+    try {
+        micarray::register_stage("scale2", factory);
+        assert(false);
+    } catch (const micarray::error &e) {
+        assert(e.code() == MICARRAY_ERROR_INVALID_PARAM);
+    }
+    try {
+        micarray::register_stage("aec", [](const micarray_stage_format_t &, std::string_view) { return scaler{1.0f}; });
+        assert(false);
+    } catch (const micarray::error &e) {
+        assert(e.code() == MICARRAY_ERROR_INVALID_PARAM);
+    }
+    
+    micarray_config_t config = headless_config();
+    micarray::context plain = micarray::context::headless(config);
+    std::strcpy(config.pipeline_stages, "scale:1");
+    micarray::context unity = micarray::context::headless(config);
+    std::strcpy(config.pipeline_stages, "scale:0");
+    micarray::context mute = micarray::context::headless(config);
+    assert(scaler_inits == 2);
+    
+    std::vector<int16_t> planar(TEST_CHANNELS * TEST_BLOCK);
+    std::vector<int16_t> interleaved(TEST_CHANNELS * TEST_BLOCK);
+    std::vector<int16_t> out_plain(2 * TEST_BLOCK);
+    std::vector<int16_t> out_unity(2 * TEST_BLOCK);
+    std::vector<int16_t> out_mute(2 * TEST_BLOCK);
+    
+    for (int block = 0; block < 3; block++) {
+        fill_block(planar, interleaved, block);
+        micarray::planar_view<const int16_t> input(planar.data(), TEST_CHANNELS, TEST_BLOCK);
+        plain.process(input, out_plain);
+        unity.process(input, out_unity);
+        mute.process(input, out_mute);
+        assert(out_plain == out_unity);
+        for (int16_t sample : out_mute) {
+            assert(sample == 0);
+        }
+    }
+    
+    micarray_stage_stats_t stats[2];
+    assert(unity.stage_stats(stats) == 1);
+    assert(std::strcmp(stats[0].name, "scale") == 0 && stats[0].calls == 3);
+    
+    printf("✓ Stage test passed\n");
+}
+
+int main() {
+    printf("Running C++ API tests...\n\n");
+    
+    test_cpp_views();
+    test_cpp_context();
+    test_cpp_stage();
+    
+    printf("\n✅ All C++ API tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,185 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "../src/dereverb.h"
+
+#define TEST_RATE 16000
+#define TEST_CHANNELS 2
+#define TEST_BLOCK 160
+#define TEST_SECONDS 8
+#define TAIL_START 256
+#define TAIL_LENGTH 1024
+
+static dereverb_config_t default_config(void) {
+    dereverb_config_t config = {
+        .num_channels = TEST_CHANNELS,
+        .sample_rate = TEST_RATE,
+        .frame_size = 512,
+        .order = 8,
+        .delay = 2,
+        .forgetting = 0.99f
+    };
+    return config;
+}
+
+static uint32_t next_random(uint32_t *seed) {
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed >> 8;
+}
+
+static float uniform(uint32_t *seed) {
+    return next_random(seed) / 8388608.0f - 1.0f;
+}
+
+static void test_dereverb_invalid_params(void) {
+    printf("Testing dereverberation invalid parameters...\n");
+    
+    dereverb_context_t *ctx = NULL;
+    dereverb_config_t config = default_config();
+    assert(dereverb_init(NULL, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(dereverb_init(&ctx, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config.frame_size = 500;
+    assert(dereverb_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    config = default_config();
+    config.order = 0;
+    assert(dereverb_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    config = default_config();
+    config.delay = DEREVERB_MAX_DELAY + 1;
+    assert(dereverb_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    config = default_config();
+    config.num_channels = 8;
+    config.order = DEREVERB_MAX_TAPS / 8 + 1;
+    assert(dereverb_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    config = default_config();
+    config.forgetting = 1.0f;
+    assert(dereverb_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config = default_config();
+    assert(dereverb_init(&ctx, &config) == MICARRAY_SUCCESS);
+    assert(dereverb_get_latency(ctx) == 512);
+    assert(dereverb_process(ctx, NULL, 10, 0x3) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(dereverb_cleanup(ctx) == MICARRAY_SUCCESS);
+    assert(dereverb_cleanup(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Dereverberation invalid parameters test passed\n");
+}
+
+static void test_dereverb_passthrough(void) {
+    printf("Testing dereverberation passthrough...\n");
+    
+    // With the delay spanning a whole frame a lone impulse has nothing to
+    // be predicted from, so it comes out unchanged one frame later
+    dereverb_context_t *ctx = NULL;
+    dereverb_config_t config = default_config();
+    config.delay = 4;
+    assert(dereverb_init(&ctx, &config) == MICARRAY_SUCCESS);
+    const int latency = dereverb_get_latency(ctx);
+    
+    int16_t samples[TEST_CHANNELS][2048] = {{0}};
+    int16_t *channels[TEST_CHANNELS] = {samples[0], samples[1]};
+    samples[0][10] = 1000;
+    samples[1][10] = -2000;
+    
+    // Odd block lengths must not matter
+    for (size_t done = 0; done < 2048; done += 100) {
+        int16_t *block[TEST_CHANNELS] = {channels[0] + done, channels[1] + done};
+        size_t count = 2048 - done < 100 ? 2048 - done : 100;
+        assert(dereverb_process(ctx, block, count, 0x3) == MICARRAY_SUCCESS);
+    }
+    for (int j = 0; j < 2048; j++) {
+        assert(abs(samples[0][j] - (j == 10 + latency ? 1000 : 0)) <= 1);
+        assert(abs(samples[1][j] - (j == 10 + latency ? -2000 : 0)) <= 1);
+    }
+    
+    // Channels outside the mask are left alone
+    memset(samples, 0, sizeof(samples));
+    samples[1][5] = 300;
+    dereverb_process(ctx, channels, 2048, 0x1);
+    assert(samples[1][5] == 300);
+    
+    dereverb_cleanup(ctx);
+    
+    printf("✓ Dereverberation passthrough test passed\n");
+}
+
+static void test_dereverb_removes_tail(void) {
+    printf("Testing dereverberation of a synthetic room...\n");
+    
+    // A modulated noise source heard through a direct path followed, past
+    // the prediction delay, by a decaying diffuse tail on each microphone
+    const size_t total = TEST_SECONDS * TEST_RATE;
+    float *dry = malloc(total * sizeof(float));
+    float *tails[TEST_CHANNELS];
+    int16_t *wet[TEST_CHANNELS];
+    int16_t *processed[TEST_CHANNELS];
+    uint32_t seed = 7;
+    for (size_t j = 0; j < total; j++) {
+        float envelope = 0.5f + 0.5f * sinf(2.0f * (float)M_PI * 3.0f * j / TEST_RATE);
+        dry[j] = 0.1f * envelope * uniform(&seed);
+    }
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        tails[c] = malloc(TAIL_LENGTH * sizeof(float));
+        wet[c] = malloc(total * sizeof(int16_t));
+        processed[c] = malloc(total * sizeof(int16_t));
+        for (int n = 0; n < TAIL_LENGTH; n++) {
+            tails[c][n] = 0.15f * uniform(&seed) * expf(-6.9f * n / TAIL_LENGTH);
+        }
+        for (size_t j = 0; j < total; j++) {
+            float sample = dry[j];
+            for (int n = 0; n < TAIL_LENGTH && (size_t)(n + TAIL_START) <= j; n++) {
+                sample += tails[c][n] * dry[j - TAIL_START - n];
+            }
+            wet[c][j] = (int16_t)lrintf(sample * 32767.0f);
+        }
+        memcpy(processed[c], wet[c], total * sizeof(int16_t));
+    }
+    
+    dereverb_context_t *ctx = NULL;
+    dereverb_config_t config = default_config();
+    assert(dereverb_init(&ctx, &config) == MICARRAY_SUCCESS);
+    const int latency = dereverb_get_latency(ctx);
+    for (size_t done = 0; done < total; done += TEST_BLOCK) {
+        int16_t *block[TEST_CHANNELS] = {processed[0] + done, processed[1] + done};
+        dereverb_process(ctx, block, TEST_BLOCK, 0x3);
+    }
+    
+    // Over the last second the tail left in the output is well under the
+    // tail in the input
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        double before = 0.0, after = 0.0;
+        for (size_t j = total - TEST_RATE; j < total; j++) {
+            double direct = dry[j - latency] * 32767.0;
+            double input = wet[c][j - latency] - direct;
+            double output = processed[c][j] - direct;
+            before += input * input;
+            after += output * output;
+        }
+        printf("  channel %d: tail %.1f dB\n", c, 10.0 * log10(after / before));
+        assert(after < before * 0.25);
+    }
+    
+    dereverb_cleanup(ctx);
+    free(dry);
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        free(tails[c]);
+        free(wet[c]);
+        free(processed[c]);
+    }
+    
+    printf("✓ Dereverberation of a synthetic room test passed\n");
+}
+
+int main(void) {
+    printf("Running dereverberation tests...\n\n");
+    
+    test_dereverb_invalid_params();
+    test_dereverb_passthrough();
+    test_dereverb_removes_tail();
+    
+    printf("\n✅ All dereverberation tests passed!\n");
+    return 0;
+}
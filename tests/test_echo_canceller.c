@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "../src/echo_canceller.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TEST_CHANNELS 3
+#define TEST_BLOCK 128
+#define TEST_TAPS 64
+#define TEST_HISTORY (TEST_BLOCK + 128)
+
+static uint32_t seed = 7;
+
+static float next_noise(void) {
+    seed = seed * 1664525u + 1013904223u;
+    return ((int32_t)(seed >> 16) - 32768) / 32768.0f;
+}
+
+/* Room response of channel c: a decaying, sign-alternating tail that
+ * starts `lag` samples after playback. */
+static float echo_path(int channel, int n) {
+    int lag = channel == 0 ? 40 : 60;
+    float gain = channel == 0 ? 0.5f : 0.25f;
+    int k = n - lag;
+    if (k < 0 || k >= TEST_TAPS) {
+        return 0.0f;
+    }
+    return gain * expf(-k / 10.0f) * ((k % 3) ? 1.0f : -0.6f);
+}
+
+typedef struct {
+    float reference[TEST_HISTORY];
+    int16_t stereo[TEST_BLOCK * 2];
+    int16_t *planar[TEST_CHANNELS];
+    float echo[TEST_CHANNELS][TEST_BLOCK];
+    long sample;
+} echo_room_t;
+
+/* Plays one block of noise and captures its echo on every channel, plus
+ * near_end (a 1 kHz tone of that amplitude) if non-zero. */
+static void room_block(echo_room_t *room, float near_end) {
+    memmove(room->reference, room->reference + TEST_BLOCK, (TEST_HISTORY - TEST_BLOCK) * sizeof(float));
+    for (int j = 0; j < TEST_BLOCK; j++) {
+        float s = 0.3f * next_noise();
+        room->reference[TEST_HISTORY - TEST_BLOCK + j] = s;
+        room->stereo[2 * j] = (int16_t)(s * 32767.0f);
+        room->stereo[2 * j + 1] = (int16_t)(s * 32767.0f);
+    }
+    
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        for (int j = 0; j < TEST_BLOCK; j++) {
+            float y = 0.0f;
+            for (int n = 0; n < 128; n++) {
+                y += echo_path(c, n) * room->reference[TEST_HISTORY - TEST_BLOCK + j - n];
+            }
+            room->echo[c][j] = y;
+            float tone = near_end * sinf(2.0f * M_PI * 1000.0f * (room->sample + j) / 16000.0f);
+            room->planar[c][j] = (int16_t)((y + tone) * 32767.0f);
+        }
+    }
+    room->sample += TEST_BLOCK;
+}
+
+static echo_canceller_context_t* create_canceller(void) {
+    echo_canceller_config_t config = {
+        .num_channels = TEST_CHANNELS,
+        .sample_rate = 16000,
+        .block_size = TEST_BLOCK,
+        .tail_length = 512,
+        .step_size = 0.5f,
+        .delay = 0
+    };
+    
+    echo_canceller_context_t *ctx = NULL;
+    int result = echo_canceller_init(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    return ctx;
+}
+
+static void test_echo_canceller_invalid_params(void) {
+    printf("Testing echo canceller invalid parameters...\n");
+    
+    echo_canceller_context_t *ctx = NULL;
+    echo_canceller_config_t config = {
+        .num_channels = 2,
+        .sample_rate = 16000,
+        .block_size = 100,
+        .tail_length = 512
+    };
+    
+    assert(echo_canceller_init(NULL, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(echo_canceller_init(&ctx, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(echo_canceller_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config.block_size = 2 * ECHO_CANCELLER_MAX_BLOCK;
+    assert(echo_canceller_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config.block_size = 64;
+    config.step_size = 1.5f;
+    assert(echo_canceller_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config.step_size = 0.0f;
+    assert(echo_canceller_init(&ctx, &config) == MICARRAY_SUCCESS);
+    
+    assert(echo_canceller_push_reference(NULL, NULL, 0) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(echo_canceller_process(ctx, NULL, 64, 0x3) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(echo_canceller_set_delay(ctx, -1) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(echo_canceller_set_delay(ctx, 320) == MICARRAY_SUCCESS);
+    assert(echo_canceller_get_delay(ctx) == 320);
+    
+    assert(echo_canceller_cleanup(ctx) == MICARRAY_SUCCESS);
+    assert(echo_canceller_cleanup(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Echo canceller invalid parameters test passed\n");
+}
+
+static void test_echo_canceller_convergence(void) {
+    printf("Testing echo cancellation convergence...\n");
+    
+    echo_canceller_context_t *ctx = create_canceller();
+    echo_room_t room;
+    memset(&room, 0, sizeof(room));
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        room.planar[c] = malloc(TEST_BLOCK * sizeof(int16_t));
+    }
+    
+    // Channel 2 is excluded and must come through untouched
+    const uint32_t mask = 0x3;
+    for (int block = 0; block < 375; block++) {
+        room_block(&room, 0.0f);
+        int16_t untouched[TEST_BLOCK];
+        memcpy(untouched, room.planar[2], sizeof(untouched));
+        
+        assert(echo_canceller_push_reference(ctx, room.stereo, TEST_BLOCK) == MICARRAY_SUCCESS);
+        assert(echo_canceller_process(ctx, room.planar, TEST_BLOCK, mask) == MICARRAY_SUCCESS);
+        assert(memcmp(untouched, room.planar[2], sizeof(untouched)) == 0);
+    }
+    
+    float erle = echo_canceller_get_erle(ctx);
+    printf("  ERLE after 3 s: %.1f dB\n", erle);
+    assert(erle > 25.0f);
+    
+    // Near-end speech survives once the echo is gone
+    double tone_energy = 0.0, residual_energy = 0.0;
+    for (int block = 0; block < 20; block++) {
+        room_block(&room, 0.1f);
+        echo_canceller_push_reference(ctx, room.stereo, TEST_BLOCK);
+        echo_canceller_process(ctx, room.planar, TEST_BLOCK, mask);
+        
+        for (int j = 0; j < TEST_BLOCK; j++) {
+            float tone = 0.1f * sinf(2.0f * M_PI * 1000.0f * (room.sample - TEST_BLOCK + j) / 16000.0f);
+            float residual = room.planar[0][j] / 32767.0f - tone;
+            tone_energy += tone * tone;
+            residual_energy += residual * residual;
+        }
+    }
+    assert(residual_energy < 0.05 * tone_energy);
+    
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        free(room.planar[c]);
+    }
+    echo_canceller_cleanup(ctx);
+    
+    printf("✓ Echo cancellation convergence test passed\n");
+}
+
+int main(void) {
+    printf("Running echo canceller tests...\n\n");
+    
+    test_echo_canceller_invalid_params();
+    test_echo_canceller_convergence();
+    
+    printf("\n✅ All echo canceller tests passed!\n");
+    return 0;
+}
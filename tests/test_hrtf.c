@@ -0,0 +1,201 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include "../src/hrtf.h"
+
+#define TEST_FILE "test_hrir.bin"
+#define TEST_TAPS 300
+#define TEST_DIRECTIONS 4
+#define TEST_BLOCK 128
+#define TEST_BLOCKS 12
+#define TEST_FRAMES (TEST_BLOCK * TEST_BLOCKS)
+
+/* Direction d (azimuth 90 * d) reaches the left ear after 10 * d samples
+ * and the right ear after 200 + d samples, so the right ear's impulse sits
+ * in the second of three partitions. */
+static int delay_of(int direction, int ear) {
+    return ear == 0 ? 10 * direction : 200 + direction;
+}
+
+static float gain_of(int direction, int ear) {
+    return ear == 0 ? 0.9f - 0.2f * direction : 0.3f + 0.1f * direction;
+}
+
+static void write_hrir_file(const char *magic, uint32_t sample_rate) {
+    FILE *file = fopen(TEST_FILE, "wb");
+    assert(file != NULL);
+    
+    uint32_t header[4] = {sample_rate, TEST_TAPS, TEST_DIRECTIONS, 0};
+    fwrite(magic, 1, 8, file);
+    fwrite(header, sizeof(header), 1, file);
+    
+    for (int d = 0; d < TEST_DIRECTIONS; d++) {
+        float angles[2] = {90.0f * d, 0.0f};
+        fwrite(angles, sizeof(angles), 1, file);
+    }
+    
+    for (int d = 0; d < TEST_DIRECTIONS; d++) {
+        for (int e = 0; e < 2; e++) {
+            float hrir[TEST_TAPS] = {0};
+            hrir[delay_of(d, e)] = gain_of(d, e);
+            fwrite(hrir, sizeof(hrir), 1, file);
+        }
+    }
+    
+    fclose(file);
+}
+
+static hrtf_context_t* create_renderer(int sources) {
+    hrtf_config_t config = {
+        .sample_rate = 16000,
+        .block_size = TEST_BLOCK,
+        .max_sources = sources
+    };
+    strcpy(config.hrir_file, TEST_FILE);
+    
+    hrtf_context_t *ctx = NULL;
+    int result = hrtf_init(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    return ctx;
+}
+
+static int16_t noise[2][TEST_FRAMES];
+
+static void fill_noise(void) {
+    uint32_t seed = 11;
+    for (int s = 0; s < 2; s++) {
+        for (int j = 0; j < TEST_FRAMES; j++) {
+            seed = seed * 1664525u + 1013904223u;
+            noise[s][j] = (int16_t)(((int32_t)(seed >> 16) - 32768) / 4);
+        }
+    }
+}
+
+static float expected(int source, int direction, int ear, int n) {
+    int k = n - delay_of(direction, ear);
+    return k < 0 ? 0.0f : gain_of(direction, ear) * noise[source][k];
+}
+
+static const sound_location_t facing[TEST_DIRECTIONS] = {
+    {1.0f, 0.0f, 0.0f, 1.0f},
+    {0.0f, 2.0f, 0.0f, 0.5f},
+    {-1.0f, 0.1f, 0.0f, 1.0f},
+    {0.0f, -1.0f, 0.2f, 1.0f}
+};
+
+static void test_hrtf_invalid_params(void) {
+    printf("Testing HRTF invalid parameters...\n");
+    
+    hrtf_context_t *ctx = NULL;
+    hrtf_config_t config = {
+        .sample_rate = 16000,
+        .block_size = TEST_BLOCK,
+        .max_sources = 1
+    };
+    strcpy(config.hrir_file, "/nonexistent/hrir.bin");
+    
+    assert(hrtf_init(NULL, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(hrtf_init(&ctx, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(hrtf_init(&ctx, &config) == MICARRAY_ERROR_CONFIG);
+    
+    strcpy(config.hrir_file, TEST_FILE);
+    write_hrir_file("NOTHRIR!", 16000);
+    assert(hrtf_init(&ctx, &config) == MICARRAY_ERROR_CONFIG);
+    
+    write_hrir_file(HRTF_FILE_MAGIC, 48000);
+    assert(hrtf_init(&ctx, &config) == MICARRAY_ERROR_CONFIG);
+    
+    write_hrir_file(HRTF_FILE_MAGIC, 16000);
+    config.block_size = 100;
+    assert(hrtf_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config.block_size = TEST_BLOCK;
+    config.max_sources = HRTF_MAX_SOURCES + 1;
+    assert(hrtf_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config.max_sources = 1;
+    assert(hrtf_init(&ctx, &config) == MICARRAY_SUCCESS);
+    assert(hrtf_get_num_directions(ctx) == TEST_DIRECTIONS);
+    assert(hrtf_get_taps(ctx) == TEST_TAPS);
+    
+    int16_t stereo[2 * TEST_BLOCK];
+    const int16_t *sources[1] = {noise[0]};
+    assert(hrtf_render(ctx, sources, facing, 1, 1.0f, stereo, TEST_BLOCK + 1) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(hrtf_render(ctx, sources, facing, 2, 1.0f, stereo, TEST_BLOCK) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    assert(hrtf_cleanup(ctx) == MICARRAY_SUCCESS);
+    assert(hrtf_cleanup(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ HRTF invalid parameters test passed\n");
+}
+
+static void test_hrtf_convolution(void) {
+    printf("Testing partitioned HRTF convolution...\n");
+    
+    hrtf_context_t *ctx = create_renderer(2);
+    int16_t *stereo = malloc(2 * TEST_FRAMES * sizeof(int16_t));
+    
+    // Two sources in one call, rendered a few blocks at a time
+    sound_location_t locations[2] = {facing[1], facing[2]};
+    for (int b = 0; b < TEST_BLOCKS; b += 3) {
+        const int16_t *sources[2] = {noise[0] + b * TEST_BLOCK, noise[1] + b * TEST_BLOCK};
+        int result = hrtf_render(ctx, sources, locations, 2, 1.0f, stereo + 2 * b * TEST_BLOCK, 3 * TEST_BLOCK);
+        assert(result == MICARRAY_SUCCESS);
+    }
+    
+    for (int n = 0; n < TEST_FRAMES; n++) {
+        for (int e = 0; e < 2; e++) {
+            float want = expected(0, 1, e, n) + expected(1, 2, e, n);
+            assert(abs(stereo[2 * n + e] - (int)(want + (want < 0 ? -0.5f : 0.5f))) <= 2);
+        }
+    }
+    
+    free(stereo);
+    hrtf_cleanup(ctx);
+    
+    printf("✓ HRTF convolution test passed\n");
+}
+
+static void test_hrtf_crossfade(void) {
+    printf("Testing HRTF direction crossfade...\n");
+    
+    hrtf_context_t *ctx = create_renderer(1);
+    int16_t stereo[2 * TEST_BLOCK];
+    
+    // Face direction 0 for six blocks, then turn to direction 3
+    for (int b = 0; b < TEST_BLOCKS; b++) {
+        const int16_t *sources[1] = {noise[0] + b * TEST_BLOCK};
+        const sound_location_t *location = b < 6 ? &facing[0] : &facing[3];
+        assert(hrtf_render(ctx, sources, location, 1, 1.0f, stereo, TEST_BLOCK) == MICARRAY_SUCCESS);
+        
+        for (int j = 0; j < TEST_BLOCK; j++) {
+            int n = b * TEST_BLOCK + j;
+            float w = b < 6 ? 0.0f : (b == 6 ? (j + 1) / (float)TEST_BLOCK : 1.0f);
+            for (int e = 0; e < 2; e++) {
+                float want = (1.0f - w) * expected(0, 0, e, n) + w * expected(0, 3, e, n);
+                assert(abs(stereo[2 * j + e] - (int)(want + (want < 0 ? -0.5f : 0.5f))) <= 2);
+            }
+        }
+    }
+    
+    hrtf_cleanup(ctx);
+    
+    printf("✓ HRTF crossfade test passed\n");
+}
+
+int main(void) {
+    printf("Running HRTF tests...\n\n");
+    
+    fill_noise();
+    
+    test_hrtf_invalid_params();
+    test_hrtf_convolution();
+    test_hrtf_crossfade();
+    
+    unlink(TEST_FILE);
+    
+    printf("\n✅ All HRTF tests passed!\n");
+    return 0;
+}
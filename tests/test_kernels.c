@@ -0,0 +1,151 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "../src/kernels.h"
+#include "../src/simd.h"
+
+// 129 vectors, as for a 512-sample block, leaves a tail for the wider paths
+#define TEST_VECTORS 129
+#define TEST_ROWS 7
+#define TEST_STRIDE 48
+
+static const char *const levels[] = {"scalar", "sse4", "avx2", "avx512", "neon", "dotprod"};
+
+static uint32_t next_random(uint32_t *seed) {
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed >> 16;
+}
+
+static float random_float(uint32_t *seed) {
+    return (float)next_random(seed) / 32768.0f - 1.0f;
+}
+
+static void test_kernels_selection(void) {
+    unsetenv("MICARRAY_KERNELS");
+    
+    assert(kernels_select("scalar") == MICARRAY_SUCCESS);
+    assert(strcmp(kernels_get()->level, "scalar") == 0);
+    
+    // Unknown names are rejected and leave the selection alone
+    assert(!kernels_is_known("sse2"));
+    assert(!kernels_is_known(NULL));
+    assert(kernels_select("sse2") == MICARRAY_ERROR_INVALID_PARAM);
+    assert(strcmp(kernels_get()->level, "scalar") == 0);
+    
+    // Known everywhere, runnable only on its own architecture
+#if defined(__x86_64__) || defined(__i386__)
+    assert(kernels_is_known("neon"));
+    assert(kernels_select("neon") == MICARRAY_ERROR_INIT);
+#elif defined(__aarch64__)
+    assert(kernels_is_known("avx2"));
+    assert(kernels_select("avx2") == MICARRAY_ERROR_INIT);
+#endif
+    assert(strcmp(kernels_get()->level, "scalar") == 0);
+    
+    assert(kernels_select("auto") == MICARRAY_SUCCESS);
+    printf("  auto selects %s\n", kernels_get()->level);
+    
+    // The environment overrides whatever the caller asks for
+    setenv("MICARRAY_KERNELS", "scalar", 1);
+    assert(kernels_select("auto") == MICARRAY_SUCCESS);
+    assert(strcmp(kernels_get()->level, "scalar") == 0);
+    setenv("MICARRAY_KERNELS", "bogus", 1);
+    assert(kernels_select("auto") == MICARRAY_ERROR_INVALID_PARAM);
+    unsetenv("MICARRAY_KERNELS");
+    
+    printf("✓ Kernel selection test passed\n");
+}
+
+static void test_kernels_match_scalar(void) {
+    const int count = TEST_VECTORS * SIMD_LANES;
+    float *a_re = (float*)simd_alloc(TEST_VECTORS);
+    float *a_im = (float*)simd_alloc(TEST_VECTORS);
+    float *b_re = (float*)simd_alloc(TEST_VECTORS);
+    float *b_im = (float*)simd_alloc(TEST_VECTORS);
+    float *ref_re = (float*)simd_alloc(TEST_VECTORS);
+    float *ref_im = (float*)simd_alloc(TEST_VECTORS);
+    float *y_re = (float*)simd_alloc(TEST_VECTORS);
+    float *y_im = (float*)simd_alloc(TEST_VECTORS);
+    int8_t weight[TEST_ROWS * TEST_STRIDE];
+    int8_t x[TEST_STRIDE];
+    int32_t ref_out[TEST_ROWS];
+    int32_t out[TEST_ROWS];
+    
+    uint32_t seed = 7;
+    for (int k = 0; k < count; k++) {
+        a_re[k] = random_float(&seed);
+        a_im[k] = random_float(&seed);
+        b_re[k] = random_float(&seed);
+        b_im[k] = random_float(&seed);
+        ref_re[k] = random_float(&seed);
+        ref_im[k] = random_float(&seed);
+    }
+    // Full-scale values check the int16 products and int32 sums
+    for (int i = 0; i < TEST_ROWS * TEST_STRIDE; i++) {
+        weight[i] = i < TEST_STRIDE ? -128 : (int8_t)(next_random(&seed) & 0xFF);
+    }
+    for (int j = 0; j < TEST_STRIDE; j++) {
+        x[j] = j % 5 == 0 ? -128 : (int8_t)(next_random(&seed) & 0xFF);
+    }
+    float *start_re = malloc(count * sizeof(float));
+    float *start_im = malloc(count * sizeof(float));
+    memcpy(start_re, ref_re, count * sizeof(float));
+    memcpy(start_im, ref_im, count * sizeof(float));
+    
+    assert(kernels_select("scalar") == MICARRAY_SUCCESS);
+    const kernel_table_t *scalar = kernels_get();
+    scalar->complex_mac(ref_re, ref_im, a_re, a_im, b_re, b_im, count);
+    scalar->gemv_int8(weight, TEST_ROWS, TEST_STRIDE, x, ref_out);
+    
+    int tested = 0;
+    for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+        if (kernels_select(levels[l]) != MICARRAY_SUCCESS) {
+            continue;
+        }
+        const kernel_table_t *table = kernels_get();
+        assert(strcmp(table->level, levels[l]) == 0);
+        
+        memcpy(y_re, start_re, count * sizeof(float));
+        memcpy(y_im, start_im, count * sizeof(float));
+        table->complex_mac(y_re, y_im, a_re, a_im, b_re, b_im, count);
+        for (int k = 0; k < count; k++) {
+            // Fused multiply-adds round differently
+            assert(fabsf(y_re[k] - ref_re[k]) < 1e-5f);
+            assert(fabsf(y_im[k] - ref_im[k]) < 1e-5f);
+        }
+        
+        memset(out, 0, sizeof(out));
+        table->gemv_int8(weight, TEST_ROWS, TEST_STRIDE, x, out);
+        assert(memcmp(out, ref_out, sizeof(out)) == 0);
+        
+        printf("  %s matches scalar\n", levels[l]);
+        tested++;
+    }
+    assert(tested >= 1);
+    
+    free(start_re);
+    free(start_im);
+    free(a_re);
+    free(a_im);
+    free(b_re);
+    free(b_im);
+    free(ref_re);
+    free(ref_im);
+    free(y_re);
+    free(y_im);
+    
+    printf("✓ Kernels match scalar test passed\n");
+}
+
+int main(void) {
+    printf("Running SIMD kernel tests...\n\n");
+    
+    test_kernels_selection();
+    test_kernels_match_scalar();
+    
+    printf("\n✅ All SIMD kernel tests passed!\n");
+    return 0;
+}
@@ -1,9 +1,16 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <dirent.h>
 #include "../src/libmicarray.h"
+#include "../src/beam_output.h"
+#include "../src/kernels.h"
 
 static void test_libmicarray_version(void) {
     printf("Testing libmicarray version...\n");
@@ -124,6 +131,712 @@ static void test_libmicarray_init_with_valid_config(void) {
     printf("✓ Valid config initialization test completed\n");
 }
 
+#define TEST_CHANNELS 4
+#define TEST_BLOCK 256
+
+static micarray_config_t headless_config(void) {
+    micarray_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.num_microphones = TEST_CHANNELS;
+    config.mic_spacing = 15.0f;
+    config.dma_buffer_size = 1024;
+    config.sample_rate = 16000;
+    config.noise_reduction_enable = false;
+    config.volume = 0.8f;
+    strcpy(config.log_level, "ERROR");
+    return config;
+}
+
+static void test_libmicarray_process_block(void) {
+    printf("Testing headless micarray_process_block...\n");
+    
+    micarray_config_t config = headless_config();
+    micarray_context_t *interleaved_ctx = NULL;
+    micarray_context_t *planar_ctx = NULL;
+    
+    int result = micarray_init_headless(&interleaved_ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    result = micarray_init_headless(&planar_ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    result = micarray_start(interleaved_ctx);
+    assert(result == MICARRAY_ERROR_INIT);
+    
+    int16_t interleaved[TEST_BLOCK * TEST_CHANNELS];
+    int16_t planar[TEST_BLOCK * TEST_CHANNELS];
+    int16_t out_a[TEST_BLOCK * 2];
+    int16_t out_b[TEST_BLOCK * 2];
+    
+    for (int block = 0; block < 4; block++) {
+        for (int j = 0; j < TEST_BLOCK; j++) {
+            for (int c = 0; c < TEST_CHANNELS; c++) {
+                int16_t sample = (int16_t)(8000.0f * sinf(2.0f * M_PI * 440.0f * (block * TEST_BLOCK + j) / 16000.0f));
+                interleaved[j * TEST_CHANNELS + c] = sample;
+                planar[c * TEST_BLOCK + j] = sample;
+            }
+        }
+        
+        sound_location_t loc_a, loc_b;
+        result = micarray_process_block(interleaved_ctx, interleaved, MICARRAY_LAYOUT_INTERLEAVED, 
+                                        TEST_BLOCK, out_a, &loc_a);
+        assert(result == MICARRAY_SUCCESS);
+        result = micarray_process_block(planar_ctx, planar, MICARRAY_LAYOUT_PLANAR, 
+                                        TEST_BLOCK, out_b, &loc_b);
+        assert(result == MICARRAY_SUCCESS);
+        
+        assert(memcmp(out_a, out_b, sizeof(out_a)) == 0);
+        assert(loc_a.confidence == loc_b.confidence);
+    }
+    
+    micarray_stats_t stats;
+    result = micarray_get_stats(interleaved_ctx, &stats);
+    assert(result == MICARRAY_SUCCESS);
+    assert(stats.blocks_processed == 4);
+    assert(stats.frames_processed == 4 * TEST_BLOCK);
+    assert(stats.localization_updates == 1);
+    assert(stats.max_block_ns >= stats.last_block_ns);
+    
+    result = micarray_process_block(interleaved_ctx, interleaved, MICARRAY_LAYOUT_INTERLEAVED, 
+                                    config.dma_buffer_size + 1, out_a, NULL);
+    assert(result == MICARRAY_ERROR_INVALID_PARAM);
+    
+    result = micarray_process_block(NULL, interleaved, MICARRAY_LAYOUT_INTERLEAVED, TEST_BLOCK, out_a, NULL);
+    assert(result == MICARRAY_ERROR_INVALID_PARAM);
+    
+    micarray_cleanup(interleaved_ctx);
+    micarray_cleanup(planar_ctx);
+    
+    printf("✓ Headless process block test passed\n");
+}
+
+static void test_libmicarray_low_latency_report(void) {
+    printf("Testing low-latency configuration report...\n");
+    
+    micarray_config_t config = headless_config();
+    config.noise_reduction_enable = true;
+    strcpy(config.algorithm, "spectral_subtraction");
+    
+    micarray_context_t *ctx = NULL;
+    int result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    micarray_latency_t normal;
+    result = micarray_get_latency(ctx, &normal);
+    assert(result == MICARRAY_SUCCESS);
+    assert(normal.block_frames == 1024);
+    assert(normal.noise_reduction_frames == 1024);
+    micarray_cleanup(ctx);
+    
+    config.low_latency = true;
+    config.hop_size = 128;
+    result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    micarray_latency_t low;
+    result = micarray_get_latency(ctx, &low);
+    assert(result == MICARRAY_SUCCESS);
+    assert(low.block_frames == 128);
+    assert(low.noise_reduction_frames == 256);
+    assert(low.output_frames == 0);
+    assert(low.localization_window_frames == 1024);
+    assert(fabsf(low.audio_latency_ms - 24.0f) < 0.01f);
+    assert(low.audio_latency_ms < normal.audio_latency_ms);
+    
+    // Localization still sees a full window assembled from 128-frame hops
+    int16_t input[128 * TEST_CHANNELS];
+    int16_t output[128 * 2];
+    memset(input, 0, sizeof(input));
+    for (int block = 0; block < 8; block++) {
+        result = micarray_process_block(ctx, input, MICARRAY_LAYOUT_INTERLEAVED, 128, output, NULL);
+        assert(result == MICARRAY_SUCCESS);
+    }
+    
+    micarray_stats_t stats;
+    micarray_get_stats(ctx, &stats);
+    assert(stats.localization_updates == 1);
+    
+    micarray_cleanup(ctx);
+    
+    // The limiter's look-ahead adds to the audio path
+    config.agc_enable = true;
+    config.agc_target_db = -20.0f;
+    config.agc_max_gain_db = 18.0f;
+    config.agc_ceiling_db = -1.0f;
+    config.agc_lookahead_ms = 5.0f;
+    result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    micarray_latency_t leveled;
+    micarray_get_latency(ctx, &leveled);
+    assert(leveled.agc_frames == 80);
+    assert(fabsf(leveled.audio_latency_ms - 29.0f) < 0.01f);
+    micarray_cleanup(ctx);
+    
+    // So does a dereverberation frame
+    config.dereverb_enable = true;
+    config.dereverb_order = 4;
+    config.dereverb_delay = 2;
+    config.dereverb_frame_size = 256;
+    config.dereverb_forgetting = 0.99f;
+    result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    micarray_latency_t dereverberated;
+    micarray_get_latency(ctx, &dereverberated);
+    assert(dereverberated.dereverb_frames == 256);
+    assert(fabsf(dereverberated.audio_latency_ms - 45.0f) < 0.01f);
+    
+    for (int block = 0; block < 8; block++) {
+        result = micarray_process_block(ctx, input, MICARRAY_LAYOUT_INTERLEAVED, 128, output, NULL);
+        assert(result == MICARRAY_SUCCESS);
+    }
+    
+    micarray_stage_stats_t stages[MICARRAY_MAX_STAGES];
+    int num_stages = 0;
+    micarray_get_stage_stats(ctx, stages, MICARRAY_MAX_STAGES, &num_stages);
+    bool found = false;
+    for (int i = 0; i < num_stages; i++) {
+        found |= strcmp(stages[i].name, "dereverb") == 0 && stages[i].calls == 8;
+    }
+    assert(found);
+    micarray_cleanup(ctx);
+    
+    printf("✓ Low-latency report test passed\n");
+}
+
+static void test_libmicarray_localization_rate(void) {
+    printf("Testing decoupled localization rate...\n");
+    
+    micarray_config_t config = headless_config();
+    config.low_latency = true;
+    config.hop_size = 128;
+    config.localization_rate = 62.5f;
+    config.localization_window = 2048;
+    
+    micarray_context_t *ctx = NULL;
+    int result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    micarray_latency_t latency;
+    micarray_get_latency(ctx, &latency);
+    assert(latency.localization_window_frames == 2048);
+    assert(latency.localization_interval_frames == 256);
+    assert(latency.block_frames == 128);
+    
+    int16_t input[128 * TEST_CHANNELS];
+    int16_t output[128 * 2];
+    memset(input, 0, sizeof(input));
+    for (int block = 0; block < 16; block++) {
+        result = micarray_process_block(ctx, input, MICARRAY_LAYOUT_INTERLEAVED, 128, output, NULL);
+        assert(result == MICARRAY_SUCCESS);
+    }
+    
+    micarray_stats_t stats;
+    micarray_get_stats(ctx, &stats);
+    assert(stats.blocks_processed == 16);
+    assert(stats.localization_updates == 8);
+    assert(stats.localization_overruns == 0);
+    
+    micarray_cleanup(ctx);
+    
+    config.localization_window = 100;
+    result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_ERROR_CONFIG);
+    assert(ctx == NULL);
+    
+    printf("✓ Localization rate test passed\n");
+}
+
+static void test_libmicarray_dead_channel(void) {
+    printf("Testing dead channel exclusion...\n");
+    
+    micarray_config_t config = headless_config();
+    config.health_monitor = true;
+    
+    micarray_context_t *ctx = NULL;
+    int result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    micarray_stats_t stats;
+    micarray_get_stats(ctx, &stats);
+    assert(stats.active_channel_mask == 0xF);
+    
+    // Channels 0-2 hear the same noise, channel 3 is silent
+    int16_t *input = malloc(1024 * TEST_CHANNELS * sizeof(int16_t));
+    int16_t *output = malloc(1024 * 2 * sizeof(int16_t));
+    uint32_t seed = 42;
+    for (int block = 0; block < 16; block++) {
+        for (int j = 0; j < 1024; j++) {
+            seed = seed * 1664525u + 1013904223u;
+            int16_t s = (int16_t)((int32_t)(seed >> 16) - 32768) / 4;
+            for (int c = 0; c < TEST_CHANNELS; c++) {
+                input[j * TEST_CHANNELS + c] = (c == 3) ? 0 : s;
+            }
+        }
+        result = micarray_process_block(ctx, input, MICARRAY_LAYOUT_INTERLEAVED, 1024, output, NULL);
+        assert(result == MICARRAY_SUCCESS);
+    }
+    
+    micarray_get_stats(ctx, &stats);
+    assert(stats.active_channel_mask == 0x7);
+    assert(stats.channel_exclusions == 1);
+    
+    free(input);
+    free(output);
+    micarray_cleanup(ctx);
+    
+    printf("✓ Dead channel exclusion test passed\n");
+}
+
+static void test_libmicarray_metrics(void) {
+    printf("Testing level and noise metrics...\n");
+    
+    micarray_config_t config = headless_config();
+    config.noise_reduction_enable = true;
+    config.noise_threshold = 0.05f;
+    strcpy(config.algorithm, "spectral_subtraction");
+    config.metrics_rate = 8.0f;
+    config.perf_counters = true;
+    
+    micarray_context_t *ctx = NULL;
+    int result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    // Counters are opened by the first thread to process a block
+    micarray_stats_t stats;
+    micarray_get_stats(ctx, &stats);
+    assert(stats.channel_rms[0] == 0.0f);
+    assert(!stats.perf_counters);
+    
+    // Channel c carries a tone at (c + 1) / 8 of full scale
+    int16_t *input = malloc(1024 * TEST_CHANNELS * sizeof(int16_t));
+    int16_t *output = malloc(1024 * 2 * sizeof(int16_t));
+    for (int block = 0; block < 4; block++) {
+        for (int j = 0; j < 1024; j++) {
+            float tone = sinf(2.0f * M_PI * 500.0f * (block * 1024 + j) / 16000.0f);
+            for (int c = 0; c < TEST_CHANNELS; c++) {
+                input[j * TEST_CHANNELS + c] = (int16_t)(tone * 4096.0f * (c + 1));
+            }
+        }
+        result = micarray_process_block(ctx, input, MICARRAY_LAYOUT_INTERLEAVED, 1024, output, NULL);
+        assert(result == MICARRAY_SUCCESS);
+    }
+    
+    micarray_get_stats(ctx, &stats);
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        float amplitude = (c + 1) / 8.0f;
+        assert(fabsf(stats.channel_rms[c] - amplitude / sqrtf(2.0f)) < 0.01f);
+        assert(fabsf(stats.channel_peak[c] - amplitude) < 0.01f);
+    }
+    assert(stats.noise_input_rms > 0.2f && stats.noise_input_rms < 0.25f);
+    assert(stats.noise_output_rms > 0.0f);
+    
+    micarray_stage_stats_t stage;
+    int num_stages = 0;
+    assert(micarray_get_stage_stats(ctx, &stage, 1, &num_stages) == MICARRAY_SUCCESS);
+    assert(num_stages > 1 && strcmp(stage.name, "noise_reduction") == 0);
+    assert(stats.perf_counters ? stage.cycles > 0 && stage.instructions > 0 : stage.cycles == 0);
+    
+    // Work outside the graph follows as pseudo-stages, counted the same way
+    micarray_stage_stats_t stages[MICARRAY_MAX_STAGES + MICARRAY_PSEUDO_STAGES];
+    int total = 0;
+    assert(micarray_get_stage_stats(ctx, stages, num_stages, &total) == MICARRAY_SUCCESS);
+    assert(total == num_stages && total <= 1 + MICARRAY_PSEUDO_STAGES);
+    const char *per_block[] = {"capture", "health", "render"};
+    for (size_t n = 0; n < sizeof(per_block) / sizeof(per_block[0]); n++) {
+        bool found = false;
+        for (int i = 1; i < total; i++) {
+            if (strcmp(stages[i].name, per_block[n]) == 0) {
+                found = true;
+                assert(stages[i].calls == 4 && stages[i].total_ns > 0);
+                assert(stats.perf_counters ? stages[i].instructions > 0 : stages[i].cycles == 0);
+            }
+        }
+        assert(found);
+    }
+    for (int i = 1; i < total; i++) {
+        assert(strcmp(stages[i].name, "recorder") != 0 && strcmp(stages[i].name, "beams") != 0);
+    }
+    
+    free(input);
+    free(output);
+    micarray_cleanup(ctx);
+    
+    printf("✓ Metrics test passed\n");
+}
+
+static void test_libmicarray_echo_cancellation(void) {
+    printf("Testing headless echo cancellation...\n");
+    
+    micarray_config_t config = headless_config();
+    config.aec_enable = true;
+    config.aec_tail_ms = 32;
+    config.aec_step = 0.5f;
+    config.aec_delay_ms = 0;
+    config.metrics_rate = 8.0f;
+    
+    // Partitions must divide the block and be at least 4 frames
+    micarray_context_t *ctx = NULL;
+    config.dma_buffer_size = 1022;
+    assert(micarray_init_headless(&ctx, &config) != MICARRAY_SUCCESS);
+    assert(ctx == NULL);
+    
+    config.dma_buffer_size = 1000;
+    int result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    // The rendered output is the reference for the next block's echo
+    int16_t *input = malloc(1000 * TEST_CHANNELS * sizeof(int16_t));
+    int16_t *output = calloc(1000 * 2, sizeof(int16_t));
+    uint32_t seed = 3;
+    for (int block = 0; block < 16; block++) {
+        for (int j = 0; j < 1000; j++) {
+            seed = seed * 1664525u + 1013904223u;
+            int16_t near_end = (int16_t)(((int32_t)(seed >> 16) - 32768) / 8);
+            for (int c = 0; c < TEST_CHANNELS; c++) {
+                input[j * TEST_CHANNELS + c] = near_end + output[2 * j] / 2;
+            }
+        }
+        result = micarray_process_block(ctx, input, MICARRAY_LAYOUT_INTERLEAVED, 1000, output, NULL);
+        assert(result == MICARRAY_SUCCESS);
+    }
+    
+    micarray_stats_t stats;
+    micarray_get_stats(ctx, &stats);
+    assert(isfinite(stats.echo_erle_db));
+    assert(stats.echo_erle_db >= 0.0f);
+    
+    free(input);
+    free(output);
+    micarray_cleanup(ctx);
+    
+    printf("✓ Echo cancellation test passed\n");
+}
+
+static void test_libmicarray_hrtf_output(void) {
+    printf("Testing headless HRTF output...\n");
+    
+    // One direction: the left ear hears the source as is, the right at half level
+    FILE *file = fopen("test_hrir.bin", "wb");
+    assert(file != NULL);
+    uint32_t header[4] = {16000, 4, 1, 0};
+    float angles[2] = {0.0f, 0.0f};
+    float hrir[2][4] = {{1.0f, 0.0f, 0.0f, 0.0f}, {0.5f, 0.0f, 0.0f, 0.0f}};
+    fwrite("MICHRIR1", 1, 8, file);
+    fwrite(header, sizeof(header), 1, file);
+    fwrite(angles, sizeof(angles), 1, file);
+    fwrite(hrir, sizeof(hrir), 1, file);
+    fclose(file);
+    
+    micarray_config_t config = headless_config();
+    strcpy(config.output_renderer, "hrtf");
+    strcpy(config.hrtf_file, "test_hrir.bin");
+    
+    micarray_context_t *ctx = NULL;
+    int result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    int16_t *input = malloc(1024 * TEST_CHANNELS * sizeof(int16_t));
+    int16_t *output = malloc(1024 * 2 * sizeof(int16_t));
+    for (int j = 0; j < 1024; j++) {
+        float tone = sinf(2.0f * M_PI * 500.0f * j / 16000.0f);
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            input[j * TEST_CHANNELS + c] = (int16_t)(tone * 8000.0f);
+        }
+    }
+    
+    result = micarray_process_block(ctx, input, MICARRAY_LAYOUT_INTERLEAVED, 1024, output, NULL);
+    assert(result == MICARRAY_SUCCESS);
+    
+    int loud = 0;
+    for (int j = 0; j < 1024; j++) {
+        assert(abs(output[2 * j] / 2 - output[2 * j + 1]) <= 1);
+        if (abs(output[2 * j]) > 1000) {
+            loud++;
+        }
+    }
+    assert(loud > 0);
+    
+    free(input);
+    free(output);
+    micarray_cleanup(ctx);
+    unlink("test_hrir.bin");
+    
+    printf("✓ HRTF output test passed\n");
+}
+
+static void test_libmicarray_beam_output(void) {
+    printf("Testing headless beam output...\n");
+    
+    micarray_config_t config = headless_config();
+    config.beam_enable = true;
+    config.beam_count = 3;
+    strcpy(config.beam_sink, "file");
+    strcpy(config.beam_target, "test_beams.wav");
+    config.beam_ring_ms = 100;
+    
+    // A headless context must not block on file I/O
+    micarray_context_t *ctx = NULL;
+    int result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_ERROR_CONFIG);
+    assert(ctx == NULL);
+    
+    strcpy(config.beam_sink, "shm");
+    strcpy(config.beam_target, "/micarray-test-libmicarray");
+    result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    sound_location_t side = {0.0f, 1.0f, 0.0f, 1.0f};
+    assert(micarray_steer_beam(ctx, 0, &side) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(micarray_steer_beam(ctx, 3, &side) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(micarray_steer_beam(ctx, 2, &side) == MICARRAY_SUCCESS);
+    
+    int16_t *input = calloc(TEST_BLOCK * TEST_CHANNELS, sizeof(int16_t));
+    int16_t *output = malloc(TEST_BLOCK * 2 * sizeof(int16_t));
+    for (int j = 0; j < TEST_BLOCK; j++) {
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            input[j * TEST_CHANNELS + c] = (int16_t)(1000 * (c + 1));
+        }
+    }
+    
+    for (int b = 0; b < 3; b++) {
+        result = micarray_process_block(ctx, input, MICARRAY_LAYOUT_INTERLEAVED, TEST_BLOCK, output, NULL);
+        assert(result == MICARRAY_SUCCESS);
+    }
+    
+    // The ring is at least two blocks, so the last block sits whole behind
+    // write_frames; every beam of a constant input is the channel mean
+    int fd = shm_open(config.beam_target, O_RDONLY, 0);
+    assert(fd >= 0);
+    beam_ring_header_t header;
+    assert(read(fd, &header, sizeof(header)) == (ssize_t)sizeof(header));
+    assert(header.channels == 3 && header.capacity == 2048);
+    assert(header.write_frames == 3 * TEST_BLOCK);
+    
+    int16_t frame[3];
+    off_t slot = (off_t)((header.write_frames - 1) % header.capacity);
+    assert(pread(fd, frame, sizeof(frame), sizeof(header) + slot * sizeof(frame)) == (ssize_t)sizeof(frame));
+    for (int b = 0; b < 3; b++) {
+        assert(abs(frame[b] - 2500) <= 1);
+    }
+    close(fd);
+    
+    free(input);
+    free(output);
+    micarray_cleanup(ctx);
+    shm_unlink(config.beam_target);
+    
+    printf("✓ Beam output test passed\n");
+}
+
+static void silence_process(void *state, float *const *input, float *const *output, size_t frames, 
+                            uint32_t active_mask) {
+    (void)state;
+    (void)input;
+    (void)active_mask;
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        memset(output[c], 0, frames * sizeof(float));
+    }
+}
+
+static void test_libmicarray_kernel_fallback(void) {
+    printf("Testing SIMD kernel fallback...\n");
+    
+    assert(kernels_select("auto") == MICARRAY_SUCCESS);
+    const char *best = kernels_get()->level;
+    
+    // A level this CPU cannot run replaces an earlier forced choice with
+    // the best available, as the warning says
+    micarray_config_t config = headless_config();
+#if defined(__x86_64__) || defined(__i386__)
+    strcpy(config.kernels, "neon");
+#else
+    strcpy(config.kernels, "avx2");
+#endif
+    assert(kernels_select("scalar") == MICARRAY_SUCCESS);
+    
+    micarray_context_t *ctx = NULL;
+    unsetenv("MICARRAY_KERNELS");
+    assert(micarray_init_headless(&ctx, &config) == MICARRAY_SUCCESS);
+    assert(strcmp(kernels_get()->level, best) == 0);
+    micarray_cleanup(ctx);
+    
+    printf("✓ Kernel fallback test passed\n");
+}
+
+static int count_recordings(const char *directory) {
+    int count = 0;
+    DIR *dir = opendir(directory);
+    assert(dir != NULL);
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+static void remove_recordings(const char *directory) {
+    DIR *dir = opendir(directory);
+    struct dirent *entry;
+    char path[512];
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+            unlink(path);
+        }
+    }
+    closedir(dir);
+    rmdir(directory);
+}
+
+static int headless_trigger_recordings(float trigger_confidence) {
+    char directory[] = "/tmp/micarray_trigger_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    
+    micarray_config_t config = headless_config();
+    config.recorder_enable = true;
+    strcpy(config.recorder_directory, directory);
+    strcpy(config.recorder_format, "wav");
+    config.recorder_pre_ms = 100;
+    config.recorder_post_ms = 100;
+    config.recorder_trigger_confidence = trigger_confidence;
+    
+    micarray_context_t *ctx = NULL;
+    int result = micarray_init_headless(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    // Only the reference channel hears the noise, a weak fix of 0.25
+    int16_t *input = calloc(1024 * TEST_CHANNELS, sizeof(int16_t));
+    int16_t *output = malloc(1024 * 2 * sizeof(int16_t));
+    uint32_t seed = 7;
+    for (int block = 0; block < 4; block++) {
+        for (int j = 0; j < 1024; j++) {
+            seed = seed * 1664525u + 1013904223u;
+            input[j * TEST_CHANNELS] = (int16_t)((int32_t)(seed >> 16) - 32768) / 4;
+        }
+        result = micarray_process_block(ctx, input, MICARRAY_LAYOUT_INTERLEAVED, 1024, output, NULL);
+        assert(result == MICARRAY_SUCCESS);
+    }
+    
+    sound_location_t location;
+    micarray_get_location(ctx, &location);
+    assert(fabsf(location.confidence - 0.25f) < 1e-3f);
+    micarray_cleanup(ctx);
+    
+    int recordings = count_recordings(directory);
+    remove_recordings(directory);
+    free(input);
+    free(output);
+    return recordings;
+}
+
+static void test_libmicarray_confidence_trigger(void) {
+    printf("Testing confidence-triggered recording...\n");
+    
+    assert(headless_trigger_recordings(0.2f) == 1);
+    assert(headless_trigger_recordings(0.3f) == 0);
+    
+    // A started context publishes its fixes from the localization worker
+    char directory[] = "/tmp/micarray_trigger_XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    FILE *config_file = fopen("test_trigger.conf", "w");
+    assert(config_file != NULL);
+    fprintf(config_file,
+        "[General]\n"
+        "log_level = \"ERROR\"\n"
+        "\n"
+        "[MicrophoneArray]\n"
+        "num_microphones = 4\n"
+        "mic_spacing = 15mm\n"
+        "i2s_bus = 1\n"
+        "dma_buffer_size = 1024\n"
+        "sample_rate = 16000\n"
+        "\n"
+        "[Recorder]\n"
+        "enable = true\n"
+        "directory = %s\n"
+        "pre_trigger_ms = 100\n"
+        "post_trigger_ms = 100\n"
+        "trigger_confidence = 0.01\n", directory);
+    fclose(config_file);
+    
+    micarray_context_t *ctx = NULL;
+    int result = micarray_init(&ctx, "test_trigger.conf");
+    if (result == MICARRAY_SUCCESS) {
+        result = micarray_start(ctx);
+        assert(result == MICARRAY_SUCCESS);
+        sound_location_t location;
+        location.confidence = 0.0f;
+        for (int i = 0; i < 40 && location.confidence < 0.01f; i++) {
+            usleep(50000);
+            micarray_get_location(ctx, &location);
+        }
+        micarray_cleanup(ctx);
+        if (location.confidence >= 0.01f) {
+            assert(count_recordings(directory) == 1);
+        }
+    } else {
+        printf("  Note: Hardware initialization failed (expected on test systems)\n");
+    }
+    unlink("test_trigger.conf");
+    remove_recordings(directory);
+    
+    printf("✓ Confidence trigger test passed\n");
+}
+
+static void test_libmicarray_custom_stage(void) {
+    printf("Testing a registered pipeline stage...\n");
+    
+    static const micarray_stage_t silence = {
+        .name = "silence",
+        .flags = MICARRAY_STAGE_IN_PLACE,
+        .process = silence_process
+    };
+    micarray_stage_t builtin = silence;
+    builtin.name = "aec";
+    assert(micarray_register_stage(&builtin) == MICARRAY_ERROR_INVALID_PARAM);
+    builtin.name = "dereverb";
+    assert(micarray_register_stage(&builtin) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(micarray_register_stage(&silence) == MICARRAY_SUCCESS);
+    
+    micarray_config_t config = headless_config();
+    micarray_context_t *ctx = NULL;
+    strcpy(config.pipeline_stages, "prefilter, missing");
+    assert(micarray_init_headless(&ctx, &config) == MICARRAY_ERROR_CONFIG);
+    
+    // The disabled pre-filter drops out of the graph
+    strcpy(config.pipeline_stages, "prefilter, silence");
+    assert(micarray_init_headless(&ctx, &config) == MICARRAY_SUCCESS);
+    
+    int16_t input[TEST_BLOCK * TEST_CHANNELS];
+    int16_t output[TEST_BLOCK * 2];
+    for (int j = 0; j < TEST_BLOCK * TEST_CHANNELS; j++) {
+        input[j] = (int16_t)(8000.0f * sinf(2.0f * M_PI * 440.0f * j / (16000.0f * TEST_CHANNELS)));
+    }
+    
+    for (int block = 0; block < 3; block++) {
+        int result = micarray_process_block(ctx, input, MICARRAY_LAYOUT_INTERLEAVED, TEST_BLOCK, output, NULL);
+        assert(result == MICARRAY_SUCCESS);
+        for (int j = 0; j < TEST_BLOCK * 2; j++) {
+            assert(output[j] == 0);
+        }
+    }
+    
+    micarray_stage_stats_t stats[2];
+    int num_stages = 0;
+    assert(micarray_get_stage_stats(ctx, stats, 2, &num_stages) == MICARRAY_SUCCESS);
+    assert(num_stages == 1);
+    assert(strcmp(stats[0].name, "silence") == 0 && stats[0].calls == 3);
+    assert(micarray_get_stage_stats(NULL, stats, 2, &num_stages) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    micarray_cleanup(ctx);
+    
+    printf("✓ Custom stage test passed\n");
+}
+
 static void test_libmicarray_operations_without_init(void) {
     printf("Testing libmicarray operations without initialization...\n");
     
@@ -154,6 +867,17 @@ int main(void) {
     test_libmicarray_init_invalid_params();
     test_libmicarray_init_missing_config();
     test_libmicarray_init_with_valid_config();
+    test_libmicarray_process_block();
+    test_libmicarray_low_latency_report();
+    test_libmicarray_localization_rate();
+    test_libmicarray_dead_channel();
+    test_libmicarray_metrics();
+    test_libmicarray_echo_cancellation();
+    test_libmicarray_hrtf_output();
+    test_libmicarray_beam_output();
+    test_libmicarray_kernel_fallback();
+    test_libmicarray_confidence_trigger();
+    test_libmicarray_custom_stage();
     test_libmicarray_operations_without_init();
     
     printf("\n✅ All libmicarray integration tests passed!\n");
@@ -129,6 +129,293 @@ static void test_localization_processing(void) {
     printf("✓ Localization processing test passed\n");
 }
 
+static void test_localization_incremental_gcc(void) {
+    printf("Testing incremental GCC-PHAT delay estimation...\n");
+    
+    localization_context_t *ctx = NULL;
+    
+    localization_config_t config = {
+        .num_microphones = 4,
+        .mic_positions = NULL,
+        .mic_spacing = 0.1f,
+        .sample_rate = 16000,
+        .speed_of_sound = 343.0f,
+        .correlation_window_size = 1024,
+        .min_confidence_threshold = 0.1f,
+        .gcc_frame_size = 256,
+        .gcc_smoothing = 0.3f
+    };
+    
+    int result = localization_init(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    // Broadband source, each microphone a whole number of samples behind mic 0
+    const int delays[4] = {0, 2, -1, 3};
+    const size_t samples = 4096;
+    const size_t hop = 64;
+    int16_t *noise = malloc((samples + 16) * sizeof(int16_t));
+    uint32_t seed = 12345;
+    for (size_t s = 0; s < samples + 16; s++) {
+        seed = seed * 1664525u + 1013904223u;
+        noise[s] = (int16_t)((int32_t)(seed >> 16) - 32768) / 4;
+    }
+    
+    int16_t *mic_data[4];
+    for (int i = 0; i < 4; i++) {
+        mic_data[i] = malloc(samples * sizeof(int16_t));
+        for (size_t s = 0; s < samples; s++) {
+            mic_data[i][s] = noise[s + 8 - delays[i]];
+        }
+    }
+    
+    // Fewer samples than one hop produce no estimate yet
+    sound_location_t location;
+    result = localization_process(ctx, mic_data, 64, &location);
+    assert(result == MICARRAY_SUCCESS);
+    assert(location.confidence == 0.0f);
+    
+    for (size_t s = 64; s < samples; s += hop) {
+        int16_t *chunk[4];
+        for (int i = 0; i < 4; i++) {
+            chunk[i] = mic_data[i] + s;
+        }
+        result = localization_process(ctx, chunk, hop, &location);
+        assert(result == MICARRAY_SUCCESS);
+    }
+    
+    float estimated[4];
+    float confidences[4];
+    result = localization_get_delays(ctx, estimated, confidences, 4);
+    assert(result == MICARRAY_SUCCESS);
+    
+    for (int i = 1; i < 4; i++) {
+        assert(fabsf(estimated[i] - delays[i]) < 0.25f);
+        assert(confidences[i] > 0.5f && confidences[i] <= 1.0f);
+    }
+    
+    result = localization_get_delays(ctx, estimated, confidences, 3);
+    assert(result == MICARRAY_ERROR_INVALID_PARAM);
+    
+    // Excluding mic 0 moves the reference to mic 1 and restarts the pairs
+    result = localization_set_active_mask(ctx, 0xE);
+    assert(result == MICARRAY_SUCCESS);
+    assert(localization_set_active_mask(ctx, 0x10) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    for (size_t s = 0; s < samples; s += hop) {
+        int16_t *chunk[4];
+        for (int i = 0; i < 4; i++) {
+            chunk[i] = mic_data[i] + s;
+        }
+        localization_process(ctx, chunk, hop, &location);
+    }
+    
+    localization_get_delays(ctx, estimated, confidences, 4);
+    assert(confidences[0] == 0.0f);
+    assert(estimated[1] == 0.0f);
+    for (int i = 2; i < 4; i++) {
+        assert(fabsf(estimated[i] - (delays[i] - delays[1])) < 0.25f);
+    }
+    
+    for (int i = 0; i < 4; i++) {
+        free(mic_data[i]);
+    }
+    free(noise);
+    
+    result = localization_cleanup(ctx);
+    assert(result == MICARRAY_SUCCESS);
+    
+    // Odd frame sizes cannot be split into two hops
+    config.gcc_frame_size = 255;
+    result = localization_init(&ctx, &config);
+    assert(result == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Incremental GCC-PHAT test passed\n");
+}
+
+static void test_localization_specialized(void) {
+    printf("Testing fixed-span GCC-PHAT lag search...\n");
+    
+    // The 8 x 15 mm circle at both sample rates with an instance: the
+    // fixed lag span must give the generic search's answers
+    static const int rates[] = {16000, 48000};
+    for (int r = 0; r < 2; r++) {
+        localization_config_t config = {
+            .num_microphones = 8,
+            .mic_spacing = 0.015f,
+            .sample_rate = rates[r],
+            .speed_of_sound = 343.0f,
+            .min_confidence_threshold = 0.1f,
+            .gcc_frame_size = 512
+        };
+        localization_context_t *fixed = NULL, *generic = NULL;
+        assert(localization_init(&fixed, &config) == MICARRAY_SUCCESS);
+        config.generic = true;
+        assert(localization_init(&generic, &config) == MICARRAY_SUCCESS);
+        assert(localization_get_lag_search(fixed) == (r == 0 ? 2 : 5));
+        assert(localization_get_lag_search(generic) == 0);
+        
+        const int spread = r == 0 ? 1 : 4;
+        const size_t samples = 4096;
+        int16_t *mic_data[8];
+        uint32_t seed = 99;
+        int16_t *noise = malloc((samples + 16) * sizeof(int16_t));
+        for (size_t s = 0; s < samples + 16; s++) {
+            seed = seed * 1664525u + 1013904223u;
+            noise[s] = (int16_t)((int32_t)(seed >> 16) - 32768) / 4;
+        }
+        for (int i = 0; i < 8; i++) {
+            mic_data[i] = malloc(samples * sizeof(int16_t));
+            for (size_t s = 0; s < samples; s++) {
+                mic_data[i][s] = noise[s + 8 - ((i + spread) % (2 * spread + 1) - spread)];
+            }
+        }
+        
+        sound_location_t a, b;
+        for (size_t s = 0; s < samples; s += 256) {
+            int16_t *chunk[8];
+            for (int i = 0; i < 8; i++) {
+                chunk[i] = mic_data[i] + s;
+            }
+            assert(localization_process(fixed, chunk, 256, &a) == MICARRAY_SUCCESS);
+            assert(localization_process(generic, chunk, 256, &b) == MICARRAY_SUCCESS);
+        }
+        
+        float fixed_delays[8], generic_delays[8], fixed_conf[8], generic_conf[8];
+        localization_get_delays(fixed, fixed_delays, fixed_conf, 8);
+        localization_get_delays(generic, generic_delays, generic_conf, 8);
+        for (int i = 0; i < 8; i++) {
+            assert(fixed_delays[i] == generic_delays[i]);
+            assert(fixed_conf[i] == generic_conf[i]);
+        }
+        assert(fabsf(fixed_delays[1] - 1.0f) < 0.25f);
+        
+        for (int i = 0; i < 8; i++) {
+            free(mic_data[i]);
+        }
+        free(noise);
+        localization_cleanup(fixed);
+        localization_cleanup(generic);
+    }
+    
+    // Only the lag span is specialised: 44.1 kHz spans 4 lags and falls
+    // back, the time-domain estimator has no lag search at all
+    localization_config_t other = {
+        .num_microphones = 8,
+        .mic_spacing = 0.015f,
+        .sample_rate = 44100,
+        .speed_of_sound = 343.0f,
+        .gcc_frame_size = 512
+    };
+    localization_context_t *ctx = NULL;
+    assert(localization_init(&ctx, &other) == MICARRAY_SUCCESS);
+    assert(localization_get_lag_search(ctx) == 0);
+    localization_cleanup(ctx);
+    other.sample_rate = 16000;
+    other.gcc_frame_size = 0;
+    assert(localization_init(&ctx, &other) == MICARRAY_SUCCESS);
+    assert(localization_get_lag_search(ctx) == 0);
+    localization_cleanup(ctx);
+    assert(localization_get_lag_search(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Fixed-span GCC-PHAT test passed\n");
+}
+
+static float tonal_pair_confidence(int max_bins, float *delay) {
+    localization_context_t *ctx = NULL;
+    
+    localization_config_t config = {
+        .num_microphones = 2,
+        .mic_positions = NULL,
+        .mic_spacing = 0.1f,
+        .sample_rate = 16000,
+        .speed_of_sound = 343.0f,
+        .correlation_window_size = 1024,
+        .min_confidence_threshold = 0.0f,
+        .gcc_frame_size = 256,
+        .gcc_smoothing = 0.3f,
+        .band_low_hz = 300.0f,
+        .band_high_hz = 4000.0f,
+        .max_bins = max_bins
+    };
+    
+    int result = localization_init(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    // Flat noise floor: ranking by SNR picks the loudest bins
+    float psd[129];
+    for (int k = 0; k < 129; k++) {
+        psd[k] = 1e-6f;
+    }
+    result = localization_set_noise_psd(ctx, psd, 129);
+    assert(result == MICARRAY_SUCCESS);
+    result = localization_set_noise_psd(ctx, psd, 128);
+    assert(result == MICARRAY_ERROR_INVALID_PARAM);
+    
+    // Tones on bin centres reach mic 1 two samples late; each microphone
+    // also picks up its own uncorrelated noise
+    const size_t samples = 4096;
+    int16_t *mic_data[2];
+    uint32_t seed = 777;
+    for (int i = 0; i < 2; i++) {
+        mic_data[i] = malloc(samples * sizeof(int16_t));
+        for (size_t s = 0; s < samples; s++) {
+            float t = (float)s - (i == 1 ? 2.0f : 0.0f);
+            float tone = 0.0f;
+            for (int bin = 8; bin <= 32; bin += 8) {
+                tone += sinf(2.0f * M_PI * bin * t / 256.0f) * 3000.0f;
+            }
+            seed = seed * 1664525u + 1013904223u;
+            float noise = ((int32_t)(seed >> 16) - 32768) / 4.0f;
+            mic_data[i][s] = (int16_t)(tone + noise);
+        }
+    }
+    
+    sound_location_t location;
+    result = localization_process(ctx, mic_data, samples, &location);
+    assert(result == MICARRAY_SUCCESS);
+    
+    float delays[2];
+    float confidences[2];
+    result = localization_get_delays(ctx, delays, confidences, 2);
+    assert(result == MICARRAY_SUCCESS);
+    *delay = delays[1];
+    
+    for (int i = 0; i < 2; i++) {
+        free(mic_data[i]);
+    }
+    localization_cleanup(ctx);
+    
+    return confidences[1];
+}
+
+static void test_localization_bin_selection(void) {
+    printf("Testing GCC-PHAT band and SNR bin selection...\n");
+    
+    float all_delay, top_delay;
+    float all_confidence = tonal_pair_confidence(0, &all_delay);
+    float top_confidence = tonal_pair_confidence(8, &top_delay);
+    
+    assert(fabsf(top_delay - 2.0f) < 0.25f);
+    assert(top_confidence > 0.8f);
+    assert(top_confidence > all_confidence + 0.2f);
+    
+    // A band with no bins in it is rejected
+    localization_context_t *ctx = NULL;
+    localization_config_t config = {
+        .num_microphones = 2,
+        .mic_spacing = 0.1f,
+        .sample_rate = 16000,
+        .correlation_window_size = 1024,
+        .gcc_frame_size = 256,
+        .band_low_hz = 5000.0f,
+        .band_high_hz = 4000.0f
+    };
+    int result = localization_init(&ctx, &config);
+    assert(result == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Bin selection test passed\n");
+}
+
 static void test_localization_mic_positions(void) {
     printf("Testing localization microphone position setting...\n");
     
@@ -185,6 +472,9 @@ int main(void) {
     test_localization_init();
     test_localization_invalid_params();
     test_localization_processing();
+    test_localization_incremental_gcc();
+    test_localization_specialized();
+    test_localization_bin_selection();
     test_localization_mic_positions();
     
     printf("\n✅ All localization tests passed!\n");
@@ -0,0 +1,282 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../src/lossless.h"
+
+#define TEST_CHANNELS 5
+#define TEST_BLOCK 1000
+#define TEST_FRAMES 10500
+#define TEST_FILE "test_capture.mla"
+
+static int16_t samples[TEST_FRAMES * TEST_CHANNELS];
+
+/* One channel of each kind the encoder picks a different method for: a
+ * tone, a tone with noise, silence, full-scale noise and a square wave
+ * that slams between the rails. */
+static void fill_channels(void) {
+    uint32_t seed = 99;
+    for (int n = 0; n < TEST_FRAMES; n++) {
+        seed = seed * 1664525u + 1013904223u;
+        int32_t noise = (int32_t)(seed >> 16) - 32768;
+        float tone = sinf(2.0f * (float)M_PI * 440.0f * n / 16000.0f);
+        
+        int16_t *frame = samples + n * TEST_CHANNELS;
+        frame[0] = (int16_t)(12000.0f * tone);
+        frame[1] = (int16_t)(8000.0f * tone + noise / 256);
+        frame[2] = 0;
+        frame[3] = (int16_t)noise;
+        frame[4] = (n / 37) % 2 ? 32767 : -32768;
+    }
+}
+
+static lossless_writer_t* create_writer(int threads) {
+    lossless_config_t config = {
+        .channels = TEST_CHANNELS,
+        .sample_rate = 16000,
+        .block_frames = TEST_BLOCK,
+        .threads = threads
+    };
+    
+    lossless_writer_t *ctx = NULL;
+    int result = lossless_writer_init(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    return ctx;
+}
+
+/* Writes the first frames in uneven pieces so blocks fill across calls. */
+static void write_capture(lossless_writer_t *ctx, size_t frames, bool finish) {
+    int fd = open(TEST_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    assert(fd >= 0);
+    assert(lossless_writer_begin(ctx, fd) == MICARRAY_SUCCESS);
+    
+    size_t done = 0;
+    for (size_t piece = 1; done < frames; piece = piece * 3 + 1) {
+        size_t count = piece < frames - done ? piece : frames - done;
+        assert(lossless_writer_write(ctx, samples + done * TEST_CHANNELS, count) == MICARRAY_SUCCESS);
+        done += count;
+    }
+    
+    if (finish) {
+        assert(lossless_writer_finish(ctx) == MICARRAY_SUCCESS);
+    }
+    close(fd);
+}
+
+static void check_frames(lossless_reader_t *reader, uint64_t first, size_t frames) {
+    int16_t *out = malloc(frames * TEST_CHANNELS * sizeof(int16_t));
+    size_t read;
+    assert(lossless_reader_read(reader, out, frames, &read) == MICARRAY_SUCCESS);
+    assert(read == frames);
+    assert(memcmp(out, samples + first * TEST_CHANNELS, frames * TEST_CHANNELS * sizeof(int16_t)) == 0);
+    free(out);
+}
+
+static void test_lossless_invalid_params(void) {
+    printf("Testing lossless codec invalid parameters...\n");
+    
+    lossless_writer_t *ctx = NULL;
+    lossless_config_t config = {
+        .channels = TEST_CHANNELS,
+        .sample_rate = 16000,
+        .block_frames = LOSSLESS_MAX_BLOCK + 1
+    };
+    
+    assert(lossless_writer_init(NULL, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(lossless_writer_init(&ctx, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(lossless_writer_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    ctx = create_writer(2);
+    assert(lossless_writer_write(ctx, samples, 10) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(lossless_writer_finish(ctx) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(lossless_writer_begin(ctx, -1) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(lossless_writer_cleanup(ctx) == MICARRAY_SUCCESS);
+    assert(lossless_writer_cleanup(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    lossless_reader_t *reader = NULL;
+    assert(lossless_reader_open(&reader, "does-not-exist.mla") == MICARRAY_ERROR_CONFIG);
+    
+    FILE *file = fopen(TEST_FILE, "wb");
+    assert(file != NULL);
+    fwrite(samples, 1, 4096, file);
+    fclose(file);
+    assert(lossless_reader_open(&reader, TEST_FILE) == MICARRAY_ERROR_CONFIG);
+    unlink(TEST_FILE);
+    
+    printf("✓ Lossless codec invalid parameters test passed\n");
+}
+
+static void test_lossless_round_trip(void) {
+    printf("Testing lossless round trip...\n");
+    
+    lossless_writer_t *ctx = create_writer(3);
+    write_capture(ctx, TEST_FRAMES, true);
+    
+    // Everything but the noise channel shrinks well below 16 bits
+    struct stat st;
+    assert(stat(TEST_FILE, &st) == 0);
+    size_t raw = sizeof(samples);
+    assert((size_t)st.st_size < raw * 6 / 10);
+    
+    lossless_reader_t *reader = NULL;
+    assert(lossless_reader_open(&reader, TEST_FILE) == MICARRAY_SUCCESS);
+    lossless_info_t info;
+    assert(lossless_reader_get_info(reader, &info) == MICARRAY_SUCCESS);
+    assert(info.channels == TEST_CHANNELS && info.sample_rate == 16000);
+    assert(info.frames == TEST_FRAMES && info.blocks == 11);
+    
+    check_frames(reader, 0, TEST_FRAMES);
+    size_t read;
+    int16_t spare[TEST_CHANNELS];
+    assert(lossless_reader_read(reader, spare, 1, &read) == MICARRAY_SUCCESS && read == 0);
+    
+    // Seeking lands mid-block and reads run across block boundaries
+    assert(lossless_reader_seek(reader, 4321) == MICARRAY_SUCCESS);
+    check_frames(reader, 4321, 2000);
+    assert(lossless_reader_seek(reader, 10499) == MICARRAY_SUCCESS);
+    check_frames(reader, 10499, 1);
+    assert(lossless_reader_seek(reader, 17) == MICARRAY_SUCCESS);
+    check_frames(reader, 17, 5);
+    assert(lossless_reader_seek(reader, TEST_FRAMES + 1) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    lossless_reader_close(reader);
+    
+    // The same encoder with a single thread writes the same bytes
+    uint8_t *threaded = malloc(st.st_size);
+    FILE *file = fopen(TEST_FILE, "rb");
+    assert(fread(threaded, 1, st.st_size, file) == (size_t)st.st_size);
+    fclose(file);
+    
+    lossless_writer_cleanup(ctx);
+    ctx = create_writer(1);
+    write_capture(ctx, TEST_FRAMES, true);
+    uint8_t *single = malloc(st.st_size);
+    file = fopen(TEST_FILE, "rb");
+    assert(fread(single, 1, st.st_size, file) == (size_t)st.st_size);
+    fclose(file);
+    assert(memcmp(threaded, single, st.st_size) == 0);
+    
+    free(threaded);
+    free(single);
+    lossless_writer_cleanup(ctx);
+    unlink(TEST_FILE);
+    
+    printf("✓ Lossless round trip test passed\n");
+}
+
+static void test_lossless_unfinished(void) {
+    printf("Testing recovery of an unfinished file...\n");
+    
+    // The writer dies mid-block: the whole blocks are recovered by scanning
+    lossless_writer_t *ctx = create_writer(2);
+    write_capture(ctx, 3500, false);
+    
+    lossless_reader_t *reader = NULL;
+    assert(lossless_reader_open(&reader, TEST_FILE) == MICARRAY_SUCCESS);
+    lossless_info_t info;
+    lossless_reader_get_info(reader, &info);
+    assert(info.frames == 3000 && info.blocks == 3);
+    
+    assert(lossless_reader_seek(reader, 1500) == MICARRAY_SUCCESS);
+    check_frames(reader, 1500, 1500);
+    lossless_reader_close(reader);
+    
+    // A file reused for a new capture starts over
+    write_capture(ctx, 0, true);
+    assert(lossless_reader_open(&reader, TEST_FILE) == MICARRAY_SUCCESS);
+    lossless_reader_get_info(reader, &info);
+    assert(info.frames == 0 && info.blocks == 0);
+    lossless_reader_close(reader);
+    
+    lossless_writer_cleanup(ctx);
+    unlink(TEST_FILE);
+    
+    printf("✓ Unfinished file test passed\n");
+}
+
+static void patch_file(off_t offset, const void *data, size_t size) {
+    int fd = open(TEST_FILE, O_RDWR);
+    assert(fd >= 0);
+    assert(pwrite(fd, data, size, offset) == (ssize_t)size);
+    close(fd);
+}
+
+static void read_file(off_t offset, void *data, size_t size) {
+    int fd = open(TEST_FILE, O_RDONLY);
+    assert(fd >= 0);
+    assert(pread(fd, data, size, offset) == (ssize_t)size);
+    close(fd);
+}
+
+static void test_lossless_corrupt_index(void) {
+    printf("Testing rejection of a corrupt index...\n");
+    
+    lossless_writer_t *ctx = create_writer(2);
+    lossless_reader_t *reader = NULL;
+    lossless_header_t header;
+    lossless_index_entry_t entry;
+    
+    // The first block must start at frame 0
+    write_capture(ctx, 3500, true);
+    read_file(0, &header, sizeof(header));
+    assert(header.index_blocks == 4 && header.total_frames == 3500);
+    read_file(header.index_offset, &entry, sizeof(entry));
+    entry.first_frame = 5;
+    patch_file(header.index_offset, &entry, sizeof(entry));
+    assert(lossless_reader_open(&reader, TEST_FILE) == MICARRAY_ERROR_CONFIG);
+    
+    // Entries must follow on from each other
+    write_capture(ctx, 3500, true);
+    off_t third = header.index_offset + 2 * sizeof(entry);
+    read_file(third, &entry, sizeof(entry));
+    entry.first_frame += 1;
+    patch_file(third, &entry, sizeof(entry));
+    assert(lossless_reader_open(&reader, TEST_FILE) == MICARRAY_ERROR_CONFIG);
+    
+    // total_frames must end inside the last block
+    write_capture(ctx, 3500, true);
+    header.total_frames = 9000;
+    patch_file(0, &header, sizeof(header));
+    assert(lossless_reader_open(&reader, TEST_FILE) == MICARRAY_ERROR_CONFIG);
+    
+    // A block shorter than the index says fails the read instead of spinning
+    write_capture(ctx, 3500, true);
+    header.total_frames = 3500;
+    read_file(header.index_offset + sizeof(entry), &entry, sizeof(entry));
+    lossless_block_header_t block;
+    read_file(entry.offset, &block, sizeof(block));
+    block.frames = 10;
+    patch_file(entry.offset, &block, sizeof(block));
+    assert(lossless_reader_open(&reader, TEST_FILE) == MICARRAY_SUCCESS);
+    check_frames(reader, 0, 1000);
+    int16_t *out = malloc(1000 * TEST_CHANNELS * sizeof(int16_t));
+    size_t read;
+    assert(lossless_reader_seek(reader, 1500) == MICARRAY_SUCCESS);
+    assert(lossless_reader_read(reader, out, 1000, &read) == MICARRAY_ERROR_CONFIG && read == 0);
+    free(out);
+    lossless_reader_close(reader);
+    
+    lossless_writer_cleanup(ctx);
+    unlink(TEST_FILE);
+    
+    printf("✓ Corrupt index test passed\n");
+}
+
+int main(void) {
+    printf("Running lossless codec tests...\n\n");
+    
+    fill_channels();
+    
+    test_lossless_invalid_params();
+    test_lossless_round_trip();
+    test_lossless_unfinished();
+    test_lossless_corrupt_index();
+    
+    printf("\n✅ All lossless codec tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "../src/mic_health.h"
+
+#define TEST_CHANNELS 4
+#define TEST_FRAMES 160
+
+enum {
+    SIGNAL_COMMON = 0,
+    SIGNAL_STUCK,
+    SIGNAL_INDEPENDENT,
+    SIGNAL_CLIPPED
+};
+
+static uint32_t seed = 1;
+
+static int16_t next_noise(int amplitude) {
+    seed = seed * 1664525u + 1013904223u;
+    return (int16_t)(((int32_t)(seed >> 16) - 32768) * amplitude / 32768);
+}
+
+/* One window of interleaved frames; kind[c] picks what channel c carries. */
+static void fill_block(int16_t *block, const int *kind) {
+    for (int j = 0; j < TEST_FRAMES; j++) {
+        int16_t common = next_noise(8000);
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            int16_t s;
+            switch (kind[c]) {
+                case SIGNAL_STUCK: s = 5000; break;
+                case SIGNAL_INDEPENDENT: s = next_noise(8000); break;
+                case SIGNAL_CLIPPED: s = (j % 2) ? 32767 : -32768; break;
+                default: s = (int16_t)(common + next_noise(200)); break;
+            }
+            block[j * TEST_CHANNELS + c] = s;
+        }
+    }
+}
+
+static mic_health_context_t* create_monitor(void) {
+    mic_health_config_t config = {
+        .num_channels = TEST_CHANNELS,
+        .sample_rate = 16000,
+        .window_seconds = 0.01f,
+        .drop_windows = 2,
+        .recover_windows = 3
+    };
+    
+    mic_health_context_t *ctx = NULL;
+    int result = mic_health_init(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    assert(mic_health_get_mask(ctx) == 0xF);
+    return ctx;
+}
+
+static uint32_t run_window(mic_health_context_t *ctx, const int *kind, int16_t **planar) {
+    int16_t block[TEST_FRAMES * TEST_CHANNELS];
+    fill_block(block, kind);
+    mic_health_deinterleave(ctx, block, TEST_FRAMES, planar, 0);
+    return mic_health_evaluate(ctx);
+}
+
+static void test_mic_health_invalid_params(void) {
+    printf("Testing health monitor invalid parameters...\n");
+    
+    mic_health_context_t *ctx = NULL;
+    mic_health_config_t config = { .num_channels = 0, .sample_rate = 16000 };
+    
+    assert(mic_health_init(NULL, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(mic_health_init(&ctx, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(mic_health_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config.num_channels = 2;
+    assert(mic_health_init(&ctx, &config) == MICARRAY_SUCCESS);
+    
+    mic_health_status_t status;
+    assert(mic_health_get_status(ctx, 2, &status) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(mic_health_get_status(ctx, 0, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    assert(mic_health_cleanup(ctx) == MICARRAY_SUCCESS);
+    assert(mic_health_cleanup(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Health monitor invalid parameters test passed\n");
+}
+
+static void test_mic_health_stuck_channel(void) {
+    printf("Testing stuck channel exclusion and recovery...\n");
+    
+    mic_health_context_t *ctx = create_monitor();
+    int16_t *planar[TEST_CHANNELS];
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        planar[c] = malloc(TEST_FRAMES * sizeof(int16_t));
+    }
+    
+    const int stuck[TEST_CHANNELS] = {SIGNAL_COMMON, SIGNAL_COMMON, SIGNAL_STUCK, SIGNAL_COMMON};
+    const int healthy[TEST_CHANNELS] = {SIGNAL_COMMON, SIGNAL_COMMON, SIGNAL_COMMON, SIGNAL_COMMON};
+    
+    // The copy is exact
+    int16_t block[TEST_FRAMES * TEST_CHANNELS];
+    fill_block(block, healthy);
+    mic_health_deinterleave(ctx, block, TEST_FRAMES, planar, 0);
+    for (int j = 0; j < TEST_FRAMES; j++) {
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            assert(planar[c][j] == block[j * TEST_CHANNELS + c]);
+        }
+    }
+    assert(mic_health_evaluate(ctx) == 0);
+    
+    // One bad window is tolerated, the second drops the channel
+    assert(run_window(ctx, stuck, planar) == 0);
+    assert(run_window(ctx, stuck, planar) == (1u << 2));
+    assert(mic_health_get_mask(ctx) == 0xB);
+    
+    mic_health_status_t status;
+    assert(mic_health_get_status(ctx, 2, &status) == MICARRAY_SUCCESS);
+    assert(!status.active);
+    assert(status.rms == 0.0f);
+    assert(fabsf(status.dc_offset - 5000.0f / 32768.0f) < 1e-4f);
+    
+    assert(mic_health_get_status(ctx, 0, &status) == MICARRAY_SUCCESS);
+    assert(status.active);
+    assert(status.coherence > 0.9f);
+    
+    // Re-admitted after recover_windows good windows
+    assert(run_window(ctx, healthy, planar) == 0);
+    assert(run_window(ctx, healthy, planar) == 0);
+    assert(run_window(ctx, healthy, planar) == (1u << 2));
+    assert(mic_health_get_mask(ctx) == 0xF);
+    
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        free(planar[c]);
+    }
+    mic_health_cleanup(ctx);
+    
+    printf("✓ Stuck channel test passed\n");
+}
+
+static void test_mic_health_coherence_and_clipping(void) {
+    printf("Testing incoherent and clipping channels...\n");
+    
+    mic_health_context_t *ctx = create_monitor();
+    int16_t *planar[TEST_CHANNELS];
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        planar[c] = malloc(TEST_FRAMES * sizeof(int16_t));
+    }
+    
+    // The clipping channel swamps the common mix until it is dropped; only
+    // then does the incoherent one stand out
+    const int faulty[TEST_CHANNELS] = {SIGNAL_COMMON, SIGNAL_INDEPENDENT, SIGNAL_COMMON, SIGNAL_CLIPPED};
+    assert(run_window(ctx, faulty, planar) == 0);
+    assert(run_window(ctx, faulty, planar) == (1u << 3));
+    assert(run_window(ctx, faulty, planar) == 0);
+    assert(run_window(ctx, faulty, planar) == (1u << 1));
+    assert(mic_health_get_mask(ctx) == 0x5);
+    
+    mic_health_status_t status;
+    mic_health_get_status(ctx, 3, &status);
+    assert(status.clip_rate > 0.9f);
+    mic_health_get_status(ctx, 1, &status);
+    assert(fabsf(status.coherence) < 0.3f);
+    
+    mic_health_cleanup(ctx);
+    
+    // Self-noise only: nothing is coherent, so coherence alone drops nobody
+    ctx = create_monitor();
+    const int quiet[TEST_CHANNELS] = {SIGNAL_INDEPENDENT, SIGNAL_INDEPENDENT, SIGNAL_INDEPENDENT, SIGNAL_INDEPENDENT};
+    for (int w = 0; w < 5; w++) {
+        assert(run_window(ctx, quiet, planar) == 0);
+    }
+    assert(mic_health_get_mask(ctx) == 0xF);
+    
+    // The last active channel is never dropped
+    const int dead[TEST_CHANNELS] = {SIGNAL_STUCK, SIGNAL_STUCK, SIGNAL_STUCK, SIGNAL_STUCK};
+    for (int w = 0; w < 5; w++) {
+        run_window(ctx, dead, planar);
+    }
+    assert(mic_health_get_mask(ctx) != 0);
+    
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        free(planar[c]);
+    }
+    mic_health_cleanup(ctx);
+    
+    printf("✓ Incoherent and clipping channel test passed\n");
+}
+
+static void test_mic_health_levels(void) {
+    printf("Testing level metering...\n");
+    
+    mic_health_config_t config = {
+        .num_channels = TEST_CHANNELS,
+        .sample_rate = 16000,
+        .window_seconds = 0.01f,
+        .drop_windows = 2,
+        .monitor_only = true
+    };
+    
+    mic_health_context_t *ctx = NULL;
+    assert(mic_health_init(&ctx, &config) == MICARRAY_SUCCESS);
+    
+    int16_t *planar[TEST_CHANNELS];
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        planar[c] = malloc(TEST_FRAMES * sizeof(int16_t));
+    }
+    
+    float rms[TEST_CHANNELS], peak[TEST_CHANNELS];
+    assert(mic_health_read_levels(ctx, rms, peak, TEST_CHANNELS) == MICARRAY_ERROR_INIT);
+    assert(mic_health_read_levels(ctx, rms, peak, TEST_CHANNELS + 1) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    // A monitor-only context never drops the stuck channel
+    const int kind[TEST_CHANNELS] = {SIGNAL_COMMON, SIGNAL_STUCK, SIGNAL_CLIPPED, SIGNAL_COMMON};
+    for (int w = 0; w < 4; w++) {
+        assert(run_window(ctx, kind, planar) == 0);
+    }
+    assert(mic_health_get_mask(ctx) == 0xF);
+    
+    assert(mic_health_read_levels(ctx, rms, peak, TEST_CHANNELS) == MICARRAY_SUCCESS);
+    assert(fabsf(rms[1] - 5000.0f / 32768.0f) < 1e-5f);
+    assert(peak[1] == 5000.0f / 32768.0f);
+    assert(peak[2] == 1.0f);
+    assert(rms[2] > 0.99f);
+    assert(rms[0] > 0.1f && rms[0] < 0.2f);
+    assert(peak[0] >= rms[0] && peak[0] < 0.3f);
+    
+    // Read and reset
+    assert(mic_health_read_levels(ctx, rms, peak, TEST_CHANNELS) == MICARRAY_ERROR_INIT);
+    
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        free(planar[c]);
+    }
+    mic_health_cleanup(ctx);
+    
+    printf("✓ Level metering test passed\n");
+}
+
+static void test_mic_health_specialized(void) {
+    printf("Testing fixed-count deinterleave...\n");
+    
+    // Each count with its own loop must match the generic one, including
+    // the mix once a stuck channel has been dropped
+    static const int counts[] = {2, 4, 8};
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        const int channels = counts[i];
+        mic_health_config_t config = {
+            .num_channels = channels,
+            .sample_rate = 16000,
+            .window_seconds = 0.01f,
+            .drop_windows = 1
+        };
+        mic_health_context_t *fixed = NULL, *generic = NULL;
+        assert(mic_health_init(&fixed, &config) == MICARRAY_SUCCESS);
+        config.generic = true;
+        assert(mic_health_init(&generic, &config) == MICARRAY_SUCCESS);
+        
+        int16_t block[TEST_FRAMES * 8];
+        int16_t fixed_data[8][TEST_FRAMES + 3], generic_data[8][TEST_FRAMES + 3];
+        int16_t *fixed_planar[8], *generic_planar[8];
+        for (int c = 0; c < channels; c++) {
+            fixed_planar[c] = fixed_data[c];
+            generic_planar[c] = generic_data[c];
+        }
+        
+        for (int w = 0; w < 4; w++) {
+            for (int j = 0; j < TEST_FRAMES * channels; j++) {
+                block[j] = j % channels == 1 ? 5000 : next_noise(8000);
+            }
+            mic_health_deinterleave(fixed, block, TEST_FRAMES, fixed_planar, 3);
+            mic_health_deinterleave(generic, block, TEST_FRAMES, generic_planar, 3);
+            assert(mic_health_evaluate(fixed) == mic_health_evaluate(generic));
+            
+            for (int c = 0; c < channels; c++) {
+                assert(memcmp(fixed_data[c] + 3, generic_data[c] + 3, TEST_FRAMES * sizeof(int16_t)) == 0);
+                mic_health_status_t a, b;
+                mic_health_get_status(fixed, c, &a);
+                mic_health_get_status(generic, c, &b);
+                assert(a.active == b.active && a.rms == b.rms && a.coherence == b.coherence);
+            }
+        }
+        assert(!(mic_health_get_mask(fixed) & 0x2));
+        
+        mic_health_cleanup(fixed);
+        mic_health_cleanup(generic);
+    }
+    
+    printf("✓ Fixed-count deinterleave test passed\n");
+}
+
+int main(void) {
+    printf("Running microphone health tests...\n\n");
+    
+    test_mic_health_invalid_params();
+    test_mic_health_stuck_channel();
+    test_mic_health_coherence_and_clipping();
+    test_mic_health_levels();
+    test_mic_health_specialized();
+    
+    printf("\n✅ All microphone health tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,205 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <unistd.h>
+#include "../src/nn_suppressor.h"
+#include "../src/noise_reduction.h"
+
+#define TEST_FILE "test_nn_model.bin"
+#define TEST_RATE 16000
+#define TEST_FRAME 1024
+#define TEST_BINS (TEST_FRAME / 2 + 1)
+#define ALIGNED(n) (((n) + NN_ALIGN - 1) / NN_ALIGN * NN_ALIGN)
+
+typedef struct {
+    int rows;
+    int cols;
+    float *weight;
+    float *bias;
+} test_layer_t;
+
+static void write_layer(FILE *file, const test_layer_t *layer) {
+    float max_weight = 1e-6f, max_bias = 1e-6f;
+    for (int i = 0; i < layer->rows * layer->cols; i++) {
+        max_weight = fmaxf(max_weight, fabsf(layer->weight[i]));
+    }
+    for (int i = 0; i < layer->rows; i++) {
+        max_bias = fmaxf(max_bias, fabsf(layer->bias[i]));
+    }
+    
+    uint32_t shape[2] = {(uint32_t)layer->rows, (uint32_t)layer->cols};
+    float scales[2] = {max_weight / 127.0f, max_bias / 32767.0f};
+    fwrite(shape, sizeof(shape), 1, file);
+    fwrite(scales, sizeof(scales), 1, file);
+    
+    for (int i = 0; i < ALIGNED(layer->rows); i++) {
+        int16_t bias = i < layer->rows ? (int16_t)lrintf(layer->bias[i] / scales[1]) : 0;
+        fwrite(&bias, sizeof(bias), 1, file);
+    }
+    for (int i = 0; i < layer->rows; i++) {
+        for (int j = 0; j < ALIGNED(layer->cols); j++) {
+            int8_t weight = j < layer->cols ? (int8_t)lrintf(layer->weight[i * layer->cols + j] / scales[0]) : 0;
+            fwrite(&weight, sizeof(weight), 1, file);
+        }
+    }
+}
+
+static test_layer_t new_layer(int rows, int cols) {
+    test_layer_t layer = {rows, cols, calloc(rows * cols, sizeof(float)), calloc(rows, sizeof(float))};
+    return layer;
+}
+
+/* A gate per band: the input layer passes the band features through,
+ * z is held near 0 so the GRU state is just tanh(2 h), and the output
+ * opens the band when it is loud. With gated false only the output
+ * bias is set, so every gain is sigmoid(0) = 0.5. */
+static void write_model(const char *magic, uint32_t bands, int cut, int gated) {
+    const int dense = NN_BANDS, gru = NN_BANDS;
+    test_layer_t layers[4] = {
+        new_layer(dense, NN_BANDS), new_layer(3 * gru, dense), new_layer(3 * gru, gru), new_layer(NN_BANDS, gru)
+    };
+    
+    if (gated) {
+        for (int b = 0; b < NN_BANDS; b++) {
+            layers[0].weight[b * NN_BANDS + b] = 1.0f;
+            layers[1].bias[b] = -8.0f;
+            layers[1].weight[(2 * gru + b) * dense + b] = 2.0f;
+            layers[3].weight[b * gru + b] = 8.0f;
+        }
+    }
+    
+    FILE *file = fopen(TEST_FILE, "wb");
+    assert(file != NULL);
+    uint32_t header[4] = {bands, (uint32_t)dense, (uint32_t)gru, 0};
+    fwrite(magic, 8, 1, file);
+    fwrite(header, sizeof(header), 1, file);
+    for (int l = 0; l < 4; l++) {
+        write_layer(file, &layers[l]);
+        free(layers[l].weight);
+        free(layers[l].bias);
+    }
+    
+    long size = ftell(file);
+    fclose(file);
+    if (cut) {
+        assert(truncate(TEST_FILE, size - cut) == 0);
+    }
+}
+
+static nn_suppressor_config_t default_config(void) {
+    nn_suppressor_config_t config = {
+        .frame_size = TEST_FRAME,
+        .sample_rate = TEST_RATE
+    };
+    strcpy(config.model_file, TEST_FILE);
+    return config;
+}
+
+static void test_nn_invalid_model(void) {
+    printf("Testing noise model validation...\n");
+    
+    nn_suppressor_context_t *ctx = NULL;
+    nn_suppressor_config_t config = default_config();
+    assert(nn_suppressor_init(NULL, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(nn_suppressor_init(&ctx, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    strcpy(config.model_file, "/nonexistent/model.bin");
+    assert(nn_suppressor_init(&ctx, &config) == MICARRAY_ERROR_CONFIG);
+    
+    config = default_config();
+    write_model("NOTMODEL", NN_BANDS, 0, 0);
+    assert(nn_suppressor_init(&ctx, &config) == MICARRAY_ERROR_CONFIG);
+    write_model(NN_FILE_MAGIC, NN_BANDS + 1, 0, 0);
+    assert(nn_suppressor_init(&ctx, &config) == MICARRAY_ERROR_CONFIG);
+    write_model(NN_FILE_MAGIC, NN_BANDS, 1, 0);
+    assert(nn_suppressor_init(&ctx, &config) == MICARRAY_ERROR_CONFIG);
+    
+    write_model(NN_FILE_MAGIC, NN_BANDS, 0, 0);
+    assert(nn_suppressor_init(&ctx, &config) == MICARRAY_SUCCESS);
+    
+    // The flat model gives every bin half gain whatever it hears
+    float power[TEST_BINS], gains[TEST_BINS];
+    for (int k = 0; k < TEST_BINS; k++) {
+        power[k] = (float)(k % 7) * 100.0f;
+    }
+    assert(nn_suppressor_process(ctx, power, gains) == MICARRAY_SUCCESS);
+    for (int k = 0; k < TEST_BINS; k++) {
+        assert(fabsf(gains[k] - 0.5f) < 1e-4f);
+    }
+    assert(nn_suppressor_process(ctx, NULL, gains) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(nn_suppressor_cleanup(ctx) == MICARRAY_SUCCESS);
+    assert(nn_suppressor_cleanup(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Noise model validation test passed\n");
+}
+
+static float rms(const int16_t *samples, size_t count) {
+    double energy = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        energy += (double)samples[i] * samples[i];
+    }
+    return (float)sqrt(energy / count);
+}
+
+static void test_nn_noise_reduction(void) {
+    printf("Testing nn noise reduction...\n");
+    
+    write_model(NN_FILE_MAGIC, NN_BANDS, 0, 1);
+    
+    noise_reduction_context_t *ctx = NULL;
+    noise_reduction_config_t config = {
+        .noise_threshold = 0.05f,
+        .frame_size = TEST_FRAME,
+        .overlap = TEST_FRAME / 2,
+        .alpha = 2.0f,
+        .beta = 0.1f,
+        .sample_rate = TEST_RATE
+    };
+    strcpy(config.algorithm, "nn");
+    strcpy(config.model_file, "/nonexistent/model.bin");
+    assert(noise_reduction_init(&ctx, &config) == MICARRAY_ERROR_CONFIG);
+    strcpy(config.model_file, TEST_FILE);
+    assert(noise_reduction_init(&ctx, &config) == MICARRAY_SUCCESS);
+    
+    const size_t samples = 8 * TEST_FRAME;
+    int16_t *input = malloc(samples * sizeof(int16_t));
+    int16_t *output = malloc(samples * sizeof(int16_t));
+    
+    // A loud tone on a band edge passes
+    for (size_t i = 0; i < samples; i++) {
+        input[i] = (int16_t)(16384.0f * sinf(2.0f * M_PI * 1000.0f * i / TEST_RATE));
+    }
+    noise_reduction_process(ctx, input, output, samples);
+    float ratio = rms(output + samples / 2, samples / 2) / rms(input + samples / 2, samples / 2);
+    assert(ratio > 0.9f && ratio < 1.05f);
+    
+    // Faint hiss is gated
+    uint32_t seed = 3;
+    for (size_t i = 0; i < samples; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        input[i] = (int16_t)(((int32_t)(seed >> 16) - 32768) / 1000);
+    }
+    noise_reduction_process(ctx, input, output, samples);
+    ratio = rms(output + samples / 2, samples / 2) / rms(input + samples / 2, samples / 2);
+    assert(ratio < 0.1f);
+    
+    free(input);
+    free(output);
+    noise_reduction_cleanup(ctx);
+    remove(TEST_FILE);
+    
+    printf("✓ nn noise reduction test passed\n");
+}
+
+int main(void) {
+    printf("Running nn suppressor tests...\n\n");
+    
+    test_nn_invalid_model();
+    test_nn_noise_reduction();
+    
+    printf("\n✅ All nn suppressor tests passed!\n");
+    return 0;
+}
@@ -86,10 +86,21 @@ static void test_noise_reduction_processing(void) {
     result = noise_reduction_update_noise_profile(ctx, noise_profile, samples);
     assert(result == MICARRAY_SUCCESS);
     
+    float input_rms, output_rms;
+    result = noise_reduction_read_energy(ctx, &input_rms, &output_rms);
+    assert(result == MICARRAY_ERROR_INIT);
+    
     // Process audio
     result = noise_reduction_process(ctx, input, output, samples);
     assert(result == MICARRAY_SUCCESS);
     
+    // Levels are metered on the way through and reset once read
+    result = noise_reduction_read_energy(ctx, &input_rms, &output_rms);
+    assert(result == MICARRAY_SUCCESS);
+    assert(fabsf(input_rms - 0.5f / sqrtf(2.0f)) < 0.01f);
+    assert(output_rms > 0.0f && output_rms < input_rms);
+    assert(noise_reduction_read_energy(ctx, &input_rms, &output_rms) == MICARRAY_ERROR_INIT);
+    
     // Verify output is different from input (processing occurred)
     bool different = false;
     for (size_t i = 0; i < samples; i++) {
@@ -110,6 +121,123 @@ static void test_noise_reduction_processing(void) {
     printf("✓ Noise reduction processing test passed\n");
 }
 
+static void test_noise_reduction_short_frame_streaming(void) {
+    printf("Testing short-frame streaming reconstruction...\n");
+    
+    noise_reduction_context_t *ctx = NULL;
+    noise_reduction_config_t config = {
+        .noise_threshold = 0.05f,
+        .frame_size = 256,
+        .overlap = 128,
+        .alpha = 2.0f,
+        .beta = 0.1f,
+        .sample_rate = 16000
+    };
+    strcpy(config.algorithm, "spectral_subtraction");
+    
+    int result = noise_reduction_init(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    int latency = noise_reduction_get_latency(ctx);
+    assert(latency == 256);
+    
+    const size_t samples = 2048;
+    const size_t block = 64;
+    int16_t *input = malloc(samples * sizeof(int16_t));
+    int16_t *output = malloc(samples * sizeof(int16_t));
+    assert(input != NULL && output != NULL);
+    
+    for (size_t i = 0; i < samples; i++) {
+        input[i] = (int16_t)(sinf(2.0f * M_PI * 440.0f * i / 16000.0f) * 16384.0f);
+    }
+    
+    // Without a noise profile the gain is unity, so small blocks must come
+    // back as the input delayed by the reported latency
+    for (size_t offset = 0; offset < samples; offset += block) {
+        result = noise_reduction_process(ctx, &input[offset], &output[offset], block);
+        assert(result == MICARRAY_SUCCESS);
+    }
+    
+    for (size_t i = 0; i < (size_t)latency; i++) {
+        assert(output[i] == 0);
+    }
+    for (size_t i = 2 * latency; i < samples; i++) {
+        assert(abs(output[i] - input[i - latency]) <= 4);
+    }
+    
+    free(input);
+    free(output);
+    
+    result = noise_reduction_cleanup(ctx);
+    assert(result == MICARRAY_SUCCESS);
+    
+    printf("✓ Short-frame streaming test passed\n");
+}
+
+static float mean_noise_psd(int16_t amplitude) {
+    noise_reduction_context_t *ctx = NULL;
+    noise_reduction_config_t config = {
+        .noise_threshold = 0.05f,
+        .frame_size = 1024,
+        .overlap = 512,
+        .alpha = 2.0f,
+        .beta = 0.1f,
+        .sample_rate = 16000
+    };
+    strcpy(config.algorithm, "spectral_subtraction");
+    
+    int result = noise_reduction_init(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    
+    float psd[129];
+    result = noise_reduction_get_noise_psd(ctx, psd, 129);
+    assert(result == MICARRAY_ERROR_INIT);
+    
+    const size_t samples = 16384;
+    int16_t *input = malloc(samples * sizeof(int16_t));
+    int16_t *output = malloc(samples * sizeof(int16_t));
+    assert(input != NULL && output != NULL);
+    
+    uint32_t seed = 1;
+    for (size_t i = 0; i < samples; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        input[i] = (int16_t)(((int32_t)(seed >> 16) - 32768) * amplitude / 32768);
+    }
+    
+    result = noise_reduction_process(ctx, input, output, samples);
+    assert(result == MICARRAY_SUCCESS);
+    
+    // Resampled from 513 bins to a 256-point FFT's 129
+    result = noise_reduction_get_noise_psd(ctx, psd, 129);
+    assert(result == MICARRAY_SUCCESS);
+    
+    float mean = 0.0f;
+    for (int k = 1; k < 128; k++) {
+        assert(psd[k] > 0.0f);
+        mean += psd[k];
+    }
+    
+    free(input);
+    free(output);
+    noise_reduction_cleanup(ctx);
+    
+    return mean / 127.0f;
+}
+
+static void test_noise_reduction_noise_psd(void) {
+    printf("Testing noise PSD tracking...\n");
+    
+    // A 4x louder noise floor reads about 16x the power
+    float quiet = mean_noise_psd(1000);
+    float loud = mean_noise_psd(4000);
+    assert(loud / quiet > 12.0f && loud / quiet < 20.0f);
+    
+    float psd[2];
+    assert(noise_reduction_get_noise_psd(NULL, psd, 2) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Noise PSD tracking test passed\n");
+}
+
 static void test_noise_reduction_threshold_setting(void) {
     printf("Testing noise reduction threshold setting...\n");
     
@@ -147,6 +275,8 @@ int main(void) {
     test_noise_reduction_init();
     test_noise_reduction_invalid_params();
     test_noise_reduction_processing();
+    test_noise_reduction_short_frame_streaming();
+    test_noise_reduction_noise_psd();
     test_noise_reduction_threshold_setting();
     
     printf("\n✅ All noise reduction tests passed!\n");
@@ -0,0 +1,140 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "../src/panner.h"
+
+#define TEST_FRAMES 256
+#define TEST_BLOCKS 8
+
+static int16_t noise[TEST_FRAMES * TEST_BLOCKS];
+static int16_t stereo[2 * TEST_FRAMES * TEST_BLOCKS];
+
+static panner_context_t* create_panner(void) {
+    panner_config_t config = { .sample_rate = 16000 };
+    panner_context_t *ctx = NULL;
+    int result = panner_init(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    return ctx;
+}
+
+static void render_blocks(panner_context_t *ctx, const int16_t *input, const sound_location_t *location) {
+    for (int b = 0; b < TEST_BLOCKS; b++) {
+        int result = panner_render(ctx, input + b * TEST_FRAMES, location, 1.0f,
+                                   stereo + 2 * b * TEST_FRAMES, TEST_FRAMES);
+        assert(result == MICARRAY_SUCCESS);
+    }
+}
+
+static void test_panner_invalid_params(void) {
+    printf("Testing panner invalid parameters...\n");
+    
+    panner_context_t *ctx = NULL;
+    panner_config_t config = { .sample_rate = 0 };
+    sound_location_t location = {1.0f, 0.0f, 0.0f, 1.0f};
+    
+    assert(panner_init(NULL, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(panner_init(&ctx, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(panner_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    ctx = create_panner();
+    assert(panner_render(NULL, noise, &location, 1.0f, stereo, 16) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(panner_render(ctx, noise, NULL, 1.0f, stereo, 16) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(panner_render(ctx, noise, &location, 1.0f, stereo, MAX_BUFFER_SIZE + 1) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(panner_reset(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    assert(panner_cleanup(ctx) == MICARRAY_SUCCESS);
+    assert(panner_cleanup(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Panner invalid parameters test passed\n");
+}
+
+static void test_panner_interaural_cues(void) {
+    printf("Testing interaural time and level differences...\n");
+    
+    // Straight ahead both ears are identical
+    panner_context_t *ctx = create_panner();
+    sound_location_t ahead = {1.0f, 0.0f, 0.0f, 0.3f};
+    render_blocks(ctx, noise, &ahead);
+    for (int j = 0; j < TEST_FRAMES * TEST_BLOCKS; j++) {
+        assert(stereo[2 * j] == stereo[2 * j + 1]);
+        assert(abs(stereo[2 * j] - (int)(noise[j] / 1.1f)) <= 1);
+    }
+    panner_cleanup(ctx);
+    
+    // Hard right (-y): the left ear lags by Woodworth's ITD, about 10.5
+    // samples, and is 10 dB down
+    ctx = create_panner();
+    sound_location_t right = {0.0f, -1.0f, 0.0f, 1.0f};
+    render_blocks(ctx, noise, &right);
+    
+    const float itd = 0.0875f / 343.0f * (M_PI / 2.0f + 1.0f) * 16000.0f;
+    const float ild = powf(10.0f, -10.0f / 20.0f);
+    for (int j = 16; j < TEST_FRAMES * TEST_BLOCKS; j++) {
+        int whole = (int)itd;
+        float frac = itd - whole;
+        float lagged = noise[j - whole] + frac * (noise[j - whole - 1] - noise[j - whole]);
+        assert(abs(stereo[2 * j] - (int)lrintf(lagged * ild / 1.1f)) <= 1);
+        assert(abs(stereo[2 * j + 1] - (int)lrintf(noise[j] / 1.1f)) <= 1);
+    }
+    
+    // Confidence must not change the level
+    int16_t first[2 * TEST_FRAMES];
+    panner_reset(ctx);
+    panner_render(ctx, noise, &right, 1.0f, first, TEST_FRAMES);
+    right.confidence = 0.1f;
+    panner_reset(ctx);
+    panner_render(ctx, noise, &right, 1.0f, stereo, TEST_FRAMES);
+    assert(memcmp(first, stereo, sizeof(first)) == 0);
+    
+    panner_cleanup(ctx);
+    
+    printf("✓ Interaural cue test passed\n");
+}
+
+static void test_panner_ramps(void) {
+    printf("Testing smooth parameter ramps...\n");
+    
+    panner_context_t *ctx = create_panner();
+    int16_t dc[TEST_FRAMES * TEST_BLOCKS];
+    for (int j = 0; j < TEST_FRAMES * TEST_BLOCKS; j++) {
+        dc[j] = 20000;
+    }
+    
+    // Jump from hard left to hard right every block; with a constant input
+    // only the gain ramp shows, and it must not step
+    sound_location_t sides[2] = {{0.0f, 1.0f, 0.0f, 1.0f}, {0.0f, -1.0f, 0.0f, 1.0f}};
+    for (int b = 0; b < TEST_BLOCKS; b++) {
+        panner_render(ctx, dc + b * TEST_FRAMES, &sides[b % 2], 1.0f, stereo + 2 * b * TEST_FRAMES, TEST_FRAMES);
+    }
+    
+    float max_step = (20000.0f / 1.1f) * (1.0f - powf(10.0f, -0.5f)) / TEST_FRAMES;
+    for (int j = TEST_FRAMES; j < TEST_FRAMES * TEST_BLOCKS; j++) {
+        for (int e = 0; e < 2; e++) {
+            assert(abs(stereo[2 * j + e] - stereo[2 * (j - 1) + e]) <= (int)max_step + 2);
+        }
+    }
+    
+    panner_cleanup(ctx);
+    
+    printf("✓ Parameter ramp test passed\n");
+}
+
+int main(void) {
+    printf("Running panner tests...\n\n");
+    
+    uint32_t seed = 5;
+    for (int j = 0; j < TEST_FRAMES * TEST_BLOCKS; j++) {
+        seed = seed * 1664525u + 1013904223u;
+        noise[j] = (int16_t)(((int32_t)(seed >> 16) - 32768) / 4);
+    }
+    
+    test_panner_invalid_params();
+    test_panner_interaural_cues();
+    test_panner_ramps();
+    
+    printf("\n✅ All panner tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "../src/prefilter.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TEST_CHANNELS 5
+#define TEST_FRAMES 16000
+
+static int16_t* planar[TEST_CHANNELS];
+
+static void fill_tone(int channel, float frequency, float amplitude, float offset) {
+    for (int j = 0; j < TEST_FRAMES; j++) {
+        float s = offset + amplitude * sinf(2.0f * M_PI * frequency * j / 16000.0f);
+        planar[channel][j] = (int16_t)s;
+    }
+}
+
+/* RMS over the second half, once the filters have settled. */
+static float settled_rms(int channel) {
+    double sum_sq = 0.0;
+    for (int j = TEST_FRAMES / 2; j < TEST_FRAMES; j++) {
+        sum_sq += (double)planar[channel][j] * planar[channel][j];
+    }
+    return (float)sqrt(sum_sq / (TEST_FRAMES / 2));
+}
+
+static prefilter_context_t* create_filter(bool dc_removal, float highpass, float lowpass) {
+    prefilter_config_t config = {
+        .num_channels = TEST_CHANNELS,
+        .sample_rate = 16000,
+        .dc_removal = dc_removal,
+        .highpass_hz = highpass,
+        .lowpass_hz = lowpass
+    };
+    
+    prefilter_context_t *ctx = NULL;
+    int result = prefilter_init(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    return ctx;
+}
+
+/* Odd-sized calls exercise the chunking and carry the state across. */
+static void run_filter(prefilter_context_t *ctx) {
+    size_t done = 0;
+    size_t step = 333;
+    while (done < TEST_FRAMES) {
+        size_t n = TEST_FRAMES - done < step ? TEST_FRAMES - done : step;
+        int16_t *views[TEST_CHANNELS];
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            views[c] = planar[c] + done;
+        }
+        assert(prefilter_process(ctx, views, n) == MICARRAY_SUCCESS);
+        done += n;
+    }
+}
+
+static void test_prefilter_invalid_params(void) {
+    printf("Testing pre-filter invalid parameters...\n");
+    
+    prefilter_context_t *ctx = NULL;
+    prefilter_config_t config = { .num_channels = 0, .sample_rate = 16000 };
+    
+    assert(prefilter_init(NULL, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(prefilter_init(&ctx, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(prefilter_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config.num_channels = 2;
+    config.highpass_hz = 8000.0f;
+    assert(prefilter_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config.highpass_hz = 1000.0f;
+    config.lowpass_hz = 500.0f;
+    assert(prefilter_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    // No stage enabled is a valid pass-through
+    config.highpass_hz = 0.0f;
+    config.lowpass_hz = 0.0f;
+    assert(prefilter_init(&ctx, &config) == MICARRAY_SUCCESS);
+    assert(prefilter_get_num_sections(ctx) == 0);
+    assert(prefilter_process(NULL, planar, 16) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    assert(prefilter_cleanup(ctx) == MICARRAY_SUCCESS);
+    assert(prefilter_cleanup(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Pre-filter invalid parameters test passed\n");
+}
+
+static void test_prefilter_dc_and_bands(void) {
+    printf("Testing DC removal, high-pass and low-pass...\n");
+    
+    // Channel 0: DC only, 1: DC + 1 kHz, 2: rumble, 3: 1 kHz, 4: silence
+    prefilter_context_t *ctx = create_filter(true, 100.0f, 0.0f);
+    assert(prefilter_get_num_sections(ctx) == 2);
+    
+    fill_tone(0, 0.0f, 0.0f, 5000.0f);
+    fill_tone(1, 1000.0f, 8000.0f, -3000.0f);
+    fill_tone(2, 20.0f, 8000.0f, 0.0f);
+    fill_tone(3, 1000.0f, 8000.0f, 0.0f);
+    memset(planar[4], 0, TEST_FRAMES * sizeof(int16_t));
+    
+    run_filter(ctx);
+    
+    assert(settled_rms(0) < 2.0f);
+    assert(fabsf(settled_rms(1) - 8000.0f / sqrtf(2.0f)) < 100.0f);
+    assert(settled_rms(2) < 0.05f * 8000.0f);
+    assert(fabsf(settled_rms(3) - 8000.0f / sqrtf(2.0f)) < 100.0f);
+    assert(settled_rms(4) == 0.0f);
+    
+    // The offset was removed, the tone was not
+    for (int j = TEST_FRAMES / 2; j < TEST_FRAMES; j++) {
+        assert(abs(planar[1][j] - planar[3][j]) < 40);
+    }
+    
+    prefilter_cleanup(ctx);
+    
+    ctx = create_filter(false, 0.0f, 1000.0f);
+    fill_tone(0, 200.0f, 8000.0f, 0.0f);
+    fill_tone(1, 6000.0f, 8000.0f, 0.0f);
+    for (int c = 2; c < TEST_CHANNELS; c++) {
+        fill_tone(c, 200.0f, 8000.0f, 0.0f);
+    }
+    
+    run_filter(ctx);
+    
+    assert(settled_rms(0) > 0.95f * 8000.0f / sqrtf(2.0f));
+    assert(settled_rms(1) < 0.05f * 8000.0f);
+    
+    // Every lane runs the same filter
+    for (int c = 2; c < TEST_CHANNELS; c++) {
+        assert(memcmp(planar[c], planar[0], TEST_FRAMES * sizeof(int16_t)) == 0);
+    }
+    
+    prefilter_cleanup(ctx);
+    
+    printf("✓ DC removal and band filter test passed\n");
+}
+
+int main(void) {
+    printf("Running pre-filter tests...\n\n");
+    
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        planar[c] = malloc(TEST_FRAMES * sizeof(int16_t));
+    }
+    
+    test_prefilter_invalid_params();
+    test_prefilter_dc_and_bands();
+    
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        free(planar[c]);
+    }
+    
+    printf("\n✅ All pre-filter tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,286 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "../src/recorder.h"
+#include "../src/lossless.h"
+
+#define TEST_CHANNELS 3
+#define TEST_BLOCK 256
+#define TEST_HEADER 4096
+
+static int16_t planes[TEST_CHANNELS][TEST_BLOCK];
+static int16_t *channels[TEST_CHANNELS] = {planes[0], planes[1], planes[2]};
+
+static int16_t pattern(uint64_t frame, int channel) {
+    return (int16_t)((frame * 7 + channel * 1000) % 30000);
+}
+
+static void push_frames(recorder_context_t *ctx, uint64_t *frame, int blocks, bool loud) {
+    for (int b = 0; b < blocks; b++) {
+        for (int j = 0; j < TEST_BLOCK; j++) {
+            for (int c = 0; c < TEST_CHANNELS; c++) {
+                planes[c][j] = loud ? pattern(*frame + j, c) : 0;
+            }
+        }
+        assert(recorder_push(ctx, channels, TEST_BLOCK) == MICARRAY_SUCCESS);
+        *frame += TEST_BLOCK;
+    }
+}
+
+static recorder_context_t* create_recorder(const char *directory, recorder_format_t format, 
+                                           int pre, int post, float trigger_db) {
+    recorder_config_t config = {
+        .num_channels = TEST_CHANNELS,
+        .sample_rate = 16000,
+        .format = format,
+        .pre_trigger_frames = pre,
+        .post_trigger_frames = post,
+        .trigger_level_db = trigger_db
+    };
+    strcpy(config.directory, directory);
+    
+    recorder_context_t *ctx = NULL;
+    int result = recorder_init(&ctx, &config);
+    assert(result == MICARRAY_SUCCESS);
+    return ctx;
+}
+
+static void wait_for_recording(recorder_context_t *ctx, bool recording) {
+    recorder_stats_t stats;
+    for (int i = 0; i < 400; i++) {
+        recorder_get_stats(ctx, &stats);
+        if (stats.recording == recording) {
+            return;
+        }
+        usleep(10000);
+    }
+    assert(!"recorder did not change state");
+}
+
+/* Finds the only file in directory, which must have extension. */
+static void find_recording(const char *directory, const char *extension, char *path, size_t path_size) {
+    DIR *dir = opendir(directory);
+    assert(dir != NULL);
+    
+    struct dirent *entry;
+    int found = 0;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            snprintf(path, path_size, "%s/%s", directory, entry->d_name);
+            found++;
+        }
+    }
+    closedir(dir);
+    assert(found == 1);
+    assert(strstr(path, "micarray-") != NULL && strstr(path, extension) != NULL);
+}
+
+/* Returns the only file in directory, read whole, and removes it. */
+static uint8_t* take_recording(const char *directory, size_t *size) {
+    char path[512];
+    find_recording(directory, ".wav", path, sizeof(path));
+    
+    FILE *file = fopen(path, "rb");
+    assert(file != NULL);
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *data = malloc(*size);
+    assert(fread(data, 1, *size, file) == *size);
+    fclose(file);
+    unlink(path);
+    
+    return data;
+}
+
+/* Frames outside [loud_from, loud_to) were pushed as silence. */
+static void check_recording(const uint8_t *data, size_t size, uint64_t first, uint64_t last, 
+                            uint64_t loud_from, uint64_t loud_to) {
+    uint32_t riff_size, data_size;
+    uint16_t num_channels;
+    memcpy(&riff_size, data + 4, 4);
+    memcpy(&num_channels, data + 22, 2);
+    memcpy(&data_size, data + TEST_HEADER - 4, 4);
+    assert(memcmp(data, "RIFF", 4) == 0 && memcmp(data + 36, "JUNK", 4) == 0);
+    assert(memcmp(data + TEST_HEADER - 8, "data", 4) == 0);
+    assert(num_channels == TEST_CHANNELS);
+    assert(size == TEST_HEADER + data_size && riff_size == size - 8);
+    assert(data_size == (last - first) * TEST_CHANNELS * sizeof(int16_t));
+    
+    const int16_t *samples = (const int16_t*)(data + TEST_HEADER);
+    for (uint64_t n = first; n < last; n++) {
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            int16_t expected = (n < loud_from || n >= loud_to) ? 0 : pattern(n, c);
+            assert(samples[(n - first) * TEST_CHANNELS + c] == expected);
+        }
+    }
+}
+
+static void test_recorder_invalid_params(void) {
+    printf("Testing recorder invalid parameters...\n");
+    
+    recorder_context_t *ctx = NULL;
+    recorder_config_t config = {
+        .num_channels = TEST_CHANNELS,
+        .sample_rate = 16000,
+        .pre_trigger_frames = 1000
+    };
+    
+    assert(recorder_init(NULL, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(recorder_init(&ctx, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(recorder_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    strcpy(config.directory, ".");
+    config.pre_trigger_frames = -1;
+    assert(recorder_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    config.pre_trigger_frames = 0;
+    config.format = RECORDER_FORMAT_LOSSLESS + 1;
+    assert(recorder_init(&ctx, &config) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    ctx = create_recorder(".", RECORDER_FORMAT_WAV, 1000, 0, 0.0f);
+    assert(recorder_push(ctx, channels, MAX_BUFFER_SIZE + 1) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(recorder_trigger(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(recorder_stop(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(recorder_cleanup(ctx) == MICARRAY_SUCCESS);
+    assert(recorder_cleanup(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Recorder invalid parameters test passed\n");
+}
+
+static void test_recorder_pre_trigger(const char *directory) {
+    printf("Testing pre-trigger recording...\n");
+    
+    // Enough history to wrap the ring before the trigger
+    recorder_context_t *ctx = create_recorder(directory, RECORDER_FORMAT_WAV, 3000, 0, 0.0f);
+    uint64_t frame = 0;
+    push_frames(ctx, &frame, 200, true);
+    
+    assert(recorder_trigger(ctx) == MICARRAY_SUCCESS);
+    wait_for_recording(ctx, true);
+    uint64_t triggered = frame;
+    push_frames(ctx, &frame, 40, true);
+    assert(recorder_stop(ctx) == MICARRAY_SUCCESS);
+    wait_for_recording(ctx, false);
+    
+    // Pushing after the stop adds nothing
+    push_frames(ctx, &frame, 4, true);
+    
+    recorder_stats_t stats;
+    recorder_get_stats(ctx, &stats);
+    assert(stats.files == 1 && stats.frames_dropped == 0 && stats.write_errors == 0);
+    recorder_cleanup(ctx);
+    
+    // The file starts at most an alignment unit (2048 frames of 3
+    // channels) before the pre-trigger window and runs up to the stop
+    size_t size;
+    uint8_t *data = take_recording(directory, &size);
+    uint64_t frames = stats.frames_written;
+    uint64_t first = triggered + 40 * TEST_BLOCK - frames;
+    assert(first <= triggered - 3000 && first + 2048 > triggered - 3000);
+    assert(first % 2048 == 0);
+    check_recording(data, size, first, triggered + 40 * TEST_BLOCK, 0, UINT64_MAX);
+    free(data);
+    
+    printf("✓ Pre-trigger recording test passed\n");
+}
+
+static void test_recorder_level_trigger(const char *directory) {
+    printf("Testing level-triggered recording...\n");
+    
+    // Quiet input never starts a file; a loud block records 4000 frames
+    // after it, and every further loud block would extend that
+    recorder_context_t *ctx = create_recorder(directory, RECORDER_FORMAT_WAV, 0, 4000, -30.0f);
+    uint64_t frame = 0;
+    push_frames(ctx, &frame, 20, false);
+    usleep(120000);
+    
+    recorder_stats_t stats;
+    recorder_get_stats(ctx, &stats);
+    assert(stats.files == 0 && !stats.recording);
+    
+    uint64_t loud_end = frame + TEST_BLOCK;
+    push_frames(ctx, &frame, 1, true);
+    wait_for_recording(ctx, true);
+    push_frames(ctx, &frame, 40, false);
+    wait_for_recording(ctx, false);
+    recorder_get_stats(ctx, &stats);
+    recorder_cleanup(ctx);
+    
+    // With no pre-trigger window the file starts at the aligned frame
+    // before the trigger, so it holds some of the silence before it too
+    size_t size;
+    uint8_t *data = take_recording(directory, &size);
+    uint64_t last = loud_end + 4000;
+    uint64_t first = last - stats.frames_written;
+    assert(stats.files == 1);
+    assert(first <= loud_end && first + 2048 > loud_end && first % 2048 == 0);
+    check_recording(data, size, first, last, loud_end - TEST_BLOCK, loud_end);
+    free(data);
+    
+    printf("✓ Level trigger test passed\n");
+}
+
+static void test_recorder_lossless(const char *directory) {
+    printf("Testing lossless recording...\n");
+    
+    recorder_context_t *ctx = create_recorder(directory, RECORDER_FORMAT_LOSSLESS, 3000, 0, 0.0f);
+    uint64_t frame = 0;
+    push_frames(ctx, &frame, 50, true);
+    assert(recorder_trigger(ctx) == MICARRAY_SUCCESS);
+    wait_for_recording(ctx, true);
+    push_frames(ctx, &frame, 30, true);
+    assert(recorder_stop(ctx) == MICARRAY_SUCCESS);
+    wait_for_recording(ctx, false);
+    
+    recorder_stats_t stats;
+    recorder_get_stats(ctx, &stats);
+    assert(stats.files == 1 && stats.write_errors == 0);
+    recorder_cleanup(ctx);
+    
+    char path[512];
+    find_recording(directory, ".mla", path, sizeof(path));
+    lossless_reader_t *reader = NULL;
+    assert(lossless_reader_open(&reader, path) == MICARRAY_SUCCESS);
+    lossless_info_t info;
+    lossless_reader_get_info(reader, &info);
+    assert(info.channels == TEST_CHANNELS && info.frames == stats.frames_written);
+    
+    uint64_t first = frame - info.frames;
+    int16_t *samples = malloc(info.frames * TEST_CHANNELS * sizeof(int16_t));
+    size_t read;
+    assert(lossless_reader_read(reader, samples, info.frames, &read) == MICARRAY_SUCCESS);
+    assert(read == info.frames);
+    for (uint64_t n = 0; n < info.frames; n++) {
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            assert(samples[n * TEST_CHANNELS + c] == pattern(first + n, c));
+        }
+    }
+    
+    free(samples);
+    lossless_reader_close(reader);
+    unlink(path);
+    
+    printf("✓ Lossless recording test passed\n");
+}
+
+int main(void) {
+    printf("Running recorder tests...\n\n");
+    
+    char directory[] = "/tmp/micarray-recorder-XXXXXX";
+    assert(mkdtemp(directory) != NULL);
+    
+    test_recorder_invalid_params();
+    test_recorder_pre_trigger(directory);
+    test_recorder_level_trigger(directory);
+    test_recorder_lossless(directory);
+    
+    rmdir(directory);
+    
+    printf("\n✅ All recorder tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,350 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../src/stage_graph.h"
+
+#define TEST_CHANNELS 3
+#define TEST_FRAMES 256
+
+typedef struct {
+    float gain;
+    float *const *input;
+    float *const *output;
+    uint32_t active_mask;
+    int resets;
+} probe_state_t;
+
+static int cleanups;
+
+static int gain_init(void **state, const micarray_stage_format_t *format, const char *args) {
+    if (format->num_channels != TEST_CHANNELS || format->max_frames != TEST_FRAMES) {
+        return MICARRAY_ERROR_INVALID_PARAM;
+    }
+    
+    probe_state_t *probe = calloc(1, sizeof(probe_state_t));
+    if (!probe) {
+        return MICARRAY_ERROR_MEMORY;
+    }
+    probe->gain = args[0] ? strtof(args, NULL) : 1.0f;
+    *state = probe;
+    return MICARRAY_SUCCESS;
+}
+
+static void gain_process(void *state, float *const *input, float *const *output, size_t frames,
+                         uint32_t active_mask) {
+    probe_state_t *probe = state;
+    probe->input = input;
+    probe->output = output;
+    probe->active_mask = active_mask;
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        for (size_t j = 0; j < frames; j++) {
+            output[c][j] = input[c][j] * probe->gain;
+        }
+    }
+}
+
+static void probe_reset(void *state) {
+    ((probe_state_t*)state)->resets++;
+}
+
+static void probe_cleanup(void *state) {
+    free(state);
+    cleanups++;
+}
+
+static const micarray_stage_t gain_stage = {
+    .name = "gain",
+    .flags = MICARRAY_STAGE_IN_PLACE,
+    .init = gain_init,
+    .process = gain_process,
+    .reset = probe_reset,
+    .cleanup = probe_cleanup
+};
+
+/* The same arithmetic, but declared out of place. */
+static const micarray_stage_t scale_stage = {
+    .name = "scale",
+    .flags = 0,
+    .init = gain_init,
+    .process = gain_process,
+    .reset = probe_reset,
+    .cleanup = probe_cleanup
+};
+
+static void offset_pcm(void *state, int16_t **channels, size_t frames, uint32_t active_mask) {
+    int offset = *(int*)state;
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        if (active_mask & (1u << c)) {
+            for (size_t j = 0; j < frames; j++) {
+                channels[c][j] = (int16_t)(channels[c][j] + offset);
+            }
+        }
+    }
+}
+
+static stage_graph_t* create_graph(void) {
+    micarray_stage_format_t format = {
+        .num_channels = TEST_CHANNELS,
+        .sample_rate = 16000,
+        .max_frames = TEST_FRAMES
+    };
+    
+    stage_graph_t *graph = NULL;
+    assert(stage_graph_init(&graph, &format) == MICARRAY_SUCCESS);
+    return graph;
+}
+
+static void test_stage_graph_invalid_params(void) {
+    printf("Testing stage graph invalid parameters...\n");
+    
+    stage_graph_t *graph = NULL;
+    micarray_stage_format_t format = { .num_channels = 0, .sample_rate = 16000, .max_frames = TEST_FRAMES };
+    assert(stage_graph_init(NULL, &format) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(stage_graph_init(&graph, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(stage_graph_init(&graph, &format) == MICARRAY_ERROR_INVALID_PARAM);
+    format.num_channels = TEST_CHANNELS;
+    format.max_frames = 0;
+    assert(stage_graph_init(&graph, &format) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    micarray_stage_t unnamed = gain_stage;
+    unnamed.name = "";
+    micarray_stage_t no_process = gain_stage;
+    no_process.process = NULL;
+    assert(stage_registry_add(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(stage_registry_add(&unnamed) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(stage_registry_add(&no_process) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    assert(stage_registry_add(&gain_stage) == MICARRAY_SUCCESS);
+    assert(stage_registry_add(&gain_stage) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(stage_registry_find("gain") == &gain_stage);
+    assert(stage_registry_find("missing") == NULL);
+    
+    // A stage whose init fails is not added
+    graph = create_graph();
+    micarray_stage_format_t wrong = { .num_channels = 2, .sample_rate = 16000, .max_frames = TEST_FRAMES };
+    stage_graph_t *other = NULL;
+    assert(stage_graph_init(&other, &wrong) == MICARRAY_SUCCESS);
+    assert(stage_graph_add(other, &gain_stage, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    int num_stages = -1;
+    assert(stage_graph_get_stats(other, NULL, 0, &num_stages) == MICARRAY_SUCCESS && num_stages == 0);
+    stage_graph_cleanup(other);
+    
+    int16_t samples[TEST_CHANNELS][TEST_FRAMES];
+    int16_t *channels[TEST_CHANNELS] = { samples[0], samples[1], samples[2] };
+    assert(stage_graph_process(graph, channels, TEST_FRAMES + 1, 0x7) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(stage_graph_add_pcm(graph, "offset", NULL, NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    for (int i = 0; i < MICARRAY_MAX_STAGES; i++) {
+        assert(stage_graph_add(graph, &gain_stage, "1") == MICARRAY_SUCCESS);
+    }
+    assert(stage_graph_add(graph, &gain_stage, "1") == MICARRAY_ERROR_INVALID_PARAM);
+    assert(stage_graph_cleanup(graph) == MICARRAY_SUCCESS);
+    assert(stage_graph_cleanup(NULL) == MICARRAY_ERROR_INVALID_PARAM);
+    
+    printf("✓ Stage graph invalid parameters test passed\n");
+}
+
+/* Node states are not exposed, so the probes record themselves into this
+ * table in the order the graph creates them. */
+static probe_state_t *probes[MICARRAY_MAX_STAGES];
+
+static int probe_init(void **state, const micarray_stage_format_t *format, const char *args) {
+    int result = gain_init(state, format, args);
+    for (int i = 0; result == MICARRAY_SUCCESS && i < MICARRAY_MAX_STAGES; i++) {
+        if (!probes[i]) {
+            probes[i] = *state;
+            break;
+        }
+    }
+    return result;
+}
+
+static void test_stage_graph_process(void) {
+    printf("Testing stage graph processing...\n");
+    
+    micarray_stage_t in_place = gain_stage;
+    micarray_stage_t out_of_place = scale_stage;
+    in_place.init = probe_init;
+    out_of_place.init = probe_init;
+    memset(probes, 0, sizeof(probes));
+    cleanups = 0;
+    
+    // pcm, in place, out of place, in place, pcm
+    int before = 100, after = 1;
+    stage_graph_t *graph = create_graph();
+    assert(stage_graph_add_pcm(graph, "before", offset_pcm, &before) == MICARRAY_SUCCESS);
+    assert(stage_graph_add(graph, &in_place, "0.5") == MICARRAY_SUCCESS);
+    assert(stage_graph_add(graph, &out_of_place, "-1") == MICARRAY_SUCCESS);
+    assert(stage_graph_add(graph, &in_place, "2") == MICARRAY_SUCCESS);
+    assert(stage_graph_add_pcm(graph, "after", offset_pcm, &after) == MICARRAY_SUCCESS);
+    
+    probe_state_t *half = probes[0];
+    probe_state_t *invert = probes[1];
+    probe_state_t *twice = probes[2];
+    
+    int16_t samples[TEST_CHANNELS][TEST_FRAMES];
+    int16_t *channels[TEST_CHANNELS] = { samples[0], samples[1], samples[2] };
+    for (int block = 0; block < 2; block++) {
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            for (int j = 0; j < TEST_FRAMES; j++) {
+                samples[c][j] = (int16_t)((j * 37 + c * 1000 + block) % 20000 - 10000);
+            }
+        }
+        
+        assert(stage_graph_process(graph, channels, TEST_FRAMES, 0x5) == MICARRAY_SUCCESS);
+        
+        // The offsets skip the inactive channel; the float stages do not
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            int offset = (c == 1) ? 0 : before;
+            for (int j = 0; j < TEST_FRAMES; j++) {
+                int x = (j * 37 + c * 1000 + block) % 20000 - 10000;
+                int expected = -(x + offset) + ((c == 1) ? 0 : after);
+                assert(samples[c][j] == expected);
+            }
+        }
+    }
+    
+    // Buffers pass between float stages without copies
+    assert(half->input == half->output);
+    assert(invert->input == half->output);
+    assert(invert->output != invert->input);
+    assert(twice->input == invert->output && twice->output == twice->input);
+    assert(half->active_mask == 0x5);
+    
+    micarray_stage_stats_t stats[MICARRAY_MAX_STAGES];
+    int num_stages = 0;
+    assert(stage_graph_get_stats(graph, stats, MICARRAY_MAX_STAGES, &num_stages) == MICARRAY_SUCCESS);
+    assert(num_stages == 5);
+    static const char *names[] = {"before", "gain", "scale", "gain", "after"};
+    for (int i = 0; i < num_stages; i++) {
+        assert(strcmp(stats[i].name, names[i]) == 0);
+        assert(stats[i].calls == 2);
+        assert(stats[i].max_ns >= stats[i].last_ns && stats[i].total_ns >= stats[i].max_ns);
+    }
+    
+    // A short array gets the first stages and the full count
+    memset(stats, 0, sizeof(stats));
+    assert(stage_graph_get_stats(graph, stats, 2, &num_stages) == MICARRAY_SUCCESS);
+    assert(num_stages == 5 && stats[1].calls == 2 && stats[2].calls == 0);
+    
+    assert(stage_graph_reset(graph) == MICARRAY_SUCCESS);
+    assert(half->resets == 1 && invert->resets == 1 && twice->resets == 1);
+    
+    assert(stage_graph_cleanup(graph) == MICARRAY_SUCCESS);
+    assert(cleanups == 3);
+    
+    printf("✓ Stage graph processing test passed\n");
+}
+
+static void test_stage_graph_clipping(void) {
+    printf("Testing stage graph clipping...\n");
+    
+    stage_graph_t *graph = create_graph();
+    assert(stage_graph_add(graph, &scale_stage, "4") == MICARRAY_SUCCESS);
+    
+    int16_t samples[TEST_CHANNELS][TEST_FRAMES];
+    int16_t *channels[TEST_CHANNELS] = { samples[0], samples[1], samples[2] };
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        for (int j = 0; j < TEST_FRAMES; j++) {
+            samples[c][j] = (int16_t)((j % 2) ? 20000 : -20000);
+        }
+    }
+    
+    // Only the frames asked for are touched
+    assert(stage_graph_process(graph, channels, 100, 0x7) == MICARRAY_SUCCESS);
+    for (int c = 0; c < TEST_CHANNELS; c++) {
+        for (int j = 0; j < TEST_FRAMES; j++) {
+            int limit = (j < 100) ? 32767 : 20000;
+            assert(samples[c][j] == ((j % 2) ? limit : -limit - (j < 100)));
+        }
+    }
+    
+    stage_graph_cleanup(graph);
+    
+    printf("✓ Stage graph clipping test passed\n");
+}
+
+static void test_stage_graph_counters(void) {
+    printf("Testing stage graph hardware counters...\n");
+    
+    int offset = 3;
+    stage_graph_t *plain = create_graph();
+    stage_graph_t *counted = create_graph();
+    assert(stage_graph_add_pcm(plain, "offset", offset_pcm, &offset) == MICARRAY_SUCCESS);
+    assert(stage_graph_add(plain, &scale_stage, "0.5") == MICARRAY_SUCCESS);
+    assert(stage_graph_add_pcm(counted, "offset", offset_pcm, &offset) == MICARRAY_SUCCESS);
+    assert(stage_graph_add(counted, &scale_stage, "0.5") == MICARRAY_SUCCESS);
+    
+    // Either outcome is fine; without a PMU the graph simply does not count
+    perf_counters_context_t *counters = NULL;
+    int result = perf_counters_init(&counters);
+    assert(result == MICARRAY_SUCCESS || result == MICARRAY_ERROR_INIT);
+    assert((result == MICARRAY_SUCCESS) == (counters != NULL));
+    printf("  perf events %s\n", result == MICARRAY_SUCCESS ? "available" : "not available");
+    assert(stage_graph_set_counters(NULL, counters) == MICARRAY_ERROR_INVALID_PARAM);
+    assert(stage_graph_set_counters(counted, counters) == MICARRAY_SUCCESS);
+    
+    int16_t a[TEST_CHANNELS][TEST_FRAMES], b[TEST_CHANNELS][TEST_FRAMES];
+    int16_t *channels_a[TEST_CHANNELS] = { a[0], a[1], a[2] };
+    int16_t *channels_b[TEST_CHANNELS] = { b[0], b[1], b[2] };
+    for (int block = 0; block < 4; block++) {
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            for (int j = 0; j < TEST_FRAMES; j++) {
+                a[c][j] = b[c][j] = (int16_t)((j * 91 + c * 300 + block) % 16000 - 8000);
+            }
+        }
+        assert(stage_graph_process(plain, channels_a, TEST_FRAMES, 0x7) == MICARRAY_SUCCESS);
+        assert(stage_graph_process(counted, channels_b, TEST_FRAMES, 0x7) == MICARRAY_SUCCESS);
+        assert(memcmp(a, b, sizeof(a)) == 0);
+    }
+    
+    micarray_stage_stats_t stats[2];
+    int num_stages = 0;
+    assert(stage_graph_get_stats(counted, stats, 2, &num_stages) == MICARRAY_SUCCESS && num_stages == 2);
+    for (int i = 0; i < num_stages; i++) {
+        assert(stats[i].calls == 4);
+        if (result == MICARRAY_SUCCESS) {
+            assert(stats[i].cycles > 0 && stats[i].instructions > 0);
+        } else {
+            assert(stats[i].cycles == 0 && stats[i].instructions == 0);
+            assert(stats[i].cache_misses == 0 && stats[i].branch_misses == 0);
+        }
+    }
+    
+    // Counting is off unless asked for
+    assert(stage_graph_get_stats(plain, stats, 2, &num_stages) == MICARRAY_SUCCESS);
+    assert(stats[0].cycles == 0 && stats[1].cycles == 0);
+    
+    // Code outside the graph is counted the same way
+    stage_section_t section;
+    stage_section_init(&section, "outside");
+    for (int i = 0; i < 3; i++) {
+        stage_section_begin(&section, counters);
+        assert(stage_graph_process(plain, channels_a, TEST_FRAMES, 0x7) == MICARRAY_SUCCESS);
+        stage_section_end(&section, counters);
+    }
+    assert(strcmp(section.stats.name, "outside") == 0 && section.stats.calls == 3);
+    assert(section.stats.total_ns >= section.stats.max_ns && section.stats.max_ns > 0);
+    assert(counters ? section.stats.cycles > 0 : section.stats.cycles == 0);
+    
+    stage_graph_cleanup(plain);
+    stage_graph_cleanup(counted);
+    if (counters) {
+        perf_counters_cleanup(counters);
+    }
+    
+    printf("✓ Stage graph counters test passed\n");
+}
+
+int main(void) {
+    printf("Running stage graph tests...\n\n");
+    
+    test_stage_graph_invalid_params();
+    test_stage_graph_process();
+    test_stage_graph_clipping();
+    test_stage_graph_counters();
+    
+    printf("\n✅ All stage graph tests passed!\n");
+    return 0;
+}